@@ -1,5 +1,8 @@
 @echo OFF
 DEL /Q *.vspv
 DEL /Q *.pspv
+DEL /Q *.cspv
+DEL /Q *.aspv
+DEL /Q *.mspv
 
 echo "cleaned spirv shader binaries."
@@ -15,4 +15,20 @@ echo "compiling %%~nf.ps"
 %DXC_ROOT%\dxc.exe -spirv -T ps_6_7 -E main %%f -Fo %%~nf.pspv
 )
 
+for %%f in (%SHADER_SRC_DIR%\*.cs) do (
+echo "compiling %%~nf.cs" 
+%DXC_ROOT%\dxc.exe -spirv -T cs_6_7 -E main %%f -Fo %%~nf.cspv
+)
+
+REM task and mesh shaders target VK_EXT_mesh_shader, which needs the vulkan 1.3 environment
+for %%f in (%SHADER_SRC_DIR%\*.as) do (
+echo "compiling %%~nf.as" 
+%DXC_ROOT%\dxc.exe -spirv -fspv-target-env=vulkan1.3 -T as_6_7 -E main %%f -Fo %%~nf.aspv
+)
+
+for %%f in (%SHADER_SRC_DIR%\*.ms) do (
+echo "compiling %%~nf.ms" 
+%DXC_ROOT%\dxc.exe -spirv -fspv-target-env=vulkan1.3 -T ms_6_7 -E main %%f -Fo %%~nf.mspv
+)
+
 pause
\ No newline at end of file
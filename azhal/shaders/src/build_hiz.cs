@@ -0,0 +1,140 @@
+// reduces the depth buffer into a max-depth pyramid in a single dispatch. every group reduces a 64x64 depth tile
+// into mips 0-5, the last group to finish then reduces the remaining mips from mip 5 of all groups.
+// mip 0 is half the depth resolution, padded to a power of two, texels outside the depth buffer are far
+
+static const uint K_MAX_MIPS = 12;
+static const uint K_GROUP_MIPS = 6;
+static const uint K_GROUP_SIZE = 256;
+
+struct HizConstants
+{
+  uint2 DepthExtent;
+  uint2 Mip0Extent;
+  uint MipCount;
+  uint GroupCount;
+};
+
+[[vk::push_constant]] HizConstants g_constants;
+
+[[vk::binding(0, 0)]] globallycoherent RWStructuredBuffer<uint> g_finishedGroupCount;
+[[vk::binding(1, 0)]] Texture2D<float> g_depth;
+[[vk::binding(2, 0)]] globallycoherent RWTexture2D<float> g_pyramid[K_MAX_MIPS];
+
+groupshared float s_depth[16][16];
+groupshared bool s_isLastGroup;
+
+uint2 get_mip_extent( uint mip )
+{
+  return max( g_constants.Mip0Extent >> mip, 1 );
+}
+
+float load_depth( uint2 texel )
+{
+  return all( texel < g_constants.DepthExtent ) ? g_depth.Load( int3( texel, 0 ) ) : 1.0;
+}
+
+// mips whose extent already reached 1 have no second child along that axis, 0 leaves the max untouched
+float load_pyramid( uint mip, uint2 texel )
+{
+  return all( texel < get_mip_extent( mip ) ) ? g_pyramid[mip][texel] : 0.0;
+}
+
+void store_pyramid( uint mip, uint2 texel, float depth )
+{
+  if( mip < g_constants.MipCount && all( texel < get_mip_extent( mip ) ) )
+  {
+    g_pyramid[mip][texel] = depth;
+  }
+}
+
+float max4( float a, float b, float c, float d )
+{
+  return max( max( a, b ), max( c, d ) );
+}
+
+[numthreads(K_GROUP_SIZE, 1, 1)]
+void main( uint3 GroupId : SV_GROUPID, uint GroupIndex : SV_GROUPINDEX )
+{
+  // every thread reduces a 4x4 depth block into 2x2 texels of mip 0 and one of mip 1
+  const uint2 local_texel = uint2( GroupIndex % 16, GroupIndex / 16 );
+  const uint2 mip1_texel = GroupId.xy * 16 + local_texel;
+
+  float mip1_depth = 0.0;
+  [unroll]
+  for( uint i = 0; i < 4; ++i )
+  {
+    const uint2 mip0_texel = mip1_texel * 2 + uint2( i & 1, i >> 1 );
+    const uint2 depth_texel = mip0_texel * 2;
+    const float mip0_depth = max4( load_depth( depth_texel ), load_depth( depth_texel + uint2( 1, 0 ) ),
+      load_depth( depth_texel + uint2( 0, 1 ) ), load_depth( depth_texel + uint2( 1, 1 ) ) );
+
+    store_pyramid( 0, mip0_texel, mip0_depth );
+    mip1_depth = max( mip1_depth, mip0_depth );
+  }
+  store_pyramid( 1, mip1_texel, mip1_depth );
+  s_depth[local_texel.y][local_texel.x] = mip1_depth;
+
+  [unroll]
+  for( uint mip = 2; mip < K_GROUP_MIPS; ++mip )
+  {
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint tile_size = 32 >> mip;
+    const bool is_active = all( local_texel < tile_size );
+    float depth = 0.0;
+    if( is_active )
+    {
+      const uint2 src = local_texel * 2;
+      depth = max4( s_depth[src.y][src.x], s_depth[src.y][src.x + 1], s_depth[src.y + 1][src.x], s_depth[src.y + 1][src.x + 1] );
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if( is_active )
+    {
+      s_depth[local_texel.y][local_texel.x] = depth;
+      store_pyramid( mip, GroupId.xy * tile_size + local_texel, depth );
+    }
+  }
+
+  // mip 5 of this group has to be visible to whichever group finishes last
+  DeviceMemoryBarrierWithGroupSync();
+  if( GroupIndex == 0 )
+  {
+    uint finished_group_count;
+    InterlockedAdd( g_finishedGroupCount[0], 1, finished_group_count );
+    s_isLastGroup = ( finished_group_count == g_constants.GroupCount - 1 );
+  }
+  GroupMemoryBarrierWithGroupSync();
+
+  if( !s_isLastGroup )
+  {
+    return;
+  }
+
+  // ready for the next frame
+  if( GroupIndex == 0 )
+  {
+    g_finishedGroupCount[0] = 0;
+  }
+
+  [unroll]
+  for( uint tail_mip = K_GROUP_MIPS; tail_mip < K_MAX_MIPS; ++tail_mip )
+  {
+    if( tail_mip >= g_constants.MipCount )
+    {
+      break;
+    }
+
+    const uint2 extent = get_mip_extent( tail_mip );
+    for( uint texel_index = GroupIndex; texel_index < extent.x * extent.y; texel_index += K_GROUP_SIZE )
+    {
+      const uint2 texel = uint2( texel_index % extent.x, texel_index / extent.x );
+      const uint2 src = texel * 2;
+      store_pyramid( tail_mip, texel, max4( load_pyramid( tail_mip - 1, src ), load_pyramid( tail_mip - 1, src + uint2( 1, 0 ) ),
+        load_pyramid( tail_mip - 1, src + uint2( 0, 1 ) ), load_pyramid( tail_mip - 1, src + uint2( 1, 1 ) ) ) );
+    }
+
+    DeviceMemoryBarrierWithGroupSync();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+// culls every instance and appends the visible ones to the indirect draw list of their pso bucket. runs twice a frame:
+// the early phase tests against the depth pyramid of the previous frame, the late phase re-tests everything the early
+// phase rejected against the pyramid of this frame's early depth, catching instances that became visible
+
+static const uint K_PHASE_EARLY = 0;
+static const uint K_PHASE_LATE = 1;
+
+struct CullConstants
+{
+  uint4 BucketFirstCommand;
+  uint InstanceCount;
+  uint ViewIndex;
+  uint Phase;
+  uint DrawCountOffset;
+};
+
+struct CullView
+{
+  float4 FrustumPlanes[6];
+  float4x4 ViewProjection;
+  // the view the pyramid was rendered from
+  float4x4 PyramidViewProjection;
+  float2 DepthExtent;
+  uint2 PyramidMip0Extent;
+  uint PyramidMipCount;
+  uint IsPyramidValid;
+  uint IsOcclusionCullingEnabled;
+  uint Padding;
+};
+
+struct Instance
+{
+  float4 BoundingSphere;
+  float4 PositionScale;
+  uint MeshIndex;
+  uint BucketIndex;
+  uint PackedColor;
+  uint Padding;
+};
+
+struct Mesh
+{
+  uint IndexCount;
+  uint FirstIndex;
+  int VertexOffset;
+  float BoundingRadius;
+};
+
+struct DrawIndexedIndirectCommand
+{
+  uint IndexCount;
+  uint InstanceCount;
+  uint FirstIndex;
+  int VertexOffset;
+  uint FirstInstance;
+};
+
+[[vk::push_constant]] CullConstants g_constants;
+
+[[vk::binding(0, 0)]] StructuredBuffer<Instance> g_instances;
+[[vk::binding(1, 0)]] StructuredBuffer<Mesh> g_meshes;
+[[vk::binding(2, 0)]] RWStructuredBuffer<DrawIndexedIndirectCommand> g_drawCommands;
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint> g_drawCounts;
+// 1 for instances the early phase drew this frame
+[[vk::binding(4, 0)]] RWStructuredBuffer<uint> g_earlyDrawn;
+[[vk::binding(5, 0)]] StructuredBuffer<CullView> g_views;
+[[vk::binding(6, 0)]] Texture2D<float> g_pyramid;
+
+bool is_in_frustum( float4 sphere, CullView view )
+{
+  [unroll]
+  for( uint i = 0; i < 6; ++i )
+  {
+    if( dot( view.FrustumPlanes[i].xyz, sphere.xyz ) + view.FrustumPlanes[i].w < -sphere.w )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// conservative: anything crossing the camera plane or too large for the pyramid counts as visible
+bool is_occluded( float4 sphere, float4x4 view_projection, CullView view )
+{
+  float2 uv_min = 1.0;
+  float2 uv_max = 0.0;
+  float nearest_depth = 1.0;
+
+  [unroll]
+  for( uint corner = 0; corner < 8; ++corner )
+  {
+    const float3 offset = float3( ( corner & 1 ) ? 1.0 : -1.0, ( corner & 2 ) ? 1.0 : -1.0, ( corner & 4 ) ? 1.0 : -1.0 );
+    const float4 clip = mul( view_projection, float4( sphere.xyz + offset * sphere.w, 1.0 ) );
+    if( clip.w <= 0.0 )
+    {
+      return false;
+    }
+
+    const float3 ndc = clip.xyz / clip.w;
+    const float2 uv = ndc.xy * 0.5 + 0.5;
+    uv_min = min( uv_min, uv );
+    uv_max = max( uv_max, uv );
+    nearest_depth = min( nearest_depth, ndc.z );
+  }
+
+  if( nearest_depth <= 0.0 )
+  {
+    return false;
+  }
+
+  // in mip 0 texels, which cover 2x2 depth texels
+  const float2 texel_min = saturate( uv_min ) * view.DepthExtent * 0.5;
+  const float2 texel_max = saturate( uv_max ) * view.DepthExtent * 0.5;
+  const float2 rect_size = texel_max - texel_min;
+
+  // a rect no larger than one texel of the mip overlaps at most 2x2 of them
+  const uint mip = (uint) ceil( log2( max( max( rect_size.x, rect_size.y ), 1.0 ) ) );
+  if( mip >= view.PyramidMipCount )
+  {
+    return false;
+  }
+
+  const uint2 last_texel = max( view.PyramidMip0Extent >> mip, 1 ) - 1;
+  const uint2 min_texel = min( uint2( texel_min ) >> mip, last_texel );
+  const uint2 max_texel = min( uint2( texel_max ) >> mip, last_texel );
+
+  const float occluder_depth = max(
+    max( g_pyramid.Load( int3( min_texel.x, min_texel.y, mip ) ), g_pyramid.Load( int3( max_texel.x, min_texel.y, mip ) ) ),
+    max( g_pyramid.Load( int3( min_texel.x, max_texel.y, mip ) ), g_pyramid.Load( int3( max_texel.x, max_texel.y, mip ) ) ) );
+
+  return nearest_depth > occluder_depth;
+}
+
+void append_draw( uint instance_index, Instance instance )
+{
+  uint bucket_slot;
+  InterlockedAdd( g_drawCounts[g_constants.DrawCountOffset + instance.BucketIndex], 1, bucket_slot );
+
+  const Mesh mesh = g_meshes[instance.MeshIndex];
+
+  DrawIndexedIndirectCommand command;
+  command.IndexCount = mesh.IndexCount;
+  command.InstanceCount = 1;
+  command.FirstIndex = mesh.FirstIndex;
+  command.VertexOffset = mesh.VertexOffset;
+  // reaches the vertex shader as SV_InstanceID
+  command.FirstInstance = instance_index;
+
+  g_drawCommands[g_constants.BucketFirstCommand[instance.BucketIndex] + bucket_slot] = command;
+}
+
+[numthreads(64, 1, 1)]
+void main( uint3 DispatchThreadId : SV_DISPATCHTHREADID )
+{
+  const uint instance_index = DispatchThreadId.x;
+  if( instance_index >= g_constants.InstanceCount )
+  {
+    return;
+  }
+
+  const Instance instance = g_instances[instance_index];
+  const CullView view = g_views[g_constants.ViewIndex];
+
+  if( g_constants.Phase == K_PHASE_EARLY )
+  {
+    const bool is_visible = is_in_frustum( instance.BoundingSphere, view ) &&
+      !( view.IsOcclusionCullingEnabled && view.IsPyramidValid && is_occluded( instance.BoundingSphere, view.PyramidViewProjection, view ) );
+
+    g_earlyDrawn[instance_index] = is_visible ? 1 : 0;
+    if( is_visible )
+    {
+      append_draw( instance_index, instance );
+    }
+  }
+  else if( g_earlyDrawn[instance_index] == 0 && is_in_frustum( instance.BoundingSphere, view ) &&
+    !is_occluded( instance.BoundingSphere, view.ViewProjection, view ) )
+  {
+    append_draw( instance_index, instance );
+  }
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+// pulls vertices and instances through buffer device addresses, the draws come from cull_instances
+
+struct DrawConstants
+{
+  float4x4 ViewProjection;
+  uint64_t VerticesAddress;
+  uint64_t InstancesAddress;
+};
+
+[[vk::push_constant]] DrawConstants g_constants;
+
+// strides and offsets match GpuVertex and GpuInstance of the sandbox
+static const uint K_VERTEX_STRIDE = 16;
+static const uint K_INSTANCE_STRIDE = 48;
+static const uint K_INSTANCE_POSITION_SCALE_OFFSET = 16;
+static const uint K_INSTANCE_PACKED_COLOR_OFFSET = 40;
+
+struct VS_OUTPUT
+{
+  float4 Position : SV_POSITION;
+
+  [[vk::location(0)]]
+  float3 Color : COLOR;
+};
+
+float3 unpack_color( uint packed_color )
+{
+  return float3( packed_color & 0xff, ( packed_color >> 8 ) & 0xff, ( packed_color >> 16 ) & 0xff ) / 255.0;
+}
+
+VS_OUTPUT main( uint VertexIndex : SV_VERTEXID, uint InstanceIndex : SV_INSTANCEID )
+{
+  const float4 vertex = vk::RawBufferLoad<float4>( g_constants.VerticesAddress + VertexIndex * K_VERTEX_STRIDE );
+
+  const uint64_t instance_address = g_constants.InstancesAddress + InstanceIndex * K_INSTANCE_STRIDE;
+  const float4 position_scale = vk::RawBufferLoad<float4>( instance_address + K_INSTANCE_POSITION_SCALE_OFFSET );
+  const uint instance_color = vk::RawBufferLoad<uint>( instance_address + K_INSTANCE_PACKED_COLOR_OFFSET );
+
+  const float3 world_position = vertex.xyz * position_scale.w + position_scale.xyz;
+
+  VS_OUTPUT output = (VS_OUTPUT) 0;
+  output.Position = mul( g_constants.ViewProjection, float4( world_position, 1.0 ) );
+  output.Color = unpack_color( asuint( vertex.w ) ) * unpack_color( instance_color );
+
+  return output;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+// decodes PackedMeshVertex from the fixed function vertex fetch, the instances are laid out on a grid
+
+struct DrawConstants
+{
+  float4x4 ViewProjection;
+  // xyz half extent of the mesh bounds, w distance between instances
+  float4 BoundsExtentSpacing;
+  uint GridColumns;
+};
+
+[[vk::push_constant]] DrawConstants g_constants;
+
+static const float3 K_LIGHT_DIRECTION = float3( 0.408, 0.816, 0.408 );
+
+struct VS_INPUT
+{
+  // snorm, relative to the mesh bounds
+  [[vk::location(0)]]
+  float4 Position : POSITION;
+
+  // snorm, octahedral
+  [[vk::location(1)]]
+  float2 Normal : NORMAL;
+
+  [[vk::location(2)]]
+  float2 Uv : TEXCOORD0;
+};
+
+struct VS_OUTPUT
+{
+  float4 Position : SV_POSITION;
+
+  [[vk::location(0)]]
+  float3 Color : COLOR;
+};
+
+float3 decode_octahedral( float2 encoded )
+{
+  float3 normal = float3( encoded, 1.0 - abs( encoded.x ) - abs( encoded.y ) );
+  const float fold = saturate( -normal.z );
+  normal.x += ( normal.x >= 0.0 ) ? -fold : fold;
+  normal.y += ( normal.y >= 0.0 ) ? -fold : fold;
+  return normalize( normal );
+}
+
+VS_OUTPUT main( VS_INPUT input, uint InstanceIndex : SV_INSTANCEID )
+{
+  // instances are centered on their bounds
+  const float2 cell = float2( InstanceIndex % g_constants.GridColumns, InstanceIndex / g_constants.GridColumns );
+  const float2 grid_offset = ( cell - ( g_constants.GridColumns - 1 ) * 0.5 ) * g_constants.BoundsExtentSpacing.w;
+  const float3 world_position = input.Position.xyz * g_constants.BoundsExtentSpacing.xyz + float3( grid_offset.x, 0.0, grid_offset.y );
+
+  const float3 normal = decode_octahedral( input.Normal );
+  const float3 albedo = float3( 0.6 + 0.4 * frac( input.Uv ), 0.8 );
+
+  VS_OUTPUT output = (VS_OUTPUT) 0;
+  output.Position = mul( g_constants.ViewProjection, float4( world_position, 1.0 ) );
+  output.Color = albedo * ( 0.2 + 0.8 * saturate( dot( normal, K_LIGHT_DIRECTION ) ) );
+
+  return output;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+// culls the meshlets of one instance against the frustum and their normal cones, and launches one mesh shader group
+// per survivor. the groups of a draw are laid out as meshlet groups in x and instances in y
+
+static const uint K_GROUP_SIZE = 32;
+
+struct DrawConstants
+{
+  uint64_t ViewAddress;
+  uint64_t MeshletsAddress;
+  uint64_t VerticesAddress;
+  uint64_t MeshletVerticesAddress;
+  uint64_t MeshletTrianglesAddress;
+};
+
+[[vk::push_constant]] DrawConstants g_constants;
+
+// strides and offsets match GpuMeshlet and GpuMeshletView of the sandbox
+static const uint K_MESHLET_STRIDE = 48;
+static const uint K_MESHLET_CONE_OFFSET = 16;
+static const uint K_VIEW_FRUSTUM_PLANES_OFFSET = 64;
+static const uint K_VIEW_CAMERA_POSITION_OFFSET = 160;
+static const uint K_VIEW_BOUNDS_CENTER_SPACING_OFFSET = 176;
+static const uint K_VIEW_GRID_OFFSET = 208;
+static const uint K_VIEW_MESHLET_COUNT_OFFSET = 216;
+
+struct Payload
+{
+  uint InstanceIndex;
+  uint MeshletIndices[K_GROUP_SIZE];
+};
+
+groupshared Payload s_payload;
+groupshared uint s_visibleCount;
+
+float3 get_instance_translation( uint instance_index )
+{
+  // instances are centered on their bounds, see mesh.vs
+  const float4 bounds_center_spacing = vk::RawBufferLoad<float4>( g_constants.ViewAddress + K_VIEW_BOUNDS_CENTER_SPACING_OFFSET );
+  const uint grid_columns = vk::RawBufferLoad<uint>( g_constants.ViewAddress + K_VIEW_GRID_OFFSET );
+  const float2 cell = float2( instance_index % grid_columns, instance_index / grid_columns );
+  const float2 grid_offset = ( cell - ( grid_columns - 1 ) * 0.5 ) * bounds_center_spacing.w;
+  return float3( grid_offset.x, 0.0, grid_offset.y ) - bounds_center_spacing.xyz;
+}
+
+bool is_in_frustum( float4 sphere )
+{
+  [unroll]
+  for( uint i = 0; i < 6; ++i )
+  {
+    const float4 plane = vk::RawBufferLoad<float4>( g_constants.ViewAddress + K_VIEW_FRUSTUM_PLANES_OFFSET + i * 16 );
+    if( dot( plane.xyz, sphere.xyz ) + plane.w < -sphere.w )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// every triangle of the meshlet faces away from the camera
+bool is_backfacing( float4 sphere, float4 cone, float3 camera_position )
+{
+  const float3 to_center = sphere.xyz - camera_position;
+  return dot( to_center, cone.xyz ) >= cone.w * length( to_center ) + sphere.w;
+}
+
+[numthreads(K_GROUP_SIZE, 1, 1)]
+void main( uint3 GroupId : SV_GROUPID, uint GroupThreadId : SV_GROUPINDEX )
+{
+  if( GroupThreadId == 0 )
+  {
+    s_visibleCount = 0;
+    s_payload.InstanceIndex = GroupId.y;
+  }
+  GroupMemoryBarrierWithGroupSync();
+
+  const uint meshlet_count = vk::RawBufferLoad<uint>( g_constants.ViewAddress + K_VIEW_MESHLET_COUNT_OFFSET );
+  const uint meshlet_index = GroupId.x * K_GROUP_SIZE + GroupThreadId;
+  if( meshlet_index < meshlet_count )
+  {
+    const uint64_t meshlet_address = g_constants.MeshletsAddress + meshlet_index * K_MESHLET_STRIDE;
+    float4 sphere = vk::RawBufferLoad<float4>( meshlet_address );
+    const float4 cone = vk::RawBufferLoad<float4>( meshlet_address + K_MESHLET_CONE_OFFSET );
+    sphere.xyz += get_instance_translation( GroupId.y );
+
+    const float3 camera_position = vk::RawBufferLoad<float4>( g_constants.ViewAddress + K_VIEW_CAMERA_POSITION_OFFSET ).xyz;
+    if( is_in_frustum( sphere ) && !is_backfacing( sphere, cone, camera_position ) )
+    {
+      uint slot;
+      InterlockedAdd( s_visibleCount, 1, slot );
+      s_payload.MeshletIndices[slot] = meshlet_index;
+    }
+  }
+  GroupMemoryBarrierWithGroupSync();
+
+  DispatchMesh( s_visibleCount, 1, 1, s_payload );
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+// fallback for devices without mesh shaders: culls every meshlet of every instance like meshlet.as and appends one
+// indexed indirect draw per survivor. a meshlet's triangles are a contiguous range of the mesh's index buffer
+
+struct CullConstants
+{
+  uint ViewIndex;
+};
+
+struct MeshletView
+{
+  float4x4 ViewProjection;
+  float4 FrustumPlanes[6];
+  float4 CameraPosition;
+  // xyz center of the mesh bounds, w distance between instances
+  float4 BoundsCenterSpacing;
+  float4 BoundsExtent;
+  uint GridColumns;
+  uint InstanceCount;
+  uint MeshletCount;
+  uint Padding[9];
+};
+
+struct Meshlet
+{
+  float4 BoundingSphere;
+  float4 Cone;
+  uint VertexOffset;
+  uint TriangleOffset;
+  uint VertexCount;
+  uint TriangleCount;
+};
+
+struct DrawIndexedIndirectCommand
+{
+  uint IndexCount;
+  uint InstanceCount;
+  uint FirstIndex;
+  int VertexOffset;
+  uint FirstInstance;
+};
+
+[[vk::push_constant]] CullConstants g_constants;
+
+[[vk::binding(0, 0)]] StructuredBuffer<Meshlet> g_meshlets;
+[[vk::binding(1, 0)]] StructuredBuffer<MeshletView> g_views;
+[[vk::binding(2, 0)]] RWStructuredBuffer<DrawIndexedIndirectCommand> g_drawCommands;
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint> g_drawCount;
+
+bool is_in_frustum( float4 sphere, MeshletView view )
+{
+  [unroll]
+  for( uint i = 0; i < 6; ++i )
+  {
+    if( dot( view.FrustumPlanes[i].xyz, sphere.xyz ) + view.FrustumPlanes[i].w < -sphere.w )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool is_backfacing( float4 sphere, float4 cone, float3 camera_position )
+{
+  const float3 to_center = sphere.xyz - camera_position;
+  return dot( to_center, cone.xyz ) >= cone.w * length( to_center ) + sphere.w;
+}
+
+[numthreads(64, 1, 1)]
+void main( uint3 DispatchThreadId : SV_DISPATCHTHREADID )
+{
+  const MeshletView view = g_views[g_constants.ViewIndex];
+  if( DispatchThreadId.x >= view.MeshletCount * view.InstanceCount )
+  {
+    return;
+  }
+
+  const uint instance_index = DispatchThreadId.x / view.MeshletCount;
+  const Meshlet meshlet = g_meshlets[DispatchThreadId.x % view.MeshletCount];
+
+  // instances are centered on their bounds, see mesh.vs
+  const float2 cell = float2( instance_index % view.GridColumns, instance_index / view.GridColumns );
+  const float2 grid_offset = ( cell - ( view.GridColumns - 1 ) * 0.5 ) * view.BoundsCenterSpacing.w;
+  const float4 sphere = float4( meshlet.BoundingSphere.xyz + float3( grid_offset.x, 0.0, grid_offset.y ) - view.BoundsCenterSpacing.xyz, meshlet.BoundingSphere.w );
+
+  if( !is_in_frustum( sphere, view ) || is_backfacing( sphere, meshlet.Cone, view.CameraPosition.xyz ) )
+  {
+    return;
+  }
+
+  uint slot;
+  InterlockedAdd( g_drawCount[0], 1, slot );
+
+  DrawIndexedIndirectCommand command;
+  command.IndexCount = meshlet.TriangleCount * 3;
+  command.InstanceCount = 1;
+  command.FirstIndex = meshlet.TriangleOffset * 3;
+  command.VertexOffset = 0;
+  // reaches mesh.vs as SV_InstanceID
+  command.FirstInstance = instance_index;
+
+  g_drawCommands[slot] = command;
+}
\ No newline at end of file
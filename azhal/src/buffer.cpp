@@ -0,0 +1,216 @@
+#include "azpch.h"
+#include "buffer.h"
+
+#include "device_capabilities.h"
+#include "resource_pool.h"
+#include "staging.h"
+
+namespace
+{
+	gdevice::ResourcePool<gdevice::BufferTag, gdevice::Buffer> s_bufferPool( "buffer", 64 );
+}
+
+namespace
+{
+	// buffer copies have no alignment requirement, this only keeps the memcpy into the mapped ring aligned
+	constexpr vk::DeviceSize K_BUFFER_UPLOAD_ALIGNMENT = 16;
+
+
+	void get_memory_flags( gdevice::BufferMemoryUsage memory_usage, vk::MemoryPropertyFlags& out_required_flags, vk::MemoryPropertyFlags& out_preferred_flags )
+	{
+		switch( memory_usage )
+		{
+		case gdevice::BufferMemoryUsage::eCpuToGpu:
+			out_required_flags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+			// resizable bar memory lets the gpu read it at full speed
+			out_preferred_flags = vk::MemoryPropertyFlagBits::eDeviceLocal;
+			break;
+		case gdevice::BufferMemoryUsage::eGpuToCpu:
+			out_required_flags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+			out_preferred_flags = vk::MemoryPropertyFlagBits::eHostCached;
+			break;
+		case gdevice::BufferMemoryUsage::eGpuOnly:
+		default:
+			out_required_flags = vk::MemoryPropertyFlagBits::eDeviceLocal;
+			out_preferred_flags = {};
+			break;
+		}
+	}
+}
+
+namespace gdevice
+{
+	Uint32 find_memory_type_index( const vk::PhysicalDeviceMemoryProperties& memory_props, Uint32 memory_type_bits,
+		vk::MemoryPropertyFlags required_flags, vk::MemoryPropertyFlags preferred_flags )
+	{
+		Uint32 fallback_index = UINT32_MAX;
+		for( Uint32 i = 0; i < memory_props.memoryTypeCount; ++i )
+		{
+			const vk::MemoryPropertyFlags type_flags = memory_props.memoryTypes[ i ].propertyFlags;
+			if( !( memory_type_bits & ( 1u << i ) ) || ( type_flags & required_flags ) != required_flags )
+			{
+				continue;
+			}
+
+			if( ( type_flags & preferred_flags ) == preferred_flags )
+			{
+				return i;
+			}
+			if( fallback_index == UINT32_MAX )
+			{
+				fallback_index = i;
+			}
+		}
+
+		return fallback_index;
+	}
+
+
+	Buffer create_buffer( const DeviceCapabilities& device_capabilities, const vk::Device device, const BufferCreationParams& buffer_creation_params,
+		std::span<const Uint32> queue_family_indices )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_FATAL_ASSERT( buffer_creation_params.size > 0, "buffers must not be empty" );
+
+		const Bool is_device_address_used = static_cast< Bool >( buffer_creation_params.usage & vk::BufferUsageFlagBits::eShaderDeviceAddress );
+		AZHAL_FATAL_ASSERT( !is_device_address_used || is_device_feature_enabled( device_capabilities, eDeviceFeatureBufferDeviceAddress ),
+			"eShaderDeviceAddress needs the bufferDeviceAddress feature" );
+
+		const Bool is_concurrent = ( queue_family_indices.size() > 1 );
+		const vk::BufferCreateInfo buffer_create_info
+		{
+			.size = buffer_creation_params.size,
+			.usage = buffer_creation_params.usage,
+			.sharingMode = is_concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+			.queueFamilyIndexCount = is_concurrent ? VK_SIZE_CAST( queue_family_indices.size() ) : 0u,
+			.pQueueFamilyIndices = is_concurrent ? queue_family_indices.data() : VK_NULL_HANDLE
+		};
+		const vk::ResultValue rv_buffer = device.createBuffer( buffer_create_info );
+		const vk::Buffer vk_buffer = get_vk_result( rv_buffer, "failed to create buffer" );
+
+		const vk::MemoryRequirements memory_requirements = device.getBufferMemoryRequirements( vk_buffer );
+
+		vk::MemoryPropertyFlags required_flags;
+		vk::MemoryPropertyFlags preferred_flags;
+		get_memory_flags( buffer_creation_params.memoryUsage, required_flags, preferred_flags );
+
+		const Uint32 memory_type_index = find_memory_type_index( device_capabilities.memoryProperties, memory_requirements.memoryTypeBits, required_flags, preferred_flags );
+		if( memory_type_index == UINT32_MAX )
+		{
+			device.destroy( vk_buffer );
+			throw GDeviceException( "no memory type fits the buffer" );
+		}
+
+		const vk::MemoryAllocateFlagsInfo memory_allocate_flags_info
+		{
+			.flags = vk::MemoryAllocateFlagBits::eDeviceAddress
+		};
+		const vk::MemoryAllocateInfo memory_allocate_info
+		{
+			.pNext = is_device_address_used ? &memory_allocate_flags_info : VK_NULL_HANDLE,
+			.allocationSize = memory_requirements.size,
+			.memoryTypeIndex = memory_type_index
+		};
+		const vk::ResultValue rv_memory = device.allocateMemory( memory_allocate_info );
+		const vk::DeviceMemory memory = get_vk_result( rv_memory, "failed to allocate buffer memory" );
+
+		const vk::Result res_bind = device.bindBufferMemory( vk_buffer, memory, 0 );
+		vk::resultCheck( res_bind, "failed to bind buffer memory" );
+
+		Buffer buffer
+		{
+			.vkBuffer = vk_buffer,
+			.memory = memory,
+			.size = buffer_creation_params.size
+		};
+
+		if( buffer_creation_params.memoryUsage != BufferMemoryUsage::eGpuOnly )
+		{
+			const vk::ResultValue rv_mapped_data = device.mapMemory( memory, 0, VK_WHOLE_SIZE );
+			buffer.pMappedData = get_vk_result( rv_mapped_data, "failed to map buffer memory" );
+		}
+
+		if( is_device_address_used )
+		{
+			const vk::BufferDeviceAddressInfo device_address_info
+			{
+				.buffer = vk_buffer
+			};
+			buffer.deviceAddress = device.getBufferAddress( device_address_info );
+		}
+
+		return buffer;
+	}
+
+
+	void destroy_buffer( const vk::Device device, Buffer& buffer )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		device.destroy( buffer.vkBuffer );
+		device.free( buffer.memory );
+		buffer = {};
+	}
+
+
+	BufferHandle register_buffer( const Buffer& buffer )
+	{
+		return s_bufferPool.Register( buffer );
+	}
+
+
+	Buffer unregister_buffer( BufferHandle buffer_handle )
+	{
+		return s_bufferPool.Unregister( buffer_handle );
+	}
+
+
+	Buffer get_buffer( BufferHandle buffer_handle )
+	{
+		return s_bufferPool.Get( buffer_handle );
+	}
+
+
+	Bool is_buffer_valid( BufferHandle buffer_handle )
+	{
+		return s_bufferPool.IsValid( buffer_handle );
+	}
+
+
+	void destroy_buffer_pool( const vk::Device device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		s_bufferPool.DestroyAll( [device]( Buffer& buffer ) { destroy_buffer( device, buffer ); } );
+	}
+
+
+	void record_buffer_upload( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		const Buffer& dst_buffer, vk::DeviceSize dst_offset, const void* p_data, vk::DeviceSize size )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_FATAL_ASSERT( dst_offset + size <= dst_buffer.size, "upload exceeds the buffer" );
+
+		if( size == 0 )
+		{
+			return;
+		}
+
+		if( dst_buffer.pMappedData )
+		{
+			std::memcpy( static_cast< Uint8* >( dst_buffer.pMappedData ) + dst_offset, p_data, size );
+			return;
+		}
+
+		const StagingAllocation staging = allocate_staging( device_capabilities, device, size, K_BUFFER_UPLOAD_ALIGNMENT );
+		std::memcpy( staging.pMappedData, p_data, size );
+
+		const vk::BufferCopy buffer_copy
+		{
+			.srcOffset = staging.offset,
+			.dstOffset = dst_offset,
+			.size = size
+		};
+		cmd_buffer.copyBuffer( staging.vkBuffer, dst_buffer.vkBuffer, buffer_copy );
+	}
+}
\ No newline at end of file
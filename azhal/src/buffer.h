@@ -0,0 +1,65 @@
+#pragma once
+
+namespace gdevice
+{
+	struct DeviceCapabilities;
+
+	enum class BufferMemoryUsage : Uint32
+	{
+		// device local, written through uploads or by the gpu
+		eGpuOnly = 0,
+		// host visible and coherent, persistently mapped. for data the cpu rewrites every frame
+		eCpuToGpu = 1,
+		// host visible and cached, persistently mapped. for readbacks
+		eGpuToCpu = 2
+	};
+
+	struct BufferCreationParams
+	{
+		vk::DeviceSize size = 0;
+		vk::BufferUsageFlags usage;
+		BufferMemoryUsage memoryUsage = BufferMemoryUsage::eGpuOnly;
+		// concurrent sharing between the graphics and the async compute queue family, see begin_async_compute
+		Bool isSharedWithAsyncCompute = false;
+	};
+
+	struct Buffer
+	{
+		vk::Buffer vkBuffer;
+		// every buffer gets its own dedicated allocation
+		vk::DeviceMemory memory;
+		vk::DeviceSize size = 0;
+		// null for eGpuOnly
+		void* pMappedData = nullptr;
+		// non-zero when created with eShaderDeviceAddress, shaders reach the buffer through it
+		vk::DeviceAddress deviceAddress = 0;
+	};
+
+	struct BufferTag;
+	using BufferHandle = Handle<BufferTag>;
+
+	// the first type that is allowed by memory_type_bits and has all required flags, preferring one that also has the
+	// preferred flags. UINT32_MAX when none fits
+	Uint32 find_memory_type_index( const vk::PhysicalDeviceMemoryProperties& memory_props, Uint32 memory_type_bits,
+		vk::MemoryPropertyFlags required_flags, vk::MemoryPropertyFlags preferred_flags );
+
+	// queue_family_indices with more than one unique family create the buffer with concurrent sharing
+	Buffer create_buffer( const DeviceCapabilities& device_capabilities, const vk::Device device, const BufferCreationParams& buffer_creation_params,
+		std::span<const Uint32> queue_family_indices );
+	// destroys immediately, at runtime use the Context overload which defers until the gpu is done with it
+	void destroy_buffer( const vk::Device device, Buffer& buffer );
+
+	// the process-wide buffer pool the Context overloads address buffers through, see ResourcePool. a stale or null
+	// handle resolves to a null buffer, unregister hands the buffer back for the caller to destroy
+	BufferHandle register_buffer( const Buffer& buffer );
+	Buffer unregister_buffer( BufferHandle buffer_handle );
+	Buffer get_buffer( BufferHandle buffer_handle );
+	Bool is_buffer_valid( BufferHandle buffer_handle );
+	// destroys buffers that were never unregistered and reports them as leaks
+	void destroy_buffer_pool( const vk::Device device );
+
+	// mapped buffers are written in place. anything else goes through the staging ring, see allocate_staging. the copy
+	// is recorded into cmd_buffer and has to be made visible with a barrier
+	void record_buffer_upload( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		const Buffer& dst_buffer, vk::DeviceSize dst_offset, const void* p_data, vk::DeviceSize size );
+}
\ No newline at end of file
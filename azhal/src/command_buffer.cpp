@@ -30,6 +30,8 @@ namespace gdevice
 {
 	void init_command_pools( const vk::Device& device, const CommandPoolsInitParams& cmd_pool_init_params )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		s_computeCommandPool = create_command_pool( device, cmd_pool_init_params.computeQueueFamilyIndex );
 		s_graphicsCommandPool = create_command_pool( device, cmd_pool_init_params.graphicsQueueFamilyIndex );
 		s_presentCommandPool = create_command_pool( device, cmd_pool_init_params.presentQueueFamilyIndex );
@@ -39,6 +41,8 @@ namespace gdevice
 
 	void destroy_command_pools( const vk::Device& device )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		device.destroy( s_computeCommandPool );
 		device.destroy( s_graphicsCommandPool );
 		device.destroy( s_presentCommandPool );
@@ -48,6 +52,8 @@ namespace gdevice
 	//TODO: this is only for 1 command buffer now, change it to be for multiple
 	vk::CommandBuffer allocate_command_buffer( const vk::Device& device, QueueType queue_type, vk::CommandBufferLevel cmd_buffer_level )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		vk::CommandBufferAllocateInfo cmd_buffer_alloc_info
 		{
 			.level = cmd_buffer_level,
@@ -74,14 +80,18 @@ namespace gdevice
 			break;
 		}
 
-		const vk::ResultValue rv_command_buffer = device.allocateCommandBuffers( cmd_buffer_alloc_info );
-		const std::vector<vk::CommandBuffer>& cmd_buffers = get_vk_result( rv_command_buffer, "failed to allocate command buffer" );
+		// the pointer overload, the vector-returning one heap-allocates for a single handle
+		vk::CommandBuffer cmd_buffer;
+		const vk::Result res_allocate = device.allocateCommandBuffers( &cmd_buffer_alloc_info, &cmd_buffer );
+		vk::resultCheck( res_allocate, "failed to allocate command buffer" );
 
-		return cmd_buffers[ 0 ];
+		return cmd_buffer;
 	}
 
 	void free_command_buffer( vk::Device device, QueueType queue_type, vk::CommandBuffer cmd_buffer )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		switch( queue_type )
 		{
 		case gdevice::QueueType::eGraphics:
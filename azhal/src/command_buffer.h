@@ -16,6 +16,7 @@ namespace gdevice
 	void destroy_command_pools( const vk::Device& device );
 
 	vk::CommandBuffer allocate_command_buffer( const vk::Device& device, QueueType queue_type, vk::CommandBufferLevel cmd_buffer_level = vk::CommandBufferLevel::ePrimary );
+	// frees immediately, at runtime use the Context overload which defers until the gpu is done with it
 	void free_command_buffer( vk::Device device, QueueType queue_type, vk::CommandBuffer cmd_buffer );
 
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "azpch.h"
+#include "deferred_destruction.h"
+
+#include "buffer.h"
+#include "command_buffer.h"
+#include "enums.h"
+#include "frame.h"
+#include "image.h"
+#include "pso.h"
+#include "swapchain.h"
+
+#include <deque>
+#include <mutex>
+
+namespace
+{
+	struct DeferredCommandBuffer
+	{
+		gdevice::QueueType queueType;
+		vk::CommandBuffer cmdBuffer;
+	};
+
+	struct DeferredDestructionBatch
+	{
+		Uint64 frameIndex = 0;
+
+		std::vector<vk::Pipeline> pipelines;
+		std::vector<vk::PipelineLayout> pipelineLayouts;
+		std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;
+		std::vector<vk::DescriptorPool> descriptorPools;
+		std::vector<DeferredCommandBuffer> cmdBuffers;
+		std::vector<vk::ImageView> imageViews;
+		std::vector<vk::SwapchainKHR> swapchains;
+		std::vector<vk::Semaphore> semaphores;
+		std::vector<vk::Buffer> buffers;
+		std::vector<vk::Image> images;
+		std::vector<vk::DeviceMemory> memories;
+	};
+
+	std::mutex s_deferredDestructionMutex;
+	// ordered by frameIndex
+	std::deque<DeferredDestructionBatch> s_pendingBatches;
+	// released batches keep their capacity for later frames
+	std::vector<DeferredDestructionBatch> s_freeBatches;
+}
+
+namespace
+{
+	// must be called with s_deferredDestructionMutex held
+	DeferredDestructionBatch& get_current_batch()
+	{
+		const Uint64 frame_index = gdevice::get_current_frame_index();
+		if( s_pendingBatches.empty() || s_pendingBatches.back().frameIndex != frame_index )
+		{
+			if( s_freeBatches.empty() )
+			{
+				s_pendingBatches.emplace_back();
+			}
+			else
+			{
+				s_pendingBatches.push_back( std::move( s_freeBatches.back() ) );
+				s_freeBatches.pop_back();
+			}
+			s_pendingBatches.back().frameIndex = frame_index;
+		}
+
+		return s_pendingBatches.back();
+	}
+
+
+	void destroy_batch( const vk::Device& device, DeferredDestructionBatch& batch )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		for( const vk::Pipeline pipeline : batch.pipelines )
+		{
+			device.destroy( pipeline );
+		}
+		for( const vk::PipelineLayout pipeline_layout : batch.pipelineLayouts )
+		{
+			device.destroy( pipeline_layout );
+		}
+		for( const vk::DescriptorSetLayout descriptor_set_layout : batch.descriptorSetLayouts )
+		{
+			device.destroy( descriptor_set_layout );
+		}
+		// frees the sets allocated from them
+		for( const vk::DescriptorPool descriptor_pool : batch.descriptorPools )
+		{
+			device.destroy( descriptor_pool );
+		}
+		for( const DeferredCommandBuffer& deferred_cmd_buffer : batch.cmdBuffers )
+		{
+			gdevice::free_command_buffer( device, deferred_cmd_buffer.queueType, deferred_cmd_buffer.cmdBuffer );
+		}
+		// image views before the swapchains that own their images
+		for( const vk::ImageView image_view : batch.imageViews )
+		{
+			device.destroy( image_view );
+		}
+		for( const vk::SwapchainKHR swapchain : batch.swapchains )
+		{
+			device.destroy( swapchain );
+		}
+		for( const vk::Semaphore semaphore : batch.semaphores )
+		{
+			device.destroy( semaphore );
+		}
+		// buffers and images before the memory bound to them
+		for( const vk::Buffer buffer : batch.buffers )
+		{
+			device.destroy( buffer );
+		}
+		for( const vk::Image image : batch.images )
+		{
+			device.destroy( image );
+		}
+		for( const vk::DeviceMemory memory : batch.memories )
+		{
+			device.free( memory );
+		}
+
+		batch.pipelines.clear();
+		batch.pipelineLayouts.clear();
+		batch.descriptorSetLayouts.clear();
+		batch.descriptorPools.clear();
+		batch.cmdBuffers.clear();
+		batch.imageViews.clear();
+		batch.swapchains.clear();
+		batch.semaphores.clear();
+		batch.buffers.clear();
+		batch.images.clear();
+		batch.memories.clear();
+	}
+}
+
+namespace gdevice
+{
+	void defer_destroy_pso( PSO& pso )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		DeferredDestructionBatch& batch = get_current_batch();
+		batch.pipelines.push_back( pso.vkPipelineObject );
+		batch.pipelineLayouts.push_back( pso.pipelineLayout );
+		if( pso.descriptorSetLayout )
+		{
+			batch.descriptorSetLayouts.push_back( pso.descriptorSetLayout );
+		}
+
+		pso = {};
+	}
+
+
+	void defer_free_command_buffer( QueueType queue_type, vk::CommandBuffer cmd_buffer )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		get_current_batch().cmdBuffers.push_back( DeferredCommandBuffer { .queueType = queue_type, .cmdBuffer = cmd_buffer } );
+	}
+
+
+	void defer_destroy_swapchain( Swapchain& swapchain )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		DeferredDestructionBatch& batch = get_current_batch();
+		batch.imageViews.insert( batch.imageViews.end(), swapchain.imageViews.begin(), swapchain.imageViews.end() );
+		batch.swapchains.push_back( swapchain.vkSwapchain );
+
+		swapchain.vkSwapchain = VK_NULL_HANDLE;
+		swapchain.images.clear();
+		swapchain.imageViews.clear();
+	}
+
+
+	void defer_destroy_semaphore( vk::Semaphore semaphore )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		get_current_batch().semaphores.push_back( semaphore );
+	}
+
+
+	void defer_destroy_descriptor_pool( vk::DescriptorPool descriptor_pool )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		get_current_batch().descriptorPools.push_back( descriptor_pool );
+	}
+
+
+	void defer_free_memory( vk::DeviceMemory memory )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		get_current_batch().memories.push_back( memory );
+	}
+
+
+	void defer_destroy_buffer( Buffer& buffer )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		DeferredDestructionBatch& batch = get_current_batch();
+		batch.buffers.push_back( buffer.vkBuffer );
+		batch.memories.push_back( buffer.memory );
+
+		buffer = {};
+	}
+
+
+	void defer_destroy_image( Image& image )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		DeferredDestructionBatch& batch = get_current_batch();
+		batch.imageViews.push_back( image.view );
+		for( const vk::ImageView mip_view : image.mipViews )
+		{
+			if( mip_view )
+			{
+				batch.imageViews.push_back( mip_view );
+			}
+		}
+		batch.images.push_back( image.vkImage );
+		batch.memories.push_back( image.memory );
+
+		image = {};
+	}
+
+
+	void release_deferred_destructions( const vk::Device& device, Uint64 completed_frame_index )
+	{
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		while( !s_pendingBatches.empty() && s_pendingBatches.front().frameIndex <= completed_frame_index )
+		{
+			destroy_batch( device, s_pendingBatches.front() );
+			s_freeBatches.push_back( std::move( s_pendingBatches.front() ) );
+			s_pendingBatches.pop_front();
+		}
+	}
+
+
+	void flush_deferred_destructions( const vk::Device& device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		std::scoped_lock lock( s_deferredDestructionMutex );
+
+		for( DeferredDestructionBatch& batch : s_pendingBatches )
+		{
+			destroy_batch( device, batch );
+		}
+		s_pendingBatches.clear();
+		s_freeBatches.clear();
+	}
+}
\ No newline at end of file
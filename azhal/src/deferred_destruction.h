@@ -0,0 +1,28 @@
+#pragma once
+
+namespace gdevice
+{
+	enum class QueueType : Uint32;
+	struct Buffer;
+	struct Image;
+	struct PSO;
+	struct Swapchain;
+
+	// handles queued while frame n is the current frame are destroyed in one batch once frame n has retired on the gpu,
+	// which makes it safe to drop objects that in-flight command buffers may still reference
+	void defer_destroy_pso( PSO& pso );
+	void defer_free_command_buffer( QueueType queue_type, vk::CommandBuffer cmd_buffer );
+	// takes over the swapchain's handles and leaves it empty
+	void defer_destroy_swapchain( Swapchain& swapchain );
+	void defer_destroy_semaphore( vk::Semaphore semaphore );
+	void defer_destroy_buffer( Buffer& buffer );
+	void defer_destroy_image( Image& image );
+	void defer_destroy_descriptor_pool( vk::DescriptorPool descriptor_pool );
+	// memory the caller sub-allocated, freed after the buffers and images of the same batch
+	void defer_free_memory( vk::DeviceMemory memory );
+
+	// destroys every batch queued during frames up to and including completed_frame_index
+	void release_deferred_destructions( const vk::Device& device, Uint64 completed_frame_index );
+	// destroys everything that is queued, the device must be idle
+	void flush_deferred_destructions( const vk::Device& device );
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "azpch.h"
+#include "descriptors.h"
+
+namespace gdevice
+{
+	DescriptorSet create_descriptor_set( const vk::Device device, vk::DescriptorSetLayout descriptor_set_layout, const DescriptorSetWrites& descriptor_set_writes )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_FATAL_ASSERT( descriptor_set_layout, "the pso takes no descriptors" );
+
+		std::vector<vk::DescriptorPoolSize> pool_sizes;
+		const auto add_pool_size = [&pool_sizes]( vk::DescriptorType descriptor_type, size_t descriptor_count )
+		{
+			if( descriptor_count > 0 )
+			{
+				pool_sizes.push_back( vk::DescriptorPoolSize { .type = descriptor_type, .descriptorCount = VK_SIZE_CAST( descriptor_count ) } );
+			}
+		};
+		add_pool_size( vk::DescriptorType::eStorageBuffer, descriptor_set_writes.storageBuffers.size() );
+		add_pool_size( vk::DescriptorType::eSampledImage, descriptor_set_writes.sampledImages.size() );
+		add_pool_size( vk::DescriptorType::eStorageImage, descriptor_set_writes.storageImages.size() );
+		AZHAL_FATAL_ASSERT( !pool_sizes.empty(), "a descriptor set needs at least one descriptor" );
+
+		const vk::DescriptorPoolCreateInfo descriptor_pool_create_info
+		{
+			.maxSets = 1,
+			.poolSizeCount = VK_SIZE_CAST( pool_sizes.size() ),
+			.pPoolSizes = pool_sizes.data()
+		};
+		const vk::ResultValue rv_descriptor_pool = device.createDescriptorPool( descriptor_pool_create_info );
+		const vk::DescriptorPool descriptor_pool = get_vk_result( rv_descriptor_pool, "failed to create descriptor pool" );
+
+		const vk::DescriptorSetAllocateInfo descriptor_set_alloc_info
+		{
+			.descriptorPool = descriptor_pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &descriptor_set_layout
+		};
+		vk::DescriptorSet vk_descriptor_set;
+		const vk::Result res_alloc = device.allocateDescriptorSets( &descriptor_set_alloc_info, &vk_descriptor_set );
+		vk::resultCheck( res_alloc, "failed to allocate descriptor set" );
+
+		std::vector<vk::WriteDescriptorSet> descriptor_writes;
+		Uint32 binding = 0;
+		for( const vk::DescriptorBufferInfo& buffer_info : descriptor_set_writes.storageBuffers )
+		{
+			descriptor_writes.push_back( vk::WriteDescriptorSet
+			{
+				.dstSet = vk_descriptor_set,
+				.dstBinding = binding++,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eStorageBuffer,
+				.pBufferInfo = &buffer_info
+			} );
+		}
+		for( const vk::DescriptorImageInfo& image_info : descriptor_set_writes.sampledImages )
+		{
+			descriptor_writes.push_back( vk::WriteDescriptorSet
+			{
+				.dstSet = vk_descriptor_set,
+				.dstBinding = binding++,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eSampledImage,
+				.pImageInfo = &image_info
+			} );
+		}
+		if( !descriptor_set_writes.storageImages.empty() )
+		{
+			descriptor_writes.push_back( vk::WriteDescriptorSet
+			{
+				.dstSet = vk_descriptor_set,
+				.dstBinding = binding,
+				.descriptorCount = VK_SIZE_CAST( descriptor_set_writes.storageImages.size() ),
+				.descriptorType = vk::DescriptorType::eStorageImage,
+				.pImageInfo = descriptor_set_writes.storageImages.data()
+			} );
+		}
+		device.updateDescriptorSets( descriptor_writes, {} );
+
+		return DescriptorSet
+		{
+			.pool = descriptor_pool,
+			.vkDescriptorSet = vk_descriptor_set
+		};
+	}
+
+
+	void destroy_descriptor_set( const vk::Device device, DescriptorSet& descriptor_set )
+	{
+		device.destroy( descriptor_set.pool );
+		descriptor_set = {};
+	}
+}
\ No newline at end of file
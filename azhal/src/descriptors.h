@@ -0,0 +1,25 @@
+#pragma once
+
+namespace gdevice
+{
+	// a set together with the pool it was allocated from. meant for the few long-lived sets of compute passes that
+	// write storage buffers, per-draw data reaches shaders through buffer device addresses and push constants instead
+	struct DescriptorSet
+	{
+		vk::DescriptorPool pool;
+		vk::DescriptorSet vkDescriptorSet;
+	};
+
+	// laid out like the set of a compute pso: storage buffers from binding 0, then the sampled images, then the
+	// storage images as one array binding
+	struct DescriptorSetWrites
+	{
+		std::span<const vk::DescriptorBufferInfo> storageBuffers;
+		std::span<const vk::DescriptorImageInfo> sampledImages;
+		std::span<const vk::DescriptorImageInfo> storageImages;
+	};
+
+	DescriptorSet create_descriptor_set( const vk::Device device, vk::DescriptorSetLayout descriptor_set_layout, const DescriptorSetWrites& descriptor_set_writes );
+	// destroys immediately, at runtime use the Context overload which defers until the gpu is done with it
+	void destroy_descriptor_set( const vk::Device device, DescriptorSet& descriptor_set );
+}
\ No newline at end of file
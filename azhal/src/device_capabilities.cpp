@@ -0,0 +1,280 @@
+#include "azpch.h"
+#include "device_capabilities.h"
+
+#include "vulkan_init_helper.h"
+
+namespace
+{
+	// every field has to be supported for the feature to count as supported
+	std::vector<vk::Bool32*> get_feature_fields( gdevice::DeviceFeatureChain& feature_chain, gdevice::DeviceFeatureBits feature )
+	{
+		vk::PhysicalDeviceFeatures& features_10 = feature_chain.get<vk::PhysicalDeviceFeatures2>().features;
+		vk::PhysicalDeviceVulkan11Features& features_11 = feature_chain.get<vk::PhysicalDeviceVulkan11Features>();
+		vk::PhysicalDeviceVulkan12Features& features_12 = feature_chain.get<vk::PhysicalDeviceVulkan12Features>();
+		vk::PhysicalDeviceVulkan13Features& features_13 = feature_chain.get<vk::PhysicalDeviceVulkan13Features>();
+
+		switch( feature )
+		{
+		case gdevice::eDeviceFeatureDynamicRendering:
+			return { &features_13.dynamicRendering };
+		case gdevice::eDeviceFeatureSynchronization2:
+			return { &features_13.synchronization2 };
+		case gdevice::eDeviceFeatureTimelineSemaphore:
+			return { &features_12.timelineSemaphore };
+		case gdevice::eDeviceFeatureBufferDeviceAddress:
+			return { &features_12.bufferDeviceAddress };
+		case gdevice::eDeviceFeatureDescriptorIndexing:
+			return {
+				&features_12.descriptorIndexing,
+				&features_12.runtimeDescriptorArray,
+				&features_12.descriptorBindingPartiallyBound,
+				&features_12.descriptorBindingVariableDescriptorCount,
+				&features_12.descriptorBindingSampledImageUpdateAfterBind,
+				&features_12.shaderSampledImageArrayNonUniformIndexing
+			};
+		case gdevice::eDeviceFeatureStorage8Bit:
+			return { &features_12.storageBuffer8BitAccess, &features_12.uniformAndStorageBuffer8BitAccess };
+		case gdevice::eDeviceFeatureStorage16Bit:
+			return { &features_11.storageBuffer16BitAccess, &features_11.uniformAndStorageBuffer16BitAccess };
+		case gdevice::eDeviceFeatureShaderFloat16:
+			return { &features_12.shaderFloat16 };
+		case gdevice::eDeviceFeatureShaderInt8:
+			return { &features_12.shaderInt8 };
+		case gdevice::eDeviceFeatureShaderInt16:
+			return { &features_10.shaderInt16 };
+		case gdevice::eDeviceFeatureShaderInt64:
+			return { &features_10.shaderInt64 };
+		case gdevice::eDeviceFeatureDrawIndirectCount:
+			return { &features_12.drawIndirectCount };
+		case gdevice::eDeviceFeatureMultiDrawIndirect:
+			return { &features_10.multiDrawIndirect };
+		case gdevice::eDeviceFeatureScalarBlockLayout:
+			return { &features_12.scalarBlockLayout };
+		case gdevice::eDeviceFeatureSamplerFilterMinmax:
+			return { &features_12.samplerFilterMinmax };
+		case gdevice::eDeviceFeatureMaintenance4:
+			return { &features_13.maintenance4 };
+		case gdevice::eDeviceFeaturePipelineStatisticsQuery:
+			return { &features_10.pipelineStatisticsQuery };
+		case gdevice::eDeviceFeatureOcclusionQueryPrecise:
+			return { &features_10.occlusionQueryPrecise };
+		case gdevice::eDeviceFeatureSamplerAnisotropy:
+			return { &features_10.samplerAnisotropy };
+		case gdevice::eDeviceFeatureTextureCompressionBC:
+			return { &features_10.textureCompressionBC };
+		case gdevice::eDeviceFeatureHostQueryReset:
+			return { &features_12.hostQueryReset };
+		case gdevice::eDeviceFeaturePresentWait:
+			return { &feature_chain.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId, &feature_chain.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait };
+		case gdevice::eDeviceFeatureDrawIndirectFirstInstance:
+			return { &features_10.drawIndirectFirstInstance };
+		case gdevice::eDeviceFeatureMeshShader:
+			return { &feature_chain.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>().taskShader, &feature_chain.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>().meshShader };
+		default:
+			AZHAL_LOG_CRITICAL( "unknown device feature {0}", static_cast< Uint64 >( feature ) );
+			AZHAL_DEBUG_BREAK();
+			return {};
+		}
+	}
+
+
+	// extension_features is a mask of the DeviceFeatureBits whose extensions are available
+	void unlink_unused_extension_features( gdevice::DeviceFeatureChain& feature_chain, Uint64 extension_features )
+	{
+		if( !( extension_features & gdevice::eDeviceFeaturePresentWait ) )
+		{
+			feature_chain.unlink<vk::PhysicalDevicePresentIdFeaturesKHR>();
+			feature_chain.unlink<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+		}
+		if( !( extension_features & gdevice::eDeviceFeatureMeshShader ) )
+		{
+			feature_chain.unlink<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+		}
+	}
+
+
+	template<typename FnType>
+	void for_each_device_feature( Uint64 features, FnType&& fn )
+	{
+		for( Uint32 bit = 0; bit < gdevice::eDeviceFeatureCount; ++bit )
+		{
+			const Uint64 feature = ( 1ull << bit );
+			if( features & feature )
+			{
+				fn( static_cast< gdevice::DeviceFeatureBits >( feature ) );
+			}
+		}
+	}
+}
+
+namespace gdevice
+{
+	const AnsiChar* get_device_feature_name( DeviceFeatureBits feature )
+	{
+		switch( feature )
+		{
+		case eDeviceFeatureDynamicRendering:
+			return "dynamicRendering";
+		case eDeviceFeatureSynchronization2:
+			return "synchronization2";
+		case eDeviceFeatureTimelineSemaphore:
+			return "timelineSemaphore";
+		case eDeviceFeatureBufferDeviceAddress:
+			return "bufferDeviceAddress";
+		case eDeviceFeatureDescriptorIndexing:
+			return "descriptorIndexing";
+		case eDeviceFeatureStorage8Bit:
+			return "storage8Bit";
+		case eDeviceFeatureStorage16Bit:
+			return "storage16Bit";
+		case eDeviceFeatureShaderFloat16:
+			return "shaderFloat16";
+		case eDeviceFeatureShaderInt8:
+			return "shaderInt8";
+		case eDeviceFeatureShaderInt16:
+			return "shaderInt16";
+		case eDeviceFeatureShaderInt64:
+			return "shaderInt64";
+		case eDeviceFeatureDrawIndirectCount:
+			return "drawIndirectCount";
+		case eDeviceFeatureMultiDrawIndirect:
+			return "multiDrawIndirect";
+		case eDeviceFeatureScalarBlockLayout:
+			return "scalarBlockLayout";
+		case eDeviceFeatureSamplerFilterMinmax:
+			return "samplerFilterMinmax";
+		case eDeviceFeatureMaintenance4:
+			return "maintenance4";
+		case eDeviceFeaturePipelineStatisticsQuery:
+			return "pipelineStatisticsQuery";
+		case eDeviceFeatureOcclusionQueryPrecise:
+			return "occlusionQueryPrecise";
+		case eDeviceFeatureSamplerAnisotropy:
+			return "samplerAnisotropy";
+		case eDeviceFeatureTextureCompressionBC:
+			return "textureCompressionBC";
+		case eDeviceFeatureHostQueryReset:
+			return "hostQueryReset";
+		case eDeviceFeaturePresentWait:
+			return "presentWait";
+		case eDeviceFeatureDrawIndirectFirstInstance:
+			return "drawIndirectFirstInstance";
+		case eDeviceFeatureMeshShader:
+			return "meshShader";
+		default:
+			return "unknown";
+		}
+	}
+
+
+	DeviceCapabilities query_device_capabilities( const vk::PhysicalDevice physical_device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::PhysicalDeviceProperties props = physical_device.getProperties();
+
+		DeviceCapabilities device_capabilities
+		{
+			.deviceName = props.deviceName.data(),
+			.deviceType = props.deviceType,
+			.apiVersion = props.apiVersion,
+			.driverVersion = props.driverVersion,
+			.vendorId = props.vendorID,
+			.limits = props.limits
+		};
+
+		const vk::PhysicalDeviceMemoryProperties memory_props = physical_device.getMemoryProperties();
+		device_capabilities.memoryProperties = memory_props;
+		for( Uint32 i = 0; i < memory_props.memoryHeapCount; ++i )
+		{
+			if( memory_props.memoryHeaps[ i ].flags & vk::MemoryHeapFlagBits::eDeviceLocal )
+			{
+				device_capabilities.deviceLocalMemorySize += memory_props.memoryHeaps[ i ].size;
+			}
+		}
+
+		// 1.1+ feature structs are only valid on devices that report the version
+		if( props.apiVersion < VK_API_VERSION_1_3 )
+		{
+			return device_capabilities;
+		}
+
+		// extension structs may only be chained when the device knows the extension
+		Uint64 extension_features = eDeviceFeatureNone;
+		if( is_device_extension_supported( physical_device, VK_KHR_PRESENT_ID_EXTENSION_NAME ) &&
+			is_device_extension_supported( physical_device, VK_KHR_PRESENT_WAIT_EXTENSION_NAME ) )
+		{
+			extension_features |= eDeviceFeaturePresentWait;
+		}
+		if( is_device_extension_supported( physical_device, VK_EXT_MESH_SHADER_EXTENSION_NAME ) )
+		{
+			extension_features |= eDeviceFeatureMeshShader;
+
+			const auto props_chain = physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceMeshShaderPropertiesEXT>();
+			const vk::PhysicalDeviceMeshShaderPropertiesEXT& mesh_shader_props = props_chain.get<vk::PhysicalDeviceMeshShaderPropertiesEXT>();
+			device_capabilities.maxTaskWorkGroupCount = mesh_shader_props.maxTaskWorkGroupCount;
+			device_capabilities.maxTaskWorkGroupTotalCount = mesh_shader_props.maxTaskWorkGroupTotalCount;
+		}
+
+		DeviceFeatureChain feature_chain;
+		unlink_unused_extension_features( feature_chain, extension_features );
+		physical_device.getFeatures2( &feature_chain.get<vk::PhysicalDeviceFeatures2>() );
+
+		for( Uint32 bit = 0; bit < eDeviceFeatureCount; ++bit )
+		{
+			const DeviceFeatureBits feature = static_cast< DeviceFeatureBits >( 1ull << bit );
+			const std::vector<vk::Bool32*> feature_fields = get_feature_fields( feature_chain, feature );
+			const Bool is_supported = std::ranges::all_of( feature_fields, []( const vk::Bool32* p_field ) { return *p_field == VK_TRUE; } );
+			if( is_supported )
+			{
+				device_capabilities.supportedFeatures |= feature;
+			}
+		}
+
+		return device_capabilities;
+	}
+
+
+	void fill_device_feature_chain( DeviceFeatureChain& feature_chain, Uint64 features )
+	{
+		for_each_device_feature( features, [&feature_chain]( DeviceFeatureBits feature )
+		{
+			for( vk::Bool32* p_field : get_feature_fields( feature_chain, feature ) )
+			{
+				*p_field = VK_TRUE;
+			}
+		} );
+
+		unlink_unused_extension_features( feature_chain, features );
+	}
+
+
+	std::vector<const AnsiChar*> get_device_feature_extensions( Uint64 features )
+	{
+		std::vector<const AnsiChar*> feature_extensions;
+		if( features & eDeviceFeaturePresentWait )
+		{
+			feature_extensions.push_back( VK_KHR_PRESENT_ID_EXTENSION_NAME );
+			feature_extensions.push_back( VK_KHR_PRESENT_WAIT_EXTENSION_NAME );
+		}
+		if( features & eDeviceFeatureMeshShader )
+		{
+			feature_extensions.push_back( VK_EXT_MESH_SHADER_EXTENSION_NAME );
+		}
+
+		return feature_extensions;
+	}
+
+
+	void log_device_capabilities( const DeviceCapabilities& device_capabilities )
+	{
+		AZHAL_LOG_INFO( "device: {0} ({1}), api {2}.{3}.{4}, {5} MiB device local memory", device_capabilities.deviceName, vk::to_string( device_capabilities.deviceType ),
+			VK_API_VERSION_MAJOR( device_capabilities.apiVersion ), VK_API_VERSION_MINOR( device_capabilities.apiVersion ), VK_API_VERSION_PATCH( device_capabilities.apiVersion ),
+			device_capabilities.deviceLocalMemorySize / ( 1024 * 1024 ) );
+
+		for_each_device_feature( device_capabilities.supportedFeatures, [&device_capabilities]( DeviceFeatureBits feature )
+		{
+			AZHAL_LOG_INFO( "  {0}: {1}", get_device_feature_name( feature ), ( device_capabilities.enabledFeatures & feature ) ? "enabled" : "supported" );
+		} );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+namespace gdevice
+{
+	enum DeviceFeatureBits : Uint64
+	{
+		eDeviceFeatureNone = 0ull,
+		eDeviceFeatureDynamicRendering = 1ull << 0,
+		eDeviceFeatureSynchronization2 = 1ull << 1,
+		eDeviceFeatureTimelineSemaphore = 1ull << 2,
+		eDeviceFeatureBufferDeviceAddress = 1ull << 3,
+		// runtime arrays, partially bound and variable count bindings, non-uniform sampled image indexing
+		eDeviceFeatureDescriptorIndexing = 1ull << 4,
+		eDeviceFeatureStorage8Bit = 1ull << 5,
+		eDeviceFeatureStorage16Bit = 1ull << 6,
+		eDeviceFeatureShaderFloat16 = 1ull << 7,
+		eDeviceFeatureShaderInt8 = 1ull << 8,
+		eDeviceFeatureShaderInt16 = 1ull << 9,
+		eDeviceFeatureShaderInt64 = 1ull << 10,
+		eDeviceFeatureDrawIndirectCount = 1ull << 11,
+		eDeviceFeatureMultiDrawIndirect = 1ull << 12,
+		eDeviceFeatureScalarBlockLayout = 1ull << 13,
+		eDeviceFeatureSamplerFilterMinmax = 1ull << 14,
+		eDeviceFeatureMaintenance4 = 1ull << 15,
+		eDeviceFeaturePipelineStatisticsQuery = 1ull << 16,
+		eDeviceFeatureOcclusionQueryPrecise = 1ull << 17,
+		eDeviceFeatureSamplerAnisotropy = 1ull << 18,
+		eDeviceFeatureTextureCompressionBC = 1ull << 19,
+		eDeviceFeatureHostQueryReset = 1ull << 20,
+		// VK_KHR_present_id + VK_KHR_present_wait
+		eDeviceFeaturePresentWait = 1ull << 21,
+		// indirect draws with a non-zero firstInstance, gpu-driven draws pass the instance index through it
+		eDeviceFeatureDrawIndirectFirstInstance = 1ull << 22,
+		// VK_EXT_mesh_shader with task shaders
+		eDeviceFeatureMeshShader = 1ull << 23,
+
+		eDeviceFeatureCount = 24
+	};
+
+	// all three are core in vulkan 1.3, which device selection requires anyway. submission relies on the last two
+	constexpr Uint64 K_DEFAULT_REQUIRED_DEVICE_FEATURES = ( eDeviceFeatureDynamicRendering | eDeviceFeatureSynchronization2 | eDeviceFeatureTimelineSemaphore );
+	constexpr Uint64 K_DEFAULT_OPTIONAL_DEVICE_FEATURES = ( ( 1ull << eDeviceFeatureCount ) - 1 ) & ~K_DEFAULT_REQUIRED_DEVICE_FEATURES;
+
+	// masks of DeviceFeatureBits
+	struct DeviceFeatureRequest
+	{
+		// devices missing any of these are rejected
+		Uint64 required = K_DEFAULT_REQUIRED_DEVICE_FEATURES;
+		// enabled when present and used to rank devices
+		Uint64 optional = K_DEFAULT_OPTIONAL_DEVICE_FEATURES;
+	};
+
+	struct DeviceCapabilities
+	{
+		String deviceName;
+		vk::PhysicalDeviceType deviceType = vk::PhysicalDeviceType::eOther;
+		Uint32 apiVersion = 0;
+		Uint32 driverVersion = 0;
+		Uint32 vendorId = 0;
+
+		vk::PhysicalDeviceLimits limits;
+		vk::PhysicalDeviceMemoryProperties memoryProperties;
+		vk::DeviceSize deviceLocalMemorySize = 0;
+		// VK_EXT_mesh_shader task dispatch limits, zero without eDeviceFeatureMeshShader support
+		std::array<Uint32, 3> maxTaskWorkGroupCount {};
+		Uint32 maxTaskWorkGroupTotalCount = 0;
+
+		Uint64 supportedFeatures = eDeviceFeatureNone;
+		// what the logical device was created with, a subset of supportedFeatures
+		Uint64 enabledFeatures = eDeviceFeatureNone;
+	};
+
+	using DeviceFeatureChain = vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan11Features, vk::PhysicalDeviceVulkan12Features,
+		vk::PhysicalDeviceVulkan13Features, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR, vk::PhysicalDeviceMeshShaderFeaturesEXT>;
+
+	const AnsiChar* get_device_feature_name( DeviceFeatureBits feature );
+
+	// enabledFeatures is left empty
+	DeviceCapabilities query_device_capabilities( const vk::PhysicalDevice physical_device );
+
+	// sets the fields of the given features, meant to be linked into vk::DeviceCreateInfo. extension structs
+	// of features that are not requested are unlinked
+	void fill_device_feature_chain( DeviceFeatureChain& feature_chain, Uint64 features );
+	// extensions that have to be enabled alongside the given features
+	std::vector<const AnsiChar*> get_device_feature_extensions( Uint64 features );
+
+	void log_device_capabilities( const DeviceCapabilities& device_capabilities );
+
+	AZHAL_INLINE Bool is_device_feature_enabled( const DeviceCapabilities& device_capabilities, Uint64 features )
+	{
+		return ( ( device_capabilities.enabledFeatures & features ) == features );
+	}
+}
\ No newline at end of file
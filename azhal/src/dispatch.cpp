@@ -0,0 +1,106 @@
+#include "azpch.h"
+#include "dispatch.h"
+
+#include "device_capabilities.h"
+
+namespace
+{
+	// VK_EXT_mesh_shader is not exported by the loader
+	PFN_vkCmdDrawMeshTasksEXT s_pfnDrawMeshTasks = nullptr;
+}
+
+namespace gdevice
+{
+	void load_dispatch_functions( const vk::Device device, Uint64 enabled_features )
+	{
+		s_pfnDrawMeshTasks = nullptr;
+		if( enabled_features & eDeviceFeatureMeshShader )
+		{
+			s_pfnDrawMeshTasks = reinterpret_cast< PFN_vkCmdDrawMeshTasksEXT >( device.getProcAddr( "vkCmdDrawMeshTasksEXT" ) );
+		}
+	}
+
+
+	void dispatch( vk::CommandBuffer cmd_buffer, const PSO& pso, Uint32 group_count_x, Uint32 group_count_y, Uint32 group_count_z )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		// a stale handle resolved to a null pso, dispatching would run whatever compute pso was bound before
+		AZHAL_ASSERT( pso.vkPipelineObject, "dispatch with a null pso, the dispatch is skipped" );
+		if( !pso.vkPipelineObject )
+		{
+			return;
+		}
+
+		bind_pso( cmd_buffer, pso );
+		cmd_buffer.dispatch( group_count_x, group_count_y, group_count_z );
+	}
+
+
+	void dispatch( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, Uint32 group_count_x, Uint32 group_count_y, Uint32 group_count_z )
+	{
+		dispatch( cmd_buffer, get_pso( pso_handle ), group_count_x, group_count_y, group_count_z );
+	}
+
+
+	void dispatch_threads( vk::CommandBuffer cmd_buffer, const PSO& pso, Uint32 thread_count, Uint32 group_size )
+	{
+		if( thread_count == 0 )
+		{
+			return;
+		}
+
+		dispatch( cmd_buffer, pso, get_dispatch_group_count( thread_count, group_size ) );
+	}
+
+
+	void dispatch_threads( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, Uint32 thread_count, Uint32 group_size )
+	{
+		dispatch_threads( cmd_buffer, get_pso( pso_handle ), thread_count, group_size );
+	}
+
+
+	void dispatch_indirect( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, vk::Buffer args_buffer, vk::DeviceSize args_offset )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_ASSERT( ( args_offset % 4 ) == 0, "indirect dispatch arguments must be 4 byte aligned" );
+
+		const PSO pso = get_pso( pso_handle );
+		AZHAL_ASSERT( pso.vkPipelineObject, "indirect dispatch with a null pso, the dispatch is skipped" );
+		if( !pso.vkPipelineObject )
+		{
+			return;
+		}
+
+		bind_pso( cmd_buffer, pso );
+		cmd_buffer.dispatchIndirect( args_buffer, args_offset );
+	}
+
+
+	void draw_indexed_indirect_count( vk::CommandBuffer cmd_buffer, vk::Buffer args_buffer, vk::DeviceSize args_offset,
+		vk::Buffer count_buffer, vk::DeviceSize count_offset, Uint32 max_draw_count )
+	{
+		AZHAL_ASSERT( ( args_offset % 4 ) == 0 && ( count_offset % 4 ) == 0, "indirect draw arguments must be 4 byte aligned" );
+
+		if( max_draw_count == 0 )
+		{
+			return;
+		}
+
+		cmd_buffer.drawIndexedIndirectCount( args_buffer, args_offset, count_buffer, count_offset, max_draw_count,
+			VK_SIZE_CAST( sizeof( vk::DrawIndexedIndirectCommand ) ) );
+	}
+
+
+	void draw_mesh_tasks( vk::CommandBuffer cmd_buffer, Uint32 group_count_x, Uint32 group_count_y, Uint32 group_count_z )
+	{
+		AZHAL_FATAL_ASSERT( s_pfnDrawMeshTasks, "mesh tasks need the meshShader device feature" );
+
+		if( group_count_x == 0 || group_count_y == 0 || group_count_z == 0 )
+		{
+			return;
+		}
+
+		s_pfnDrawMeshTasks( cmd_buffer, group_count_x, group_count_y, group_count_z );
+	}
+}
\ No newline at end of file
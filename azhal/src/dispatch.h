@@ -0,0 +1,37 @@
+#pragma once
+
+#include "pso.h"
+
+namespace gdevice
+{
+	// resolves the extension entry points of the enabled features, called once the device exists
+	void load_dispatch_functions( const vk::Device device, Uint64 enabled_features );
+
+	// groups needed to cover thread_count threads, the shader has to bounds check the last group
+	AZHAL_INLINE Uint32 get_dispatch_group_count( Uint32 thread_count, Uint32 group_size )
+	{
+		AZHAL_ASSERT( group_size > 0, "group size must not be 0" );
+		return ( thread_count + group_size - 1 ) / group_size;
+	}
+
+	// binds the compute pso, then dispatches. psos that are already bound can use the command buffer directly
+	void dispatch( vk::CommandBuffer cmd_buffer, const PSO& pso, Uint32 group_count_x, Uint32 group_count_y = 1, Uint32 group_count_z = 1 );
+	void dispatch( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, Uint32 group_count_x, Uint32 group_count_y = 1, Uint32 group_count_z = 1 );
+
+	// one thread per element, group_size must match numthreads of the shader
+	void dispatch_threads( vk::CommandBuffer cmd_buffer, const PSO& pso, Uint32 thread_count, Uint32 group_size );
+	void dispatch_threads( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, Uint32 thread_count, Uint32 group_size );
+
+	// reads a vk::DispatchIndirectCommand at args_offset, which must be a multiple of 4. lets a previous dispatch
+	// size the work without a round trip to the cpu
+	void dispatch_indirect( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, vk::Buffer args_buffer, vk::DeviceSize args_offset = 0 );
+
+	// draws the first count_buffer[ count_offset ] of max_draw_count tightly packed vk::DrawIndexedIndirectCommands,
+	// both written by an earlier compute pass. the pso and the index buffer have to be bound
+	void draw_indexed_indirect_count( vk::CommandBuffer cmd_buffer, vk::Buffer args_buffer, vk::DeviceSize args_offset,
+		vk::Buffer count_buffer, vk::DeviceSize count_offset, Uint32 max_draw_count );
+
+	// launches task shader groups, or mesh shader groups for psos without a task shader. needs eDeviceFeatureMeshShader
+	// and a bound mesh pso
+	void draw_mesh_tasks( vk::CommandBuffer cmd_buffer, Uint32 group_count_x, Uint32 group_count_y = 1, Uint32 group_count_z = 1 );
+}
\ No newline at end of file
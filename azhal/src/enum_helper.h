@@ -58,6 +58,23 @@ namespace gdevice
 		}
 	}
 
+	constexpr const AnsiChar* EnumToString( PresentPolicy enum_val )
+	{
+		switch( enum_val )
+		{
+		case PresentPolicy::eImmediate:
+			return "PresentPolicy::eImmediate";
+		case PresentPolicy::eMailbox:
+			return "PresentPolicy::eMailbox";
+		case PresentPolicy::eFifo:
+			return "PresentPolicy::eFifo";
+		case PresentPolicy::eFifoRelaxed:
+			return "PresentPolicy::eFifoRelaxed";
+		default:
+			return "Invalid PresentPolicy Enum";
+		}
+	}
+
 }
 
 // Note: As a rule of thumb, use EnumToString directly for values known at compile-time 
@@ -73,4 +90,5 @@ struct fmt::formatter<ENUM_TYPE> : formatter<std::string_view>
 
 IMPLEMENT_FORMATTER_FOR_ENUM( vk::DebugUtilsMessageTypeFlagBitsEXT );
 IMPLEMENT_FORMATTER_FOR_ENUM( vk::DebugUtilsMessageSeverityFlagBitsEXT );
-IMPLEMENT_FORMATTER_FOR_ENUM( vk::QueueFlagBits );
\ No newline at end of file
+IMPLEMENT_FORMATTER_FOR_ENUM( vk::QueueFlagBits );
+IMPLEMENT_FORMATTER_FOR_ENUM( gdevice::PresentPolicy );
\ No newline at end of file
@@ -18,6 +18,19 @@ namespace gdevice
 		eAccessTypeWrite = 0x00000002,
 		eAccessTypeReadWrite = ( eAccessTypeRead | eAccessTypeWrite )
 	};
+
+	// unsupported policies fall back to the next entry of their chain, FIFO is always available
+	enum class PresentPolicy : Uint32
+	{
+		// lowest latency, tears: immediate -> mailbox -> fifo
+		eImmediate = 0,
+		// low latency without tearing, renders frames that are never shown: mailbox -> fifo
+		eMailbox = 1,
+		// vsync, lowest power: fifo
+		eFifo = 2,
+		// vsync that tears instead of stuttering when a frame is late: fifo relaxed -> fifo
+		eFifoRelaxed = 3
+	};
 }
 
 
@@ -0,0 +1,446 @@
+#include "azpch.h"
+#include "frame.h"
+
+#include <chrono>
+#include <thread>
+
+#include "deferred_destruction.h"
+#include "gdevice.h"
+#include "staging.h"
+#include "vulkan_sync_utils.h"
+
+namespace
+{
+	struct FrameSyncObjects
+	{
+		vk::CommandBuffer cmdBuffer;
+		vk::Semaphore imageAcquiredSemaphore;
+		vk::Fence inFlightFence;
+		// submission thread value of the slot's last present, its semaphores and swapchain are in use until it was processed
+		Uint64 presentValue = 0;
+
+		vk::CommandBuffer computeCmdBuffer;
+		// compute timeline value of the slot's last async compute submit
+		Uint64 computeValue = 0;
+		Bool isComputeRecording = false;
+	};
+
+	std::array<FrameSyncObjects, gdevice::MAX_FRAMES_IN_FLIGHT> s_frameSyncObjects;
+	// indexed by swapchain image, a present may still be reading the semaphore when a frame slot is reused
+	std::vector<vk::Semaphore> s_renderFinishedSemaphores;
+	Uint64 s_frameIndex = 0;
+	Uint64 s_lastPresentValue = 0;
+
+	Bool s_isSwapchainResizePending = false;
+	vk::Extent2D s_pendingSwapchainExtent;
+
+	using Clock = std::chrono::steady_clock;
+
+	struct FramePacingState
+	{
+		gdevice::FramePacingParams params;
+
+		PFN_vkWaitForPresentKHR pfnWaitForPresent = nullptr;
+		// present ids restart being meaningful with every swapchain, earlier ids were never presented to it
+		vk::SwapchainKHR pacedSwapchain;
+		Uint64 firstPresentId = 0;
+
+		Clock::duration minFrameDuration = Clock::duration::zero();
+		Clock::time_point nextFrameBeginTime;
+	};
+
+	FramePacingState s_framePacing;
+
+	// a present that never completes (e.g. a retired swapchain) must not hang the frame loop
+	constexpr Uint64 K_PRESENT_WAIT_TIMEOUT_NS = 100'000'000;
+	// the swapchain lock is held for at most this long at a time while waiting for a present
+	constexpr Uint64 K_PRESENT_WAIT_SLICE_NS = 1'000'000;
+	// sleeping is coarse on most platforms, the remainder is spent yielding
+	constexpr std::chrono::microseconds K_LIMITER_SPIN_DURATION { 1500 };
+}
+
+namespace
+{
+	vk::Semaphore create_semaphore( const vk::Device& device )
+	{
+		const vk::SemaphoreCreateInfo semaphore_create_info {};
+
+		const vk::ResultValue rv_semaphore = device.createSemaphore( semaphore_create_info );
+		return ( gdevice::get_vk_result( rv_semaphore, "failed to create semaphore" ) );
+	}
+
+
+	vk::Fence create_fence( const vk::Device& device, Bool is_signaled )
+	{
+		const vk::FenceCreateInfo fence_create_info
+		{
+			.flags = is_signaled ? vk::FenceCreateFlagBits::eSignaled : vk::FenceCreateFlags {}
+		};
+
+		const vk::ResultValue rv_fence = device.createFence( fence_create_info );
+		return ( gdevice::get_vk_result( rv_fence, "failed to create fence" ) );
+	}
+
+
+	void ensure_render_finished_semaphores( const vk::Device& device, size_t swapchain_image_count )
+	{
+		while( s_renderFinishedSemaphores.size() < swapchain_image_count )
+		{
+			s_renderFinishedSemaphores.push_back( create_semaphore( device ) );
+		}
+	}
+
+
+	// present id 0 means "no id", so frame n is presented with id n + 1
+	Uint64 get_present_id( Uint64 frame_index )
+	{
+		return frame_index + 1;
+	}
+
+
+	void wait_for_queued_presents( const vk::Device& device, const gdevice::Swapchain& swapchain, Uint64 frame_index )
+	{
+		const Uint32 max_queued_presents = s_framePacing.params.maxQueuedPresents;
+		if( !s_framePacing.pfnWaitForPresent || max_queued_presents == 0 || frame_index <= max_queued_presents ||
+			swapchain.vkSwapchain != s_framePacing.pacedSwapchain )
+		{
+			return;
+		}
+
+		const Uint64 present_id = get_present_id( frame_index - max_queued_presents - 1 );
+		if( present_id < s_framePacing.firstPresentId )
+		{
+			return;
+		}
+
+		AZHAL_PROFILE_SCOPE( "wait_for_present" );
+
+		gdevice::wait_for_submission_thread( s_lastPresentValue );
+
+		// vkWaitForPresentKHR needs the swapchain externally synchronized, but holding the lock for the whole wait would
+		// keep the submission thread from presenting. the wait is split into short slices with the lock released between
+		const Clock::time_point deadline = Clock::now() + std::chrono::nanoseconds( K_PRESENT_WAIT_TIMEOUT_NS );
+		VkResult res_wait = VK_TIMEOUT;
+		while( res_wait == VK_TIMEOUT && Clock::now() < deadline )
+		{
+			const std::unique_lock swapchain_lock = gdevice::lock_swapchain_access();
+			res_wait = s_framePacing.pfnWaitForPresent( device, swapchain.vkSwapchain, present_id, K_PRESENT_WAIT_SLICE_NS );
+		}
+		if( res_wait != VK_SUCCESS && res_wait != VK_TIMEOUT && res_wait != VK_SUBOPTIMAL_KHR && res_wait != VK_ERROR_OUT_OF_DATE_KHR )
+		{
+			vk::resultCheck( static_cast< vk::Result >( res_wait ), "failed to wait for present" );
+		}
+	}
+
+
+	void limit_frame_rate()
+	{
+		if( s_framePacing.minFrameDuration == Clock::duration::zero() )
+		{
+			return;
+		}
+
+		AZHAL_PROFILE_SCOPE( "frame_rate_limiter" );
+
+		const Clock::time_point target_time = s_framePacing.nextFrameBeginTime;
+		if( Clock::now() < target_time - K_LIMITER_SPIN_DURATION )
+		{
+			std::this_thread::sleep_until( target_time - K_LIMITER_SPIN_DURATION );
+		}
+		while( Clock::now() < target_time )
+		{
+			std::this_thread::yield();
+		}
+
+		// a late frame does not earn the next ones a burst of catch-up frames
+		s_framePacing.nextFrameBeginTime = std::max( target_time + s_framePacing.minFrameDuration, Clock::now() );
+	}
+
+
+	// a surface without area (minimized window) keeps the request pending until it can be served
+	void recreate_or_defer_swapchain( gdevice::Context& gctx, const vk::Extent2D& new_extent )
+	{
+		// the retired swapchain is passed as oldSwapchain, which the submission thread may be presenting to
+		const std::unique_lock swapchain_lock = gdevice::lock_swapchain_access();
+		s_isSwapchainResizePending = !gdevice::recreate_swapchain( gctx, new_extent );
+		s_pendingSwapchainExtent = new_extent;
+	}
+}
+
+namespace gdevice
+{
+	void init_frames( const vk::Device& device, const FramesInitParams& frames_init_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		for( FrameSyncObjects& sync_objects : s_frameSyncObjects )
+		{
+			sync_objects.cmdBuffer = allocate_command_buffer( device, QueueType::eGraphics );
+			sync_objects.computeCmdBuffer = allocate_command_buffer( device, QueueType::eCompute );
+			sync_objects.imageAcquiredSemaphore = create_semaphore( device );
+			// signaled so that the first wait on each slot returns immediately
+			sync_objects.inFlightFence = create_fence( device, true );
+		}
+
+		s_frameIndex = 0;
+		s_lastPresentValue = 0;
+
+		s_framePacing = {};
+		s_framePacing.params = frames_init_params.framePacing;
+		if( frames_init_params.isPresentWaitEnabled )
+		{
+			s_framePacing.pfnWaitForPresent = reinterpret_cast< PFN_vkWaitForPresentKHR >( device.getProcAddr( "vkWaitForPresentKHR" ) );
+		}
+		else if( s_framePacing.params.maxQueuedPresents > 0 )
+		{
+			AZHAL_LOG_WARN( "VK_KHR_present_wait is not available, maxQueuedPresents is ignored and pacing relies on the cpu limiter" );
+		}
+
+		if( s_framePacing.params.maxFramesPerSecond > 0.0 )
+		{
+			s_framePacing.minFrameDuration = std::chrono::duration_cast< Clock::duration >( std::chrono::duration<Double>( 1.0 / s_framePacing.params.maxFramesPerSecond ) );
+		}
+		s_framePacing.nextFrameBeginTime = Clock::now();
+	}
+
+
+	void destroy_frames( const vk::Device& device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		for( FrameSyncObjects& sync_objects : s_frameSyncObjects )
+		{
+			free_command_buffer( device, QueueType::eGraphics, sync_objects.cmdBuffer );
+			free_command_buffer( device, QueueType::eCompute, sync_objects.computeCmdBuffer );
+			device.destroy( sync_objects.imageAcquiredSemaphore );
+			device.destroy( sync_objects.inFlightFence );
+			sync_objects = {};
+		}
+
+		for( const vk::Semaphore semaphore : s_renderFinishedSemaphores )
+		{
+			device.destroy( semaphore );
+		}
+		s_renderFinishedSemaphores.clear();
+
+		s_isSwapchainResizePending = false;
+	}
+
+
+	void retire_swapchain( Swapchain& swapchain )
+	{
+		// presents of the old images may still wait on the render-finished semaphores, so they leave together
+		defer_destroy_swapchain( swapchain );
+		for( const vk::Semaphore semaphore : s_renderFinishedSemaphores )
+		{
+			defer_destroy_semaphore( semaphore );
+		}
+		s_renderFinishedSemaphores.clear();
+	}
+
+
+	Uint64 get_current_frame_index()
+	{
+		return s_frameIndex;
+	}
+
+
+	void request_swapchain_resize( const vk::Extent2D& new_extent )
+	{
+		s_isSwapchainResizePending = true;
+		s_pendingSwapchainExtent = new_extent;
+	}
+
+
+	Bool begin_frame( Context& gctx, Frame& frame )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const Uint32 frame_slot = static_cast< Uint32 >( s_frameIndex % MAX_FRAMES_IN_FLIGHT );
+		FrameSyncObjects& sync_objects = s_frameSyncObjects[ frame_slot ];
+
+		limit_frame_rate();
+		wait_for_queued_presents( gctx.device, gctx.swapchain, s_frameIndex );
+
+		// the slot's submit and the present queued behind it must have reached the driver before the fence can be
+		// waited on, a submit that failed there would leave the fence unsignaled forever
+		wait_for_submission_thread( sync_objects.presentValue );
+		check_submission_error();
+
+		{
+			AZHAL_PROFILE_SCOPE( "wait_for_frame_fence" );
+			const vk::Result res_wait = gctx.device.waitForFences( sync_objects.inFlightFence, VK_TRUE, UINT64_MAX );
+			vk::resultCheck( res_wait, "failed to wait for in-flight fence" );
+		}
+
+		// graphics waited for it, so this only blocks when the slot's compute work was never handed to graphics
+		if( sync_objects.computeValue > 0 )
+		{
+			AZHAL_PROFILE_SCOPE( "wait_for_async_compute" );
+			wait_for_queue_timeline( gctx, QueueType::eCompute, sync_objects.computeValue );
+		}
+
+		// every frame before this slot's previous frame has been waited on by an earlier begin_frame
+		if( s_frameIndex >= MAX_FRAMES_IN_FLIGHT )
+		{
+			release_deferred_destructions( gctx.device, s_frameIndex - MAX_FRAMES_IN_FLIGHT );
+			release_staging( s_frameIndex - MAX_FRAMES_IN_FLIGHT );
+		}
+
+		// presents run on the submission thread, an out-of-date result reaches the next frame instead of the one that presented
+		if( consume_present_out_of_date() && !s_isSwapchainResizePending )
+		{
+			s_isSwapchainResizePending = true;
+			s_pendingSwapchainExtent = gctx.swapchain.imageExtent;
+		}
+
+		if( s_isSwapchainResizePending )
+		{
+			recreate_or_defer_swapchain( gctx, s_pendingSwapchainExtent );
+			if( s_isSwapchainResizePending )
+			{
+				return false;
+			}
+		}
+
+		vk::ResultValue<Uint32> rv_image_index( vk::Result::eSuccess, 0 );
+		{
+			AZHAL_PROFILE_SCOPE( "acquire_next_image" );
+			const std::unique_lock swapchain_lock = lock_swapchain_access();
+			rv_image_index = gctx.device.acquireNextImageKHR( gctx.swapchain.vkSwapchain, UINT64_MAX, sync_objects.imageAcquiredSemaphore, VK_NULL_HANDLE );
+		}
+		if( rv_image_index.result == vk::Result::eErrorOutOfDateKHR )
+		{
+			recreate_or_defer_swapchain( gctx, gctx.swapchain.imageExtent );
+			return false;
+		}
+		AZHAL_FATAL_ASSERT( rv_image_index.result == vk::Result::eSuccess || rv_image_index.result == vk::Result::eSuboptimalKHR, "failed to acquire swapchain image" );
+
+		// only reset once work is guaranteed to be submitted for this slot
+		const vk::Result res_reset_fence = gctx.device.resetFences( sync_objects.inFlightFence );
+		vk::resultCheck( res_reset_fence, "failed to reset in-flight fence" );
+
+		ensure_render_finished_semaphores( gctx.device, gctx.swapchain.images.size() );
+
+		const vk::Result res_reset_cmd = sync_objects.cmdBuffer.reset();
+		vk::resultCheck( res_reset_cmd, "failed to reset frame command buffer" );
+
+		const vk::CommandBufferBeginInfo cmd_begin_info
+		{
+			.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+		};
+		const vk::Result res_begin_cmd = sync_objects.cmdBuffer.begin( cmd_begin_info );
+		vk::resultCheck( res_begin_cmd, "failed to begin frame command buffer" );
+
+		frame.frameIndex = s_frameIndex;
+		frame.frameSlot = frame_slot;
+		frame.cmdBuffer = sync_objects.cmdBuffer;
+		frame.swapchainImageIndex = rv_image_index.value;
+		frame.swapchainImage = gctx.swapchain.images[ frame.swapchainImageIndex ];
+		frame.swapchainImageView = gctx.swapchain.imageViews[ frame.swapchainImageIndex ];
+		frame.swapchainExtent = gctx.swapchain.imageExtent;
+
+		frame.asyncComputeValue = 0;
+		frame.asyncComputeWaitStageMask = vk::PipelineStageFlagBits2::eNone;
+
+		insert_image_pipeline_barrier( frame.cmdBuffer, frame.swapchainImage,
+			vk::ImageLayout::eUndefined, eAccessTypeInvalid,
+			vk::ImageLayout::eColorAttachmentOptimal, eAccessTypeWrite );
+
+		return true;
+	}
+
+
+	void end_frame( Context& gctx, const Frame& frame )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		FrameSyncObjects& sync_objects = s_frameSyncObjects[ frame.frameSlot ];
+		const vk::Semaphore render_finished_semaphore = s_renderFinishedSemaphores[ frame.swapchainImageIndex ];
+		AZHAL_ASSERT( !sync_objects.isComputeRecording, "begin_async_compute without end_async_compute" );
+
+		insert_image_pipeline_barrier( frame.cmdBuffer, frame.swapchainImage,
+			vk::ImageLayout::eColorAttachmentOptimal, eAccessTypeWrite,
+			vk::ImageLayout::ePresentSrcKHR, eAccessTypeInvalid );
+
+		AZHAL_PROFILE_GPU_COLLECT( frame.cmdBuffer );
+
+		const vk::Result res_end_cmd = frame.cmdBuffer.end();
+		vk::resultCheck( res_end_cmd, "failed to end frame command buffer" );
+
+		const SubmitParams submit_params
+		{
+			.cmdBuffer = frame.cmdBuffer,
+			.waitSemaphore = sync_objects.imageAcquiredSemaphore,
+			.waitStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			.waitQueueType = ( frame.asyncComputeValue > 0 ) ? QueueType::eCompute : QueueType::eInvalid,
+			.waitQueueValue = frame.asyncComputeValue,
+			.waitQueueStageMask = frame.asyncComputeWaitStageMask,
+			.signalSemaphore = render_finished_semaphore,
+			.fence = sync_objects.inFlightFence
+		};
+		submit( gctx, QueueType::eGraphics, submit_params );
+
+		Uint64 present_id = 0;
+		if( s_framePacing.pfnWaitForPresent )
+		{
+			present_id = get_present_id( frame.frameIndex );
+			if( gctx.swapchain.vkSwapchain != s_framePacing.pacedSwapchain )
+			{
+				s_framePacing.pacedSwapchain = gctx.swapchain.vkSwapchain;
+				s_framePacing.firstPresentId = present_id;
+			}
+		}
+
+		sync_objects.presentValue = present( gctx, frame.swapchainImageIndex, render_finished_semaphore, present_id );
+		s_lastPresentValue = sync_objects.presentValue;
+
+		s_frameIndex++;
+	}
+
+
+	vk::CommandBuffer begin_async_compute( Frame& frame )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		FrameSyncObjects& sync_objects = s_frameSyncObjects[ frame.frameSlot ];
+		AZHAL_FATAL_ASSERT( frame.asyncComputeValue == 0 && !sync_objects.isComputeRecording, "async compute is recorded once per frame" );
+
+		// begin_frame waited for the slot's previous compute submit
+		const vk::Result res_reset_cmd = sync_objects.computeCmdBuffer.reset();
+		vk::resultCheck( res_reset_cmd, "failed to reset async compute command buffer" );
+
+		const vk::CommandBufferBeginInfo cmd_begin_info
+		{
+			.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+		};
+		const vk::Result res_begin_cmd = sync_objects.computeCmdBuffer.begin( cmd_begin_info );
+		vk::resultCheck( res_begin_cmd, "failed to begin async compute command buffer" );
+
+		sync_objects.isComputeRecording = true;
+
+		return sync_objects.computeCmdBuffer;
+	}
+
+
+	void end_async_compute( Context& gctx, Frame& frame, vk::PipelineStageFlags2 graphics_wait_stage_mask )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		FrameSyncObjects& sync_objects = s_frameSyncObjects[ frame.frameSlot ];
+		AZHAL_FATAL_ASSERT( sync_objects.isComputeRecording, "end_async_compute without begin_async_compute" );
+
+		const vk::Result res_end_cmd = sync_objects.computeCmdBuffer.end();
+		vk::resultCheck( res_end_cmd, "failed to end async compute command buffer" );
+
+		const SubmitParams submit_params
+		{
+			.cmdBuffer = sync_objects.computeCmdBuffer
+		};
+		sync_objects.computeValue = submit( gctx, QueueType::eCompute, submit_params );
+		sync_objects.isComputeRecording = false;
+
+		frame.asyncComputeValue = sync_objects.computeValue;
+		frame.asyncComputeWaitStageMask = graphics_wait_stage_mask;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+namespace gdevice
+{
+	struct Swapchain;
+
+	constexpr Uint32 MAX_FRAMES_IN_FLIGHT = 2;
+
+	// per-frame state handed to the caller between begin_frame and end_frame
+	struct Frame
+	{
+		Uint64 frameIndex = 0;
+		Uint32 frameSlot = 0;
+
+		vk::CommandBuffer cmdBuffer;
+
+		Uint32 swapchainImageIndex = UINT32_MAX;
+		vk::Image swapchainImage;
+		vk::ImageView swapchainImageView;
+		vk::Extent2D swapchainExtent;
+
+		// set by end_async_compute, the frame's graphics submit then waits for the compute queue at this stage
+		Uint64 asyncComputeValue = 0;
+		vk::PipelineStageFlags2 asyncComputeWaitStageMask = vk::PipelineStageFlagBits2::eNone;
+	};
+
+	struct FramePacingParams
+	{
+		// with VK_KHR_present_wait, begin_frame blocks until at most this many presents are still queued. 0 disables it
+		Uint32 maxQueuedPresents = 0;
+		// cpu-side limiter, caps the rate at which frames begin. 0 disables it
+		Double maxFramesPerSecond = 0.0;
+	};
+
+	struct FramesInitParams
+	{
+		Bool isPresentWaitEnabled = false;
+		FramePacingParams framePacing;
+	};
+
+	void init_frames( const vk::Device& device, const FramesInitParams& frames_init_params );
+	void destroy_frames( const vk::Device& device );
+
+	// hands a replaced swapchain to the deferred destruction queue, it is destroyed once every frame that may still use its images has retired
+	void retire_swapchain( Swapchain& swapchain );
+
+	// the frame being recorded, or the next one between end_frame and begin_frame
+	Uint64 get_current_frame_index();
+
+	// the swapchain is recreated by the next begin_frame, frames already in flight keep presenting to the old one
+	void request_swapchain_resize( const vk::Extent2D& new_extent );
+
+	// returns the frame's compute queue command buffer in the recording state. the work runs on the compute queue
+	// alongside the frame's graphics work; resources both queues touch have to be created with concurrent sharing.
+	// end_async_compute submits it
+	vk::CommandBuffer begin_async_compute( Frame& frame );
+}
\ No newline at end of file
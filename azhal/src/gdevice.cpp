@@ -3,6 +3,9 @@
 
 #include "vulkan_init_helper.h"
 
+#include <exception>
+#include <optional>
+
 namespace
 {
 	VKAPI_ATTR vk::Bool32 VKAPI_CALL vk_debug_callback( vk::DebugUtilsMessageSeverityFlagBitsEXT message_severity, vk::DebugUtilsMessageTypeFlagBitsEXT message_type,
@@ -55,12 +58,37 @@ namespace
 		return VK_FALSE;
 #endif
 	}
+
+
+	// waits for a job however the scope is left, exceptions included. declared right after the job is started, so that
+	// the locals the job references are destroyed only after it finished
+	class JobWaitGuard : NonCopyable
+	{
+	public:
+		explicit JobWaitGuard( const JobCounter& counter )
+			: m_counter( counter )
+		{
+		}
+
+		~JobWaitGuard()
+		{
+			JobSystem::Wait( m_counter );
+		}
+
+	private:
+		const JobCounter& m_counter;
+	};
 }
 
 namespace gdevice
 {
 	Context init( const GDeviceInitParams& gdevice_init_params )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
+		StageTimings* p_timings = gdevice_init_params.pStartupTimings;
+		AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/init" );
+
 		const PFN_vkDebugUtilsMessengerCallbackEXT debug_callback_fn = reinterpret_cast< PFN_vkDebugUtilsMessengerCallbackEXT >( vk_debug_callback );
 
 		const VulkanInstanceCreationParams instance_creation_params
@@ -69,24 +97,52 @@ namespace gdevice
 			.debugMessageSeverity = gdevice_init_params.debugMessageSeverity,
 			.debugCallbackFn = debug_callback_fn,
 
-			.enableGpuAssistedValidation = gdevice_init_params.isGpuAssistedValidationEnabled
+			.enableGpuAssistedValidation = gdevice_init_params.isGpuAssistedValidationEnabled,
+
+			.isHeadless = is_headless( gdevice_init_params )
 		};
-		vk::Instance instance = create_instance( instance_creation_params );
+		vk::Instance instance;
+		{
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/instance" );
+			instance = create_instance( instance_creation_params );
+		}
 
 		vk::DispatchLoaderDynamic instance_dispatch_dynamic = vk::DispatchLoaderDynamic( instance, vkGetInstanceProcAddr );
 
+		// instance-level calls are thread safe, the messenger is created while the surface and device are set up
+		vk::DebugUtilsMessengerEXT debug_messenger;
+		JobCounter debug_messenger_counter;
 #ifdef AZHAL_ENABLE_LOGGING
-		vk::DebugUtilsMessengerEXT debug_messenger = create_debug_messenger( instance, gdevice_init_params.debugMessageSeverity, debug_callback_fn, instance_dispatch_dynamic );
+		JobSystem::Run( [&]()
+		{
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/debug_messenger" );
+			debug_messenger = create_debug_messenger( instance, gdevice_init_params.debugMessageSeverity, debug_callback_fn, instance_dispatch_dynamic );
+		}, &debug_messenger_counter );
+		const JobWaitGuard debug_messenger_wait_guard( debug_messenger_counter );
 #endif
 
-		vk::SurfaceKHR surface = create_vulkan_surface( instance, gdevice_init_params.pWindow );
+		vk::SurfaceKHR surface;
+		{
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/surface" );
+			surface = create_vulkan_surface( instance, gdevice_init_params.pWindow, instance_dispatch_dynamic );
+		}
+
+		vk::PhysicalDevice physical_device;
+		DeviceCapabilities device_capabilities;
+		{
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/physical_device" );
+			physical_device = get_suitable_physical_device( instance, surface, instance_dispatch_dynamic, gdevice_init_params.deviceFeatures );
 
-		vk::PhysicalDevice physical_device = get_suitable_physical_device( instance );
+			device_capabilities = query_device_capabilities( physical_device );
+			device_capabilities.enabledFeatures = device_capabilities.supportedFeatures & ( gdevice_init_params.deviceFeatures.required | gdevice_init_params.deviceFeatures.optional );
+		}
+		log_device_capabilities( device_capabilities );
 
 		const Uint32 graphics_queue_family_index = find_queue_family_index( physical_device, vk::QueueFlagBits::eGraphics );
-		const Uint32 compute_queue_family_index = find_queue_family_index( physical_device, vk::QueueFlagBits::eCompute );
+		const Uint32 compute_queue_family_index = find_async_compute_queue_family_index( physical_device );
 		const Uint32 transfer_queue_family_index = find_queue_family_index( physical_device, vk::QueueFlagBits::eTransfer );
 		const Uint32 present_queue_family_index = find_present_queue_family_index( physical_device, surface, instance_dispatch_dynamic );
+		AZHAL_LOG_INFO( "async compute: {0}", ( compute_queue_family_index != graphics_queue_family_index ) ? "dedicated compute queue family" : "shares the graphics queue family" );
 
 		const std::set<Uint32> unique_queue_families
 		{
@@ -96,9 +152,38 @@ namespace gdevice
 			present_queue_family_index
 		};
 
-		vk::Device device = create_device( instance, physical_device, unique_queue_families );
+		vk::Device device;
+		{
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/device" );
+			device = create_device( instance, physical_device, unique_queue_families, device_capabilities.enabledFeatures );
+		}
 
-		Swapchain swapchain = create_swapchain( physical_device, device, surface, gdevice_init_params.swapchainExtent );
+		// the swapchain only depends on the device and the surface, everything below it runs on this thread meanwhile.
+		// exceptions cannot leave a job, the swapchain's is rethrown once the job has been waited for
+		const SwapchainCreationParams swapchain_creation_params
+		{
+			.desiredExtent = gdevice_init_params.swapchainExtent,
+			.presentPolicy = gdevice_init_params.presentPolicy,
+			.desiredImageCount = gdevice_init_params.swapchainImageCount
+		};
+		std::optional<Swapchain> swapchain;
+		std::exception_ptr p_swapchain_exception;
+		JobCounter swapchain_counter;
+		JobSystem::Run( [&]()
+		{
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/swapchain" );
+			try
+			{
+				swapchain.emplace( create_swapchain( physical_device, device, surface, swapchain_creation_params ) );
+			}
+			catch( ... )
+			{
+				p_swapchain_exception = std::current_exception();
+			}
+		}, &swapchain_counter );
+		const JobWaitGuard swapchain_wait_guard( swapchain_counter );
+
+		AZHAL_STAGE_TIMING_SCOPE( p_timings, "gdevice/queues_and_frames" );
 
 		const CommandPoolsInitParams cmd_pools_init_params
 		{
@@ -109,6 +194,56 @@ namespace gdevice
 		};
 		init_command_pools( device, cmd_pools_init_params );
 
+		const auto get_device_queue_fn = [device]( Uint32 queue_family_index ) -> DeviceQueue
+		{
+			return DeviceQueue
+			{
+				.vkQueue = device.getQueue( queue_family_index, 0 ),
+				.familyIndex = queue_family_index
+			};
+		};
+
+		const DeviceQueues device_queues
+		{
+			.graphics = get_device_queue_fn( graphics_queue_family_index ),
+			.compute = get_device_queue_fn( compute_queue_family_index ),
+			.transfer = get_device_queue_fn( transfer_queue_family_index ),
+			.present = get_device_queue_fn( present_queue_family_index )
+		};
+
+		// tracy records its calibration commands into this buffer only during initialization
+		const vk::CommandBuffer gpu_profiler_cmd_buffer = allocate_command_buffer( device, QueueType::eGraphics );
+		const GpuProfilerInitParams gpu_profiler_init_params
+		{
+			.instance = instance,
+			.physicalDevice = physical_device,
+			.device = device,
+			.queue = device_queues.graphics.vkQueue,
+			.cmdBuffer = gpu_profiler_cmd_buffer,
+			.useCalibratedTimestamps = is_device_extension_supported( physical_device, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME ),
+			.pName = "graphics queue"
+		};
+		init_gpu_profiler( gpu_profiler_init_params );
+		free_command_buffer( device, QueueType::eGraphics, gpu_profiler_cmd_buffer );
+
+		const FramesInitParams frames_init_params
+		{
+			.isPresentWaitEnabled = is_device_feature_enabled( device_capabilities, eDeviceFeaturePresentWait ),
+			.framePacing = gdevice_init_params.framePacing
+		};
+		init_frames( device, frames_init_params );
+		init_staging_ring( device_capabilities, device, gdevice_init_params.stagingRingSize );
+		load_dispatch_functions( device, device_capabilities.enabledFeatures );
+
+		// from here on the queues belong to the submission thread
+		init_submission_thread( device, { device_queues.graphics.vkQueue, device_queues.compute.vkQueue, device_queues.present.vkQueue, device_queues.transfer.vkQueue } );
+
+		JobSystem::Wait( swapchain_counter );
+		JobSystem::Wait( debug_messenger_counter );
+		if( p_swapchain_exception )
+		{
+			std::rethrow_exception( p_swapchain_exception );
+		}
 
 		Context gctx(
 			instance,
@@ -116,8 +251,10 @@ namespace gdevice
 			debug_messenger,
 			surface,
 			physical_device,
+			device_capabilities,
 			device,
-			swapchain
+			device_queues,
+			*swapchain
 		);
 
 		return gctx;
@@ -126,6 +263,24 @@ namespace gdevice
 
 	void shutdown( Context& gctx )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
+		wait_idle( gctx );
+		shutdown_submission_thread( gctx.device );
+
+		destroy_pso_pool( gctx.device );
+		destroy_mesh_pool( gctx.device );
+		destroy_buffer_pool( gctx.device );
+		destroy_image_pool( gctx.device );
+
+		flush_deferred_destructions( gctx.device );
+
+		destroy_staging_ring( gctx.device );
+
+		destroy_frames( gctx.device );
+
+		destroy_gpu_profiler();
+
 		destroy_command_pools( gctx.device );
 
 		destroy_swapchain( gctx.device, gctx.swapchain );
@@ -1,10 +1,28 @@
 #pragma once
 #include "swapchain.h"
 
+#include "buffer.h"
 #include "command_buffer.h"
+#include "deferred_destruction.h"
+#include "descriptors.h"
+#include "device_capabilities.h"
+#include "dispatch.h"
 #include "enums.h"
+#include "frame.h"
+#include "geometry_pool.h"
+#include "gpu_queries.h"
+#include "gpu_timer.h"
+#include "image.h"
+#include "image_memory_pool.h"
+#include "mesh.h"
+#include "profiler_vk.h"
 #include "pso.h"
+#include "render_queue.h"
+#include "staging.h"
+#include "submission.h"
 #include "swapchain.h"
+#include "texture.h"
+#include "vulkan_sync_utils.h"
 #include "window.h"
 
 namespace gdevice
@@ -20,6 +38,38 @@ namespace gdevice
 		vk::DebugUtilsMessageSeverityFlagBitsEXT debugMessageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose;
 
 		Bool isGpuAssistedValidationEnabled = false;
+
+		DeviceFeatureRequest deviceFeatures;
+
+		PresentPolicy presentPolicy = PresentPolicy::eMailbox;
+		// 0 picks minImageCount + 1
+		Uint32 swapchainImageCount = 0;
+		FramePacingParams framePacing;
+		// shared by every upload, see allocate_staging
+		vk::DeviceSize stagingRingSize = 32 * K_MEBIBYTE;
+
+		// receives the duration of every init stage when set, stages on the critical path show as gaps between the others
+		StageTimings* pStartupTimings = nullptr;
+	};
+
+	// a null pWindow creates a VK_EXT_headless_surface instead of a window surface
+	AZHAL_INLINE Bool is_headless( const GDeviceInitParams& gdevice_init_params )
+	{
+		return ( gdevice_init_params.pWindow == nullptr );
+	}
+
+	struct DeviceQueue
+	{
+		vk::Queue vkQueue;
+		Uint32 familyIndex = UINT32_MAX;
+	};
+
+	struct DeviceQueues
+	{
+		DeviceQueue graphics;
+		DeviceQueue compute;
+		DeviceQueue transfer;
+		DeviceQueue present;
 	};
 
 	struct Context : NonCopyable
@@ -31,7 +81,9 @@ namespace gdevice
 			, debugMessenger( other.debugMessenger )
 			, surface( other.surface )
 			, physicalDevice( other.physicalDevice )
+			, capabilities( std::move( other.capabilities ) )
 			, device( other.device )
+			, queues( other.queues )
 			, swapchain( std::move( other.swapchain ) )
 		{
 
@@ -41,6 +93,7 @@ namespace gdevice
 			other.surface = VK_NULL_HANDLE;
 			other.physicalDevice = VK_NULL_HANDLE;
 			other.device = VK_NULL_HANDLE;
+			other.queues = {};
 		}
 
 		Context() = delete;
@@ -50,17 +103,39 @@ namespace gdevice
 	private:
 
 		explicit Context( vk::Instance instance_, vk::DispatchLoaderDynamic instance_dispatch_dynamic, vk::DebugUtilsMessengerEXT debug_messenger,
-			vk::SurfaceKHR surface_, vk::PhysicalDevice physical_device, vk::Device logical_device, Swapchain& swapchain_ )
+			vk::SurfaceKHR surface_, vk::PhysicalDevice physical_device, const DeviceCapabilities& capabilities_, vk::Device logical_device, const DeviceQueues& queues_,
+			Swapchain& swapchain_ )
 			: instance( instance_ )
 			, instanceDynamicDispatchLoader( instance_dispatch_dynamic )
 			, debugMessenger( debug_messenger )
 			, surface( surface_ )
 			, physicalDevice( physical_device )
+			, capabilities( capabilities_ )
 			, device( logical_device )
+			, queues( queues_ )
 			, swapchain( std::move( swapchain_ ) )
 		{
 		}
 
+		AZHAL_INLINE const DeviceQueue& get_queue( QueueType queue_type ) const
+		{
+			switch( queue_type )
+			{
+			case QueueType::eGraphics:
+				return queues.graphics;
+			case QueueType::eCompute:
+				return queues.compute;
+			case QueueType::eTransfer:
+				return queues.transfer;
+			case QueueType::ePresent:
+				return queues.present;
+			default:
+				AZHAL_LOG_CRITICAL( "Invalid queue type when retrieving device queue" );
+				AZHAL_DEBUG_BREAK();
+				return queues.graphics;
+			}
+		}
+
 		//-------------------------------------------------------------------//
 
 		vk::Instance instance;
@@ -70,7 +145,9 @@ namespace gdevice
 		vk::SurfaceKHR surface;
 
 		vk::PhysicalDevice physicalDevice;
+		DeviceCapabilities capabilities;
 		vk::Device device;
+		DeviceQueues queues;
 
 		Swapchain swapchain;
 
@@ -79,18 +156,410 @@ namespace gdevice
 		friend Context init( const GDeviceInitParams& gdevice_init_params );
 		friend void shutdown( Context& gctx );
 
-		friend void recreate_swapchain( Context& gctx, const vk::Extent2D& desired_extent );
+		friend Bool recreate_swapchain( Context& gctx, const vk::Extent2D& desired_extent );
+
+		friend Uint64 submit( Context& gctx, QueueType queue_type, const SubmitParams& submit_params );
+		friend Uint64 present( Context& gctx, Uint32 image_index, vk::Semaphore wait_semaphore, Uint64 present_id );
+
+		friend Bool begin_frame( Context& gctx, Frame& frame );
+		friend void end_frame( Context& gctx, const Frame& frame );
+		friend void end_async_compute( Context& gctx, Frame& frame, vk::PipelineStageFlags2 graphics_wait_stage_mask );
+		friend Bool is_async_compute_available( const Context& gctx );
+		friend void wait_idle( Context& gctx );
+		friend Bool wait_for_queue_timeline( Context& gctx, QueueType queue_type, Uint64 value, Uint64 timeout_ns );
+		friend void flush_deferred_destructions( Context& gctx );
+		friend const Swapchain& get_swapchain( const Context& gctx );
+		friend const DeviceCapabilities& get_device_capabilities( const Context& gctx );
+
+		friend PSOHandle create_pso( Context& gctx, const PSOCreationParams& pso_creation_params );
+		friend PSOHandle create_compute_pso( Context& gctx, const ComputePSOCreationParams& compute_pso_creation_params );
+		friend void destroy_pso( Context& gctx, PSOHandle pso_handle );
+		friend vk::PipelineCache create_pipeline_cache( Context& gctx, const ByteBufferDynamic& initial_data );
+		friend void destroy_pipeline_cache( Context& gctx, vk::PipelineCache pipeline_cache );
+		friend ByteBufferDynamic get_pipeline_cache_data( Context& gctx, vk::PipelineCache pipeline_cache );
+
+		friend BufferHandle create_buffer( Context& gctx, const BufferCreationParams& buffer_creation_params );
+		friend void destroy_buffer( Context& gctx, BufferHandle buffer_handle );
+		friend void record_buffer_upload( Context& gctx, vk::CommandBuffer cmd_buffer, BufferHandle dst_buffer_handle, vk::DeviceSize dst_offset, const void* p_data, vk::DeviceSize size );
+
+		friend ImageHandle create_image( Context& gctx, const ImageCreationParams& image_creation_params );
+		friend void destroy_image( Context& gctx, ImageHandle image_handle );
+
+		friend MeshHandle create_mesh( Context& gctx, vk::CommandBuffer cmd_buffer, const PackedMesh& packed_mesh, Bool is_pulled );
+		friend void destroy_mesh( Context& gctx, MeshHandle mesh_handle );
+
+		friend GeometryPool create_geometry_pool( Context& gctx, const GeometryPoolCreationParams& geometry_pool_creation_params );
+		friend void destroy_geometry_pool( Context& gctx, GeometryPool& geometry_pool );
+		friend GeometryHandle add_pool_mesh( Context& gctx, vk::CommandBuffer cmd_buffer, GeometryPool& geometry_pool, const PackedMesh& packed_mesh );
+		friend void compact_geometry_pool( Context& gctx, vk::CommandBuffer cmd_buffer, GeometryPool& geometry_pool );
+
+		friend vk::Format get_texture_vk_format( const Context& gctx, TextureFormat format );
+		friend TextureHandle add_streamed_texture( Context& gctx, TextureStreamer& texture_streamer, TextureData texture_data );
+		friend TextureStreamingStats update_texture_streaming( Context& gctx, vk::CommandBuffer cmd_buffer, TextureStreamer& texture_streamer );
+		friend Image create_pooled_image( Context& gctx, ImageMemoryPool& image_memory_pool, const ImageCreationParams& image_creation_params, ImageMemoryRange& out_range );
+
+		friend DescriptorSet create_pso_descriptor_set( Context& gctx, PSOHandle pso_handle, const DescriptorSetWrites& descriptor_set_writes );
+		friend void destroy_descriptor_set( Context& gctx, DescriptorSet& descriptor_set );
+
+		friend vk::CommandBuffer allocate_command_buffer( Context& gctx, QueueType queue_type, vk::CommandBufferLevel cmd_buffer_level );
+		friend void free_command_buffer( Context& gctx, QueueType queue_type, vk::CommandBuffer cmd_buffer );
+
+		friend GpuTimer create_gpu_timer( Context& gctx, GpuTimerCreationParams gpu_timer_creation_params );
+		friend void destroy_gpu_timer( Context& gctx, GpuTimer& gpu_timer );
+		friend void gpu_timer_begin_frame( Context& gctx, GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer, Uint64 frame_index );
+		friend void gpu_timer_collect_pending( Context& gctx, GpuTimer& gpu_timer );
+
+		friend GpuQueries create_gpu_queries( Context& gctx, const GpuQueriesCreationParams& gpu_queries_creation_params );
+		friend void destroy_gpu_queries( Context& gctx, GpuQueries& gpu_queries );
+		friend void gpu_queries_begin_frame( Context& gctx, GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer, Uint64 frame_index );
 	};
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+	// independent stages overlap on the job system: the debug messenger with surface and device selection, and the
+	// swapchain with command pools, gpu profiler and frame setup. works without an initialized job system, just serially
 	Context init( const GDeviceInitParams& gdevice_init_params );
 	void shutdown( Context& gctx );
 
+	// waits for the in-flight fence of the next frame slot and acquires a swapchain image, the frame's
+	// command buffer is returned in the recording state with the swapchain image in eColorAttachmentOptimal.
+	// returns false when the swapchain had to be recreated and the frame must be skipped
+	Bool begin_frame( Context& gctx, Frame& frame );
+	// transitions the swapchain image for presentation, submits the frame's command buffer and presents
+	void end_frame( Context& gctx, const Frame& frame );
+	// submits the compute work, the frame's graphics submit waits for it at graphics_wait_stage_mask. stages of the
+	// graphics work that do not consume compute results keep overlapping with it
+	void end_async_compute( Context& gctx, Frame& frame, vk::PipelineStageFlags2 graphics_wait_stage_mask );
+
+
+	// vkDeviceWaitIdle needs every queue, so the submission thread is drained first. callers must not submit concurrently
+	AZHAL_INLINE void wait_idle( Context& gctx )
+	{
+		wait_for_submission_thread_idle();
+
+		const vk::Result res_device_wait_idle = gctx.device.waitIdle();
+		vk::resultCheck( res_device_wait_idle, "failed to wait for device idle" );
+	}
+
+
+	// waits for the device, then destroys everything queued for deferred destruction
+	AZHAL_INLINE void flush_deferred_destructions( Context& gctx )
+	{
+		wait_idle( gctx );
+		flush_deferred_destructions( gctx.device );
+	}
+
+
+	AZHAL_INLINE const Swapchain& get_swapchain( const Context& gctx )
+	{
+		return gctx.swapchain;
+	}
+
+
+	// false when compute shares the graphics queue family, async compute then still works but serializes with graphics
+	AZHAL_INLINE Bool is_async_compute_available( const Context& gctx )
+	{
+		return ( gctx.queues.compute.familyIndex != gctx.queues.graphics.familyIndex );
+	}
+
+
+	// fast paths check is_device_feature_enabled on this
+	AZHAL_INLINE const DeviceCapabilities& get_device_capabilities( const Context& gctx )
+	{
+		return gctx.capabilities;
+	}
+
+
+	// may be called from several threads at once
+	AZHAL_INLINE PSOHandle create_pso( Context& gctx, const PSOCreationParams& pso_creation_params )
+	{
+		return register_pso( create_pso( gctx.device, pso_creation_params ), pso_creation_params );
+	}
+
 
-	AZHAL_INLINE void recreate_swapchain( Context& gctx, const vk::Extent2D& new_extent )
+	AZHAL_INLINE PSOHandle create_compute_pso( Context& gctx, const ComputePSOCreationParams& compute_pso_creation_params )
 	{
-		gctx.swapchain = recreate_swapchain( gctx.physicalDevice, gctx.device, gctx.surface, new_extent, gctx.swapchain );
+		return register_pso( create_compute_pso( gctx.device, compute_pso_creation_params ), compute_pso_creation_params );
 	}
 
+
+	// the handle is stale right away, the objects are destroyed once the frames that may still reference them have retired
+	AZHAL_INLINE void destroy_pso( Context& gctx, PSOHandle pso_handle )
+	{
+		PSO pso = unregister_pso( pso_handle );
+		defer_destroy_pso( pso );
+	}
+
+
+	AZHAL_INLINE vk::PipelineCache create_pipeline_cache( Context& gctx, const ByteBufferDynamic& initial_data )
+	{
+		return create_pipeline_cache( gctx.device, initial_data );
+	}
+
+
+	AZHAL_INLINE void destroy_pipeline_cache( Context& gctx, vk::PipelineCache pipeline_cache )
+	{
+		destroy_pipeline_cache( gctx.device, pipeline_cache );
+	}
+
+
+	AZHAL_INLINE ByteBufferDynamic get_pipeline_cache_data( Context& gctx, vk::PipelineCache pipeline_cache )
+	{
+		return get_pipeline_cache_data( gctx.device, pipeline_cache );
+	}
+
+
+	// resolve the handle with get_buffer, once per recording loop like psos
+	AZHAL_INLINE BufferHandle create_buffer( Context& gctx, const BufferCreationParams& buffer_creation_params )
+	{
+		const std::array<Uint32, 2> shared_queue_families { gctx.queues.graphics.familyIndex, gctx.queues.compute.familyIndex };
+		const Bool is_concurrent = buffer_creation_params.isSharedWithAsyncCompute && is_async_compute_available( gctx );
+
+		return register_buffer( create_buffer( gctx.capabilities, gctx.device, buffer_creation_params,
+			is_concurrent ? std::span<const Uint32>( shared_queue_families ) : std::span<const Uint32>() ) );
+	}
+
+
+	// the handle is stale right away, the buffer is destroyed once the frames that may still reference it have retired
+	AZHAL_INLINE void destroy_buffer( Context& gctx, BufferHandle buffer_handle )
+	{
+		Buffer buffer = unregister_buffer( buffer_handle );
+		defer_destroy_buffer( buffer );
+	}
+
+
+	// skipped for a stale handle
+	AZHAL_INLINE void record_buffer_upload( Context& gctx, vk::CommandBuffer cmd_buffer, BufferHandle dst_buffer_handle, vk::DeviceSize dst_offset, const void* p_data, vk::DeviceSize size )
+	{
+		const Buffer dst_buffer = get_buffer( dst_buffer_handle );
+		if( !dst_buffer.vkBuffer )
+		{
+			return;
+		}
+
+		record_buffer_upload( gctx.capabilities, gctx.device, cmd_buffer, dst_buffer, dst_offset, p_data, size );
+	}
+
+
+	AZHAL_INLINE ImageHandle create_image( Context& gctx, const ImageCreationParams& image_creation_params )
+	{
+		return register_image( create_image( gctx.capabilities, gctx.device, image_creation_params ) );
+	}
+
+
+	// the handle is stale right away, the image is destroyed once the frames that may still reference it have retired
+	AZHAL_INLINE void destroy_image( Context& gctx, ImageHandle image_handle )
+	{
+		Image image = unregister_image( image_handle );
+		defer_destroy_image( image );
+	}
+
+
+	AZHAL_INLINE MeshHandle create_mesh( Context& gctx, vk::CommandBuffer cmd_buffer, const PackedMesh& packed_mesh, Bool is_pulled = false )
+	{
+		return register_mesh( create_mesh( gctx.capabilities, gctx.device, cmd_buffer, packed_mesh, is_pulled ) );
+	}
+
+
+	// the handle is stale right away, the buffers are destroyed once the frames that may still reference them have retired
+	AZHAL_INLINE void destroy_mesh( Context& gctx, MeshHandle mesh_handle )
+	{
+		Mesh mesh = unregister_mesh( mesh_handle );
+		defer_destroy_buffer( mesh.vertexBuffer );
+		defer_destroy_buffer( mesh.indexBuffer );
+	}
+
+
+	AZHAL_INLINE GeometryPool create_geometry_pool( Context& gctx, const GeometryPoolCreationParams& geometry_pool_creation_params )
+	{
+		return create_geometry_pool( gctx.capabilities, gctx.device, geometry_pool_creation_params );
+	}
+
+
+	// destroyed once the frames that may still reference it have retired
+	AZHAL_INLINE void destroy_geometry_pool( Context& gctx, GeometryPool& geometry_pool )
+	{
+		defer_destroy_buffer( geometry_pool.vertexBuffer );
+		defer_destroy_buffer( geometry_pool.indexBuffer );
+		geometry_pool = {};
+	}
+
+
+	AZHAL_INLINE GeometryHandle add_pool_mesh( Context& gctx, vk::CommandBuffer cmd_buffer, GeometryPool& geometry_pool, const PackedMesh& packed_mesh )
+	{
+		return add_pool_mesh( gctx.capabilities, gctx.device, cmd_buffer, geometry_pool, packed_mesh );
+	}
+
+
+	AZHAL_INLINE void compact_geometry_pool( Context& gctx, vk::CommandBuffer cmd_buffer, GeometryPool& geometry_pool )
+	{
+		compact_geometry_pool( gctx.capabilities, gctx.device, cmd_buffer, geometry_pool );
+	}
+
+
+	AZHAL_INLINE vk::Format get_texture_vk_format( const Context& gctx, TextureFormat format )
+	{
+		return get_texture_vk_format( gctx.capabilities, format );
+	}
+
+
+	AZHAL_INLINE TextureHandle add_streamed_texture( Context& gctx, TextureStreamer& texture_streamer, TextureData texture_data )
+	{
+		return add_streamed_texture( gctx.capabilities, texture_streamer, std::move( texture_data ) );
+	}
+
+
+	AZHAL_INLINE TextureStreamingStats update_texture_streaming( Context& gctx, vk::CommandBuffer cmd_buffer, TextureStreamer& texture_streamer )
+	{
+		return update_texture_streaming( gctx.capabilities, gctx.device, cmd_buffer, texture_streamer );
+	}
+
+
+	AZHAL_INLINE Image create_pooled_image( Context& gctx, ImageMemoryPool& image_memory_pool, const ImageCreationParams& image_creation_params, ImageMemoryRange& out_range )
+	{
+		return create_pooled_image( gctx.capabilities, gctx.device, image_memory_pool, image_creation_params, out_range );
+	}
+
+
+	// the blocks are freed once the frames that may still sample their images have retired
+	AZHAL_INLINE void destroy_image_memory_pool( Context& gctx, ImageMemoryPool& image_memory_pool )
+	{
+		for( const ImageMemoryBlock& block : image_memory_pool.blocks )
+		{
+			defer_free_memory( block.memory );
+		}
+		image_memory_pool.blocks.clear();
+		image_memory_pool.pendingFrees.clear();
+	}
+
+
+	// every image is destroyed once the frames that may still sample it have retired
+	AZHAL_INLINE void destroy_texture_streamer( Context& gctx, TextureStreamer& texture_streamer )
+	{
+		for( StreamedTexture& texture : texture_streamer.textures.GetDense<0>() )
+		{
+			destroy_pooled_image( texture_streamer.imageMemoryPool, texture.image, texture.imageMemoryRange );
+		}
+		destroy_image_memory_pool( gctx, texture_streamer.imageMemoryPool );
+		texture_streamer = {};
+	}
+
+
+	// a set for descriptor set 0 of the compute pso, bind it with bind_pso_descriptor_set
+	AZHAL_INLINE DescriptorSet create_pso_descriptor_set( Context& gctx, PSOHandle pso_handle, const DescriptorSetWrites& descriptor_set_writes )
+	{
+		return create_descriptor_set( gctx.device, get_pso( pso_handle ).descriptorSetLayout, descriptor_set_writes );
+	}
+
+
+	// destroyed once the frames that may still reference it have retired
+	AZHAL_INLINE void destroy_descriptor_set( Context& gctx, DescriptorSet& descriptor_set )
+	{
+		defer_destroy_descriptor_pool( descriptor_set.pool );
+		descriptor_set = {};
+	}
+
+
+	AZHAL_INLINE vk::CommandBuffer allocate_command_buffer( Context& gctx, QueueType queue_type, vk::CommandBufferLevel cmd_buffer_level = vk::CommandBufferLevel::ePrimary )
+	{
+		return allocate_command_buffer( gctx.device, queue_type, cmd_buffer_level );
+	}
+
+
+	// freed once the frames that may still execute it have retired
+	AZHAL_INLINE void free_command_buffer( Context& gctx, QueueType queue_type, vk::CommandBuffer cmd_buffer )
+	{
+		defer_free_command_buffer( queue_type, cmd_buffer );
+	}
+
+
+	// returns false and keeps the current swapchain while the surface has no area
+	AZHAL_INLINE Bool recreate_swapchain( Context& gctx, const vk::Extent2D& new_extent )
+	{
+		if( is_surface_extent_empty( gctx.physicalDevice, gctx.surface ) )
+		{
+			return false;
+		}
+
+		Swapchain new_swapchain = recreate_swapchain( gctx.physicalDevice, gctx.device, gctx.surface, new_extent, gctx.swapchain );
+		retire_swapchain( gctx.swapchain );
+		gctx.swapchain = std::move( new_swapchain );
+
+		return true;
+	}
+
+
+	// queued on the submission thread, returns the value the queue's timeline semaphore reaches once the work completed
+	AZHAL_INLINE Uint64 submit( Context& gctx, QueueType queue_type, const SubmitParams& submit_params )
+	{
+		return enqueue_submit( queue_type, submit_params );
+	}
+
+
+	// queued on the submission thread, returns the value to pass to wait_for_submission_thread.
+	// out-of-date results are picked up by the next begin_frame
+	AZHAL_INLINE Uint64 present( Context& gctx, Uint32 image_index, vk::Semaphore wait_semaphore, Uint64 present_id = 0 )
+	{
+		const PresentParams present_params
+		{
+			.swapchain = gctx.swapchain.vkSwapchain,
+			.imageIndex = image_index,
+			.waitSemaphore = wait_semaphore,
+			.presentId = present_id
+		};
+		return enqueue_present( present_params );
+	}
+
+
+	AZHAL_INLINE Bool wait_for_queue_timeline( Context& gctx, QueueType queue_type, Uint64 value, Uint64 timeout_ns = UINT64_MAX )
+	{
+		return wait_for_queue_timeline( gctx.device, queue_type, value, timeout_ns );
+	}
+
+
+	// timestamps are written from the graphics queue unless another family is given
+	AZHAL_INLINE GpuTimer create_gpu_timer( Context& gctx, GpuTimerCreationParams gpu_timer_creation_params )
+	{
+		if( gpu_timer_creation_params.queueFamilyIndex == UINT32_MAX )
+		{
+			gpu_timer_creation_params.queueFamilyIndex = gctx.queues.graphics.familyIndex;
+		}
+		return create_gpu_timer( gctx.physicalDevice, gctx.device, gpu_timer_creation_params );
+	}
+
+
+	AZHAL_INLINE void destroy_gpu_timer( Context& gctx, GpuTimer& gpu_timer )
+	{
+		destroy_gpu_timer( gctx.device, gpu_timer );
+	}
+
+
+	AZHAL_INLINE void gpu_timer_begin_frame( Context& gctx, GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer, Uint64 frame_index )
+	{
+		gpu_timer_begin_frame( gctx.device, gpu_timer, cmd_buffer, frame_index );
+	}
+
+
+	AZHAL_INLINE void gpu_timer_collect_pending( Context& gctx, GpuTimer& gpu_timer )
+	{
+		gpu_timer_collect_pending( gctx.device, gpu_timer );
+	}
+
+
+	AZHAL_INLINE GpuQueries create_gpu_queries( Context& gctx, const GpuQueriesCreationParams& gpu_queries_creation_params )
+	{
+		return create_gpu_queries( gctx.capabilities, gctx.device, gpu_queries_creation_params );
+	}
+
+
+	AZHAL_INLINE void destroy_gpu_queries( Context& gctx, GpuQueries& gpu_queries )
+	{
+		destroy_gpu_queries( gctx.device, gpu_queries );
+	}
+
+
+	AZHAL_INLINE void gpu_queries_begin_frame( Context& gctx, GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer, Uint64 frame_index )
+	{
+		gpu_queries_begin_frame( gctx.device, gpu_queries, cmd_buffer, frame_index );
+	}
 }
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "azpch.h"
+#include "geometry_pool.h"
+
+#include "deferred_destruction.h"
+#include "frame.h"
+#include "vulkan_sync_utils.h"
+
+namespace
+{
+	vk::DeviceSize get_index_size( vk::IndexType index_type )
+	{
+		return ( index_type == vk::IndexType::eUint16 ) ? sizeof( Uint16 ) : sizeof( Uint32 );
+	}
+
+
+	gdevice::Buffer create_pool_buffer( const gdevice::DeviceCapabilities& device_capabilities, const vk::Device device, vk::DeviceSize size,
+		vk::BufferUsageFlags usage, Bool is_pulled )
+	{
+		const gdevice::BufferCreationParams buffer_creation_params
+		{
+			.size = size,
+			// transfer source for the copies into the buffers of a reallocated pool
+			.usage = usage | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | gdevice::get_pulled_geometry_usage( is_pulled )
+		};
+		return gdevice::create_buffer( device_capabilities, device, buffer_creation_params, {} );
+	}
+
+
+	void release_retired_geometry( gdevice::GeometryPool& geometry_pool )
+	{
+		const Uint64 current_frame_index = gdevice::get_current_frame_index();
+		std::erase_if( geometry_pool.pendingFrees, [&geometry_pool, current_frame_index]( const gdevice::PendingGeometryFree& pending_free )
+		{
+			if( current_frame_index < pending_free.frameIndex + gdevice::MAX_FRAMES_IN_FLIGHT )
+			{
+				return false;
+			}
+
+			geometry_pool.vertexRanges.Free( pending_free.vertexOffset );
+			geometry_pool.indexRanges.Free( pending_free.indexOffset );
+			return true;
+		} );
+	}
+
+
+	// moves sorted by srcOffset
+	Uint64 find_moved_offset( const std::vector<RangeMove>& moves, Uint64 src_offset )
+	{
+		const auto it_move = std::ranges::lower_bound( moves, src_offset, {}, &RangeMove::srcOffset );
+		AZHAL_ASSERT( it_move != moves.end() && it_move->srcOffset == src_offset, "pool mesh without a range" );
+		return it_move->dstOffset;
+	}
+
+
+	void record_range_copies( vk::CommandBuffer cmd_buffer, const gdevice::Buffer& src_buffer, const gdevice::Buffer& dst_buffer,
+		const std::vector<RangeMove>& moves, vk::DeviceSize element_size )
+	{
+		std::vector<vk::BufferCopy> buffer_copies;
+		buffer_copies.reserve( moves.size() );
+		for( const RangeMove& move : moves )
+		{
+			buffer_copies.push_back( vk::BufferCopy
+			{
+				.srcOffset = move.srcOffset * element_size,
+				.dstOffset = move.dstOffset * element_size,
+				.size = move.size * element_size
+			} );
+		}
+
+		if( !buffer_copies.empty() )
+		{
+			cmd_buffer.copyBuffer( src_buffer.vkBuffer, dst_buffer.vkBuffer, buffer_copies );
+		}
+	}
+
+
+	// the new buffers hold every live mesh packed to the front, removed meshes are dropped right away since in-flight
+	// frames keep reading them from the old buffers
+	void reallocate_geometry_pool( const gdevice::DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		gdevice::GeometryPool& geometry_pool, Uint64 vertex_capacity, Uint64 index_capacity )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		for( const gdevice::PendingGeometryFree& pending_free : geometry_pool.pendingFrees )
+		{
+			geometry_pool.vertexRanges.Free( pending_free.vertexOffset );
+			geometry_pool.indexRanges.Free( pending_free.indexOffset );
+		}
+		geometry_pool.pendingFrees.clear();
+
+		const std::vector<RangeMove> vertex_moves = geometry_pool.vertexRanges.Compact();
+		const std::vector<RangeMove> index_moves = geometry_pool.indexRanges.Compact();
+		geometry_pool.vertexRanges.Grow( vertex_capacity );
+		geometry_pool.indexRanges.Grow( index_capacity );
+
+		const vk::DeviceSize index_size = get_index_size( geometry_pool.indexType );
+		gdevice::Buffer vertex_buffer = create_pool_buffer( device_capabilities, device, geometry_pool.vertexRanges.GetCapacity() * sizeof( PackedMeshVertex ),
+			vk::BufferUsageFlagBits::eVertexBuffer, geometry_pool.isPulled );
+		gdevice::Buffer index_buffer = create_pool_buffer( device_capabilities, device, geometry_pool.indexRanges.GetCapacity() * index_size,
+			vk::BufferUsageFlagBits::eIndexBuffer, geometry_pool.isPulled );
+
+		// uploads recorded earlier into the same command buffer
+		gdevice::insert_memory_barrier( cmd_buffer,
+			vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+			vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead );
+
+		record_range_copies( cmd_buffer, geometry_pool.vertexBuffer, vertex_buffer, vertex_moves, sizeof( PackedMeshVertex ) );
+		record_range_copies( cmd_buffer, geometry_pool.indexBuffer, index_buffer, index_moves, index_size );
+		gdevice::insert_geometry_upload_barrier( cmd_buffer, geometry_pool.isPulled );
+
+		for( gdevice::Mesh& mesh : geometry_pool.meshes.GetDense<0>() )
+		{
+			mesh.vertexOffset = static_cast< Int32 >( find_moved_offset( vertex_moves, static_cast< Uint64 >( mesh.vertexOffset ) ) );
+			mesh.firstIndex = static_cast< Uint32 >( find_moved_offset( index_moves, mesh.firstIndex ) );
+			mesh.vertexBuffer = vertex_buffer;
+			mesh.indexBuffer = index_buffer;
+		}
+
+		gdevice::defer_destroy_buffer( geometry_pool.vertexBuffer );
+		gdevice::defer_destroy_buffer( geometry_pool.indexBuffer );
+		geometry_pool.vertexBuffer = vertex_buffer;
+		geometry_pool.indexBuffer = index_buffer;
+	}
+}
+
+namespace gdevice
+{
+	GeometryPool create_geometry_pool( const DeviceCapabilities& device_capabilities, const vk::Device device, const GeometryPoolCreationParams& geometry_pool_creation_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_ASSERT( geometry_pool_creation_params.vertexCapacity > 0 && geometry_pool_creation_params.indexCapacity > 0, "geometry pools cannot be empty" );
+
+		GeometryPool geometry_pool
+		{
+			.indexType = geometry_pool_creation_params.indexType,
+			.isPulled = geometry_pool_creation_params.isPulled,
+			.vertexRanges = RangeAllocator( geometry_pool_creation_params.vertexCapacity ),
+			.indexRanges = RangeAllocator( geometry_pool_creation_params.indexCapacity )
+		};
+
+		geometry_pool.vertexBuffer = create_pool_buffer( device_capabilities, device, geometry_pool_creation_params.vertexCapacity * sizeof( PackedMeshVertex ),
+			vk::BufferUsageFlagBits::eVertexBuffer, geometry_pool.isPulled );
+		geometry_pool.indexBuffer = create_pool_buffer( device_capabilities, device, geometry_pool_creation_params.indexCapacity * get_index_size( geometry_pool.indexType ),
+			vk::BufferUsageFlagBits::eIndexBuffer, geometry_pool.isPulled );
+
+		return geometry_pool;
+	}
+
+
+	void destroy_geometry_pool( const vk::Device device, GeometryPool& geometry_pool )
+	{
+		destroy_buffer( device, geometry_pool.vertexBuffer );
+		destroy_buffer( device, geometry_pool.indexBuffer );
+		geometry_pool = {};
+	}
+
+
+	GeometryHandle add_pool_mesh( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		GeometryPool& geometry_pool, const PackedMesh& packed_mesh )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_ASSERT( !packed_mesh.vertices.empty() && !packed_mesh.indices.empty(), "meshes without triangles cannot be drawn" );
+
+		// the indices would be truncated by the 16-bit copy below
+		if( geometry_pool.indexType == vk::IndexType::eUint16 && packed_mesh.vertices.size() > 0x10000 )
+		{
+			AZHAL_LOG_ERROR( "a mesh of {0} vertices does not fit the 16-bit indices of the geometry pool", packed_mesh.vertices.size() );
+			return {};
+		}
+
+		release_retired_geometry( geometry_pool );
+
+		const Uint64 vertex_count = packed_mesh.vertices.size();
+		const Uint64 index_count = packed_mesh.indices.size();
+		Uint64 vertex_offset = geometry_pool.vertexRanges.Allocate( vertex_count );
+		Uint64 index_offset = geometry_pool.indexRanges.Allocate( index_count );
+
+		if( vertex_offset == RangeAllocator::K_INVALID_OFFSET || index_offset == RangeAllocator::K_INVALID_OFFSET )
+		{
+			if( vertex_offset != RangeAllocator::K_INVALID_OFFSET )
+			{
+				geometry_pool.vertexRanges.Free( vertex_offset );
+			}
+			if( index_offset != RangeAllocator::K_INVALID_OFFSET )
+			{
+				geometry_pool.indexRanges.Free( index_offset );
+			}
+
+			// doubling keeps the number of reallocations logarithmic in the final size
+			const Uint64 vertex_capacity = std::max( geometry_pool.vertexRanges.GetCapacity() * 2, geometry_pool.vertexRanges.GetUsedSize() + vertex_count );
+			const Uint64 index_capacity = std::max( geometry_pool.indexRanges.GetCapacity() * 2, geometry_pool.indexRanges.GetUsedSize() + index_count );
+			AZHAL_LOG_INFO( "growing geometry pool to {0} vertices and {1} indices", vertex_capacity, index_capacity );
+			reallocate_geometry_pool( device_capabilities, device, cmd_buffer, geometry_pool, vertex_capacity, index_capacity );
+
+			vertex_offset = geometry_pool.vertexRanges.Allocate( vertex_count );
+			index_offset = geometry_pool.indexRanges.Allocate( index_count );
+		}
+		AZHAL_FATAL_ASSERT( vertex_offset != RangeAllocator::K_INVALID_OFFSET && index_offset != RangeAllocator::K_INVALID_OFFSET, "geometry pool allocation failed" );
+
+		std::vector<Uint16> indices_16;
+		const void* p_index_data = packed_mesh.indices.data();
+		if( geometry_pool.indexType == vk::IndexType::eUint16 )
+		{
+			indices_16.assign( packed_mesh.indices.begin(), packed_mesh.indices.end() );
+			p_index_data = indices_16.data();
+		}
+
+		const vk::DeviceSize index_size = get_index_size( geometry_pool.indexType );
+		record_buffer_upload( device_capabilities, device, cmd_buffer, geometry_pool.vertexBuffer, vertex_offset * sizeof( PackedMeshVertex ),
+			packed_mesh.vertices.data(), vertex_count * sizeof( PackedMeshVertex ) );
+		record_buffer_upload( device_capabilities, device, cmd_buffer, geometry_pool.indexBuffer, index_offset * index_size, p_index_data, index_count * index_size );
+		insert_geometry_upload_barrier( cmd_buffer, geometry_pool.isPulled );
+
+		return geometry_pool.meshes.Create( Mesh
+		{
+			.vertexBuffer = geometry_pool.vertexBuffer,
+			.indexBuffer = geometry_pool.indexBuffer,
+			.indexType = geometry_pool.indexType,
+			.vertexCount = static_cast< Uint32 >( vertex_count ),
+			.indexCount = static_cast< Uint32 >( index_count ),
+			.vertexOffset = static_cast< Int32 >( vertex_offset ),
+			.firstIndex = static_cast< Uint32 >( index_offset ),
+			.boundsCenter = packed_mesh.boundsCenter,
+			.boundsExtent = packed_mesh.boundsExtent
+		} );
+	}
+
+
+	void remove_pool_mesh( GeometryPool& geometry_pool, GeometryHandle geometry_handle )
+	{
+		AZHAL_ASSERT( is_valid_pool_mesh( geometry_pool, geometry_handle ), "removing through a stale or null geometry handle" );
+		if( !is_valid_pool_mesh( geometry_pool, geometry_handle ) )
+		{
+			return;
+		}
+
+		const Mesh& mesh = geometry_pool.meshes.Get<0>( geometry_handle );
+		geometry_pool.pendingFrees.push_back( PendingGeometryFree
+		{
+			.frameIndex = get_current_frame_index(),
+			.vertexOffset = static_cast< Uint64 >( mesh.vertexOffset ),
+			.indexOffset = mesh.firstIndex
+		} );
+
+		geometry_pool.meshes.Destroy( geometry_handle );
+	}
+
+
+	void compact_geometry_pool( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer, GeometryPool& geometry_pool )
+	{
+		reallocate_geometry_pool( device_capabilities, device, cmd_buffer, geometry_pool, geometry_pool.vertexRanges.GetCapacity(), geometry_pool.indexRanges.GetCapacity() );
+	}
+
+
+	GeometryPoolStats get_geometry_pool_stats( const GeometryPool& geometry_pool )
+	{
+		return GeometryPoolStats
+		{
+			.meshCount = geometry_pool.meshes.GetCount(),
+			.vertexCapacity = geometry_pool.vertexRanges.GetCapacity(),
+			.usedVertices = geometry_pool.vertexRanges.GetUsedSize(),
+			.indexCapacity = geometry_pool.indexRanges.GetCapacity(),
+			.usedIndices = geometry_pool.indexRanges.GetUsedSize(),
+			.vertexFragmentation = geometry_pool.vertexRanges.GetFragmentation(),
+			.indexFragmentation = geometry_pool.indexRanges.GetFragmentation(),
+			.pendingFreeCount = static_cast< Uint32 >( geometry_pool.pendingFrees.size() )
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "mesh.h"
+
+namespace gdevice
+{
+	struct DeviceCapabilities;
+
+	struct GeometryTag;
+	using GeometryHandle = Handle<GeometryTag>;
+
+	struct GeometryPoolCreationParams
+	{
+		// in vertices and indices. a pool that runs out is reallocated larger, which copies every mesh it holds
+		Uint32 vertexCapacity = 1 << 20;
+		Uint32 indexCapacity = 1 << 22;
+		// indices are relative to the mesh's vertexOffset, so 16-bit indices only limit each mesh to 65536 vertices
+		vk::IndexType indexType = vk::IndexType::eUint32;
+		// storage buffer use and device addresses, see create_mesh
+		Bool isPulled = false;
+	};
+
+	// ranges of a removed mesh, in-flight frames may still draw from them
+	struct PendingGeometryFree
+	{
+		Uint64 frameIndex = 0;
+		Uint64 vertexOffset = 0;
+		Uint64 indexOffset = 0;
+	};
+
+	struct GeometryPoolStats
+	{
+		Uint32 meshCount = 0;
+		Uint64 vertexCapacity = 0;
+		Uint64 usedVertices = 0;
+		Uint64 indexCapacity = 0;
+		Uint64 usedIndices = 0;
+		// see RangeAllocator::GetFragmentation, compact_geometry_pool brings them back to 0
+		Float vertexFragmentation = 0.0f;
+		Float indexFragmentation = 0.0f;
+		Uint32 pendingFreeCount = 0;
+	};
+
+	// the meshes of a pool share one vertex and one index buffer and are told apart by their vertexOffset and firstIndex,
+	// so a pass binds the pool once and every draw_mesh, or indexed indirect draw, of its meshes reuses the binding
+	struct GeometryPool
+	{
+		Buffer vertexBuffer;
+		Buffer indexBuffer;
+		vk::IndexType indexType = vk::IndexType::eUint32;
+		Bool isPulled = false;
+
+		// in vertices and indices
+		RangeAllocator vertexRanges;
+		RangeAllocator indexRanges;
+
+		HandlePool<GeometryTag, Mesh> meshes;
+		// reusable once the frame they were removed in retired
+		std::vector<PendingGeometryFree> pendingFrees;
+	};
+
+	GeometryPool create_geometry_pool( const DeviceCapabilities& device_capabilities, const vk::Device device, const GeometryPoolCreationParams& geometry_pool_creation_params );
+	// destroys immediately, at runtime use the Context overload which defers until the gpu is done with it
+	void destroy_geometry_pool( const vk::Device device, GeometryPool& geometry_pool );
+
+	// records the upload and the barrier that makes it visible into cmd_buffer, like create_mesh. a pool without the
+	// space is reallocated larger and compacted in the same command buffer. returns a null handle for a mesh of more
+	// than 65536 vertices in a pool of 16-bit indices
+	GeometryHandle add_pool_mesh( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		GeometryPool& geometry_pool, const PackedMesh& packed_mesh );
+	// the handle is stale right away, the ranges are reused once the frames that may still draw them have retired
+	void remove_pool_mesh( GeometryPool& geometry_pool, GeometryHandle geometry_handle );
+
+	// moves every mesh into new buffers without gaps between them and records the copies into cmd_buffer. the old
+	// buffers are destroyed once the frames that may still read them have retired
+	void compact_geometry_pool( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer, GeometryPool& geometry_pool );
+
+	AZHAL_INLINE Bool is_valid_pool_mesh( const GeometryPool& geometry_pool, GeometryHandle geometry_handle )
+	{
+		return geometry_pool.meshes.IsValid( geometry_handle );
+	}
+
+	// the mesh at its current place in the pool, for bind_mesh, draw_mesh and RenderItem::pMesh. the reference stays
+	// valid until the next add_pool_mesh or remove_pool_mesh, its offsets change with compaction. not to be passed to
+	// destroy_mesh
+	AZHAL_INLINE const Mesh& get_pool_mesh( const GeometryPool& geometry_pool, GeometryHandle geometry_handle )
+	{
+		return geometry_pool.meshes.Get<0>( geometry_handle );
+	}
+
+	GeometryPoolStats get_geometry_pool_stats( const GeometryPool& geometry_pool );
+}
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "azpch.h"
+#include "gpu_queries.h"
+
+#include "device_capabilities.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr vk::QueryPipelineStatisticFlags K_PIPELINE_STATISTIC_FLAGS =
+		vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+		vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+		vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+		vk::QueryPipelineStatisticFlagBits::eClippingInvocations |
+		vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+		vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+		vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+
+	// one value per enabled statistic followed by the availability value
+	constexpr Uint32 K_PIPELINE_STATISTIC_VALUE_COUNT = 7;
+	constexpr Uint32 K_PIPELINE_STATISTIC_STRIDE = K_PIPELINE_STATISTIC_VALUE_COUNT + 1;
+	AZHAL_STATIC_ASSERT( sizeof( gdevice::PipelineStatistics ) == sizeof( Uint64 ) * K_PIPELINE_STATISTIC_VALUE_COUNT, "PipelineStatistics must match the enabled statistic flags" );
+
+	// reads a query pool without waiting, returns false if the read failed
+	Bool read_query_pool( const vk::Device device, vk::QueryPool query_pool, Uint32 query_count, Uint32 stride_in_values, std::vector<Uint64>& out_values )
+	{
+		out_values.resize( static_cast< size_t >( query_count ) * stride_in_values );
+
+		const vk::Result res_query_results = device.getQueryPoolResults( query_pool, 0, query_count,
+			out_values.size() * sizeof( Uint64 ), out_values.data(), sizeof( Uint64 ) * stride_in_values,
+			vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability );
+
+		if( res_query_results != vk::Result::eSuccess && res_query_results != vk::Result::eNotReady )
+		{
+			AZHAL_LOG_WARN( "failed to read back gpu queries: {0}", vk::to_string( res_query_results ) );
+			return false;
+		}
+		return true;
+	}
+
+
+	void collect_frame_results( const vk::Device device, gdevice::GpuQueries& gpu_queries, const gdevice::GpuQueriesFrame& frame )
+	{
+		// results are rewritten in place, their capacity is reserved up front so collecting never allocates. a frame
+		// without scopes still clears them, the results of an older frame would otherwise pass for this one's
+		std::vector<gdevice::GpuQueryScopeResult>& frame_results = gpu_queries.results;
+		frame_results.clear();
+		if( frame.records.empty() )
+		{
+			return;
+		}
+
+		for( const gdevice::GpuQueryScopeRecord& record : frame.records )
+		{
+			frame_results.push_back( gdevice::GpuQueryScopeResult { .pName = record.pName, .queryTypes = gdevice::eGpuQueryTypeNone, .frameIndex = frame.frameIndex } );
+		}
+
+		if( frame.pipelineStatisticsQueryCount > 0 &&
+			read_query_pool( device, frame.pipelineStatisticsPool, frame.pipelineStatisticsQueryCount, K_PIPELINE_STATISTIC_STRIDE, gpu_queries.resultsScratch ) )
+		{
+			for( size_t i = 0; i < frame.records.size(); ++i )
+			{
+				const Uint32 query = frame.records[ i ].pipelineStatisticsQuery;
+				if( query == UINT32_MAX )
+				{
+					continue;
+				}
+
+				const Uint64* p_values = &gpu_queries.resultsScratch[ static_cast< size_t >( query ) * K_PIPELINE_STATISTIC_STRIDE ];
+				if( p_values[ K_PIPELINE_STATISTIC_VALUE_COUNT ] != 0 )
+				{
+					std::memcpy( &frame_results[ i ].pipelineStatistics, p_values, sizeof( gdevice::PipelineStatistics ) );
+					frame_results[ i ].queryTypes |= gdevice::eGpuQueryTypePipelineStatistics;
+				}
+			}
+		}
+
+		if( frame.occlusionQueryCount > 0 &&
+			read_query_pool( device, frame.occlusionPool, frame.occlusionQueryCount, 2, gpu_queries.resultsScratch ) )
+		{
+			for( size_t i = 0; i < frame.records.size(); ++i )
+			{
+				const Uint32 query = frame.records[ i ].occlusionQuery;
+				if( query != UINT32_MAX && gpu_queries.resultsScratch[ static_cast< size_t >( query ) * 2 + 1 ] != 0 )
+				{
+					frame_results[ i ].samplesPassed = gpu_queries.resultsScratch[ static_cast< size_t >( query ) * 2 ];
+					frame_results[ i ].queryTypes |= gdevice::eGpuQueryTypeOcclusion;
+				}
+			}
+		}
+	}
+}
+
+namespace gdevice
+{
+	GpuQueries create_gpu_queries( const DeviceCapabilities& device_capabilities, const vk::Device device, const GpuQueriesCreationParams& gpu_queries_creation_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		GpuQueries gpu_queries;
+		gpu_queries.maxScopesPerFrame = gpu_queries_creation_params.maxScopesPerFrame;
+		gpu_queries.isPipelineStatisticsSupported = is_device_feature_enabled( device_capabilities, eDeviceFeaturePipelineStatisticsQuery );
+		gpu_queries.isOcclusionPrecise = is_device_feature_enabled( device_capabilities, eDeviceFeatureOcclusionQueryPrecise );
+
+		if( !gpu_queries.isPipelineStatisticsSupported )
+		{
+			AZHAL_LOG_WARN( "pipelineStatisticsQuery is not enabled, only occlusion queries will be recorded" );
+		}
+
+		const vk::QueryPoolCreateInfo pipeline_statistics_pool_create_info
+		{
+			.queryType = vk::QueryType::ePipelineStatistics,
+			.queryCount = gpu_queries.maxScopesPerFrame,
+			.pipelineStatistics = K_PIPELINE_STATISTIC_FLAGS
+		};
+		const vk::QueryPoolCreateInfo occlusion_pool_create_info
+		{
+			.queryType = vk::QueryType::eOcclusion,
+			.queryCount = gpu_queries.maxScopesPerFrame
+		};
+
+		gpu_queries.frames.resize( gpu_queries_creation_params.framesInFlight );
+		for( GpuQueriesFrame& frame : gpu_queries.frames )
+		{
+			if( gpu_queries.isPipelineStatisticsSupported )
+			{
+				const vk::ResultValue rv_pipeline_statistics_pool = device.createQueryPool( pipeline_statistics_pool_create_info );
+				frame.pipelineStatisticsPool = get_vk_result( rv_pipeline_statistics_pool, "failed to create pipeline statistics query pool" );
+			}
+
+			const vk::ResultValue rv_occlusion_pool = device.createQueryPool( occlusion_pool_create_info );
+			frame.occlusionPool = get_vk_result( rv_occlusion_pool, "failed to create occlusion query pool" );
+
+			frame.records.reserve( gpu_queries.maxScopesPerFrame );
+		}
+
+		gpu_queries.results.reserve( gpu_queries.maxScopesPerFrame );
+		gpu_queries.resultsScratch.reserve( static_cast< size_t >( gpu_queries.maxScopesPerFrame ) * K_PIPELINE_STATISTIC_STRIDE );
+
+		return gpu_queries;
+	}
+
+
+	void destroy_gpu_queries( const vk::Device device, GpuQueries& gpu_queries )
+	{
+		for( GpuQueriesFrame& frame : gpu_queries.frames )
+		{
+			device.destroy( frame.pipelineStatisticsPool );
+			device.destroy( frame.occlusionPool );
+		}
+		gpu_queries.frames.clear();
+	}
+
+
+	void gpu_queries_begin_frame( const vk::Device device, GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer, Uint64 frame_index )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_ASSERT( gpu_queries.activeScope == UINT32_MAX, "a gpu query scope was left open in the previous frame" );
+
+		gpu_queries.currentFrame = static_cast< Uint32 >( frame_index % gpu_queries.frames.size() );
+		GpuQueriesFrame& frame = gpu_queries.frames[ gpu_queries.currentFrame ];
+
+		collect_frame_results( device, gpu_queries, frame );
+
+		if( frame.pipelineStatisticsPool )
+		{
+			cmd_buffer.resetQueryPool( frame.pipelineStatisticsPool, 0, gpu_queries.maxScopesPerFrame );
+		}
+		cmd_buffer.resetQueryPool( frame.occlusionPool, 0, gpu_queries.maxScopesPerFrame );
+
+		frame.records.clear();
+		frame.pipelineStatisticsQueryCount = 0;
+		frame.occlusionQueryCount = 0;
+		frame.frameIndex = frame_index;
+	}
+
+
+	void gpu_queries_begin_scope( GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer, const AnsiChar* name, Uint32 query_types )
+	{
+		AZHAL_ASSERT( gpu_queries.currentFrame != UINT32_MAX, "gpu_queries_begin_frame must be called before opening scopes" );
+		AZHAL_ASSERT( gpu_queries.activeScope == UINT32_MAX, "gpu query scopes cannot be nested" );
+
+		GpuQueriesFrame& frame = gpu_queries.frames[ gpu_queries.currentFrame ];
+		if( frame.records.size() >= gpu_queries.maxScopesPerFrame )
+		{
+			AZHAL_LOG_WARN( "gpu queries ran out of scopes, scope {0} is not measured", name );
+			return;
+		}
+
+		GpuQueryScopeRecord record
+		{
+			.pName = name,
+			.queryTypes = query_types
+		};
+
+		if( ( query_types & eGpuQueryTypePipelineStatistics ) && gpu_queries.isPipelineStatisticsSupported )
+		{
+			record.pipelineStatisticsQuery = frame.pipelineStatisticsQueryCount++;
+			cmd_buffer.beginQuery( frame.pipelineStatisticsPool, record.pipelineStatisticsQuery, {} );
+		}
+
+		if( query_types & eGpuQueryTypeOcclusion )
+		{
+			record.occlusionQuery = frame.occlusionQueryCount++;
+			const vk::QueryControlFlags occlusion_control_flags = gpu_queries.isOcclusionPrecise ? vk::QueryControlFlagBits::ePrecise : vk::QueryControlFlags {};
+			cmd_buffer.beginQuery( frame.occlusionPool, record.occlusionQuery, occlusion_control_flags );
+		}
+
+		gpu_queries.activeScope = VK_SIZE_CAST( frame.records.size() );
+		frame.records.push_back( record );
+	}
+
+
+	void gpu_queries_end_scope( GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer )
+	{
+		if( gpu_queries.activeScope == UINT32_MAX )
+		{
+			// the scope was dropped because the frame ran out of queries
+			return;
+		}
+
+		const GpuQueriesFrame& frame = gpu_queries.frames[ gpu_queries.currentFrame ];
+		const GpuQueryScopeRecord& record = frame.records[ gpu_queries.activeScope ];
+
+		if( record.pipelineStatisticsQuery != UINT32_MAX )
+		{
+			cmd_buffer.endQuery( frame.pipelineStatisticsPool, record.pipelineStatisticsQuery );
+		}
+		if( record.occlusionQuery != UINT32_MAX )
+		{
+			cmd_buffer.endQuery( frame.occlusionPool, record.occlusionQuery );
+		}
+
+		gpu_queries.activeScope = UINT32_MAX;
+	}
+
+
+	void log_gpu_query_results( const GpuQueries& gpu_queries )
+	{
+		for( const GpuQueryScopeResult& result : gpu_queries.results )
+		{
+			if( result.queryTypes & eGpuQueryTypePipelineStatistics )
+			{
+				const PipelineStatistics& stats = result.pipelineStatistics;
+				// values above 1 mean post-transform vertex reuse is poor or the mesh is not indexed
+				const Double vs_invocations_per_primitive = stats.inputAssemblyPrimitives ?
+					static_cast< Double >( stats.vertexShaderInvocations ) / static_cast< Double >( stats.inputAssemblyPrimitives ) : 0.0;
+				const Double fs_invocations_per_vs_invocation = stats.vertexShaderInvocations ?
+					static_cast< Double >( stats.fragmentShaderInvocations ) / static_cast< Double >( stats.vertexShaderInvocations ) : 0.0;
+
+				AZHAL_LOG_INFO( "[gpu_queries] {0} (frame {1}): ia verts {2}, ia prims {3}, vs {4}, clip in {5}, clip out {6}, fs {7}, cs {8} | vs/prim {9:.2f}, fs/vs {10:.2f}",
+					result.pName, result.frameIndex, stats.inputAssemblyVertices, stats.inputAssemblyPrimitives, stats.vertexShaderInvocations,
+					stats.clippingInvocations, stats.clippingPrimitives, stats.fragmentShaderInvocations, stats.computeShaderInvocations,
+					vs_invocations_per_primitive, fs_invocations_per_vs_invocation );
+			}
+
+			if( result.queryTypes & eGpuQueryTypeOcclusion )
+			{
+				// fragment invocations per passing sample approximates the overdraw of the scope
+				const Bool has_both = ( result.queryTypes & eGpuQueryTypePipelineStatistics ) && result.samplesPassed > 0;
+				const Double overdraw = has_both ?
+					static_cast< Double >( result.pipelineStatistics.fragmentShaderInvocations ) / static_cast< Double >( result.samplesPassed ) : 0.0;
+
+				AZHAL_LOG_INFO( "[gpu_queries] {0} (frame {1}): samples passed {2}{3} | overdraw {4:.2f}",
+					result.pName, result.frameIndex, result.samplesPassed, gpu_queries.isOcclusionPrecise ? "" : " (imprecise)", overdraw );
+			}
+		}
+	}
+}
\ No newline at end of file
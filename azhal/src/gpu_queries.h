@@ -0,0 +1,120 @@
+#pragma once
+
+namespace gdevice
+{
+	enum GpuQueryTypeBits : Uint32
+	{
+		eGpuQueryTypeNone = 0x00000000,
+		eGpuQueryTypePipelineStatistics = 0x00000001,
+		eGpuQueryTypeOcclusion = 0x00000002,
+		eGpuQueryTypeAll = ( eGpuQueryTypePipelineStatistics | eGpuQueryTypeOcclusion )
+	};
+
+	// field order matches the order vulkan writes the enabled statistic bits in
+	struct PipelineStatistics
+	{
+		Uint64 inputAssemblyVertices = 0;
+		Uint64 inputAssemblyPrimitives = 0;
+		Uint64 vertexShaderInvocations = 0;
+		Uint64 clippingInvocations = 0;
+		Uint64 clippingPrimitives = 0;
+		Uint64 fragmentShaderInvocations = 0;
+		Uint64 computeShaderInvocations = 0;
+	};
+
+	struct GpuQueryScopeResult
+	{
+		// scope names are expected to be string literals, the same pointer the scope was recorded with
+		const AnsiChar* pName = nullptr;
+		Uint32 queryTypes = eGpuQueryTypeNone;
+		Uint64 frameIndex = 0;
+
+		PipelineStatistics pipelineStatistics;
+		// without occlusionQueryPrecise this is only guaranteed to be non-zero when any sample passed
+		Uint64 samplesPassed = 0;
+	};
+
+	struct GpuQueriesCreationParams
+	{
+		Uint32 framesInFlight = 2;
+		Uint32 maxScopesPerFrame = 64;
+	};
+
+	struct GpuQueryScopeRecord
+	{
+		const AnsiChar* pName = nullptr;
+		Uint32 queryTypes = eGpuQueryTypeNone;
+		Uint32 pipelineStatisticsQuery = UINT32_MAX;
+		Uint32 occlusionQuery = UINT32_MAX;
+	};
+
+	struct GpuQueriesFrame
+	{
+		vk::QueryPool pipelineStatisticsPool;
+		vk::QueryPool occlusionPool;
+		std::vector<GpuQueryScopeRecord> records;
+		Uint32 pipelineStatisticsQueryCount = 0;
+		Uint32 occlusionQueryCount = 0;
+		Uint64 frameIndex = 0;
+	};
+
+	struct GpuQueries
+	{
+		std::vector<GpuQueriesFrame> frames;
+		Uint32 currentFrame = UINT32_MAX;
+		Uint32 maxScopesPerFrame = 0;
+
+		Bool isPipelineStatisticsSupported = false;
+		Bool isOcclusionPrecise = false;
+
+		// queries of the same type cannot be active at the same time, scopes therefore do not nest
+		Uint32 activeScope = UINT32_MAX;
+
+		// results of the most recently collected frame
+		std::vector<GpuQueryScopeResult> results;
+		std::vector<Uint64> resultsScratch;
+	};
+
+	struct DeviceCapabilities;
+
+	GpuQueries create_gpu_queries( const DeviceCapabilities& device_capabilities, const vk::Device device, const GpuQueriesCreationParams& gpu_queries_creation_params );
+	void destroy_gpu_queries( const vk::Device device, GpuQueries& gpu_queries );
+
+	// same contract as gpu_timer_begin_frame: the frame previously recorded into frame_index's slot must have retired
+	void gpu_queries_begin_frame( const vk::Device device, GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer, Uint64 frame_index );
+
+	// query_types is a mask of GpuQueryTypeBits, pipeline statistics are skipped on devices without the feature
+	void gpu_queries_begin_scope( GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer, const AnsiChar* name, Uint32 query_types );
+	void gpu_queries_end_scope( GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer );
+
+	AZHAL_INLINE const std::vector<GpuQueryScopeResult>& get_gpu_query_results( const GpuQueries& gpu_queries )
+	{
+		return gpu_queries.results;
+	}
+
+	// logs the raw counters together with overdraw and vertex reuse ratios
+	void log_gpu_query_results( const GpuQueries& gpu_queries );
+
+
+	class ScopedGpuQuery : NonCopyable
+	{
+	public:
+		ScopedGpuQuery( GpuQueries& gpu_queries, vk::CommandBuffer cmd_buffer, const AnsiChar* name, Uint32 query_types )
+			: m_gpuQueries( gpu_queries )
+			, m_cmdBuffer( cmd_buffer )
+		{
+			gpu_queries_begin_scope( m_gpuQueries, m_cmdBuffer, name, query_types );
+		}
+
+		~ScopedGpuQuery()
+		{
+			gpu_queries_end_scope( m_gpuQueries, m_cmdBuffer );
+		}
+
+	private:
+		GpuQueries& m_gpuQueries;
+		vk::CommandBuffer m_cmdBuffer;
+	};
+}
+
+#define AZHAL_GPU_QUERY_SCOPE(gpu_queries, cmd_buffer, name, query_types) gdevice::ScopedGpuQuery AZHAL_CONCAT( gpu_query_scope_, __LINE__ )( gpu_queries, cmd_buffer, name, query_types )
\ No newline at end of file
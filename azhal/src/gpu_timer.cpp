@@ -0,0 +1,403 @@
+#include "azpch.h"
+#include "gpu_timer.h"
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+	AZHAL_INLINE Uint64 make_scope_key( Uint32 parent_index, const AnsiChar* name )
+	{
+		const Uint64 name_hash = std::hash<std::string_view>{}( std::string_view( name ) );
+		return ( name_hash ^ ( static_cast< Uint64 >( parent_index ) + 0x9e3779b97f4a7c15ull + ( name_hash << 6 ) + ( name_hash >> 2 ) ) );
+	}
+
+
+	AZHAL_INLINE Bool is_same_scope( const gdevice::GpuTimerScopeStats& stats, Uint32 parent_index, const AnsiChar* name )
+	{
+		return ( stats.parentIndex == parent_index ) && ( stats.name == name );
+	}
+
+
+	void record_scope_sample( gdevice::GpuTimerScopeStats& stats, Double sample_ms )
+	{
+		const Bool is_window_full = ( stats.sampleCount >= stats.history.size() );
+		const Double evicted_ms = is_window_full ? stats.history[ stats.historyHead ] : 0.0;
+
+		stats.lastMs = sample_ms;
+		stats.history[ stats.historyHead ] = sample_ms;
+		stats.historyHead = ( stats.historyHead + 1 ) % VK_SIZE_CAST( stats.history.size() );
+		stats.sampleCount++;
+
+		const Uint64 window_size = std::min<Uint64>( stats.sampleCount, stats.history.size() );
+
+		// the window is only rescanned when the evicted sample may have been its min or max, and once per wrap so that
+		// the rounding error of the running sum does not accumulate
+		const Bool is_rescan_needed = ( stats.historyHead == 0 ) || ( is_window_full && ( evicted_ms <= stats.minMs || evicted_ms >= stats.maxMs ) );
+		if( is_rescan_needed )
+		{
+			Double sum = 0.0;
+			Double min_ms = std::numeric_limits<Double>::max();
+			Double max_ms = 0.0;
+			for( Uint64 i = 0; i < window_size; ++i )
+			{
+				const Double value = stats.history[ i ];
+				sum += value;
+				min_ms = std::min( min_ms, value );
+				max_ms = std::max( max_ms, value );
+			}
+
+			stats.historySum = sum;
+			stats.minMs = min_ms;
+			stats.maxMs = max_ms;
+		}
+		else
+		{
+			stats.historySum += sample_ms - evicted_ms;
+			stats.minMs = ( window_size == 1 ) ? sample_ms : std::min( stats.minMs, sample_ms );
+			stats.maxMs = ( window_size == 1 ) ? sample_ms : std::max( stats.maxMs, sample_ms );
+		}
+
+		stats.averageMs = stats.historySum / static_cast< Double >( window_size );
+	}
+
+
+	// reads back a retired frame without blocking, scopes whose queries are not available yet are dropped
+	void collect_frame_results( const vk::Device device, gdevice::GpuTimer& gpu_timer, gdevice::GpuTimerFrame& frame )
+	{
+		if( frame.queryCount == 0 )
+		{
+			return;
+		}
+
+		// each query is followed by its availability value
+		gpu_timer.resultsScratch.resize( static_cast< size_t >( frame.queryCount ) * 2 );
+
+		const vk::Result res_query_results = device.getQueryPoolResults( frame.queryPool, 0, frame.queryCount,
+			gpu_timer.resultsScratch.size() * sizeof( Uint64 ), gpu_timer.resultsScratch.data(), sizeof( Uint64 ) * 2,
+			vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability );
+
+		if( res_query_results != vk::Result::eSuccess && res_query_results != vk::Result::eNotReady )
+		{
+			AZHAL_LOG_WARN( "failed to read back gpu timer queries: {0}", vk::to_string( res_query_results ) );
+			return;
+		}
+
+		for( const gdevice::GpuTimerScopeRecord& record : frame.records )
+		{
+			const Uint64 begin_available = gpu_timer.resultsScratch[ record.beginQuery * 2 + 1 ];
+			const Uint64 end_available = gpu_timer.resultsScratch[ record.endQuery * 2 + 1 ];
+			if( !begin_available || !end_available )
+			{
+				continue;
+			}
+
+			const Uint64 begin_ticks = gpu_timer.resultsScratch[ record.beginQuery * 2 ] & gpu_timer.timestampMask;
+			const Uint64 end_ticks = gpu_timer.resultsScratch[ record.endQuery * 2 ] & gpu_timer.timestampMask;
+			const Uint64 elapsed_ticks = ( end_ticks - begin_ticks ) & gpu_timer.timestampMask;
+
+			const Double elapsed_ms = static_cast< Double >( elapsed_ticks ) * gpu_timer.timestampPeriodNs * 1e-6;
+			record_scope_sample( gpu_timer.scopeStats[ record.statsIndex ], elapsed_ms );
+		}
+	}
+
+
+	String build_scope_path( const gdevice::GpuTimer& gpu_timer, Uint32 stats_index )
+	{
+		String path = gpu_timer.scopeStats[ stats_index ].name;
+		Uint32 parent_index = gpu_timer.scopeStats[ stats_index ].parentIndex;
+		while( parent_index != UINT32_MAX )
+		{
+			path = gpu_timer.scopeStats[ parent_index ].name + "/" + path;
+			parent_index = gpu_timer.scopeStats[ parent_index ].parentIndex;
+		}
+		return path;
+	}
+
+
+	String escape_json_string( const String& text )
+	{
+		String escaped;
+		escaped.reserve( text.size() );
+		for( const AnsiChar c : text )
+		{
+			switch( c )
+			{
+			case '"':
+				escaped += "\\\"";
+				break;
+			case '\\':
+				escaped += "\\\\";
+				break;
+			case '\n':
+				escaped += "\\n";
+				break;
+			case '\r':
+				escaped += "\\r";
+				break;
+			case '\t':
+				escaped += "\\t";
+				break;
+			default:
+				if( static_cast< unsigned char >( c ) < 0x20 )
+				{
+					AnsiChar code_point[ 8 ];
+					std::snprintf( code_point, sizeof( code_point ), "\\u%04x", static_cast< Uint32 >( c ) );
+					escaped += code_point;
+				}
+				else
+				{
+					escaped += c;
+				}
+				break;
+			}
+		}
+		return escaped;
+	}
+
+
+	// RFC 4180: a field holding a separator, quote or line break is enclosed in quotes, with its quotes doubled
+	String quote_csv_field( const String& text )
+	{
+		if( text.find_first_of( ",\"\r\n" ) == String::npos )
+		{
+			return text;
+		}
+
+		String quoted = "\"";
+		quoted.reserve( text.size() + 2 );
+		for( const AnsiChar c : text )
+		{
+			quoted += c;
+			if( c == '"' )
+			{
+				quoted += '"';
+			}
+		}
+		quoted += '"';
+		return quoted;
+	}
+}
+
+namespace gdevice
+{
+	GpuTimer create_gpu_timer( const vk::PhysicalDevice physical_device, const vk::Device device, const GpuTimerCreationParams& gpu_timer_creation_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::PhysicalDeviceProperties device_props = physical_device.getProperties();
+		const std::vector<vk::QueueFamilyProperties> queue_family_props = physical_device.getQueueFamilyProperties();
+
+		AZHAL_FATAL_ASSERT( gpu_timer_creation_params.queueFamilyIndex < queue_family_props.size(), "invalid queue family index for gpu timer" );
+		const Uint32 timestamp_valid_bits = queue_family_props[ gpu_timer_creation_params.queueFamilyIndex ].timestampValidBits;
+		AZHAL_FATAL_ASSERT( timestamp_valid_bits > 0, "queue family does not support timestamp queries" );
+
+		GpuTimer gpu_timer;
+		gpu_timer.maxQueriesPerFrame = gpu_timer_creation_params.maxScopesPerFrame * 2;
+		gpu_timer.historyLength = std::max<Uint32>( gpu_timer_creation_params.historyLength, 1 );
+		gpu_timer.timestampPeriodNs = static_cast< Double >( device_props.limits.timestampPeriod );
+		gpu_timer.timestampMask = ( timestamp_valid_bits >= 64 ) ? UINT64_MAX : ( ( 1ull << timestamp_valid_bits ) - 1 );
+		gpu_timer.scopeStack.reserve( gpu_timer_creation_params.maxScopesPerFrame );
+		gpu_timer.scopeStats.reserve( gpu_timer_creation_params.maxScopesPerFrame );
+		gpu_timer.resultsScratch.reserve( static_cast< size_t >( gpu_timer.maxQueriesPerFrame ) * 2 );
+
+		const vk::QueryPoolCreateInfo query_pool_create_info
+		{
+			.queryType = vk::QueryType::eTimestamp,
+			.queryCount = gpu_timer.maxQueriesPerFrame
+		};
+
+		gpu_timer.frames.resize( gpu_timer_creation_params.framesInFlight );
+		for( GpuTimerFrame& frame : gpu_timer.frames )
+		{
+			const vk::ResultValue rv_query_pool = device.createQueryPool( query_pool_create_info );
+			frame.queryPool = get_vk_result( rv_query_pool, "failed to create timestamp query pool" );
+			frame.records.reserve( gpu_timer_creation_params.maxScopesPerFrame );
+		}
+
+		return gpu_timer;
+	}
+
+
+	void destroy_gpu_timer( const vk::Device device, GpuTimer& gpu_timer )
+	{
+		for( GpuTimerFrame& frame : gpu_timer.frames )
+		{
+			device.destroy( frame.queryPool );
+		}
+		gpu_timer.frames.clear();
+	}
+
+
+	void gpu_timer_begin_frame( const vk::Device device, GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer, Uint64 frame_index )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_ASSERT( gpu_timer.scopeStack.empty(), "gpu timer scopes were not closed in the previous frame" );
+
+		gpu_timer.currentFrame = static_cast< Uint32 >( frame_index % gpu_timer.frames.size() );
+		GpuTimerFrame& frame = gpu_timer.frames[ gpu_timer.currentFrame ];
+
+		collect_frame_results( device, gpu_timer, frame );
+
+		cmd_buffer.resetQueryPool( frame.queryPool, 0, gpu_timer.maxQueriesPerFrame );
+		frame.records.clear();
+		frame.queryCount = 0;
+	}
+
+
+	void gpu_timer_end_frame( GpuTimer& gpu_timer )
+	{
+		AZHAL_ASSERT( gpu_timer.scopeStack.empty(), "unbalanced gpu timer scopes at the end of the frame" );
+		gpu_timer.scopeStack.clear();
+	}
+
+
+	void gpu_timer_collect_pending( const vk::Device device, GpuTimer& gpu_timer )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		if( gpu_timer.currentFrame == UINT32_MAX )
+		{
+			return;
+		}
+
+		// the slot after the current one was recorded longest ago
+		const Uint32 frame_count = VK_SIZE_CAST( gpu_timer.frames.size() );
+		for( Uint32 i = 1; i <= frame_count; ++i )
+		{
+			GpuTimerFrame& frame = gpu_timer.frames[ ( gpu_timer.currentFrame + i ) % frame_count ];
+			collect_frame_results( device, gpu_timer, frame );
+			// the next gpu_timer_begin_frame of the slot must not count them again
+			frame.records.clear();
+			frame.queryCount = 0;
+		}
+	}
+
+
+	void gpu_timer_push_scope( GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer, const AnsiChar* name )
+	{
+		AZHAL_ASSERT( gpu_timer.currentFrame != UINT32_MAX, "gpu_timer_begin_frame must be called before pushing scopes" );
+		GpuTimerFrame& frame = gpu_timer.frames[ gpu_timer.currentFrame ];
+
+		// children of an untimed scope stay untimed, their stats would have no parent to hang off
+		const Bool is_parent_untimed = !gpu_timer.scopeStack.empty() && ( gpu_timer.scopeStack.back() == UINT32_MAX );
+		const Bool is_out_of_queries = ( frame.queryCount + 2 > gpu_timer.maxQueriesPerFrame );
+		if( is_parent_untimed || is_out_of_queries )
+		{
+			if( is_out_of_queries && !gpu_timer.isOutOfQueriesReported )
+			{
+				AZHAL_LOG_WARN( "gpu timer ran out of queries at scope {0}, it and every later scope of a full frame are not timed. raise maxScopesPerFrame", name );
+				gpu_timer.isOutOfQueriesReported = true;
+			}
+			// keep push/pop balanced by pushing a record without queries
+			gpu_timer.scopeStack.push_back( UINT32_MAX );
+			return;
+		}
+
+		const Uint32 parent_index = gpu_timer.scopeStack.empty() ? UINT32_MAX : frame.records[ gpu_timer.scopeStack.back() ].statsIndex;
+
+		// the key is only a hash, a different scope that hashes alike moves on to the next key
+		Uint64 scope_key = make_scope_key( parent_index, name );
+		auto iter = gpu_timer.scopeLookup.find( scope_key );
+		while( iter != gpu_timer.scopeLookup.end() && !is_same_scope( gpu_timer.scopeStats[ iter->second ], parent_index, name ) )
+		{
+			iter = gpu_timer.scopeLookup.find( ++scope_key );
+		}
+		if( iter == gpu_timer.scopeLookup.end() )
+		{
+			GpuTimerScopeStats scope_stats
+			{
+				.name = name,
+				.depth = VK_SIZE_CAST( gpu_timer.scopeStack.size() ),
+				.parentIndex = parent_index,
+				.history = std::vector<Double>( gpu_timer.historyLength, 0.0 )
+			};
+			gpu_timer.scopeStats.push_back( std::move( scope_stats ) );
+			iter = gpu_timer.scopeLookup.emplace( scope_key, VK_SIZE_CAST( gpu_timer.scopeStats.size() - 1 ) ).first;
+		}
+
+		const GpuTimerScopeRecord record
+		{
+			.statsIndex = iter->second,
+			.beginQuery = frame.queryCount,
+			.endQuery = frame.queryCount + 1
+		};
+		frame.queryCount += 2;
+
+		cmd_buffer.writeTimestamp( vk::PipelineStageFlagBits::eTopOfPipe, frame.queryPool, record.beginQuery );
+
+		gpu_timer.scopeStack.push_back( VK_SIZE_CAST( frame.records.size() ) );
+		frame.records.push_back( record );
+	}
+
+
+	void gpu_timer_pop_scope( GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer )
+	{
+		AZHAL_ASSERT( !gpu_timer.scopeStack.empty(), "gpu_timer_pop_scope called without a matching push" );
+
+		const Uint32 record_index = gpu_timer.scopeStack.back();
+		gpu_timer.scopeStack.pop_back();
+
+		if( record_index == UINT32_MAX )
+		{
+			return;
+		}
+
+		const GpuTimerFrame& frame = gpu_timer.frames[ gpu_timer.currentFrame ];
+		cmd_buffer.writeTimestamp( vk::PipelineStageFlagBits::eBottomOfPipe, frame.queryPool, frame.records[ record_index ].endQuery );
+	}
+
+
+	void log_gpu_timer_stats( const GpuTimer& gpu_timer )
+	{
+		for( const GpuTimerScopeStats& stats : gpu_timer.scopeStats )
+		{
+			AZHAL_LOG_INFO( "[gpu_timer] {0:>{1}}{2}: avg {3:.3f} ms, min {4:.3f} ms, max {5:.3f} ms", "", stats.depth * 2, stats.name, stats.averageMs, stats.minMs, stats.maxMs );
+		}
+	}
+
+
+	Bool write_gpu_timer_stats_csv( const GpuTimer& gpu_timer, const AnsiChar* file_path )
+	{
+		std::ofstream file_stream( file_path );
+		if( !file_stream.is_open() )
+		{
+			AZHAL_LOG_ERROR( "failed to open {0} for writing gpu timer stats", file_path );
+			return false;
+		}
+
+		file_stream << "scope,depth,samples,last_ms,avg_ms,min_ms,max_ms\n";
+		for( Uint32 i = 0; i < gpu_timer.scopeStats.size(); ++i )
+		{
+			const GpuTimerScopeStats& stats = gpu_timer.scopeStats[ i ];
+			file_stream << quote_csv_field( build_scope_path( gpu_timer, i ) ) << ',' << stats.depth << ',' << stats.sampleCount << ','
+				<< stats.lastMs << ',' << stats.averageMs << ',' << stats.minMs << ',' << stats.maxMs << '\n';
+		}
+
+		return true;
+	}
+
+
+	Bool write_gpu_timer_stats_json( const GpuTimer& gpu_timer, const AnsiChar* file_path )
+	{
+		std::ofstream file_stream( file_path );
+		if( !file_stream.is_open() )
+		{
+			AZHAL_LOG_ERROR( "failed to open {0} for writing gpu timer stats", file_path );
+			return false;
+		}
+
+		file_stream << "{\n  \"scopes\": [\n";
+		for( Uint32 i = 0; i < gpu_timer.scopeStats.size(); ++i )
+		{
+			const GpuTimerScopeStats& stats = gpu_timer.scopeStats[ i ];
+			file_stream << "    { \"path\": \"" << escape_json_string( build_scope_path( gpu_timer, i ) ) << "\", \"depth\": " << stats.depth
+				<< ", \"samples\": " << stats.sampleCount << ", \"last_ms\": " << stats.lastMs << ", \"avg_ms\": " << stats.averageMs
+				<< ", \"min_ms\": " << stats.minMs << ", \"max_ms\": " << stats.maxMs << " }"
+				<< ( ( i + 1 < gpu_timer.scopeStats.size() ) ? ",\n" : "\n" );
+		}
+		file_stream << "  ]\n}\n";
+
+		return true;
+	}
+}
\ No newline at end of file
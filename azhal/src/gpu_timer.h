@@ -0,0 +1,112 @@
+#pragma once
+
+#include <unordered_map>
+
+namespace gdevice
+{
+	struct GpuTimerCreationParams
+	{
+		Uint32 framesInFlight = 2;
+		Uint32 maxScopesPerFrame = 64;
+		// number of frames the rolling statistics are computed over
+		Uint32 historyLength = 128;
+		Uint32 queueFamilyIndex = UINT32_MAX;
+	};
+
+	struct GpuTimerScopeStats
+	{
+		String name;
+		Uint32 depth = 0;
+		Uint32 parentIndex = UINT32_MAX;
+
+		Double lastMs = 0.0;
+		Double averageMs = 0.0;
+		Double minMs = 0.0;
+		Double maxMs = 0.0;
+		Uint64 sampleCount = 0;
+
+		// ring buffer of the last historyLength samples
+		std::vector<Double> history;
+		Uint32 historyHead = 0;
+		Double historySum = 0.0;
+	};
+
+	struct GpuTimerScopeRecord
+	{
+		Uint32 statsIndex = UINT32_MAX;
+		Uint32 beginQuery = 0;
+		Uint32 endQuery = 0;
+	};
+
+	struct GpuTimerFrame
+	{
+		vk::QueryPool queryPool;
+		std::vector<GpuTimerScopeRecord> records;
+		Uint32 queryCount = 0;
+	};
+
+	struct GpuTimer
+	{
+		std::vector<GpuTimerFrame> frames;
+		Uint32 currentFrame = UINT32_MAX;
+		Uint32 maxQueriesPerFrame = 0;
+		Uint32 historyLength = 0;
+
+		Double timestampPeriodNs = 1.0;
+		Uint64 timestampMask = UINT64_MAX;
+
+		std::vector<Uint32> scopeStack;
+		std::vector<GpuTimerScopeStats> scopeStats;
+		// hash of (parent scope, name) -> index into scopeStats, a scope whose hash is taken uses the next free key
+		std::unordered_map<Uint64, Uint32> scopeLookup;
+		std::vector<Uint64> resultsScratch;
+		// running out of queries is only reported once, it would otherwise repeat every frame
+		Bool isOutOfQueriesReported = false;
+	};
+
+	GpuTimer create_gpu_timer( const vk::PhysicalDevice physical_device, const vk::Device device, const GpuTimerCreationParams& gpu_timer_creation_params );
+	void destroy_gpu_timer( const vk::Device device, GpuTimer& gpu_timer );
+
+	// the caller must guarantee that the frame previously recorded into frame_index's slot has retired,
+	// its results are then collected without waiting and the slot's queries are reset on cmd_buffer
+	void gpu_timer_begin_frame( const vk::Device device, GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer, Uint64 frame_index );
+	void gpu_timer_end_frame( GpuTimer& gpu_timer );
+	// the device has to be idle. collects every frame gpu_timer_begin_frame has not read back yet, oldest first, so that
+	// the last frames of a run get their samples too
+	void gpu_timer_collect_pending( const vk::Device device, GpuTimer& gpu_timer );
+
+	void gpu_timer_push_scope( GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer, const AnsiChar* name );
+	void gpu_timer_pop_scope( GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer );
+
+	AZHAL_INLINE const std::vector<GpuTimerScopeStats>& get_gpu_timer_stats( const GpuTimer& gpu_timer )
+	{
+		return gpu_timer.scopeStats;
+	}
+
+	void log_gpu_timer_stats( const GpuTimer& gpu_timer );
+	Bool write_gpu_timer_stats_csv( const GpuTimer& gpu_timer, const AnsiChar* file_path );
+	Bool write_gpu_timer_stats_json( const GpuTimer& gpu_timer, const AnsiChar* file_path );
+
+
+	class ScopedGpuTimer : NonCopyable
+	{
+	public:
+		ScopedGpuTimer( GpuTimer& gpu_timer, vk::CommandBuffer cmd_buffer, const AnsiChar* name )
+			: m_gpuTimer( gpu_timer )
+			, m_cmdBuffer( cmd_buffer )
+		{
+			gpu_timer_push_scope( m_gpuTimer, m_cmdBuffer, name );
+		}
+
+		~ScopedGpuTimer()
+		{
+			gpu_timer_pop_scope( m_gpuTimer, m_cmdBuffer );
+		}
+
+	private:
+		GpuTimer& m_gpuTimer;
+		vk::CommandBuffer m_cmdBuffer;
+	};
+}
+
+#define AZHAL_GPU_TIMER_SCOPE(gpu_timer, cmd_buffer, name) gdevice::ScopedGpuTimer AZHAL_CONCAT( gpu_timer_scope_, __LINE__ )( gpu_timer, cmd_buffer, name )
\ No newline at end of file
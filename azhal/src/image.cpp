@@ -0,0 +1,245 @@
+#include "azpch.h"
+#include "image.h"
+
+#include "device_capabilities.h"
+#include "resource_pool.h"
+#include "staging.h"
+
+namespace
+{
+	gdevice::ResourcePool<gdevice::ImageTag, gdevice::Image> s_imagePool( "image", 64 );
+}
+
+namespace
+{
+	constexpr vk::DeviceSize K_IMAGE_UPLOAD_ALIGNMENT = 16;
+
+
+	vk::ImageCreateInfo get_image_create_info( const gdevice::ImageCreationParams& image_creation_params )
+	{
+		AZHAL_FATAL_ASSERT( image_creation_params.extent.width > 0 && image_creation_params.extent.height > 0, "images must not be empty" );
+		AZHAL_FATAL_ASSERT( image_creation_params.mipLevels > 0 && image_creation_params.mipLevels <= gdevice::get_full_mip_count( image_creation_params.extent ), "invalid mip count" );
+		AZHAL_FATAL_ASSERT( !image_creation_params.hasMipViews || image_creation_params.mipLevels <= gdevice::K_MAX_IMAGE_MIP_VIEWS, "too many mips for mip views" );
+
+		return vk::ImageCreateInfo
+		{
+			.imageType = vk::ImageType::e2D,
+			.format = image_creation_params.format,
+			.extent = { image_creation_params.extent.width, image_creation_params.extent.height, 1 },
+			.mipLevels = image_creation_params.mipLevels,
+			.arrayLayers = 1,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = image_creation_params.usage,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+	}
+
+
+	vk::ImageView create_image_view( const vk::Device device, const gdevice::Image& image, Uint32 base_mip_level, Uint32 mip_count )
+	{
+		const vk::ImageViewCreateInfo image_view_create_info
+		{
+			.image = image.vkImage,
+			.viewType = vk::ImageViewType::e2D,
+			.format = image.format,
+			.subresourceRange =
+			{
+				.aspectMask = image.aspectMask,
+				.baseMipLevel = base_mip_level,
+				.levelCount = mip_count,
+				.baseArrayLayer = 0,
+				.layerCount = 1
+			}
+		};
+		const vk::ResultValue rv_image_view = device.createImageView( image_view_create_info );
+		return get_vk_result( rv_image_view, "failed to create image view" );
+	}
+
+
+	// the image has to be bound to its memory already
+	gdevice::Image finish_image( const vk::Device device, const vk::Image vk_image, const vk::DeviceMemory memory, const gdevice::ImageCreationParams& image_creation_params )
+	{
+		gdevice::Image image
+		{
+			.vkImage = vk_image,
+			.memory = memory,
+			.format = image_creation_params.format,
+			.extent = image_creation_params.extent,
+			.mipLevels = image_creation_params.mipLevels,
+			.aspectMask = gdevice::get_format_aspect_mask( image_creation_params.format )
+		};
+
+		image.view = create_image_view( device, image, 0, image.mipLevels );
+		if( image_creation_params.hasMipViews )
+		{
+			for( Uint32 mip = 0; mip < image.mipLevels; ++mip )
+			{
+				image.mipViews[ mip ] = create_image_view( device, image, mip, 1 );
+			}
+		}
+
+		return image;
+	}
+}
+
+namespace gdevice
+{
+	Image create_image( const DeviceCapabilities& device_capabilities, const vk::Device device, const ImageCreationParams& image_creation_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::ImageCreateInfo image_create_info = get_image_create_info( image_creation_params );
+		const vk::ResultValue rv_image = device.createImage( image_create_info );
+		const vk::Image vk_image = get_vk_result( rv_image, "failed to create image" );
+
+		const vk::MemoryRequirements memory_requirements = device.getImageMemoryRequirements( vk_image );
+		const Uint32 memory_type_index = find_memory_type_index( device_capabilities.memoryProperties, memory_requirements.memoryTypeBits,
+			vk::MemoryPropertyFlagBits::eDeviceLocal, {} );
+		if( memory_type_index == UINT32_MAX )
+		{
+			device.destroy( vk_image );
+			throw GDeviceException( "no memory type fits the image" );
+		}
+
+		const vk::MemoryAllocateInfo memory_allocate_info
+		{
+			.allocationSize = memory_requirements.size,
+			.memoryTypeIndex = memory_type_index
+		};
+		const vk::ResultValue rv_memory = device.allocateMemory( memory_allocate_info );
+		const vk::DeviceMemory memory = get_vk_result( rv_memory, "failed to allocate image memory" );
+
+		const vk::Result res_bind = device.bindImageMemory( vk_image, memory, 0 );
+		vk::resultCheck( res_bind, "failed to bind image memory" );
+
+		return finish_image( device, vk_image, memory, image_creation_params );
+	}
+
+
+	Image create_image( const vk::Device device, const ImageCreationParams& image_creation_params, vk::DeviceMemory memory, vk::DeviceSize memory_offset )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::ImageCreateInfo image_create_info = get_image_create_info( image_creation_params );
+		const vk::ResultValue rv_image = device.createImage( image_create_info );
+		const vk::Image vk_image = get_vk_result( rv_image, "failed to create image" );
+
+		const vk::Result res_bind = device.bindImageMemory( vk_image, memory, memory_offset );
+		vk::resultCheck( res_bind, "failed to bind image memory" );
+
+		return finish_image( device, vk_image, VK_NULL_HANDLE, image_creation_params );
+	}
+
+
+	void destroy_image( const vk::Device device, Image& image )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		for( const vk::ImageView mip_view : image.mipViews )
+		{
+			device.destroy( mip_view );
+		}
+		device.destroy( image.view );
+		device.destroy( image.vkImage );
+		device.free( image.memory );
+		image = {};
+	}
+
+
+	ImageHandle register_image( const Image& image )
+	{
+		return s_imagePool.Register( image );
+	}
+
+
+	Image unregister_image( ImageHandle image_handle )
+	{
+		return s_imagePool.Unregister( image_handle );
+	}
+
+
+	Image get_image( ImageHandle image_handle )
+	{
+		return s_imagePool.Get( image_handle );
+	}
+
+
+	Bool is_image_valid( ImageHandle image_handle )
+	{
+		return s_imagePool.IsValid( image_handle );
+	}
+
+
+	void destroy_image_pool( const vk::Device device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		s_imagePool.DestroyAll( [device]( Image& image ) { destroy_image( device, image ); } );
+	}
+
+
+	vk::MemoryRequirements get_image_memory_requirements( const vk::Device device, const ImageCreationParams& image_creation_params )
+	{
+		// core in vulkan 1.3 through maintenance4
+		const vk::ImageCreateInfo image_create_info = get_image_create_info( image_creation_params );
+		const vk::DeviceImageMemoryRequirements device_image_memory_requirements
+		{
+			.pCreateInfo = &image_create_info
+		};
+		return device.getImageMemoryRequirements( device_image_memory_requirements ).memoryRequirements;
+	}
+
+
+	void record_image_upload( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		const Image& dst_image, Uint32 mip_level, const void* p_data, vk::DeviceSize size )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_FATAL_ASSERT( mip_level < dst_image.mipLevels, "upload into a mip the image does not have" );
+
+		// the offset has to be a multiple of the texel block size, 16 bytes covers every format
+		const vk::DeviceSize alignment = std::max<vk::DeviceSize>( K_IMAGE_UPLOAD_ALIGNMENT, device_capabilities.limits.optimalBufferCopyOffsetAlignment );
+		const StagingAllocation staging = allocate_staging( device_capabilities, device, size, alignment );
+		std::memcpy( staging.pMappedData, p_data, size );
+
+		const vk::Extent2D mip_extent = get_mip_extent( dst_image.extent, mip_level );
+		const vk::BufferImageCopy buffer_image_copy
+		{
+			.bufferOffset = staging.offset,
+			// tightly packed
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource =
+			{
+				.aspectMask = dst_image.aspectMask,
+				.mipLevel = mip_level,
+				.baseArrayLayer = 0,
+				.layerCount = 1
+			},
+			.imageOffset = { 0, 0, 0 },
+			.imageExtent = { mip_extent.width, mip_extent.height, 1 }
+		};
+		cmd_buffer.copyBufferToImage( staging.vkBuffer, dst_image.vkImage, vk::ImageLayout::eTransferDstOptimal, buffer_image_copy );
+	}
+
+
+	vk::ImageAspectFlags get_format_aspect_mask( vk::Format format )
+	{
+		switch( format )
+		{
+		case vk::Format::eD16Unorm:
+		case vk::Format::eD32Sfloat:
+		case vk::Format::eX8D24UnormPack32:
+			return vk::ImageAspectFlagBits::eDepth;
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+		case vk::Format::eS8Uint:
+			return vk::ImageAspectFlagBits::eStencil;
+		default:
+			return vk::ImageAspectFlagBits::eColor;
+		}
+	}
+}
\ No newline at end of file
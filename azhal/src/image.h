@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <bit>
+
+namespace gdevice
+{
+	struct DeviceCapabilities;
+
+	// enough for a 32768x32768 image, images with mip views have no more mips
+	constexpr Uint32 K_MAX_IMAGE_MIP_VIEWS = 16;
+
+	struct ImageCreationParams
+	{
+		vk::Format format = vk::Format::eUndefined;
+		vk::Extent2D extent;
+		Uint32 mipLevels = 1;
+		vk::ImageUsageFlags usage;
+		// also creates one view per mip, storage image writes need a view of a single level
+		Bool hasMipViews = false;
+	};
+
+	// 2d, device local and exclusive to the graphics queue family
+	struct Image
+	{
+		vk::Image vkImage;
+		// the image's dedicated allocation, null for images placed into memory the caller owns, see ImageMemoryPool
+		vk::DeviceMemory memory;
+		vk::Format format = vk::Format::eUndefined;
+		vk::Extent2D extent;
+		Uint32 mipLevels = 1;
+		vk::ImageAspectFlags aspectMask;
+		// covers every mip
+		vk::ImageView view;
+		// the first mipLevels are set when created with hasMipViews. a fixed array keeps images cheap to copy out of
+		// the image pool
+		std::array<vk::ImageView, K_MAX_IMAGE_MIP_VIEWS> mipViews {};
+	};
+
+	struct ImageTag;
+	using ImageHandle = Handle<ImageTag>;
+
+	Image create_image( const DeviceCapabilities& device_capabilities, const vk::Device device, const ImageCreationParams& image_creation_params );
+	// binds the image at memory_offset of memory the caller owns and frees after the image is destroyed
+	Image create_image( const vk::Device device, const ImageCreationParams& image_creation_params, vk::DeviceMemory memory, vk::DeviceSize memory_offset );
+	// destroys immediately, at runtime use the Context overload which defers until the gpu is done with it
+	void destroy_image( const vk::Device device, Image& image );
+
+	// the process-wide image pool the Context overloads address images through, like the buffer pool
+	ImageHandle register_image( const Image& image );
+	Image unregister_image( ImageHandle image_handle );
+	Image get_image( ImageHandle image_handle );
+	Bool is_image_valid( ImageHandle image_handle );
+	// destroys images that were never unregistered and reports them as leaks
+	void destroy_image_pool( const vk::Device device );
+
+	// of an image created with image_creation_params, without creating one
+	vk::MemoryRequirements get_image_memory_requirements( const vk::Device device, const ImageCreationParams& image_creation_params );
+
+	// the mip has to be in eTransferDstOptimal. goes through the staging ring, like record_buffer_upload. p_data holds
+	// the mip tightly packed, in blocks for block compressed formats
+	void record_image_upload( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		const Image& dst_image, Uint32 mip_level, const void* p_data, vk::DeviceSize size );
+
+	vk::ImageAspectFlags get_format_aspect_mask( vk::Format format );
+
+	// mips down to 1x1
+	AZHAL_INLINE Uint32 get_full_mip_count( const vk::Extent2D& extent )
+	{
+		return static_cast< Uint32 >( std::bit_width( std::max( extent.width, extent.height ) ) );
+	}
+
+	AZHAL_INLINE vk::Extent2D get_mip_extent( const vk::Extent2D& extent, Uint32 mip_level )
+	{
+		return vk::Extent2D { std::max( extent.width >> mip_level, 1u ), std::max( extent.height >> mip_level, 1u ) };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "azpch.h"
+#include "image_memory_pool.h"
+
+#include "buffer.h"
+#include "deferred_destruction.h"
+#include "device_capabilities.h"
+#include "frame.h"
+
+namespace
+{
+	Uint64 get_page_count( vk::DeviceSize size )
+	{
+		return ( size + gdevice::K_IMAGE_MEMORY_PAGE_SIZE - 1 ) / gdevice::K_IMAGE_MEMORY_PAGE_SIZE;
+	}
+
+
+	void release_retired_image_memory( gdevice::ImageMemoryPool& image_memory_pool )
+	{
+		const Uint64 current_frame_index = gdevice::get_current_frame_index();
+		std::erase_if( image_memory_pool.pendingFrees, [&image_memory_pool, current_frame_index]( const gdevice::PendingImageMemoryFree& pending_free )
+		{
+			if( current_frame_index < pending_free.frameIndex + gdevice::MAX_FRAMES_IN_FLIGHT )
+			{
+				return false;
+			}
+
+			image_memory_pool.blocks[ pending_free.range.blockIndex ].pages.Free( pending_free.range.pageOffset );
+			return true;
+		} );
+	}
+}
+
+namespace gdevice
+{
+	void destroy_image_memory_pool( const vk::Device device, ImageMemoryPool& image_memory_pool )
+	{
+		for( const ImageMemoryBlock& block : image_memory_pool.blocks )
+		{
+			device.free( block.memory );
+		}
+		image_memory_pool.blocks.clear();
+		image_memory_pool.pendingFrees.clear();
+	}
+
+
+	Image create_pooled_image( const DeviceCapabilities& device_capabilities, const vk::Device device, ImageMemoryPool& image_memory_pool,
+		const ImageCreationParams& image_creation_params, ImageMemoryRange& out_range )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		out_range = {};
+
+		const vk::MemoryRequirements memory_requirements = get_image_memory_requirements( device, image_creation_params );
+		const Uint32 memory_type_index = find_memory_type_index( device_capabilities.memoryProperties, memory_requirements.memoryTypeBits,
+			vk::MemoryPropertyFlagBits::eDeviceLocal, {} );
+		if( memory_type_index == UINT32_MAX )
+		{
+			throw GDeviceException( "no memory type fits the image" );
+		}
+
+		// a range that starts on any page can be aligned up within itself
+		const vk::DeviceSize alignment_padding = ( memory_requirements.alignment > K_IMAGE_MEMORY_PAGE_SIZE ) ? ( memory_requirements.alignment - K_IMAGE_MEMORY_PAGE_SIZE ) : 0;
+		const Uint64 page_count = get_page_count( memory_requirements.size + alignment_padding );
+		const Uint64 block_page_count = image_memory_pool.blockSize / K_IMAGE_MEMORY_PAGE_SIZE;
+		if( page_count > block_page_count )
+		{
+			return create_image( device_capabilities, device, image_creation_params );
+		}
+
+		release_retired_image_memory( image_memory_pool );
+
+		Uint32 block_index = UINT32_MAX;
+		Uint64 page_offset = RangeAllocator::K_INVALID_OFFSET;
+		for( Uint32 i = 0; i < image_memory_pool.blocks.size() && page_offset == RangeAllocator::K_INVALID_OFFSET; ++i )
+		{
+			ImageMemoryBlock& block = image_memory_pool.blocks[ i ];
+			if( block.memoryTypeIndex == memory_type_index )
+			{
+				page_offset = block.pages.Allocate( page_count );
+				block_index = i;
+			}
+		}
+
+		if( page_offset == RangeAllocator::K_INVALID_OFFSET )
+		{
+			const vk::MemoryAllocateInfo memory_allocate_info
+			{
+				.allocationSize = block_page_count * K_IMAGE_MEMORY_PAGE_SIZE,
+				.memoryTypeIndex = memory_type_index
+			};
+			const vk::ResultValue rv_memory = device.allocateMemory( memory_allocate_info );
+			image_memory_pool.blocks.push_back( ImageMemoryBlock
+			{
+				.memory = get_vk_result( rv_memory, "failed to allocate an image memory block" ),
+				.memoryTypeIndex = memory_type_index,
+				.pages = RangeAllocator( block_page_count )
+			} );
+
+			block_index = static_cast< Uint32 >( image_memory_pool.blocks.size() ) - 1;
+			page_offset = image_memory_pool.blocks.back().pages.Allocate( page_count );
+		}
+
+		const vk::DeviceSize alignment = std::max<vk::DeviceSize>( memory_requirements.alignment, 1 );
+		const vk::DeviceSize memory_offset = ( page_offset * K_IMAGE_MEMORY_PAGE_SIZE + alignment - 1 ) / alignment * alignment;
+		out_range = ImageMemoryRange { .blockIndex = block_index, .pageOffset = page_offset };
+
+		return create_image( device, image_creation_params, image_memory_pool.blocks[ block_index ].memory, memory_offset );
+	}
+
+
+	void destroy_pooled_image( ImageMemoryPool& image_memory_pool, Image& image, ImageMemoryRange& range )
+	{
+		if( image.vkImage )
+		{
+			defer_destroy_image( image );
+		}
+		if( range.blockIndex != UINT32_MAX )
+		{
+			image_memory_pool.pendingFrees.push_back( PendingImageMemoryFree { .frameIndex = get_current_frame_index(), .range = range } );
+		}
+		range = {};
+	}
+
+
+	ImageMemoryPoolStats get_image_memory_pool_stats( const ImageMemoryPool& image_memory_pool )
+	{
+		ImageMemoryPoolStats stats
+		{
+			.blockCount = static_cast< Uint32 >( image_memory_pool.blocks.size() ),
+			.pendingFreeCount = static_cast< Uint32 >( image_memory_pool.pendingFrees.size() )
+		};
+		for( const ImageMemoryBlock& block : image_memory_pool.blocks )
+		{
+			stats.blockBytes += block.pages.GetCapacity() * K_IMAGE_MEMORY_PAGE_SIZE;
+			stats.usedBytes += block.pages.GetUsedSize() * K_IMAGE_MEMORY_PAGE_SIZE;
+		}
+		return stats;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "image.h"
+
+namespace gdevice
+{
+	struct DeviceCapabilities;
+
+	// the unit the blocks are split in, images with a larger alignment are padded
+	constexpr vk::DeviceSize K_IMAGE_MEMORY_PAGE_SIZE = 4 * K_KIBIBYTE;
+
+	// where a pooled image lives, blockIndex is UINT32_MAX for an image too large for a block, which got a dedicated
+	// allocation instead
+	struct ImageMemoryRange
+	{
+		Uint32 blockIndex = UINT32_MAX;
+		// in pages, as returned by the block's RangeAllocator
+		Uint64 pageOffset = 0;
+	};
+
+	struct ImageMemoryBlock
+	{
+		vk::DeviceMemory memory;
+		Uint32 memoryTypeIndex = UINT32_MAX;
+		RangeAllocator pages;
+	};
+
+	// range of a destroyed image, in-flight frames may still sample it
+	struct PendingImageMemoryFree
+	{
+		Uint64 frameIndex = 0;
+		ImageMemoryRange range;
+	};
+
+	struct ImageMemoryPoolStats
+	{
+		Uint32 blockCount = 0;
+		Uint64 blockBytes = 0;
+		// padding included
+		Uint64 usedBytes = 0;
+		Uint32 pendingFreeCount = 0;
+	};
+
+	// device local blocks that images are placed into, so that images created and destroyed at runtime, e.g. by texture
+	// streaming, do not allocate device memory each. blocks are allocated on demand and kept until the pool is destroyed
+	struct ImageMemoryPool
+	{
+		vk::DeviceSize blockSize = 64 * K_MEBIBYTE;
+		std::vector<ImageMemoryBlock> blocks;
+		// reusable once the frame they were freed in retired
+		std::vector<PendingImageMemoryFree> pendingFrees;
+	};
+
+	// destroys immediately, every image placed into the pool has to be destroyed already. at runtime use the Context
+	// overload which defers until the gpu is done with the blocks
+	void destroy_image_memory_pool( const vk::Device device, ImageMemoryPool& image_memory_pool );
+
+	// like create_image, but placed into a block of the pool. keep out_range for destroy_pooled_image
+	Image create_pooled_image( const DeviceCapabilities& device_capabilities, const vk::Device device, ImageMemoryPool& image_memory_pool,
+		const ImageCreationParams& image_creation_params, ImageMemoryRange& out_range );
+	// the image is destroyed and its range reused once the frames that may still sample it have retired
+	void destroy_pooled_image( ImageMemoryPool& image_memory_pool, Image& image, ImageMemoryRange& range );
+
+	ImageMemoryPoolStats get_image_memory_pool_stats( const ImageMemoryPool& image_memory_pool );
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "azpch.h"
+#include "mesh.h"
+
+#include "resource_pool.h"
+#include "vulkan_sync_utils.h"
+
+namespace
+{
+	gdevice::ResourcePool<gdevice::MeshTag, gdevice::Mesh> s_meshPool( "mesh", 64 );
+}
+
+namespace gdevice
+{
+	VertexLayout get_packed_mesh_vertex_layout()
+	{
+		return VertexLayout
+		{
+			.bindings =
+			{
+				{ .binding = 0, .stride = sizeof( PackedMeshVertex ), .inputRate = vk::VertexInputRate::eVertex }
+			},
+			.attributes =
+			{
+				{ .location = 0, .binding = 0, .format = vk::Format::eR16G16B16A16Snorm, .offset = offsetof( PackedMeshVertex, position ) },
+				{ .location = 1, .binding = 0, .format = vk::Format::eR16G16Snorm, .offset = offsetof( PackedMeshVertex, normal ) },
+				{ .location = 2, .binding = 0, .format = vk::Format::eR16G16Sfloat, .offset = offsetof( PackedMeshVertex, uv ) }
+			}
+		};
+	}
+
+
+	Mesh create_mesh( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer, const PackedMesh& packed_mesh,
+		Bool is_pulled )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_ASSERT( !packed_mesh.vertices.empty() && !packed_mesh.indices.empty(), "meshes without triangles cannot be drawn" );
+
+		Mesh mesh
+		{
+			.vertexCount = static_cast< Uint32 >( packed_mesh.vertices.size() ),
+			.indexCount = static_cast< Uint32 >( packed_mesh.indices.size() ),
+			.boundsCenter = packed_mesh.boundsCenter,
+			.boundsExtent = packed_mesh.boundsExtent
+		};
+
+		std::vector<Uint16> indices_16;
+		const void* p_index_data = packed_mesh.indices.data();
+		vk::DeviceSize index_buffer_size = packed_mesh.indices.size() * sizeof( Uint32 );
+		if( mesh.vertexCount <= 0x10000 )
+		{
+			indices_16.assign( packed_mesh.indices.begin(), packed_mesh.indices.end() );
+			p_index_data = indices_16.data();
+			index_buffer_size = indices_16.size() * sizeof( Uint16 );
+			mesh.indexType = vk::IndexType::eUint16;
+		}
+
+		const vk::BufferUsageFlags pulled_usage = get_pulled_geometry_usage( is_pulled );
+
+		const vk::DeviceSize vertex_buffer_size = packed_mesh.vertices.size() * sizeof( PackedMeshVertex );
+		const BufferCreationParams vertex_buffer_creation_params
+		{
+			.size = vertex_buffer_size,
+			.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | pulled_usage
+		};
+		mesh.vertexBuffer = create_buffer( device_capabilities, device, vertex_buffer_creation_params, {} );
+
+		const BufferCreationParams index_buffer_creation_params
+		{
+			.size = index_buffer_size,
+			.usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst | pulled_usage
+		};
+		mesh.indexBuffer = create_buffer( device_capabilities, device, index_buffer_creation_params, {} );
+
+		record_buffer_upload( device_capabilities, device, cmd_buffer, mesh.vertexBuffer, 0, packed_mesh.vertices.data(), vertex_buffer_size );
+		record_buffer_upload( device_capabilities, device, cmd_buffer, mesh.indexBuffer, 0, p_index_data, index_buffer_size );
+
+		insert_geometry_upload_barrier( cmd_buffer, is_pulled );
+
+		return mesh;
+	}
+
+
+	void destroy_mesh( const vk::Device device, Mesh& mesh )
+	{
+		destroy_buffer( device, mesh.vertexBuffer );
+		destroy_buffer( device, mesh.indexBuffer );
+		mesh = {};
+	}
+
+
+	MeshHandle register_mesh( const Mesh& mesh )
+	{
+		return s_meshPool.Register( mesh );
+	}
+
+
+	Mesh unregister_mesh( MeshHandle mesh_handle )
+	{
+		return s_meshPool.Unregister( mesh_handle );
+	}
+
+
+	Mesh get_mesh( MeshHandle mesh_handle )
+	{
+		return s_meshPool.Get( mesh_handle );
+	}
+
+
+	Bool is_mesh_valid( MeshHandle mesh_handle )
+	{
+		return s_meshPool.IsValid( mesh_handle );
+	}
+
+
+	void destroy_mesh_pool( const vk::Device device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		s_meshPool.DestroyAll( [device]( Mesh& mesh ) { destroy_mesh( device, mesh ); } );
+	}
+
+
+	void bind_mesh( vk::CommandBuffer cmd_buffer, const Mesh& mesh )
+	{
+		const vk::DeviceSize vertex_buffer_offset = 0;
+		cmd_buffer.bindVertexBuffers( 0, 1, &mesh.vertexBuffer.vkBuffer, &vertex_buffer_offset );
+		cmd_buffer.bindIndexBuffer( mesh.indexBuffer.vkBuffer, 0, mesh.indexType );
+	}
+
+
+	void draw_mesh( vk::CommandBuffer cmd_buffer, const Mesh& mesh, Uint32 instance_count, Uint32 first_instance )
+	{
+		cmd_buffer.drawIndexed( mesh.indexCount, instance_count, mesh.firstIndex, mesh.vertexOffset, first_instance );
+	}
+}
\ No newline at end of file
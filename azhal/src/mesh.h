@@ -0,0 +1,78 @@
+#pragma once
+
+#include "buffer.h"
+#include "pso.h"
+
+namespace gdevice
+{
+	struct DeviceCapabilities;
+
+	// a PackedMesh on the gpu, drawn through the fixed function vertex fetch
+	struct Mesh
+	{
+		Buffer vertexBuffer;
+		Buffer indexBuffer;
+		// 16-bit whenever the vertex count allows it
+		vk::IndexType indexType = vk::IndexType::eUint32;
+		Uint32 vertexCount = 0;
+		Uint32 indexCount = 0;
+		// where the mesh starts in its buffers, non-zero for meshes that share them, see GeometryPool
+		Int32 vertexOffset = 0;
+		Uint32 firstIndex = 0;
+		// decodes the snorm positions, see PackedMesh
+		Vec3 boundsCenter = Vec3( 0.0f );
+		Vec3 boundsExtent = Vec3( 1.0f );
+	};
+
+	struct MeshTag;
+	using MeshHandle = Handle<MeshTag>;
+
+	// the usage vertex and index buffers need on top of their own when shaders also read them as storage buffers through
+	// their device addresses
+	AZHAL_INLINE vk::BufferUsageFlags get_pulled_geometry_usage( Bool is_pulled )
+	{
+		return is_pulled ? ( vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress ) : vk::BufferUsageFlags {};
+	}
+
+	// binding 0, per vertex: location 0 position (snorm16x4), 1 octahedral normal (snorm16x2), 2 uv (half2)
+	VertexLayout get_packed_mesh_vertex_layout();
+
+	// records the uploads and the barrier that makes them visible to vertex input into cmd_buffer. pulled meshes can
+	// also be read as storage buffers through their device addresses, e.g. by mesh shaders
+	Mesh create_mesh( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer, const PackedMesh& packed_mesh,
+		Bool is_pulled = false );
+	// destroys immediately, at runtime use the Context overload which defers until the gpu is done with it
+	void destroy_mesh( const vk::Device device, Mesh& mesh );
+
+	// the process-wide mesh pool the Context overloads address meshes through, like the buffer pool. the buffers of a
+	// registered mesh are owned by it, not by the buffer pool
+	MeshHandle register_mesh( const Mesh& mesh );
+	Mesh unregister_mesh( MeshHandle mesh_handle );
+	Mesh get_mesh( MeshHandle mesh_handle );
+	Bool is_mesh_valid( MeshHandle mesh_handle );
+	// destroys meshes that were never unregistered and reports them as leaks
+	void destroy_mesh_pool( const vk::Device device );
+
+	// meshes of the same GeometryPool share their binding
+	AZHAL_INLINE Bool is_same_mesh_binding( const Mesh& a, const Mesh& b )
+	{
+		return ( a.vertexBuffer.vkBuffer == b.vertexBuffer.vkBuffer ) && ( a.indexBuffer.vkBuffer == b.indexBuffer.vkBuffer ) && ( a.indexType == b.indexType );
+	}
+
+	void bind_mesh( vk::CommandBuffer cmd_buffer, const Mesh& mesh );
+	// the mesh has to be bound
+	void draw_mesh( vk::CommandBuffer cmd_buffer, const Mesh& mesh, Uint32 instance_count = 1, Uint32 first_instance = 0 );
+
+	// the same draw for indexed indirect buffers, so that draws of different meshes of a pool can go through one call
+	AZHAL_INLINE vk::DrawIndexedIndirectCommand make_mesh_draw_command( const Mesh& mesh, Uint32 instance_count = 1, Uint32 first_instance = 0 )
+	{
+		return vk::DrawIndexedIndirectCommand
+		{
+			.indexCount = mesh.indexCount,
+			.instanceCount = instance_count,
+			.firstIndex = mesh.firstIndex,
+			.vertexOffset = mesh.vertexOffset,
+			.firstInstance = first_instance
+		};
+	}
+}
\ No newline at end of file
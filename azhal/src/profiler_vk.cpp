@@ -0,0 +1,58 @@
+#include "azpch.h"
+#include "profiler_vk.h"
+
+#ifdef TRACY_ENABLE
+namespace
+{
+	TracyVkCtx s_gpuProfilerContext = nullptr;
+}
+#endif
+
+namespace gdevice
+{
+	void init_gpu_profiler( const GpuProfilerInitParams& gpu_profiler_init_params )
+	{
+#ifdef TRACY_ENABLE
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_FATAL_ASSERT( s_gpuProfilerContext == nullptr, "gpu profiler is already initialized" );
+
+		const VkPhysicalDevice physical_device = gpu_profiler_init_params.physicalDevice;
+		const VkDevice device = gpu_profiler_init_params.device;
+		const VkQueue queue = gpu_profiler_init_params.queue;
+		const VkCommandBuffer cmd_buffer = gpu_profiler_init_params.cmdBuffer;
+
+		if( gpu_profiler_init_params.useCalibratedTimestamps )
+		{
+			const auto get_calibrateable_time_domains_fn = reinterpret_cast< PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT >(
+				vkGetInstanceProcAddr( gpu_profiler_init_params.instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT" ) );
+			const auto get_calibrated_timestamps_fn = reinterpret_cast< PFN_vkGetCalibratedTimestampsEXT >(
+				vkGetDeviceProcAddr( device, "vkGetCalibratedTimestampsEXT" ) );
+
+			s_gpuProfilerContext = TracyVkContextCalibrated( physical_device, device, queue, cmd_buffer, get_calibrateable_time_domains_fn, get_calibrated_timestamps_fn );
+		}
+		else
+		{
+			AZHAL_LOG_WARN( "calibrated timestamps are not available, gpu zones will drift from cpu zones" );
+			s_gpuProfilerContext = TracyVkContext( physical_device, device, queue, cmd_buffer );
+		}
+
+		TracyVkContextName( s_gpuProfilerContext, gpu_profiler_init_params.pName, static_cast< Uint16 >( strlen( gpu_profiler_init_params.pName ) ) );
+#endif
+	}
+
+
+	void destroy_gpu_profiler()
+	{
+#ifdef TRACY_ENABLE
+		TracyVkDestroy( s_gpuProfilerContext );
+		s_gpuProfilerContext = nullptr;
+#endif
+	}
+
+#ifdef TRACY_ENABLE
+	TracyVkCtx get_gpu_profiler_context()
+	{
+		return s_gpuProfilerContext;
+	}
+#endif
+}
\ No newline at end of file
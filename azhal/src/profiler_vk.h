@@ -0,0 +1,42 @@
+#pragma once
+
+#ifdef TRACY_ENABLE
+#include <TracyVulkan.hpp>
+#endif
+
+namespace gdevice
+{
+	struct GpuProfilerInitParams
+	{
+		vk::Instance instance;
+		vk::PhysicalDevice physicalDevice;
+		vk::Device device;
+		vk::Queue queue;
+		vk::CommandBuffer cmdBuffer;
+		Bool useCalibratedTimestamps = false;
+		const AnsiChar* pName = "gpu";
+	};
+
+	// creates the tracy vulkan context used by the gpu zones. calibrated timestamps
+	// are used when VK_EXT_calibrated_timestamps was enabled on the device
+	void init_gpu_profiler( const GpuProfilerInitParams& gpu_profiler_init_params );
+	void destroy_gpu_profiler();
+
+#ifdef TRACY_ENABLE
+	TracyVkCtx get_gpu_profiler_context();
+#endif
+}
+
+
+#ifdef TRACY_ENABLE
+
+#define AZHAL_PROFILE_GPU_SCOPE(cmd_buffer, name)  TracyVkZone( gdevice::get_gpu_profiler_context(), static_cast< VkCommandBuffer >( cmd_buffer ), name )
+// must be recorded once per frame, outside of a render pass
+#define AZHAL_PROFILE_GPU_COLLECT(cmd_buffer)      TracyVkCollect( gdevice::get_gpu_profiler_context(), static_cast< VkCommandBuffer >( cmd_buffer ) )
+
+#else
+
+#define AZHAL_PROFILE_GPU_SCOPE(cmd_buffer, name)
+#define AZHAL_PROFILE_GPU_COLLECT(cmd_buffer)
+
+#endif
\ No newline at end of file
@@ -1,49 +1,116 @@
 #include "azpch.h"
 #include "pso.h"
 
-namespace gdevice
+#include <shared_mutex>
+
+namespace
 {
-	PSO create_pso( const vk::Device device, const PSOCreationParams& pso_creation_params )
+	std::shared_mutex s_psoPoolMutex;
+	gdevice::PSOPool s_psoPool( 64 );
+}
+
+namespace
+{
+	vk::ShaderModule create_shader_module( const vk::Device device, const AnsiChar* file_path, const ByteBufferDynamic* p_preloaded_code )
 	{
-		const auto shader_module_create_fn = [device]( const AnsiChar* file_path ) -> const vk::ShaderModule
+		AZHAL_PROFILE_FUNCTION();
+		if( file_path )
 		{
-			const ByteBufferDynamic shader_code = LoadBinaryBlob( file_path );
-			const vk::ShaderModuleCreateInfo shader_create_info
-			{
-				.codeSize = VK_SIZE_CAST( shader_code.size() ),
-				.pCode = reinterpret_cast< const Uint32* >( shader_code.data() )
-			};
-			const vk::ResultValue rv_shader_module = device.createShaderModule( shader_create_info );
-			return ( get_vk_result( rv_shader_module, "failed to create shader module" ) );
+			AZHAL_PROFILE_ZONE_TEXT( file_path, strlen( file_path ) );
+		}
+
+		const ByteBufferDynamic loaded_code = p_preloaded_code ? ByteBufferDynamic() : LoadBinaryBlob( file_path );
+		const ByteBufferDynamic& shader_code = p_preloaded_code ? *p_preloaded_code : loaded_code;
+		const vk::ShaderModuleCreateInfo shader_create_info
+		{
+			.codeSize = VK_SIZE_CAST( shader_code.size() ),
+			.pCode = reinterpret_cast< const Uint32* >( shader_code.data() )
 		};
+		const vk::ResultValue rv_shader_module = device.createShaderModule( shader_create_info );
+		return ( gdevice::get_vk_result( rv_shader_module, "failed to create shader module" ) );
+	}
 
-		const vk::ShaderModule vertex_shader_module = shader_module_create_fn( pso_creation_params.pVertexShader );
-		const vk::ShaderModule fragment_shader_module = shader_module_create_fn( pso_creation_params.pFragmentShader );
 
-		const vk::PipelineShaderStageCreateInfo vertex_shader_stage_create_info
+	// the pool mutex must be held. HandlePool::Get only asserts, which Profile and Final compile out
+	gdevice::PSO get_pooled_pso( gdevice::PSOHandle pso_handle )
+	{
+		if( !s_psoPool.IsValid( pso_handle ) )
 		{
-			.stage = vk::ShaderStageFlagBits::eVertex,
-			.module = vertex_shader_module,
-			.pName = "main"
+			AZHAL_LOG_ERROR( "pso lookup through a stale or null handle (slot {0}, generation {1})", pso_handle.index, pso_handle.generation );
+			return gdevice::PSO {};
+		}
+
+		const gdevice::PSOBindInfo& bind_info = s_psoPool.Get<gdevice::ePSOPoolColumnBindInfo>( pso_handle );
+
+		return gdevice::PSO
+		{
+			.pipelineLayout = s_psoPool.Get<gdevice::ePSOPoolColumnLayout>( pso_handle ),
+			.vkPipelineObject = s_psoPool.Get<gdevice::ePSOPoolColumnPipeline>( pso_handle ),
+			.bindPoint = bind_info.bindPoint,
+			.pushConstantStages = bind_info.pushConstantStages,
+			.descriptorSetLayout = bind_info.descriptorSetLayout
 		};
-		const vk::PipelineShaderStageCreateInfo fragment_shader_stage_create_info
+	}
+
+
+	gdevice::PSOHandle register_pooled_pso( const gdevice::PSO& pso, gdevice::PSODebugInfo&& debug_info )
+	{
+		const gdevice::PSOBindInfo bind_info
 		{
-			.stage = vk::ShaderStageFlagBits::eFragment,
-			.module = fragment_shader_module,
-			.pName = "main"
+			.bindPoint = pso.bindPoint,
+			.pushConstantStages = pso.pushConstantStages,
+			.descriptorSetLayout = pso.descriptorSetLayout
 		};
-		const vk::PipelineShaderStageCreateInfo shader_stages[ 2 ] =
+
+		std::unique_lock lock( s_psoPoolMutex );
+		return s_psoPool.Create( pso.vkPipelineObject, pso.pipelineLayout, bind_info, std::move( debug_info ) );
+	}
+}
+
+namespace gdevice
+{
+	PSO create_pso( const vk::Device device, const PSOCreationParams& pso_creation_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const Bool is_mesh_pipeline = ( pso_creation_params.pMeshShader != nullptr );
+		AZHAL_FATAL_ASSERT( is_mesh_pipeline || pso_creation_params.pTaskShader == nullptr, "task shaders need a mesh shader" );
+
+		// task, mesh and fragment or vertex and fragment
+		std::array<vk::PipelineShaderStageCreateInfo, 3> shader_stages;
+		Uint32 shader_stage_count = 0;
+		vk::ShaderStageFlags used_stages;
+		const auto add_shader_stage = [&]( vk::ShaderStageFlagBits stage, const AnsiChar* p_path, const ByteBufferDynamic* p_code )
 		{
-			vertex_shader_stage_create_info,
-			fragment_shader_stage_create_info
+			shader_stages[ shader_stage_count++ ] = vk::PipelineShaderStageCreateInfo
+			{
+				.stage = stage,
+				.module = create_shader_module( device, p_path, p_code ),
+				.pName = "main"
+			};
+			used_stages |= stage;
 		};
 
+		if( is_mesh_pipeline )
+		{
+			if( pso_creation_params.pTaskShader )
+			{
+				add_shader_stage( vk::ShaderStageFlagBits::eTaskEXT, pso_creation_params.pTaskShader, pso_creation_params.pTaskShaderCode );
+			}
+			add_shader_stage( vk::ShaderStageFlagBits::eMeshEXT, pso_creation_params.pMeshShader, pso_creation_params.pMeshShaderCode );
+		}
+		else
+		{
+			add_shader_stage( vk::ShaderStageFlagBits::eVertex, pso_creation_params.pVertexShader, pso_creation_params.pVertexShaderCode );
+		}
+		add_shader_stage( vk::ShaderStageFlagBits::eFragment, pso_creation_params.pFragmentShader, pso_creation_params.pFragmentShaderCode );
+
 		const vk::PipelineVertexInputStateCreateInfo vertex_input_state_create_info
 		{
-			.vertexBindingDescriptionCount = 0,
-			.pVertexBindingDescriptions = VK_NULL_HANDLE,
-			.vertexAttributeDescriptionCount = 0,
-			.pVertexAttributeDescriptions = VK_NULL_HANDLE
+			.vertexBindingDescriptionCount = VK_SIZE_CAST( pso_creation_params.vertexLayout.bindings.size() ),
+			.pVertexBindingDescriptions = pso_creation_params.vertexLayout.bindings.data(),
+			.vertexAttributeDescriptionCount = VK_SIZE_CAST( pso_creation_params.vertexLayout.attributes.size() ),
+			.pVertexAttributeDescriptions = pso_creation_params.vertexLayout.attributes.data()
 		};
 
 		const vk::PipelineInputAssemblyStateCreateInfo input_assembly_state_create_info
@@ -63,8 +130,8 @@ namespace gdevice
 			.depthClampEnable = VK_FALSE,
 			.rasterizerDiscardEnable = VK_FALSE,
 			.polygonMode = vk::PolygonMode::eFill,
-			.cullMode = vk::CullModeFlagBits::eBack,
-			.frontFace = vk::FrontFace::eClockwise,
+			.cullMode = pso_creation_params.cullMode,
+			.frontFace = pso_creation_params.frontFace,
 			.depthBiasEnable = VK_FALSE,
 			.lineWidth = 1.0f
 		};
@@ -96,7 +163,7 @@ namespace gdevice
 			.blendConstants = std::array<Float, 4>{0, 0, 0, 0}
 		};
 
-		const std::vector<vk::DynamicState> dynamic_states
+		constexpr std::array<vk::DynamicState, 2> dynamic_states
 		{
 			vk::DynamicState::eViewport,
 			vk::DynamicState::eScissor
@@ -107,32 +174,55 @@ namespace gdevice
 			.pDynamicStates = dynamic_states.data()
 		};
 
+		const Bool has_push_constants = ( pso_creation_params.pushConstantSize > 0 );
+		AZHAL_FATAL_ASSERT( pso_creation_params.pushConstantSize <= 128, "only 128 bytes of push constants are guaranteed" );
+
+		const vk::ShaderStageFlags push_constant_stages = used_stages;
+		const vk::PushConstantRange push_constant_range
+		{
+			.stageFlags = push_constant_stages,
+			.offset = 0,
+			.size = pso_creation_params.pushConstantSize
+		};
 		const vk::PipelineLayoutCreateInfo pipeline_layout_create_info
 		{
 			.setLayoutCount = 0,
 			.pSetLayouts = VK_NULL_HANDLE,
-			.pushConstantRangeCount = 0,
-			.pPushConstantRanges = VK_NULL_HANDLE
+			.pushConstantRangeCount = has_push_constants ? 1u : 0u,
+			.pPushConstantRanges = has_push_constants ? &push_constant_range : VK_NULL_HANDLE
 		};
 		const vk::ResultValue rv_pipleline_layout = device.createPipelineLayout( pipeline_layout_create_info );
 		const vk::PipelineLayout pipeline_layout = get_vk_result( rv_pipleline_layout, "failed to create pipeline layout" );
 
+		const Bool has_depth_attachment = ( pso_creation_params.depthAttachmentFormat != vk::Format::eUndefined );
+		const vk::PipelineDepthStencilStateCreateInfo depth_stencil_state_create_info
+		{
+			.depthTestEnable = VK_TRUE,
+			.depthWriteEnable = pso_creation_params.isDepthWriteEnabled,
+			.depthCompareOp = pso_creation_params.depthCompareOp,
+			.depthBoundsTestEnable = VK_FALSE,
+			.stencilTestEnable = VK_FALSE,
+			.minDepthBounds = 0.0f,
+			.maxDepthBounds = 1.0f
+		};
+
 		const vk::PipelineRenderingCreateInfo pipeline_rendering_create_info
 		{
 			.colorAttachmentCount = VK_SIZE_CAST( pso_creation_params.colorAttachmentFormats.size() ),
-			.pColorAttachmentFormats = pso_creation_params.colorAttachmentFormats.data()
+			.pColorAttachmentFormats = pso_creation_params.colorAttachmentFormats.data(),
+			.depthAttachmentFormat = pso_creation_params.depthAttachmentFormat
 		};
 
 		const vk::GraphicsPipelineCreateInfo graphics_pipeline_create_info
 		{
-			.stageCount = 2,
-			.pStages = shader_stages,
-			.pVertexInputState = &vertex_input_state_create_info,
-			.pInputAssemblyState = &input_assembly_state_create_info,
+			.stageCount = shader_stage_count,
+			.pStages = shader_stages.data(),
+			.pVertexInputState = is_mesh_pipeline ? VK_NULL_HANDLE : &vertex_input_state_create_info,
+			.pInputAssemblyState = is_mesh_pipeline ? VK_NULL_HANDLE : &input_assembly_state_create_info,
 			.pViewportState = &viewport_state_create_info,
 			.pRasterizationState = &raster_state_create_info,
 			.pMultisampleState = &multisample_state_create_info,
-			.pDepthStencilState = VK_NULL_HANDLE,
+			.pDepthStencilState = has_depth_attachment ? &depth_stencil_state_create_info : VK_NULL_HANDLE,
 			.pColorBlendState = &color_blend_state_create_info,
 			.pDynamicState = &dynamic_state_create_info,
 			.layout = pipeline_layout,
@@ -145,16 +235,112 @@ namespace gdevice
 			pipeline_rendering_create_info
 		};
 
-		const vk::ResultValue rv_graphics_pipeline = device.createGraphicsPipeline( VK_NULL_HANDLE, graphics_pipeline_creation_chain.get<vk::GraphicsPipelineCreateInfo>() );
+		const vk::ResultValue rv_graphics_pipeline = device.createGraphicsPipeline( pso_creation_params.pipelineCache, graphics_pipeline_creation_chain.get<vk::GraphicsPipelineCreateInfo>() );
 		const vk::Pipeline vk_pipeline = get_vk_result( rv_graphics_pipeline, "failed to create graphics pipeline" );
 
-		device.destroy( vertex_shader_module );
-		device.destroy( fragment_shader_module );
+		for( Uint32 i = 0; i < shader_stage_count; ++i )
+		{
+			device.destroy( shader_stages[ i ].module );
+		}
 
 		const PSO pso
 		{
 			.pipelineLayout = pipeline_layout,
-			.vkPipelineObject = vk_pipeline
+			.vkPipelineObject = vk_pipeline,
+			.bindPoint = vk::PipelineBindPoint::eGraphics,
+			.pushConstantStages = has_push_constants ? push_constant_stages : vk::ShaderStageFlags {}
+		};
+
+		return pso;
+	}
+
+
+	PSO create_compute_pso( const vk::Device device, const ComputePSOCreationParams& compute_pso_creation_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::ShaderModule compute_shader_module = create_shader_module( device, compute_pso_creation_params.pComputeShader, compute_pso_creation_params.pComputeShaderCode );
+
+		const Bool has_push_constants = ( compute_pso_creation_params.pushConstantSize > 0 );
+		AZHAL_FATAL_ASSERT( compute_pso_creation_params.pushConstantSize <= 128, "only 128 bytes of push constants are guaranteed" );
+
+		vk::DescriptorSetLayout descriptor_set_layout;
+		const Uint32 storage_buffer_count = compute_pso_creation_params.storageBufferCount;
+		const Uint32 sampled_image_count = compute_pso_creation_params.sampledImageCount;
+		const Uint32 storage_image_count = compute_pso_creation_params.storageImageCount;
+		if( storage_buffer_count + sampled_image_count + storage_image_count > 0 )
+		{
+			std::vector<vk::DescriptorSetLayoutBinding> bindings;
+			for( Uint32 i = 0; i < storage_buffer_count + sampled_image_count; ++i )
+			{
+				bindings.push_back( vk::DescriptorSetLayoutBinding
+				{
+					.binding = i,
+					.descriptorType = ( i < storage_buffer_count ) ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eSampledImage,
+					.descriptorCount = 1,
+					.stageFlags = vk::ShaderStageFlagBits::eCompute
+				} );
+			}
+			if( storage_image_count > 0 )
+			{
+				bindings.push_back( vk::DescriptorSetLayoutBinding
+				{
+					.binding = storage_buffer_count + sampled_image_count,
+					.descriptorType = vk::DescriptorType::eStorageImage,
+					.descriptorCount = storage_image_count,
+					.stageFlags = vk::ShaderStageFlagBits::eCompute
+				} );
+			}
+
+			const vk::DescriptorSetLayoutCreateInfo descriptor_set_layout_create_info
+			{
+				.bindingCount = VK_SIZE_CAST( bindings.size() ),
+				.pBindings = bindings.data()
+			};
+			const vk::ResultValue rv_descriptor_set_layout = device.createDescriptorSetLayout( descriptor_set_layout_create_info );
+			descriptor_set_layout = get_vk_result( rv_descriptor_set_layout, "failed to create descriptor set layout" );
+		}
+		const Bool has_descriptor_set = static_cast< Bool >( descriptor_set_layout );
+
+		const vk::PushConstantRange push_constant_range
+		{
+			.stageFlags = vk::ShaderStageFlagBits::eCompute,
+			.offset = 0,
+			.size = compute_pso_creation_params.pushConstantSize
+		};
+		const vk::PipelineLayoutCreateInfo pipeline_layout_create_info
+		{
+			.setLayoutCount = has_descriptor_set ? 1u : 0u,
+			.pSetLayouts = has_descriptor_set ? &descriptor_set_layout : VK_NULL_HANDLE,
+			.pushConstantRangeCount = has_push_constants ? 1u : 0u,
+			.pPushConstantRanges = has_push_constants ? &push_constant_range : VK_NULL_HANDLE
+		};
+		const vk::ResultValue rv_pipleline_layout = device.createPipelineLayout( pipeline_layout_create_info );
+		const vk::PipelineLayout pipeline_layout = get_vk_result( rv_pipleline_layout, "failed to create pipeline layout" );
+
+		const vk::ComputePipelineCreateInfo compute_pipeline_create_info
+		{
+			.stage = vk::PipelineShaderStageCreateInfo
+			{
+				.stage = vk::ShaderStageFlagBits::eCompute,
+				.module = compute_shader_module,
+				.pName = "main"
+			},
+			.layout = pipeline_layout
+		};
+
+		const vk::ResultValue rv_compute_pipeline = device.createComputePipeline( compute_pso_creation_params.pipelineCache, compute_pipeline_create_info );
+		const vk::Pipeline vk_pipeline = get_vk_result( rv_compute_pipeline, "failed to create compute pipeline" );
+
+		device.destroy( compute_shader_module );
+
+		const PSO pso
+		{
+			.pipelineLayout = pipeline_layout,
+			.vkPipelineObject = vk_pipeline,
+			.bindPoint = vk::PipelineBindPoint::eCompute,
+			.pushConstantStages = has_push_constants ? vk::ShaderStageFlags( vk::ShaderStageFlagBits::eCompute ) : vk::ShaderStageFlags {},
+			.descriptorSetLayout = descriptor_set_layout
 		};
 
 		return pso;
@@ -162,8 +348,165 @@ namespace gdevice
 
 	void destroy_pso( const vk::Device device, PSO& pso )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		device.destroy( pso.vkPipelineObject );
 		device.destroy( pso.pipelineLayout );
+		device.destroy( pso.descriptorSetLayout );
+	}
+
+
+	PSOHandle register_pso( const PSO& pso, const PSOCreationParams& pso_creation_params )
+	{
+		PSODebugInfo debug_info
+		{
+			.vertexShader = pso_creation_params.pVertexShader ? pso_creation_params.pVertexShader : "",
+			.fragmentShader = pso_creation_params.pFragmentShader ? pso_creation_params.pFragmentShader : "",
+			.taskShader = pso_creation_params.pTaskShader ? pso_creation_params.pTaskShader : "",
+			.meshShader = pso_creation_params.pMeshShader ? pso_creation_params.pMeshShader : ""
+		};
+		return register_pooled_pso( pso, std::move( debug_info ) );
+	}
+
+
+	PSOHandle register_pso( const PSO& pso, const ComputePSOCreationParams& compute_pso_creation_params )
+	{
+		PSODebugInfo debug_info
+		{
+			.computeShader = compute_pso_creation_params.pComputeShader ? compute_pso_creation_params.pComputeShader : ""
+		};
+		return register_pooled_pso( pso, std::move( debug_info ) );
+	}
+
+
+	PSO unregister_pso( PSOHandle pso_handle )
+	{
+		std::unique_lock lock( s_psoPoolMutex );
+		AZHAL_FATAL_ASSERT( s_psoPool.IsValid( pso_handle ), "destroying a pso through a stale handle" );
+
+		const PSO pso = get_pooled_pso( pso_handle );
+		if( pso.vkPipelineObject )
+		{
+			s_psoPool.Destroy( pso_handle );
+		}
+
+		return pso;
+	}
+
+
+	PSO get_pso( PSOHandle pso_handle )
+	{
+		std::shared_lock lock( s_psoPoolMutex );
+		return get_pooled_pso( pso_handle );
+	}
+
+
+	Bool is_pso_valid( PSOHandle pso_handle )
+	{
+		std::shared_lock lock( s_psoPoolMutex );
+		return s_psoPool.IsValid( pso_handle );
+	}
+
+
+	void bind_pso( vk::CommandBuffer cmd_buffer, const PSO& pso )
+	{
+		if( !pso.vkPipelineObject )
+		{
+			return;
+		}
+
+		cmd_buffer.bindPipeline( pso.bindPoint, pso.vkPipelineObject );
+	}
+
+
+	void bind_pso( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle )
+	{
+		bind_pso( cmd_buffer, get_pso( pso_handle ) );
+	}
+
+
+	void push_pso_constants( vk::CommandBuffer cmd_buffer, const PSO& pso, const void* p_data, Uint32 size, Uint32 offset )
+	{
+		if( !pso.pipelineLayout )
+		{
+			return;
+		}
+		AZHAL_ASSERT( pso.pushConstantStages, "the pso was created without push constants" );
+
+		cmd_buffer.pushConstants( pso.pipelineLayout, pso.pushConstantStages, offset, size, p_data );
+	}
+
+
+	void push_pso_constants( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, const void* p_data, Uint32 size, Uint32 offset )
+	{
+		push_pso_constants( cmd_buffer, get_pso( pso_handle ), p_data, size, offset );
+	}
+
+
+	void bind_pso_descriptor_set( vk::CommandBuffer cmd_buffer, const PSO& pso, vk::DescriptorSet descriptor_set )
+	{
+		if( !pso.pipelineLayout )
+		{
+			return;
+		}
+
+		cmd_buffer.bindDescriptorSets( pso.bindPoint, pso.pipelineLayout, 0, descriptor_set, {} );
+	}
+
+
+	void bind_pso_descriptor_set( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, vk::DescriptorSet descriptor_set )
+	{
+		bind_pso_descriptor_set( cmd_buffer, get_pso( pso_handle ), descriptor_set );
+	}
+
+
+	void destroy_pso_pool( const vk::Device device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		std::unique_lock lock( s_psoPoolMutex );
+		while( s_psoPool.GetCount() > 0 )
+		{
+			const PSOHandle pso_handle = s_psoPool.GetHandle( 0 );
+			const PSODebugInfo& debug_info = s_psoPool.Get<ePSOPoolColumnDebugInfo>( pso_handle );
+			AZHAL_LOG_WARN( "pso ({0}, {1}, {2}) was never destroyed", debug_info.vertexShader, debug_info.fragmentShader, debug_info.computeShader );
+
+			PSO pso = get_pooled_pso( pso_handle );
+			destroy_pso( device, pso );
+			s_psoPool.Destroy( pso_handle );
+		}
+	}
+
+
+	vk::PipelineCache create_pipeline_cache( const vk::Device device, const ByteBufferDynamic& initial_data )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::PipelineCacheCreateInfo pipeline_cache_create_info
+		{
+			.initialDataSize = initial_data.size(),
+			.pInitialData = initial_data.empty() ? VK_NULL_HANDLE : initial_data.data()
+		};
+
+		const vk::ResultValue rv_pipeline_cache = device.createPipelineCache( pipeline_cache_create_info );
+		return ( get_vk_result( rv_pipeline_cache, "failed to create pipeline cache" ) );
+	}
+
+
+	void destroy_pipeline_cache( const vk::Device device, vk::PipelineCache pipeline_cache )
+	{
+		device.destroy( pipeline_cache );
+	}
+
+
+	ByteBufferDynamic get_pipeline_cache_data( const vk::Device device, vk::PipelineCache pipeline_cache )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::ResultValue rv_cache_data = device.getPipelineCacheData( pipeline_cache );
+		const std::vector<Uint8> cache_data = get_vk_result( rv_cache_data, "failed to retrieve pipeline cache data" );
+
+		return ByteBufferDynamic( cache_data.begin(), cache_data.end() );
 	}
 
 }
\ No newline at end of file
@@ -3,21 +3,148 @@
 
 namespace gdevice
 {
+	// per-vertex input fetched by the fixed function stage. empty for shaders that generate or pull their vertices
+	struct VertexLayout
+	{
+		std::vector<vk::VertexInputBindingDescription> bindings;
+		std::vector<vk::VertexInputAttributeDescription> attributes;
+	};
+
 	struct PSOCreationParams
 	{
 		const AnsiChar* pVertexShader;
 		const AnsiChar* pFragmentShader;
 		Bool isDynamicRendering = VK_FALSE;
 		const std::vector<vk::Format> colorAttachmentFormats;
+		vk::PipelineCache pipelineCache = VK_NULL_HANDLE;
+
+		// spirv loaded ahead of time, e.g. by a warm-up job. the shader paths are only read when these are null
+		const ByteBufferDynamic* pVertexShaderCode = nullptr;
+		const ByteBufferDynamic* pFragmentShaderCode = nullptr;
+
+		// VK_EXT_mesh_shader: set pMeshShader instead of pVertexShader, the task shader is optional. the vertex input
+		// and input assembly state are ignored, see draw_mesh_tasks
+		const AnsiChar* pTaskShader = nullptr;
+		const AnsiChar* pMeshShader = nullptr;
+		const ByteBufferDynamic* pTaskShaderCode = nullptr;
+		const ByteBufferDynamic* pMeshShaderCode = nullptr;
+
+		// bytes of push constants, visible to every stage of the pso
+		Uint32 pushConstantSize = 0;
+		vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+		// imported meshes wind counter-clockwise
+		vk::FrontFace frontFace = vk::FrontFace::eClockwise;
+		VertexLayout vertexLayout;
+
+		// eUndefined renders without a depth attachment
+		vk::Format depthAttachmentFormat = vk::Format::eUndefined;
+		vk::CompareOp depthCompareOp = vk::CompareOp::eLessOrEqual;
+		Bool isDepthWriteEnabled = VK_TRUE;
+	};
+
+	struct ComputePSOCreationParams
+	{
+		const AnsiChar* pComputeShader;
+		vk::PipelineCache pipelineCache = VK_NULL_HANDLE;
+		// bytes of push constants the shader reads, see push_pso_constants
+		Uint32 pushConstantSize = 0;
+		// storage buffers at bindings 0..n-1 of set 0, for data the shader writes with atomics. see create_pso_descriptor_set
+		Uint32 storageBufferCount = 0;
+		// sampled images without samplers, bound after the storage buffers and read with Load
+		Uint32 sampledImageCount = 0;
+		// one array of storage images bound after the sampled images, e.g. one view per mip of a pyramid
+		Uint32 storageImageCount = 0;
+
+		// same as for graphics psos, the path is only read when this is null
+		const ByteBufferDynamic* pComputeShaderCode = nullptr;
 	};
 
 	struct PSO
 	{
 		vk::PipelineLayout pipelineLayout;
 		vk::Pipeline vkPipelineObject;
+		vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics;
+		// stages the push constant range of the layout is visible to, empty without push constants
+		vk::ShaderStageFlags pushConstantStages;
+		// set 0 of the pipeline layout, null when the pso takes no descriptors
+		vk::DescriptorSetLayout descriptorSetLayout;
+	};
+
+	struct PSOTag;
+	using PSOHandle = Handle<PSOTag>;
+
+	// cold data, only read when debugging or reporting
+	struct PSODebugInfo
+	{
+		String vertexShader;
+		String fragmentShader;
+		String computeShader;
+		String taskShader;
+		String meshShader;
 	};
 
+	struct PSOBindInfo
+	{
+		vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics;
+		vk::ShaderStageFlags pushConstantStages;
+		vk::DescriptorSetLayout descriptorSetLayout;
+	};
+
+	// columns of the pso pool, the pipeline is what render loops bind
+	enum PSOPoolColumn : Uint32
+	{
+		ePSOPoolColumnPipeline = 0,
+		ePSOPoolColumnLayout = 1,
+		ePSOPoolColumnBindInfo = 2,
+		ePSOPoolColumnDebugInfo = 3
+	};
+	using PSOPool = HandlePool<PSOTag, vk::Pipeline, vk::PipelineLayout, PSOBindInfo, PSODebugInfo>;
+
+	// safe to call from several threads at once, a shared pipeline cache is synchronized by the driver
 	PSO create_pso( const vk::Device device, const PSOCreationParams& pso_creation_params );
+	PSO create_compute_pso( const vk::Device device, const ComputePSOCreationParams& compute_pso_creation_params );
+	// destroys immediately, at runtime use the Context overload which defers until the gpu is done with it
 	void destroy_pso( const vk::Device device, PSO& pso );
 
+	// the process-wide pso pool. registering and unregistering may happen from several threads, lookups take a
+	// shared lock. unregister hands the objects back, the caller decides when they are destroyed
+	PSOHandle register_pso( const PSO& pso, const PSOCreationParams& pso_creation_params );
+	PSOHandle register_pso( const PSO& pso, const ComputePSOCreationParams& compute_pso_creation_params );
+	PSO unregister_pso( PSOHandle pso_handle );
+	// a stale or null handle resolves to a null pso in every configuration, the functions below skip those
+	PSO get_pso( PSOHandle pso_handle );
+	Bool is_pso_valid( PSOHandle pso_handle );
+
+	// the handle overloads look the pso up under the pool lock on every call. recording loops resolve a handle once
+	// with get_pso and pass the PSO instead
+	// binds to the graphics or compute bind point, whichever the pso was created for
+	void bind_pso( vk::CommandBuffer cmd_buffer, const PSO& pso );
+	void bind_pso( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle );
+	void push_pso_constants( vk::CommandBuffer cmd_buffer, const PSO& pso, const void* p_data, Uint32 size, Uint32 offset = 0 );
+	void push_pso_constants( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, const void* p_data, Uint32 size, Uint32 offset = 0 );
+
+	void bind_pso_descriptor_set( vk::CommandBuffer cmd_buffer, const PSO& pso, vk::DescriptorSet descriptor_set );
+	void bind_pso_descriptor_set( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, vk::DescriptorSet descriptor_set );
+
+	template<typename T>
+	AZHAL_INLINE void push_pso_constants( vk::CommandBuffer cmd_buffer, const PSO& pso, const T& constants )
+	{
+		AZHAL_STATIC_ASSERT( std::is_trivially_copyable_v<T>, "push constants are copied byte for byte" );
+		push_pso_constants( cmd_buffer, pso, &constants, static_cast< Uint32 >( sizeof( T ) ) );
+	}
+
+	template<typename T>
+	AZHAL_INLINE void push_pso_constants( vk::CommandBuffer cmd_buffer, PSOHandle pso_handle, const T& constants )
+	{
+		AZHAL_STATIC_ASSERT( std::is_trivially_copyable_v<T>, "push constants are copied byte for byte" );
+		push_pso_constants( cmd_buffer, pso_handle, &constants, static_cast< Uint32 >( sizeof( T ) ) );
+	}
+	// destroys psos that were never unregistered and reports them as leaks
+	void destroy_pso_pool( const vk::Device device );
+
+	// initial_data may be empty, the driver validates the header of blobs from previous runs
+	vk::PipelineCache create_pipeline_cache( const vk::Device device, const ByteBufferDynamic& initial_data );
+	void destroy_pipeline_cache( const vk::Device device, vk::PipelineCache pipeline_cache );
+	ByteBufferDynamic get_pipeline_cache_data( const vk::Device device, vk::PipelineCache pipeline_cache );
+
 }
\ No newline at end of file
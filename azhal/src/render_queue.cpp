@@ -0,0 +1,216 @@
+#include "azpch.h"
+#include "render_queue.h"
+
+#include <bit>
+
+namespace
+{
+	// positive floats compare like their bit patterns, which keeps the depth bits exact instead of quantizing them
+	Uint32 get_depth_key_bits( Float view_depth, gdevice::RenderDepthOrder depth_order )
+	{
+		const Uint32 depth_bits = std::bit_cast< Uint32 >( std::max( view_depth, 0.0f ) );
+		return ( depth_order == gdevice::RenderDepthOrder::eBackToFront ) ? ~depth_bits : depth_bits;
+	}
+
+
+	Bool is_same_viewport( const vk::Viewport& a, const vk::Viewport& b )
+	{
+		return ( a.x == b.x ) && ( a.y == b.y ) && ( a.width == b.width ) && ( a.height == b.height ) && ( a.minDepth == b.minDepth ) && ( a.maxDepth == b.maxDepth );
+	}
+}
+
+namespace gdevice
+{
+	Uint64 make_render_key( Uint32 pass, PSOHandle pso_handle, Uint32 material, Float view_depth, RenderDepthOrder depth_order )
+	{
+		AZHAL_ASSERT( pass < K_RENDER_QUEUE_MAX_PASSES, "render key pass out of range" );
+		AZHAL_ASSERT( pso_handle.index < ( 1u << K_RENDER_KEY_PSO_BITS ), "pso slot does not fit into a render key" );
+		AZHAL_ASSERT( material < ( 1u << K_RENDER_KEY_MATERIAL_BITS ), "material does not fit into a render key" );
+
+		// the pso slot, not the generation: two live psos never share a slot
+		return ( static_cast< Uint64 >( pass ) << ( 64 - K_RENDER_KEY_PASS_BITS ) ) |
+			( static_cast< Uint64 >( pso_handle.index ) << ( K_RENDER_KEY_MATERIAL_BITS + K_RENDER_KEY_DEPTH_BITS ) ) |
+			( static_cast< Uint64 >( material ) << K_RENDER_KEY_DEPTH_BITS ) |
+			get_depth_key_bits( view_depth, depth_order );
+	}
+
+
+	void reset_render_queue( RenderQueue& render_queue )
+	{
+		render_queue.keys.clear();
+		render_queue.itemIndices.clear();
+		render_queue.items.clear();
+		render_queue.pushConstantData.clear();
+		render_queue.pushConstantOffsets.clear();
+		render_queue.passBegin.fill( 0 );
+		render_queue.isSorted = false;
+		render_queue.stats = {};
+	}
+
+
+	void submit_render_item( RenderQueue& render_queue, Uint64 key, const RenderItem& item )
+	{
+		AZHAL_ASSERT( !render_queue.isSorted, "the render queue was already sorted, reset it before submitting the next frame" );
+
+		const Uint32 item_index = static_cast< Uint32 >( render_queue.items.size() );
+		render_queue.keys.push_back( key );
+		render_queue.itemIndices.push_back( item_index );
+		render_queue.items.push_back( item );
+
+		// the data is copied now, its pointer is only patched in once the array stopped growing
+		const Uint32 push_constant_offset = static_cast< Uint32 >( render_queue.pushConstantData.size() );
+		render_queue.pushConstantOffsets.push_back( push_constant_offset );
+		if( item.pushConstantSize > 0 )
+		{
+			const Uint8* p_data = static_cast< const Uint8* >( item.pPushConstants );
+			render_queue.pushConstantData.insert( render_queue.pushConstantData.end(), p_data, p_data + item.pushConstantSize );
+		}
+	}
+
+
+	void sort_render_queue( RenderQueue& render_queue, RenderQueueOrder order )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const Uint32 count = static_cast< Uint32 >( render_queue.keys.size() );
+		if( order == RenderQueueOrder::eSubmission )
+		{
+			// the radix sort skips the digits every key shares, so only the pass byte is sorted
+			constexpr Uint64 pass_mask = ~0ull << ( 64 - K_RENDER_KEY_PASS_BITS );
+			for( Uint64& key : render_queue.keys )
+			{
+				key &= pass_mask;
+			}
+		}
+
+		render_queue.scratchKeys.resize( count );
+		render_queue.scratchItemIndices.resize( count );
+		RadixSortKeyValues( render_queue.keys.data(), render_queue.itemIndices.data(),
+			render_queue.scratchKeys.data(), render_queue.scratchItemIndices.data(), count, render_queue.sortHistograms );
+
+		for( Uint32 i = 0; i < count; ++i )
+		{
+			RenderItem& item = render_queue.items[ i ];
+			if( item.pushConstantSize > 0 )
+			{
+				item.pPushConstants = render_queue.pushConstantData.data() + render_queue.pushConstantOffsets[ i ];
+			}
+		}
+
+		// the keys are sorted by pass first, so every pass is one contiguous range
+		Uint32 key_index = 0;
+		for( Uint32 pass = 0; pass < K_RENDER_QUEUE_MAX_PASSES; ++pass )
+		{
+			render_queue.passBegin[ pass ] = key_index;
+			while( key_index < count && get_render_key_pass( render_queue.keys[ key_index ] ) == pass )
+			{
+				++key_index;
+			}
+		}
+		render_queue.passBegin[ K_RENDER_QUEUE_MAX_PASSES ] = count;
+
+		render_queue.isSorted = true;
+	}
+
+
+	void record_render_queue( RenderQueue& render_queue, vk::CommandBuffer cmd_buffer, Uint32 pass )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		AZHAL_ASSERT( render_queue.isSorted, "sort_render_queue has to run before the queue is recorded" );
+		AZHAL_ASSERT( pass < K_RENDER_QUEUE_MAX_PASSES, "render queue pass out of range" );
+
+		RenderQueueStats& stats = render_queue.stats;
+
+		// nothing is known to be bound when the pass starts. the bound pso is resolved once per change, so the pool
+		// lock is taken per pso switch instead of per bind and push
+		PSOHandle bound_pso;
+		PSO bound_pso_objects;
+		vk::DescriptorSet bound_descriptor_set;
+		const Mesh* p_bound_mesh = nullptr;
+		vk::Viewport bound_viewport;
+
+		for( Uint32 i = render_queue.passBegin[ pass ]; i < render_queue.passBegin[ pass + 1 ]; ++i )
+		{
+			const RenderItem& item = render_queue.items[ render_queue.itemIndices[ i ] ];
+
+			if( item.pso != bound_pso )
+			{
+				bound_pso_objects = get_pso( item.pso );
+				bind_pso( cmd_buffer, bound_pso_objects );
+				bound_pso = item.pso;
+				++stats.psoBinds;
+
+				// psos have their own pipeline layouts, a set bound against the previous one may be disturbed
+				bound_descriptor_set = VK_NULL_HANDLE;
+			}
+			else
+			{
+				++stats.psoBindsSkipped;
+			}
+
+			if( item.descriptorSet )
+			{
+				if( item.descriptorSet != bound_descriptor_set )
+				{
+					bind_pso_descriptor_set( cmd_buffer, bound_pso_objects, item.descriptorSet );
+					bound_descriptor_set = item.descriptorSet;
+					++stats.descriptorSetBinds;
+				}
+				else
+				{
+					++stats.descriptorSetBindsSkipped;
+				}
+			}
+
+			if( item.pMesh )
+			{
+				if( !p_bound_mesh || !is_same_mesh_binding( *item.pMesh, *p_bound_mesh ) )
+				{
+					bind_mesh( cmd_buffer, *item.pMesh );
+					p_bound_mesh = item.pMesh;
+					++stats.meshBinds;
+				}
+				else
+				{
+					++stats.meshBindsSkipped;
+				}
+			}
+
+			if( item.viewport.width > 0.0f )
+			{
+				if( !is_same_viewport( item.viewport, bound_viewport ) )
+				{
+					const vk::Rect2D scissor
+					{
+						.offset = { static_cast< Int32 >( item.viewport.x ), static_cast< Int32 >( item.viewport.y ) },
+						.extent = { std::max<Uint32>( static_cast< Uint32 >( item.viewport.width ), 1 ), std::max<Uint32>( static_cast< Uint32 >( item.viewport.height ), 1 ) }
+					};
+					cmd_buffer.setViewport( 0, item.viewport );
+					cmd_buffer.setScissor( 0, scissor );
+					bound_viewport = item.viewport;
+					++stats.viewportSets;
+				}
+				else
+				{
+					++stats.viewportSetsSkipped;
+				}
+			}
+
+			if( item.pushConstantSize > 0 )
+			{
+				push_pso_constants( cmd_buffer, bound_pso_objects, item.pPushConstants, item.pushConstantSize );
+			}
+
+			if( item.pMesh )
+			{
+				draw_mesh( cmd_buffer, *item.pMesh, item.instanceCount, item.firstInstance );
+			}
+			else
+			{
+				cmd_buffer.draw( item.vertexCount, item.instanceCount, 0, item.firstInstance );
+			}
+			++stats.drawCount;
+		}
+	}
+}
\ No newline at end of file
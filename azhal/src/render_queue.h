@@ -0,0 +1,106 @@
+#pragma once
+
+#include "mesh.h"
+#include "pso.h"
+
+namespace gdevice
+{
+	// a render key from most to least significant bits: pass, pso, material, depth. sorting by key groups the draws
+	// of a pass by pso, the draws of a pso by material, and orders the draws that share all state by depth
+	constexpr Uint32 K_RENDER_KEY_PASS_BITS = 4;
+	constexpr Uint32 K_RENDER_KEY_PSO_BITS = 12;
+	constexpr Uint32 K_RENDER_KEY_MATERIAL_BITS = 16;
+	constexpr Uint32 K_RENDER_KEY_DEPTH_BITS = 32;
+	AZHAL_STATIC_ASSERT( K_RENDER_KEY_PASS_BITS + K_RENDER_KEY_PSO_BITS + K_RENDER_KEY_MATERIAL_BITS + K_RENDER_KEY_DEPTH_BITS == 64, "render keys are 64 bits" );
+
+	constexpr Uint32 K_RENDER_QUEUE_MAX_PASSES = 1 << K_RENDER_KEY_PASS_BITS;
+
+	enum class RenderDepthOrder : Uint32
+	{
+		// opaque draws, so that early depth testing rejects the hidden ones
+		eFrontToBack = 0,
+		// blended draws
+		eBackToFront = 1
+	};
+
+	// view_depth is the distance along the view direction, negative depths are clamped to 0. material is any id the
+	// caller gives its descriptor sets, draws of one pso with the same material have to share their descriptor set
+	Uint64 make_render_key( Uint32 pass, PSOHandle pso_handle, Uint32 material, Float view_depth, RenderDepthOrder depth_order = RenderDepthOrder::eFrontToBack );
+
+	AZHAL_INLINE Uint32 get_render_key_pass( Uint64 key )
+	{
+		return static_cast< Uint32 >( key >> ( 64 - K_RENDER_KEY_PASS_BITS ) );
+	}
+
+	// one draw and the state it needs
+	struct RenderItem
+	{
+		PSOHandle pso;
+		// set 0 of the pso, left alone when null
+		vk::DescriptorSet descriptorSet;
+		// bound and drawn with draw_mesh when set, otherwise vertexCount vertices are drawn without vertex buffers. the
+		// meshes of a GeometryPool share one binding
+		const Mesh* pMesh = nullptr;
+		Uint32 vertexCount = 0;
+		Uint32 instanceCount = 1;
+		Uint32 firstInstance = 0;
+		// also sets the scissor to the viewport's rect. a width of 0 keeps the current viewport and scissor
+		vk::Viewport viewport;
+		// copied by submit_render_item, pushed before every draw that has them
+		const void* pPushConstants = nullptr;
+		Uint32 pushConstantSize = 0;
+	};
+
+	enum class RenderQueueOrder : Uint32
+	{
+		// pass, then the rest of the key
+		eKey = 0,
+		// pass only, the draws of a pass keep their submission order. the baseline key sorting is measured against
+		eSubmission = 1
+	};
+
+	// bind calls record_render_queue issued and the ones it skipped because the state was already bound
+	struct RenderQueueStats
+	{
+		Uint32 drawCount = 0;
+		Uint32 psoBinds = 0;
+		Uint32 psoBindsSkipped = 0;
+		Uint32 descriptorSetBinds = 0;
+		Uint32 descriptorSetBindsSkipped = 0;
+		Uint32 meshBinds = 0;
+		Uint32 meshBindsSkipped = 0;
+		Uint32 viewportSets = 0;
+		Uint32 viewportSetsSkipped = 0;
+	};
+
+	// draws collected in any order during a frame, then sorted by key and recorded with redundant binds removed.
+	// the arrays keep their capacity across reset_render_queue, so a steady frame does not allocate
+	struct RenderQueue
+	{
+		std::vector<Uint64> keys;
+		// into items, permuted along with keys by the sort
+		std::vector<Uint32> itemIndices;
+		std::vector<RenderItem> items;
+		// pPushConstants of the items points in here once sorted
+		std::vector<Uint8> pushConstantData;
+		std::vector<Uint32> pushConstantOffsets;
+
+		std::vector<Uint64> scratchKeys;
+		std::vector<Uint32> scratchItemIndices;
+		RadixSortHistograms sortHistograms;
+
+		// the first key of every pass, filled by sort_render_queue
+		std::array<Uint32, K_RENDER_QUEUE_MAX_PASSES + 1> passBegin = {};
+		Bool isSorted = false;
+
+		// accumulated over every record_render_queue since the last reset
+		RenderQueueStats stats;
+	};
+
+	void reset_render_queue( RenderQueue& render_queue );
+	void submit_render_item( RenderQueue& render_queue, Uint64 key, const RenderItem& item );
+	// stable, draws with equal keys keep their submission order. splits across JobSystem workers for large queues
+	void sort_render_queue( RenderQueue& render_queue, RenderQueueOrder order = RenderQueueOrder::eKey );
+	// records the draws of one pass in key order, inside a render pass or dynamic rendering scope the caller began
+	void record_render_queue( RenderQueue& render_queue, vk::CommandBuffer cmd_buffer, Uint32 pass );
+}
\ No newline at end of file
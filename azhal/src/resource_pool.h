@@ -0,0 +1,94 @@
+#pragma once
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace gdevice
+{
+	// a process-wide HandlePool of one gdevice object type, what the Context overloads hand out handles into. registering
+	// and unregistering may happen from several threads, lookups take a shared lock. a stale or null handle resolves to
+	// a default constructed object in every configuration, like get_pso
+	template<typename Tag, typename T>
+	class ResourcePool : NonCopyable
+	{
+	public:
+		using HandleType = Handle<Tag>;
+
+		ResourcePool( const AnsiChar* p_name, Uint32 reserve_count )
+			: m_pName( p_name )
+			, m_pool( reserve_count )
+		{
+		}
+
+		HandleType Register( const T& object )
+		{
+			std::unique_lock lock( m_mutex );
+			return m_pool.Create( object );
+		}
+
+		// hands the object back, the caller decides when it is destroyed. a null handle hands back a null object
+		T Unregister( HandleType handle )
+		{
+			if( handle.IsNull() )
+			{
+				return T {};
+			}
+
+			std::unique_lock lock( m_mutex );
+			AZHAL_ASSERT( m_pool.IsValid( handle ), "destroying through a stale handle" );
+
+			const T object = GetLocked( handle );
+			if( m_pool.IsValid( handle ) )
+			{
+				m_pool.Destroy( handle );
+			}
+
+			return object;
+		}
+
+		T Get( HandleType handle ) const
+		{
+			std::shared_lock lock( m_mutex );
+			return GetLocked( handle );
+		}
+
+		Bool IsValid( HandleType handle ) const
+		{
+			std::shared_lock lock( m_mutex );
+			return m_pool.IsValid( handle );
+		}
+
+		// hands every object that was never unregistered to destroy_object and reports it as a leak
+		template<typename DestroyFn>
+		void DestroyAll( DestroyFn&& destroy_object )
+		{
+			std::unique_lock lock( m_mutex );
+			while( m_pool.GetCount() > 0 )
+			{
+				const HandleType handle = m_pool.GetHandle( 0 );
+				AZHAL_LOG_WARN( "{0} (slot {1}) was never destroyed", m_pName, handle.index );
+
+				T object = m_pool.template Get<0>( handle );
+				destroy_object( object );
+				m_pool.Destroy( handle );
+			}
+		}
+
+	private:
+		// the mutex must be held. HandlePool::Get only asserts, which Profile and Final compile out
+		T GetLocked( HandleType handle ) const
+		{
+			if( !m_pool.IsValid( handle ) )
+			{
+				AZHAL_LOG_ERROR( "{0} lookup through a stale or null handle (slot {1}, generation {2})", m_pName, handle.index, handle.generation );
+				return T {};
+			}
+
+			return m_pool.template Get<0>( handle );
+		}
+
+		const AnsiChar* m_pName;
+		mutable std::shared_mutex m_mutex;
+		HandlePool<Tag, T> m_pool;
+	};
+}
\ No newline at end of file
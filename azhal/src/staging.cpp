@@ -0,0 +1,165 @@
+#include "azpch.h"
+#include "staging.h"
+
+#include "buffer.h"
+#include "deferred_destruction.h"
+#include "frame.h"
+
+#include <bit>
+#include <deque>
+#include <mutex>
+
+namespace
+{
+	// bytes one frame took from the ring, alignment padding and the tail skipped by a wrap included
+	struct StagingFrameUsage
+	{
+		Uint64 frameIndex = 0;
+		vk::DeviceSize size = 0;
+	};
+
+	std::mutex s_stagingMutex;
+	gdevice::Buffer s_stagingBuffer;
+	// the ring's live bytes end at s_head and start s_usedSize bytes before it, wrapping around the buffer's end
+	vk::DeviceSize s_head = 0;
+	vk::DeviceSize s_usedSize = 0;
+	// ordered by frameIndex
+	std::deque<StagingFrameUsage> s_frameUsages;
+	Bool s_isOverflowReported = false;
+}
+
+namespace
+{
+	vk::DeviceSize align_up( vk::DeviceSize value, vk::DeviceSize alignment )
+	{
+		return ( value + alignment - 1 ) & ~( alignment - 1 );
+	}
+
+
+	// must be called with s_stagingMutex held
+	Bool try_allocate_from_ring( vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& out_offset )
+	{
+		const vk::DeviceSize capacity = s_stagingBuffer.size;
+
+		vk::DeviceSize offset = align_up( s_head, alignment );
+		vk::DeviceSize taken_size = offset - s_head;
+		if( offset + size > capacity )
+		{
+			// copies need one contiguous range, the rest of the buffer is skipped
+			offset = 0;
+			taken_size = capacity - s_head;
+		}
+		taken_size += size;
+
+		if( s_usedSize + taken_size > capacity )
+		{
+			return false;
+		}
+
+		s_head = offset + size;
+		s_usedSize += taken_size;
+
+		const Uint64 frame_index = gdevice::get_current_frame_index();
+		if( s_frameUsages.empty() || s_frameUsages.back().frameIndex != frame_index )
+		{
+			s_frameUsages.push_back( StagingFrameUsage { .frameIndex = frame_index } );
+		}
+		s_frameUsages.back().size += taken_size;
+
+		out_offset = offset;
+		return true;
+	}
+}
+
+namespace gdevice
+{
+	void init_staging_ring( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::DeviceSize capacity )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const BufferCreationParams staging_creation_params
+		{
+			.size = capacity,
+			.usage = vk::BufferUsageFlagBits::eTransferSrc,
+			.memoryUsage = BufferMemoryUsage::eCpuToGpu
+		};
+		s_stagingBuffer = create_buffer( device_capabilities, device, staging_creation_params, {} );
+		s_head = 0;
+		s_usedSize = 0;
+		s_frameUsages.clear();
+		s_isOverflowReported = false;
+	}
+
+
+	void destroy_staging_ring( const vk::Device device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		destroy_buffer( device, s_stagingBuffer );
+		s_frameUsages.clear();
+	}
+
+
+	StagingAllocation allocate_staging( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::DeviceSize size, vk::DeviceSize alignment )
+	{
+		AZHAL_ASSERT( size > 0, "staging allocations must not be empty" );
+		AZHAL_ASSERT( std::has_single_bit( alignment ), "staging alignment must be a power of two" );
+
+		{
+			std::scoped_lock lock( s_stagingMutex );
+
+			vk::DeviceSize offset = 0;
+			if( s_stagingBuffer.vkBuffer && try_allocate_from_ring( size, alignment, offset ) )
+			{
+				return StagingAllocation
+				{
+					.vkBuffer = s_stagingBuffer.vkBuffer,
+					.offset = offset,
+					.pMappedData = static_cast< Uint8* >( s_stagingBuffer.pMappedData ) + offset
+				};
+			}
+
+			if( !s_isOverflowReported )
+			{
+				AZHAL_LOG_WARN( "the staging ring ({0} bytes) cannot hold an upload of {1} bytes, it gets a dedicated buffer", s_stagingBuffer.size, size );
+				s_isOverflowReported = true;
+			}
+		}
+
+		const BufferCreationParams staging_creation_params
+		{
+			.size = size,
+			.usage = vk::BufferUsageFlagBits::eTransferSrc,
+			.memoryUsage = BufferMemoryUsage::eCpuToGpu
+		};
+		Buffer staging_buffer = create_buffer( device_capabilities, device, staging_creation_params, {} );
+		const StagingAllocation allocation
+		{
+			.vkBuffer = staging_buffer.vkBuffer,
+			.offset = 0,
+			.pMappedData = staging_buffer.pMappedData
+		};
+		// destroyed with the frame's other deferred objects, after the copy that reads it
+		defer_destroy_buffer( staging_buffer );
+
+		return allocation;
+	}
+
+
+	void release_staging( Uint64 completed_frame_index )
+	{
+		std::scoped_lock lock( s_stagingMutex );
+
+		while( !s_frameUsages.empty() && s_frameUsages.front().frameIndex <= completed_frame_index )
+		{
+			s_usedSize -= s_frameUsages.front().size;
+			s_frameUsages.pop_front();
+		}
+
+		// nothing is live, so the next allocation may as well start at the beginning instead of wrapping early
+		if( s_usedSize == 0 )
+		{
+			s_head = 0;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace gdevice
+{
+	struct DeviceCapabilities;
+
+	// upload memory shared by every record_*_upload: one persistently mapped buffer used as a ring. allocations are
+	// tagged with the current frame and handed back once that frame retired, so a steady stream of uploads never
+	// allocates device memory
+	struct StagingAllocation
+	{
+		vk::Buffer vkBuffer;
+		vk::DeviceSize offset = 0;
+		// offset is already applied
+		void* pMappedData = nullptr;
+	};
+
+	void init_staging_ring( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::DeviceSize capacity );
+	// the device must be idle
+	void destroy_staging_ring( const vk::Device device );
+
+	// valid until the current frame retired. an allocation the ring cannot hold right now gets a dedicated buffer that
+	// is destroyed the same way, alignment must be a power of two
+	StagingAllocation allocate_staging( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::DeviceSize size, vk::DeviceSize alignment );
+
+	// hands back the allocations made during frames up to and including completed_frame_index
+	void release_staging( Uint64 completed_frame_index );
+}
\ No newline at end of file
@@ -0,0 +1,525 @@
+#include "azpch.h"
+#include "submission.h"
+
+#include <thread>
+
+namespace
+{
+	enum class PacketType : Uint32
+	{
+		eNone = 0,
+		eSubmit = 1,
+		ePresent = 2,
+		eShutdown = 3
+	};
+
+	struct SubmissionPacket
+	{
+		PacketType type = PacketType::eNone;
+		gdevice::QueueType queueType = gdevice::QueueType::eInvalid;
+		gdevice::SubmitParams submit;
+		gdevice::PresentParams present;
+	};
+
+	// submits the thread has not handed to the driver yet, all for the same queue
+	struct PendingSubmits
+	{
+		gdevice::QueueType queueType = gdevice::QueueType::eInvalid;
+		std::vector<gdevice::SubmitParams> batches;
+		Uint64 lastValue = 0;
+		vk::Fence fence = VK_NULL_HANDLE;
+
+		std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+		std::vector<vk::SemaphoreSubmitInfo> signalInfos;
+		std::vector<vk::CommandBufferSubmitInfo> cmdBufferInfos;
+		std::vector<vk::SubmitInfo2> submitInfos;
+	};
+
+	constexpr Uint32 K_PACKET_QUEUE_CAPACITY = 1024;
+	constexpr Uint32 K_MAX_BATCHES_PER_SUBMIT = 64;
+
+	MpscQueue<SubmissionPacket, K_PACKET_QUEUE_CAPACITY> s_packetQueue;
+	// packets pushed and not popped yet. only the push that finds it at zero wakes the thread, later pushes land while it
+	// drains and get coalesced. it dips below zero while a packet is popped before its push counted it
+	std::atomic<Int64> s_unpoppedPacketCount = 0;
+	// bumped by the pushes that wake the thread, it sleeps on it while the queue is empty
+	std::atomic<Uint32> s_wakeGeneration = 0;
+	// value of the last packet handed to the driver
+	std::atomic<Uint64> s_processedValue = 0;
+
+	std::thread s_submissionThread;
+	std::array<vk::Queue, gdevice::K_QUEUE_TYPE_COUNT> s_queues;
+	std::array<vk::Semaphore, gdevice::K_QUEUE_TYPE_COUNT> s_timelineSemaphores;
+
+	std::atomic<Bool> s_isPresentOutOfDate = false;
+	// the first VkResult a submit or present failed with, sticky since the fences of that work never signal
+	std::atomic<Int32> s_submissionError = VK_SUCCESS;
+	std::mutex s_swapchainMutex;
+}
+
+namespace
+{
+	Uint64 push_packet( const SubmissionPacket& packet )
+	{
+		const Uint64 value = s_packetQueue.Push( packet ) + 1;
+
+		if( s_unpoppedPacketCount.fetch_add( 1, std::memory_order_seq_cst ) == 0 )
+		{
+			s_wakeGeneration.fetch_add( 1, std::memory_order_release );
+			s_wakeGeneration.notify_one();
+		}
+
+		return value;
+	}
+
+
+	void record_submission_error( vk::Result result )
+	{
+		Int32 expected = VK_SUCCESS;
+		s_submissionError.compare_exchange_strong( expected, static_cast< Int32 >( result ), std::memory_order_release, std::memory_order_relaxed );
+	}
+
+
+	void publish_processed_value( Uint64 value )
+	{
+		s_processedValue.store( value, std::memory_order_release );
+		s_processedValue.notify_all();
+	}
+
+
+	void flush_pending_submits( PendingSubmits& pending )
+	{
+		if( pending.batches.empty() )
+		{
+			return;
+		}
+
+		AZHAL_PROFILE_SCOPE( "vkQueueSubmit2" );
+
+		const Uint32 batch_count = static_cast< Uint32 >( pending.batches.size() );
+		const Uint32 queue_index = gdevice::get_queue_type_index( pending.queueType );
+
+		// the infos point into these, so they must not reallocate while being filled
+		pending.waitInfos.clear();
+		pending.signalInfos.clear();
+		pending.cmdBufferInfos.clear();
+		pending.submitInfos.clear();
+		pending.waitInfos.reserve( batch_count * 2 );
+		pending.signalInfos.reserve( batch_count + 1 );
+		pending.cmdBufferInfos.reserve( batch_count );
+		pending.submitInfos.reserve( batch_count );
+
+		for( Uint32 i = 0; i < batch_count; ++i )
+		{
+			const gdevice::SubmitParams& batch = pending.batches[ i ];
+			const Bool is_last_batch = ( i + 1 == batch_count );
+
+			const vk::SemaphoreSubmitInfo* p_wait_infos = pending.waitInfos.data() + pending.waitInfos.size();
+			if( batch.waitSemaphore )
+			{
+				pending.waitInfos.push_back( vk::SemaphoreSubmitInfo
+				{
+					.semaphore = batch.waitSemaphore,
+					.value = batch.waitSemaphoreValue,
+					.stageMask = batch.waitStageMask
+				} );
+			}
+			if( batch.waitQueueType != gdevice::QueueType::eInvalid )
+			{
+				pending.waitInfos.push_back( vk::SemaphoreSubmitInfo
+				{
+					.semaphore = s_timelineSemaphores[ gdevice::get_queue_type_index( batch.waitQueueType ) ],
+					.value = batch.waitQueueValue,
+					.stageMask = batch.waitQueueStageMask
+				} );
+			}
+			const Uint32 wait_count = static_cast< Uint32 >( pending.waitInfos.data() + pending.waitInfos.size() - p_wait_infos );
+
+			const vk::SemaphoreSubmitInfo* p_signal_infos = pending.signalInfos.data() + pending.signalInfos.size();
+			if( batch.signalSemaphore )
+			{
+				pending.signalInfos.push_back( vk::SemaphoreSubmitInfo
+				{
+					.semaphore = batch.signalSemaphore,
+					.stageMask = vk::PipelineStageFlagBits2::eAllCommands
+				} );
+			}
+			// signals cover everything earlier in submission order, so only the last batch signals the timeline
+			if( is_last_batch )
+			{
+				pending.signalInfos.push_back( vk::SemaphoreSubmitInfo
+				{
+					.semaphore = s_timelineSemaphores[ queue_index ],
+					.value = pending.lastValue,
+					.stageMask = vk::PipelineStageFlagBits2::eAllCommands
+				} );
+			}
+			const Uint32 signal_count = static_cast< Uint32 >( pending.signalInfos.data() + pending.signalInfos.size() - p_signal_infos );
+
+			pending.cmdBufferInfos.push_back( vk::CommandBufferSubmitInfo
+			{
+				.commandBuffer = batch.cmdBuffer
+			} );
+
+			pending.submitInfos.push_back( vk::SubmitInfo2
+			{
+				.waitSemaphoreInfoCount = wait_count,
+				.pWaitSemaphoreInfos = p_wait_infos,
+				.commandBufferInfoCount = 1,
+				.pCommandBufferInfos = &pending.cmdBufferInfos.back(),
+				.signalSemaphoreInfoCount = signal_count,
+				.pSignalSemaphoreInfos = p_signal_infos
+			} );
+		}
+
+		const vk::Result res_submit = s_queues[ queue_index ].submit2( pending.submitInfos, pending.fence );
+		if( res_submit != vk::Result::eSuccess )
+		{
+			// exceptions cannot leave this thread, the producers throw on their next begin_frame or submit instead
+			AZHAL_LOG_CRITICAL( "vkQueueSubmit2 failed: {0}", vk::to_string( res_submit ) );
+			record_submission_error( res_submit );
+		}
+
+		publish_processed_value( pending.lastValue );
+
+		pending.batches.clear();
+		pending.fence = VK_NULL_HANDLE;
+		pending.queueType = gdevice::QueueType::eInvalid;
+	}
+
+
+	void process_present( const gdevice::PresentParams& present_params )
+	{
+		const vk::Queue present_queue = s_queues[ gdevice::get_queue_type_index( gdevice::QueueType::ePresent ) ];
+
+		vk::Result res_present;
+		{
+			std::scoped_lock lock( s_swapchainMutex );
+			res_present = gdevice::present_swapchain_image( present_queue, present_params );
+		}
+
+		if( res_present == vk::Result::eErrorOutOfDateKHR || res_present == vk::Result::eSuboptimalKHR )
+		{
+			s_isPresentOutOfDate.store( true, std::memory_order_release );
+		}
+		else if( res_present != vk::Result::eSuccess )
+		{
+			AZHAL_LOG_CRITICAL( "failed to present swapchain image: {0}", vk::to_string( res_present ) );
+			record_submission_error( res_present );
+		}
+	}
+
+
+	void submission_thread_main()
+	{
+		AZHAL_PROFILE_THREAD_NAME( "submission" );
+
+		PendingSubmits pending;
+		pending.batches.reserve( K_MAX_BATCHES_PER_SUBMIT );
+
+		Bool is_shutting_down = false;
+		while( !is_shutting_down )
+		{
+			const Uint32 wake_generation = s_wakeGeneration.load( std::memory_order_acquire );
+
+			SubmissionPacket packet;
+			Uint64 ticket = 0;
+			Bool has_popped_packet = false;
+			while( s_packetQueue.TryPop( packet, ticket ) )
+			{
+				s_unpoppedPacketCount.fetch_sub( 1, std::memory_order_seq_cst );
+				has_popped_packet = true;
+				const Uint64 value = ticket + 1;
+
+				if( packet.type != PacketType::eSubmit || packet.queueType != pending.queueType )
+				{
+					flush_pending_submits( pending );
+				}
+
+				switch( packet.type )
+				{
+				case PacketType::eSubmit:
+					pending.queueType = packet.queueType;
+					pending.batches.push_back( packet.submit );
+					pending.lastValue = value;
+					pending.fence = packet.submit.fence;
+					// a submit call takes a single fence, which signals once all of its batches completed
+					if( pending.fence || pending.batches.size() == K_MAX_BATCHES_PER_SUBMIT )
+					{
+						flush_pending_submits( pending );
+					}
+					break;
+				case PacketType::ePresent:
+					process_present( packet.present );
+					publish_processed_value( value );
+					break;
+				case PacketType::eShutdown:
+					is_shutting_down = true;
+					publish_processed_value( value );
+					break;
+				default:
+					publish_processed_value( value );
+					break;
+				}
+			}
+
+			// nothing else arrived while draining, so waiting longer would only add latency
+			flush_pending_submits( pending );
+
+			if( !has_popped_packet && !is_shutting_down )
+			{
+				// a push that took its ticket but has not written its packet yet, it does not wake the thread again
+				if( s_unpoppedPacketCount.load( std::memory_order_seq_cst ) > 0 )
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				AZHAL_PROFILE_SCOPE( "submission_idle" );
+				s_wakeGeneration.wait( wake_generation, std::memory_order_acquire );
+			}
+		}
+	}
+
+
+	vk::Semaphore create_timeline_semaphore( const vk::Device device )
+	{
+		const vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> semaphore_create_chain
+		{
+			vk::SemaphoreCreateInfo {},
+			vk::SemaphoreTypeCreateInfo
+			{
+				.semaphoreType = vk::SemaphoreType::eTimeline,
+				.initialValue = 0
+			}
+		};
+
+		const vk::ResultValue rv_semaphore = device.createSemaphore( semaphore_create_chain.get<vk::SemaphoreCreateInfo>() );
+		return ( gdevice::get_vk_result( rv_semaphore, "failed to create timeline semaphore" ) );
+	}
+}
+
+namespace gdevice
+{
+	void submit_command_buffer( const vk::Queue queue, const SubmitParams& submit_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const Bool has_signal_semaphore = static_cast< Bool >( submit_params.signalSemaphore );
+
+		std::array<vk::SemaphoreSubmitInfo, 2> wait_infos;
+		Uint32 wait_count = 0;
+		if( submit_params.waitSemaphore )
+		{
+			wait_infos[ wait_count++ ] = vk::SemaphoreSubmitInfo
+			{
+				.semaphore = submit_params.waitSemaphore,
+				.value = submit_params.waitSemaphoreValue,
+				.stageMask = submit_params.waitStageMask
+			};
+		}
+		if( submit_params.waitQueueType != QueueType::eInvalid )
+		{
+			wait_infos[ wait_count++ ] = vk::SemaphoreSubmitInfo
+			{
+				.semaphore = get_queue_timeline_semaphore( submit_params.waitQueueType ),
+				.value = submit_params.waitQueueValue,
+				.stageMask = submit_params.waitQueueStageMask
+			};
+		}
+		const vk::SemaphoreSubmitInfo signal_info
+		{
+			.semaphore = submit_params.signalSemaphore,
+			.stageMask = vk::PipelineStageFlagBits2::eAllCommands
+		};
+		const vk::CommandBufferSubmitInfo cmd_buffer_info
+		{
+			.commandBuffer = submit_params.cmdBuffer
+		};
+
+		const vk::SubmitInfo2 submit_info
+		{
+			.waitSemaphoreInfoCount = wait_count,
+			.pWaitSemaphoreInfos = wait_infos.data(),
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &cmd_buffer_info,
+			.signalSemaphoreInfoCount = has_signal_semaphore ? 1u : 0u,
+			.pSignalSemaphoreInfos = has_signal_semaphore ? &signal_info : VK_NULL_HANDLE
+		};
+
+		const vk::Result res_submit = queue.submit2( submit_info, submit_params.fence );
+		vk::resultCheck( res_submit, "failed to submit command buffer" );
+	}
+
+
+	vk::Result present_swapchain_image( const vk::Queue present_queue, const PresentParams& present_params )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::PresentIdKHR present_id_info
+		{
+			.swapchainCount = 1,
+			.pPresentIds = &present_params.presentId
+		};
+
+		const vk::PresentInfoKHR present_info
+		{
+			.pNext = ( present_params.presentId != 0 ) ? &present_id_info : VK_NULL_HANDLE,
+			.waitSemaphoreCount = 1,
+			.pWaitSemaphores = &present_params.waitSemaphore,
+			.swapchainCount = 1,
+			.pSwapchains = &present_params.swapchain,
+			.pImageIndices = &present_params.imageIndex
+		};
+
+		const vk::Result res_present = present_queue.presentKHR( present_info );
+		AZHAL_PROFILE_FRAME_MARK();
+
+		return res_present;
+	}
+
+
+	void init_submission_thread( const vk::Device device, const std::array<vk::Queue, K_QUEUE_TYPE_COUNT>& queues )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_FATAL_ASSERT( !s_submissionThread.joinable(), "submission thread is already running" );
+
+		s_queues = queues;
+		for( vk::Semaphore& timeline_semaphore : s_timelineSemaphores )
+		{
+			timeline_semaphore = create_timeline_semaphore( device );
+		}
+
+		s_isPresentOutOfDate.store( false );
+		s_submissionError.store( VK_SUCCESS );
+		s_unpoppedPacketCount.store( 0 );
+		s_submissionThread = std::thread( &submission_thread_main );
+	}
+
+
+	void shutdown_submission_thread( const vk::Device device )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const SubmissionPacket shutdown_packet
+		{
+			.type = PacketType::eShutdown
+		};
+		push_packet( shutdown_packet );
+		s_submissionThread.join();
+
+		for( vk::Semaphore& timeline_semaphore : s_timelineSemaphores )
+		{
+			device.destroy( timeline_semaphore );
+			timeline_semaphore = VK_NULL_HANDLE;
+		}
+		s_queues = {};
+	}
+
+
+	Uint64 enqueue_submit( QueueType queue_type, const SubmitParams& submit_params )
+	{
+		check_submission_error();
+
+		const SubmissionPacket packet
+		{
+			.type = PacketType::eSubmit,
+			.queueType = queue_type,
+			.submit = submit_params
+		};
+		return push_packet( packet );
+	}
+
+
+	Uint64 enqueue_present( const PresentParams& present_params )
+	{
+		check_submission_error();
+
+		const SubmissionPacket packet
+		{
+			.type = PacketType::ePresent,
+			.queueType = QueueType::ePresent,
+			.present = present_params
+		};
+		return push_packet( packet );
+	}
+
+
+	void wait_for_submission_thread( Uint64 value )
+	{
+		Uint64 processed_value = s_processedValue.load( std::memory_order_acquire );
+		if( processed_value >= value )
+		{
+			return;
+		}
+
+		AZHAL_PROFILE_FUNCTION();
+		while( processed_value < value )
+		{
+			s_processedValue.wait( processed_value, std::memory_order_acquire );
+			processed_value = s_processedValue.load( std::memory_order_acquire );
+		}
+	}
+
+
+	void wait_for_submission_thread_idle()
+	{
+		const SubmissionPacket marker_packet
+		{
+			.type = PacketType::eNone
+		};
+		wait_for_submission_thread( push_packet( marker_packet ) );
+	}
+
+
+	vk::Semaphore get_queue_timeline_semaphore( QueueType queue_type )
+	{
+		return s_timelineSemaphores[ get_queue_type_index( queue_type ) ];
+	}
+
+
+	Bool wait_for_queue_timeline( const vk::Device device, QueueType queue_type, Uint64 value, Uint64 timeout_ns )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::Semaphore timeline_semaphore = get_queue_timeline_semaphore( queue_type );
+		const vk::SemaphoreWaitInfo semaphore_wait_info
+		{
+			.semaphoreCount = 1,
+			.pSemaphores = &timeline_semaphore,
+			.pValues = &value
+		};
+
+		const vk::Result res_wait = device.waitSemaphores( semaphore_wait_info, timeout_ns );
+		if( res_wait == vk::Result::eTimeout )
+		{
+			return false;
+		}
+		vk::resultCheck( res_wait, "failed to wait for queue timeline semaphore" );
+
+		return true;
+	}
+
+
+	void check_submission_error()
+	{
+		const Int32 submission_error = s_submissionError.load( std::memory_order_acquire );
+		if( submission_error != VK_SUCCESS )
+		{
+			AZHAL_LOG_CRITICAL( "the submission thread failed with {0}, the device is lost", vk::to_string( static_cast< vk::Result >( submission_error ) ) );
+			throw GDeviceException( "a queue submit or present failed on the submission thread" );
+		}
+	}
+
+
+	Bool consume_present_out_of_date()
+	{
+		return s_isPresentOutOfDate.exchange( false, std::memory_order_acq_rel );
+	}
+
+
+	std::unique_lock<std::mutex> lock_swapchain_access()
+	{
+		return std::unique_lock<std::mutex>( s_swapchainMutex );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "enums.h"
+
+#include <mutex>
+
+namespace gdevice
+{
+	// indexed by QueueType - 1
+	constexpr Uint32 K_QUEUE_TYPE_COUNT = 4;
+
+	AZHAL_INLINE Uint32 get_queue_type_index( QueueType queue_type )
+	{
+		return static_cast< Uint32 >( queue_type ) - 1;
+	}
+
+	struct SubmitParams
+	{
+		vk::CommandBuffer cmdBuffer = VK_NULL_HANDLE;
+		vk::Semaphore waitSemaphore = VK_NULL_HANDLE;
+		// only read when waitSemaphore is a timeline semaphore
+		Uint64 waitSemaphoreValue = 0;
+		vk::PipelineStageFlags2 waitStageMask = vk::PipelineStageFlagBits2::eTopOfPipe;
+		// hand-off from another queue: waits until that queue's timeline semaphore reached the value its submit returned.
+		// waitQueueStageMask is the first stage of this submit that consumes the other queue's results
+		QueueType waitQueueType = QueueType::eInvalid;
+		Uint64 waitQueueValue = 0;
+		vk::PipelineStageFlags2 waitQueueStageMask = vk::PipelineStageFlagBits2::eAllCommands;
+		vk::Semaphore signalSemaphore = VK_NULL_HANDLE;
+		vk::Fence fence = VK_NULL_HANDLE;
+	};
+
+	struct PresentParams
+	{
+		vk::SwapchainKHR swapchain = VK_NULL_HANDLE;
+		Uint32 imageIndex = UINT32_MAX;
+		vk::Semaphore waitSemaphore = VK_NULL_HANDLE;
+		// chained through VK_KHR_present_id when non-zero, must increase with every present
+		Uint64 presentId = 0;
+	};
+
+	// direct submission, the caller must own the queue. at runtime the queues belong to the submission thread
+	void submit_command_buffer( const vk::Queue queue, const SubmitParams& submit_params );
+
+	// returns the raw result so that the caller can react to eSuboptimalKHR and eErrorOutOfDateKHR
+	vk::Result present_swapchain_image( const vk::Queue present_queue, const PresentParams& present_params );
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// the submission thread owns every vk::Queue once started. producers push submit and present packets onto a
+	// lock-free queue and return right away, the thread coalesces consecutive submits to the same queue into one
+	// vkQueueSubmit2 call. every packet gets a value in the order it was pushed; a submit signals its queue's
+	// timeline semaphore to that value, and wait_for_submission_thread( value ) returns once the packet reached the driver
+
+	void init_submission_thread( const vk::Device device, const std::array<vk::Queue, K_QUEUE_TYPE_COUNT>& queues );
+	// hands everything still queued to the driver, then stops the thread
+	void shutdown_submission_thread( const vk::Device device );
+
+	Uint64 enqueue_submit( QueueType queue_type, const SubmitParams& submit_params );
+	Uint64 enqueue_present( const PresentParams& present_params );
+
+	void wait_for_submission_thread( Uint64 value );
+	// waits for every packet pushed before the call
+	void wait_for_submission_thread_idle();
+
+	vk::Semaphore get_queue_timeline_semaphore( QueueType queue_type );
+	// returns false on timeout
+	Bool wait_for_queue_timeline( const vk::Device device, QueueType queue_type, Uint64 value, Uint64 timeout_ns = UINT64_MAX );
+
+	// a failed submit or present is sticky: the fences of its work never signal, so waiting on them would hang.
+	// throws GDeviceException once one happened, begin_frame and every enqueue check it
+	void check_submission_error();
+
+	// true when a present since the last call returned eErrorOutOfDateKHR or eSuboptimalKHR
+	Bool consume_present_out_of_date();
+
+	// acquire, present, present wait and swapchain recreation need exclusive access to the swapchain, and presents
+	// now happen on the submission thread. held only around those calls
+	std::unique_lock<std::mutex> lock_swapchain_access();
+}
\ No newline at end of file
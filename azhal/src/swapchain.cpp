@@ -1,9 +1,34 @@
 #include "azpch.h"
 #include "swapchain.h"
 
+#include <span>
+
 namespace
 {
-	vk::SwapchainCreateInfoKHR build_swapchain_create_info( const vk::PhysicalDevice physical_device, const vk::SurfaceKHR surface, vk::Extent2D desired_extent )
+	std::span<const vk::PresentModeKHR> get_present_mode_fallback_chain( gdevice::PresentPolicy present_policy )
+	{
+		static constexpr vk::PresentModeKHR immediate_chain[] = { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo };
+		static constexpr vk::PresentModeKHR mailbox_chain[] = { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifo };
+		static constexpr vk::PresentModeKHR fifo_chain[] = { vk::PresentModeKHR::eFifo };
+		static constexpr vk::PresentModeKHR fifo_relaxed_chain[] = { vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eFifo };
+
+		switch( present_policy )
+		{
+		case gdevice::PresentPolicy::eImmediate:
+			return immediate_chain;
+		case gdevice::PresentPolicy::eMailbox:
+			return mailbox_chain;
+		case gdevice::PresentPolicy::eFifoRelaxed:
+			return fifo_relaxed_chain;
+		case gdevice::PresentPolicy::eFifo:
+		default:
+			return fifo_chain;
+		}
+	}
+
+
+	vk::SwapchainCreateInfoKHR build_swapchain_create_info( const vk::PhysicalDevice physical_device, const vk::SurfaceKHR surface,
+		const gdevice::SwapchainCreationParams& swapchain_creation_params, const vk::SwapchainKHR old_swapchain )
 	{
 		const vk::ResultValue rv_surface_caps = physical_device.getSurfaceCapabilitiesKHR( surface );
 		const vk::SurfaceCapabilitiesKHR surface_caps = gdevice::get_vk_result( rv_surface_caps, "failed to get surface capabilities" );
@@ -32,21 +57,29 @@ namespace
 		}( );
 
 		// choose present mode
-		vk::PresentModeKHR present_mode = [&surface_present_modes]() -> vk::PresentModeKHR
+		const gdevice::PresentPolicy present_policy = swapchain_creation_params.presentPolicy;
+		vk::PresentModeKHR present_mode = [present_policy, &surface_present_modes]() -> vk::PresentModeKHR
 		{
-			for( const vk::PresentModeKHR present_mode : surface_present_modes )
+			const std::span<const vk::PresentModeKHR> fallback_chain = get_present_mode_fallback_chain( present_policy );
+			for( const vk::PresentModeKHR candidate_present_mode : fallback_chain )
 			{
-				if( present_mode == vk::PresentModeKHR::eMailbox )
+				if( std::ranges::find( surface_present_modes, candidate_present_mode ) != surface_present_modes.end() )
 				{
-					return vk::PresentModeKHR::eMailbox;
+					if( candidate_present_mode != fallback_chain.front() )
+					{
+						AZHAL_LOG_ALWAYS_ENABLED( "present mode {0} is not supported for {1}, falling back to {2}",
+							vk::to_string( fallback_chain.front() ), present_policy, vk::to_string( candidate_present_mode ) );
+					}
+					return candidate_present_mode;
 				}
 			}
 
-			AZHAL_LOG_ALWAYS_ENABLED( "failed to get appropriate present mode for swapchain. fallback to FIFO mode." );
+			// the spec guarantees FIFO support
 			return vk::PresentModeKHR::eFifo;
 		}( );
 
 		// choose swapchain extent
+		const vk::Extent2D desired_extent = swapchain_creation_params.desiredExtent;
 		vk::Extent2D swapchain_extent = [desired_extent, &surface_caps]() -> vk::Extent2D
 		{
 			// if the current extent width is see to the special value UINT32_MAX, then the extent of the swapchain
@@ -63,7 +96,9 @@ namespace
 		}( );
 
 
-		Uint32 image_count = ( surface_caps.minImageCount + 1 );
+		// fewer images lower the latency of fifo, mailbox needs at least three to never block on acquire
+		Uint32 image_count = ( swapchain_creation_params.desiredImageCount != 0 ) ? swapchain_creation_params.desiredImageCount : ( surface_caps.minImageCount + 1 );
+		image_count = std::max<Uint32>( image_count, surface_caps.minImageCount );
 		// if the maxImageCount has a special value of NULL/0, it means there is no max image count limit
 		if( surface_caps.maxImageCount != NULL )
 			image_count = std::min<Uint32>( image_count, surface_caps.maxImageCount );
@@ -84,7 +119,7 @@ namespace
 			.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
 			.presentMode = present_mode,
 			.clipped = VK_TRUE,
-			.oldSwapchain = VK_NULL_HANDLE
+			.oldSwapchain = old_swapchain
 		};
 
 		return swapchain_create_info;
@@ -93,9 +128,12 @@ namespace
 
 namespace gdevice
 {
-	Swapchain create_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const vk::Extent2D& desired_extent )
+	Swapchain create_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const SwapchainCreationParams& swapchain_creation_params,
+		const vk::SwapchainKHR old_swapchain )
 	{
-		const vk::SwapchainCreateInfoKHR swapchain_create_info = build_swapchain_create_info( physical_device, surface, desired_extent );
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::SwapchainCreateInfoKHR swapchain_create_info = build_swapchain_create_info( physical_device, surface, swapchain_creation_params, old_swapchain );
 
 		const vk::ResultValue rv_swapchain = device.createSwapchainKHR( swapchain_create_info );
 		vk::SwapchainKHR vk_swapchain = get_vk_result( rv_swapchain, "failed to create swapchain" );
@@ -144,7 +182,9 @@ namespace gdevice
 			swapchain_create_info.imageExtent,
 			swapchain_create_info.imageFormat,
 			swapchain_create_info.imageColorSpace,
-			swapchain_create_info.presentMode
+			swapchain_create_info.presentMode,
+			swapchain_creation_params.presentPolicy,
+			swapchain_creation_params.desiredImageCount
 		);
 
 		return swapchain;
@@ -153,6 +193,8 @@ namespace gdevice
 
 	void destroy_swapchain( const vk::Device device, Swapchain& swapchain )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		std::vector<vk::ImageView>& swapchain_image_views = swapchain.imageViews;
 		for( const vk::ImageView image_view : swapchain_image_views )
 		{
@@ -166,12 +208,26 @@ namespace gdevice
 	}
 
 
-	Swapchain recreate_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const vk::Extent2D& desired_extent, Swapchain& old_swapchain )
+	Swapchain recreate_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const vk::Extent2D& desired_extent, const Swapchain& old_swapchain )
 	{
-		const vk::Result res_device_wait_idle = device.waitIdle();
-		vk::resultCheck( res_device_wait_idle, "failed to wait for device idle while recreating swapchain" );
+		AZHAL_PROFILE_FUNCTION();
+
+		const SwapchainCreationParams swapchain_creation_params
+		{
+			.desiredExtent = desired_extent,
+			.presentPolicy = old_swapchain.presentPolicy,
+			.desiredImageCount = old_swapchain.desiredImageCount
+		};
+
+		return ( create_swapchain( physical_device, device, surface, swapchain_creation_params, old_swapchain.vkSwapchain ) );
+	}
+
+
+	Bool is_surface_extent_empty( const vk::PhysicalDevice physical_device, const vk::SurfaceKHR surface )
+	{
+		const vk::ResultValue rv_surface_caps = physical_device.getSurfaceCapabilitiesKHR( surface );
+		const vk::SurfaceCapabilitiesKHR surface_caps = get_vk_result( rv_surface_caps, "failed to get surface capabilities" );
 
-		destroy_swapchain( device, old_swapchain );
-		return ( create_swapchain( physical_device, device, surface, desired_extent ) );
+		return ( surface_caps.currentExtent.width == 0 || surface_caps.currentExtent.height == 0 );
 	}
 }
\ No newline at end of file
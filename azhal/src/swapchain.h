@@ -1,14 +1,25 @@
 #pragma once
 
+#include "enums.h"
+
 namespace gdevice
 {
+	struct SwapchainCreationParams
+	{
+		vk::Extent2D desiredExtent;
+		PresentPolicy presentPolicy = PresentPolicy::eMailbox;
+		// 0 picks minImageCount + 1, other values are clamped to the surface limits
+		Uint32 desiredImageCount = 0;
+	};
+
 	// TODO: change swapchain creation and deletion
 	struct Swapchain : NonCopyable
 	{
 	public:
 
 		explicit Swapchain( const vk::SwapchainKHR vk_swapchain, const std::vector<vk::Image>& images_, const std::vector<vk::ImageView>& image_views,
-			const vk::Extent2D image_extent, const vk::Format image_format, const vk::ColorSpaceKHR image_color_space, const vk::PresentModeKHR present_mode )
+			const vk::Extent2D image_extent, const vk::Format image_format, const vk::ColorSpaceKHR image_color_space, const vk::PresentModeKHR present_mode,
+			const PresentPolicy present_policy, const Uint32 desired_image_count )
 			: vkSwapchain( vk_swapchain )
 			, images( images_ )
 			, imageViews( image_views )
@@ -16,6 +27,8 @@ namespace gdevice
 			, imageFormat( image_format )
 			, imageColorSpace( image_color_space )
 			, presentMode( present_mode )
+			, presentPolicy( present_policy )
+			, desiredImageCount( desired_image_count )
 		{
 		}
 
@@ -27,6 +40,8 @@ namespace gdevice
 			, imageFormat( other.imageFormat )
 			, imageColorSpace( other.imageColorSpace )
 			, presentMode( other.presentMode )
+			, presentPolicy( other.presentPolicy )
+			, desiredImageCount( other.desiredImageCount )
 		{
 
 			other.vkSwapchain = VK_NULL_HANDLE;
@@ -41,7 +56,7 @@ namespace gdevice
 				return *this;
 			}
 
-			AZHAL_FATAL_ASSERT( vkSwapchain, "trying to move to a non-empty swapchain object" );
+			AZHAL_FATAL_ASSERT( !vkSwapchain, "trying to move to a non-empty swapchain object" );
 			AZHAL_FATAL_ASSERT( images.size() == 0, "trying to move to a non-empty swapchain object" );
 			AZHAL_FATAL_ASSERT( imageViews.size() == 0, "trying to move to a non-empty swapchain object" );
 
@@ -52,6 +67,8 @@ namespace gdevice
 			imageFormat = other.imageFormat;
 			imageColorSpace = other.imageColorSpace;
 			presentMode = other.presentMode;
+			presentPolicy = other.presentPolicy;
+			desiredImageCount = other.desiredImageCount;
 
 			other.vkSwapchain = VK_NULL_HANDLE;
 			other.images.clear();
@@ -73,12 +90,24 @@ namespace gdevice
 		vk::Format imageFormat;
 		vk::ColorSpaceKHR imageColorSpace;
 		vk::PresentModeKHR presentMode;
+
+		// kept so that recreation honours the original request
+		PresentPolicy presentPolicy;
+		Uint32 desiredImageCount;
 	};
 
 
-	Swapchain create_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const vk::Extent2D& desired_extent );
+	Swapchain create_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const SwapchainCreationParams& swapchain_creation_params,
+		const vk::SwapchainKHR old_swapchain = VK_NULL_HANDLE );
 
+	// destroys immediately, swapchains replaced at runtime go through defer_destroy_swapchain
 	void destroy_swapchain( const vk::Device device, Swapchain& swapchain );
 
-	Swapchain recreate_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const vk::Extent2D& desired_extent, Swapchain& old_swapchain );
+	// creates the replacement with old_swapchain as oldSwapchain, without waiting for the device. old_swapchain is
+	// left untouched: images it already handed out can still be presented and it must be destroyed by the caller
+	// once the frames using them have retired
+	Swapchain recreate_swapchain( const vk::PhysicalDevice physical_device, const vk::Device device, const vk::SurfaceKHR surface, const vk::Extent2D& desired_extent, const Swapchain& old_swapchain );
+
+	// a minimized window reports a zero extent, no swapchain can be created until it is restored
+	Bool is_surface_extent_empty( const vk::PhysicalDevice physical_device, const vk::SurfaceKHR surface );
 }
\ No newline at end of file
@@ -0,0 +1,404 @@
+#include "azpch.h"
+#include "texture.h"
+
+#include "device_capabilities.h"
+#include "enums.h"
+#include "vulkan_sync_utils.h"
+
+#include <algorithm>
+
+namespace
+{
+	Uint32 get_texture_mip_count( const gdevice::StreamedTexture& texture )
+	{
+		return texture.isMipGenerationNeeded ? gdevice::get_full_mip_count( vk::Extent2D { texture.data.width, texture.data.height } ) :
+			static_cast< Uint32 >( texture.data.mips.size() );
+	}
+
+
+	// of mips [resident_mip, mip count), generated mips are estimated as a third of the mip they are made from
+	Uint64 get_resident_size( const gdevice::StreamedTexture& texture, Uint32 resident_mip )
+	{
+		if( resident_mip >= get_texture_mip_count( texture ) )
+		{
+			return 0;
+		}
+		return texture.isMipGenerationNeeded ? ( texture.data.mips[ 0 ].size * 4 / 3 ) : GetTextureSize( texture.data, resident_mip );
+	}
+
+
+	Uint32 get_tail_mip( const TextureData& texture_data, Uint32 tail_extent )
+	{
+		for( Uint32 mip = 0; mip < texture_data.mips.size(); ++mip )
+		{
+			if( std::max( texture_data.mips[ mip ].width, texture_data.mips[ mip ].height ) <= tail_extent )
+			{
+				return mip;
+			}
+		}
+		// files whose mip chain stops early
+		return static_cast< Uint32 >( texture_data.mips.size() ) - 1;
+	}
+
+
+	// a texture holding mips finer than it wants goes first, then the texture with the lowest priority below priority.
+	// tails are never evicted. UINT32_MAX when no texture qualifies
+	Uint32 find_eviction_victim( std::span<const gdevice::StreamedTexture> textures, const std::vector<Uint32>& target_mips, Float priority )
+	{
+		Uint32 victim = UINT32_MAX;
+		Bool is_victim_over_resident = false;
+		for( Uint32 i = 0; i < textures.size(); ++i )
+		{
+			const gdevice::StreamedTexture& texture = textures[ i ];
+			if( target_mips[ i ] >= texture.tailMip )
+			{
+				continue;
+			}
+
+			const Bool is_over_resident = ( target_mips[ i ] < texture.wantedMip );
+			if( !is_over_resident && ( is_victim_over_resident || texture.priority >= priority ) )
+			{
+				continue;
+			}
+			if( victim == UINT32_MAX || ( is_over_resident && !is_victim_over_resident ) || texture.priority < textures[ victim ].priority )
+			{
+				victim = i;
+				is_victim_over_resident = is_over_resident;
+			}
+		}
+		return victim;
+	}
+
+
+	// creates the image for mips [new_resident_mip, mip count), copies over the mips the old image already holds and
+	// uploads the rest. returns the uploaded bytes
+	Uint64 replace_texture_image( const gdevice::DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		gdevice::TextureStreamer& texture_streamer, gdevice::StreamedTexture& texture, Uint32 new_resident_mip )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const Uint32 mip_count = get_texture_mip_count( texture );
+		const Uint32 old_resident_mip = texture.residentMip;
+		const vk::Extent2D extent { texture.data.width, texture.data.height };
+
+		gdevice::Image image;
+		gdevice::ImageMemoryRange image_memory_range;
+		Uint64 uploaded_bytes = 0;
+		if( new_resident_mip < mip_count )
+		{
+			const gdevice::ImageCreationParams image_creation_params
+			{
+				.format = texture.format,
+				.extent = gdevice::get_mip_extent( extent, new_resident_mip ),
+				.mipLevels = mip_count - new_resident_mip,
+				.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc
+			};
+			image = gdevice::create_pooled_image( device_capabilities, device, texture_streamer.imageMemoryPool, image_creation_params, image_memory_range );
+
+			gdevice::insert_image_pipeline_barrier( cmd_buffer, image.vkImage,
+				vk::ImageLayout::eUndefined, gdevice::eAccessTypeInvalid, vk::ImageLayout::eTransferDstOptimal, gdevice::eAccessTypeWrite, 0, image.mipLevels );
+
+			// mips both images hold are copied on the gpu instead of uploaded again
+			const Uint32 first_kept_mip = std::max( old_resident_mip, new_resident_mip );
+			if( texture.image.vkImage && first_kept_mip < mip_count )
+			{
+				gdevice::insert_image_pipeline_barrier( cmd_buffer, texture.image.vkImage,
+					vk::ImageLayout::eShaderReadOnlyOptimal, gdevice::eAccessTypeRead, vk::ImageLayout::eTransferSrcOptimal, gdevice::eAccessTypeRead,
+					first_kept_mip - old_resident_mip, mip_count - first_kept_mip );
+
+				std::vector<vk::ImageCopy>& image_copies = texture_streamer.imageCopies;
+				image_copies.clear();
+				for( Uint32 mip = first_kept_mip; mip < mip_count; ++mip )
+				{
+					const vk::Extent2D mip_extent = gdevice::get_mip_extent( extent, mip );
+					image_copies.push_back( vk::ImageCopy
+					{
+						.srcSubresource = { .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = mip - old_resident_mip, .baseArrayLayer = 0, .layerCount = 1 },
+						.srcOffset = { 0, 0, 0 },
+						.dstSubresource = { .aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = mip - new_resident_mip, .baseArrayLayer = 0, .layerCount = 1 },
+						.dstOffset = { 0, 0, 0 },
+						.extent = { mip_extent.width, mip_extent.height, 1 }
+					} );
+				}
+				cmd_buffer.copyImage( texture.image.vkImage, vk::ImageLayout::eTransferSrcOptimal, image.vkImage, vk::ImageLayout::eTransferDstOptimal, image_copies );
+			}
+
+			if( texture.isMipGenerationNeeded )
+			{
+				const TextureMip& base_mip = texture.data.mips[ 0 ];
+				gdevice::record_image_upload( device_capabilities, device, cmd_buffer, image, 0, texture.data.data.data() + base_mip.offset, base_mip.size );
+				uploaded_bytes += base_mip.size;
+				gdevice::record_mip_generation( cmd_buffer, image, 0 );
+			}
+			else
+			{
+				for( Uint32 mip = new_resident_mip; mip < std::min( old_resident_mip, mip_count ); ++mip )
+				{
+					const TextureMip& texture_mip = texture.data.mips[ mip ];
+					gdevice::record_image_upload( device_capabilities, device, cmd_buffer, image, mip - new_resident_mip, texture.data.data.data() + texture_mip.offset, texture_mip.size );
+					uploaded_bytes += texture_mip.size;
+				}
+
+				gdevice::insert_image_pipeline_barrier( cmd_buffer, image.vkImage,
+					vk::ImageLayout::eTransferDstOptimal, gdevice::eAccessTypeWrite, vk::ImageLayout::eShaderReadOnlyOptimal, gdevice::eAccessTypeRead, 0, image.mipLevels );
+			}
+		}
+
+		gdevice::destroy_pooled_image( texture_streamer.imageMemoryPool, texture.image, texture.imageMemoryRange );
+		texture.image = std::move( image );
+		texture.imageMemoryRange = image_memory_range;
+		texture.residentMip = new_resident_mip;
+
+		return uploaded_bytes;
+	}
+}
+
+namespace gdevice
+{
+	vk::Format get_texture_vk_format( const DeviceCapabilities& device_capabilities, TextureFormat format )
+	{
+		if( IsBlockCompressed( format ) && !is_device_feature_enabled( device_capabilities, eDeviceFeatureTextureCompressionBC ) )
+		{
+			return vk::Format::eUndefined;
+		}
+
+		switch( format )
+		{
+		case TextureFormat::eRgba8Unorm:
+			return vk::Format::eR8G8B8A8Unorm;
+		case TextureFormat::eRgba8Srgb:
+			return vk::Format::eR8G8B8A8Srgb;
+		case TextureFormat::eBc1Unorm:
+			return vk::Format::eBc1RgbaUnormBlock;
+		case TextureFormat::eBc1Srgb:
+			return vk::Format::eBc1RgbaSrgbBlock;
+		case TextureFormat::eBc4Unorm:
+			return vk::Format::eBc4UnormBlock;
+		case TextureFormat::eBc4Snorm:
+			return vk::Format::eBc4SnormBlock;
+		case TextureFormat::eBc2Unorm:
+			return vk::Format::eBc2UnormBlock;
+		case TextureFormat::eBc2Srgb:
+			return vk::Format::eBc2SrgbBlock;
+		case TextureFormat::eBc3Unorm:
+			return vk::Format::eBc3UnormBlock;
+		case TextureFormat::eBc3Srgb:
+			return vk::Format::eBc3SrgbBlock;
+		case TextureFormat::eBc5Unorm:
+			return vk::Format::eBc5UnormBlock;
+		case TextureFormat::eBc5Snorm:
+			return vk::Format::eBc5SnormBlock;
+		case TextureFormat::eBc6hUfloat:
+			return vk::Format::eBc6HUfloatBlock;
+		case TextureFormat::eBc6hSfloat:
+			return vk::Format::eBc6HSfloatBlock;
+		case TextureFormat::eBc7Unorm:
+			return vk::Format::eBc7UnormBlock;
+		case TextureFormat::eBc7Srgb:
+			return vk::Format::eBc7SrgbBlock;
+		default:
+			return vk::Format::eUndefined;
+		}
+	}
+
+
+	void record_mip_generation( vk::CommandBuffer cmd_buffer, const Image& image, Uint32 base_mip )
+	{
+		AZHAL_PROFILE_FUNCTION();
+		AZHAL_ASSERT( base_mip < image.mipLevels, "mip generation from a mip the image does not have" );
+
+		const Uint32 last_mip = image.mipLevels - 1;
+		if( base_mip < last_mip )
+		{
+			insert_image_pipeline_barrier( cmd_buffer, image.vkImage,
+				vk::ImageLayout::eUndefined, eAccessTypeInvalid, vk::ImageLayout::eTransferDstOptimal, eAccessTypeWrite, base_mip + 1, last_mip - base_mip );
+		}
+
+		for( Uint32 mip = base_mip + 1; mip <= last_mip; ++mip )
+		{
+			insert_image_pipeline_barrier( cmd_buffer, image.vkImage,
+				vk::ImageLayout::eTransferDstOptimal, eAccessTypeWrite, vk::ImageLayout::eTransferSrcOptimal, eAccessTypeRead, mip - 1, 1 );
+
+			const vk::Extent2D src_extent = get_mip_extent( image.extent, mip - 1 );
+			const vk::Extent2D dst_extent = get_mip_extent( image.extent, mip );
+			const vk::ImageBlit image_blit
+			{
+				.srcSubresource = { .aspectMask = image.aspectMask, .mipLevel = mip - 1, .baseArrayLayer = 0, .layerCount = 1 },
+				.srcOffsets = std::array<vk::Offset3D, 2> { vk::Offset3D { 0, 0, 0 }, vk::Offset3D { static_cast< Int32 >( src_extent.width ), static_cast< Int32 >( src_extent.height ), 1 } },
+				.dstSubresource = { .aspectMask = image.aspectMask, .mipLevel = mip, .baseArrayLayer = 0, .layerCount = 1 },
+				.dstOffsets = std::array<vk::Offset3D, 2> { vk::Offset3D { 0, 0, 0 }, vk::Offset3D { static_cast< Int32 >( dst_extent.width ), static_cast< Int32 >( dst_extent.height ), 1 } }
+			};
+			cmd_buffer.blitImage( image.vkImage, vk::ImageLayout::eTransferSrcOptimal, image.vkImage, vk::ImageLayout::eTransferDstOptimal, image_blit, vk::Filter::eLinear );
+		}
+
+		// every mip but the last was a blit source
+		if( base_mip < last_mip )
+		{
+			insert_image_pipeline_barrier( cmd_buffer, image.vkImage,
+				vk::ImageLayout::eTransferSrcOptimal, eAccessTypeRead, vk::ImageLayout::eShaderReadOnlyOptimal, eAccessTypeRead, base_mip, last_mip - base_mip );
+		}
+		insert_image_pipeline_barrier( cmd_buffer, image.vkImage,
+			vk::ImageLayout::eTransferDstOptimal, eAccessTypeWrite, vk::ImageLayout::eShaderReadOnlyOptimal, eAccessTypeRead, last_mip, 1 );
+	}
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void destroy_texture_streamer( const vk::Device device, TextureStreamer& texture_streamer )
+	{
+		for( StreamedTexture& texture : texture_streamer.textures.GetDense<0>() )
+		{
+			if( texture.image.vkImage )
+			{
+				destroy_image( device, texture.image );
+			}
+		}
+		destroy_image_memory_pool( device, texture_streamer.imageMemoryPool );
+		texture_streamer = {};
+	}
+
+
+	TextureHandle add_streamed_texture( const DeviceCapabilities& device_capabilities, TextureStreamer& texture_streamer, TextureData texture_data )
+	{
+		AZHAL_ASSERT( !texture_data.mips.empty(), "textures need at least one mip" );
+
+		const vk::Format format = get_texture_vk_format( device_capabilities, texture_data.format );
+		if( format == vk::Format::eUndefined )
+		{
+			AZHAL_LOG_ERROR( "the device cannot sample {0} textures", GetTextureFormatName( texture_data.format ) );
+			return {};
+		}
+
+		StreamedTexture texture
+		{
+			.format = format,
+			.isMipGenerationNeeded = ( texture_data.mips.size() == 1 ) && !IsBlockCompressed( texture_data.format ) &&
+				( get_full_mip_count( vk::Extent2D { texture_data.width, texture_data.height } ) > 1 )
+		};
+		texture.tailMip = texture.isMipGenerationNeeded ? 0 : get_tail_mip( texture_data, texture_streamer.params.tailExtent );
+		texture.data = std::move( texture_data );
+		texture.residentMip = get_texture_mip_count( texture );
+
+		return texture_streamer.textures.Create( std::move( texture ) );
+	}
+
+
+	void remove_streamed_texture( TextureStreamer& texture_streamer, TextureHandle texture_handle )
+	{
+		AZHAL_ASSERT( is_valid_streamed_texture( texture_streamer, texture_handle ), "removing through a stale or null texture handle" );
+		if( !is_valid_streamed_texture( texture_streamer, texture_handle ) )
+		{
+			return;
+		}
+
+		StreamedTexture& texture = texture_streamer.textures.Get<0>( texture_handle );
+		texture_streamer.residentBytes -= get_resident_size( texture, texture.residentMip );
+		destroy_pooled_image( texture_streamer.imageMemoryPool, texture.image, texture.imageMemoryRange );
+
+		texture_streamer.textures.Destroy( texture_handle );
+	}
+
+
+	void set_texture_streaming_priority( TextureStreamer& texture_streamer, TextureHandle texture_handle, Float priority, Uint32 wanted_mip )
+	{
+		AZHAL_ASSERT( is_valid_streamed_texture( texture_streamer, texture_handle ), "stale or null texture handle" );
+
+		StreamedTexture& texture = texture_streamer.textures.Get<0>( texture_handle );
+		texture.priority = priority;
+		texture.wantedMip = std::min( wanted_mip, get_texture_mip_count( texture ) - 1 );
+	}
+
+
+	TextureStreamingStats update_texture_streaming( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		TextureStreamer& texture_streamer )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		TextureStreamingStats stats;
+		const std::span<StreamedTexture> textures = texture_streamer.textures.GetDense<0>();
+		const TextureStreamingParams& params = texture_streamer.params;
+		texture_streamer.changedTextures.clear();
+
+		// the mip every texture ends this update at, by dense index. the images are only replaced once all decisions are made
+		std::vector<Uint32>& target_mips = texture_streamer.targetMips;
+		target_mips.assign( textures.size(), 0 );
+		std::vector<Uint32>& upgrade_candidates = texture_streamer.upgradeCandidates;
+		upgrade_candidates.clear();
+		Uint64 resident_bytes = texture_streamer.residentBytes;
+		Uint64 upload_bytes = 0;
+
+		// tails before any finer mip, so that every texture can be drawn as early as possible
+		for( Uint32 i = 0; i < textures.size(); ++i )
+		{
+			const StreamedTexture& texture = textures[ i ];
+			target_mips[ i ] = texture.residentMip;
+			if( texture.residentMip == get_texture_mip_count( texture ) )
+			{
+				target_mips[ i ] = texture.tailMip;
+				resident_bytes += get_resident_size( texture, texture.tailMip );
+				upload_bytes += get_resident_size( texture, texture.tailMip );
+				stats.mipsStreamedIn += get_texture_mip_count( texture ) - texture.tailMip;
+			}
+			else if( texture.residentMip > texture.wantedMip )
+			{
+				upgrade_candidates.push_back( i );
+			}
+		}
+
+		// one mip per texture and update, the coarsest missing one, highest priority first
+		std::ranges::stable_sort( upgrade_candidates, [&textures]( Uint32 a, Uint32 b ) { return textures[ a ].priority > textures[ b ].priority; } );
+		for( const Uint32 candidate : upgrade_candidates )
+		{
+			const StreamedTexture& texture = textures[ candidate ];
+			const Uint32 next_mip = target_mips[ candidate ] - 1;
+			const Uint64 mip_size = texture.data.mips[ next_mip ].size;
+			if( upload_bytes > 0 && upload_bytes + mip_size > params.uploadBudget )
+			{
+				break;
+			}
+
+			Bool does_fit = true;
+			while( resident_bytes + mip_size > params.residencyBudget )
+			{
+				const Uint32 victim = find_eviction_victim( textures, target_mips, texture.priority );
+				if( victim == UINT32_MAX )
+				{
+					does_fit = false;
+					break;
+				}
+
+				resident_bytes -= textures[ victim ].data.mips[ target_mips[ victim ] ].size;
+				++target_mips[ victim ];
+				++stats.mipsEvicted;
+			}
+			// a lower priority texture may still fit a smaller mip into what is left
+			if( !does_fit )
+			{
+				continue;
+			}
+
+			target_mips[ candidate ] = next_mip;
+			resident_bytes += mip_size;
+			upload_bytes += mip_size;
+			++stats.mipsStreamedIn;
+		}
+
+		for( Uint32 i = 0; i < textures.size(); ++i )
+		{
+			StreamedTexture& texture = textures[ i ];
+			if( target_mips[ i ] != texture.residentMip )
+			{
+				stats.uploadedBytes += replace_texture_image( device_capabilities, device, cmd_buffer, texture_streamer, texture, target_mips[ i ] );
+				++stats.replacedImages;
+				texture_streamer.changedTextures.push_back( texture_streamer.textures.GetHandle( i ) );
+			}
+
+			++stats.textureCount;
+			stats.wantedBytes += get_resident_size( texture, std::min( texture.wantedMip, texture.tailMip ) );
+		}
+
+		texture_streamer.residentBytes = resident_bytes;
+		stats.residentBytes = resident_bytes;
+
+		return stats;
+	}
+}
\ No newline at end of file
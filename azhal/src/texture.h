@@ -0,0 +1,112 @@
+#pragma once
+
+#include "image_memory_pool.h"
+
+namespace gdevice
+{
+	struct DeviceCapabilities;
+
+	struct TextureTag;
+	using TextureHandle = Handle<TextureTag>;
+
+	// eUndefined when the device cannot sample the format, block compressed formats need eDeviceFeatureTextureCompressionBC
+	vk::Format get_texture_vk_format( const DeviceCapabilities& device_capabilities, TextureFormat format );
+
+	// fills every mip after base_mip by linear blits, each from the mip before it. base_mip has to be written and in
+	// eTransferDstOptimal, the mips after it in eTransferDstOptimal or eUndefined. every mip from base_mip on ends up in
+	// eShaderReadOnlyOptimal. the format needs linear blit support, which rgba8 always has and block compressed formats never
+	void record_mip_generation( vk::CommandBuffer cmd_buffer, const Image& image, Uint32 base_mip = 0 );
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct TextureStreamingParams
+	{
+		// device memory the resident mips of every texture may take together, estimated from their data sizes
+		Uint64 residencyBudget = 256 * K_MEBIBYTE;
+		// uploaded by one update_texture_streaming at most, which bounds its cost per frame. tails and a single mip that
+		// is larger on its own are let through. kept below GDeviceInitParams::stagingRingSize the uploads stay in the ring
+		Uint64 uploadBudget = 16 * K_MEBIBYTE;
+		// mips up to this extent form the tail of a texture, loaded before any finer mip of any texture and never evicted
+		Uint32 tailExtent = 64;
+	};
+
+	struct StreamedTexture
+	{
+		// the source of every upload, kept for the whole lifetime of the texture
+		TextureData data;
+		vk::Format format = vk::Format::eUndefined;
+		// holds mips [residentMip, mip count) of data, its mip 0 is residentMip. normalized coordinates and the view
+		// stay valid across mips, but the image is replaced whenever residentMip changes
+		Image image;
+		// of image in the streamer's imageMemoryPool
+		ImageMemoryRange imageMemoryRange;
+		// the mip count while nothing is resident
+		Uint32 residentMip = 0;
+		Uint32 tailMip = 0;
+		// the finest mip worth having, e.g. from the screen size of the texture
+		Uint32 wantedMip = 0;
+		// higher streams in first and is evicted last
+		Float priority = 0.0f;
+		// textures with a single rgba8 mip get the rest of their chain generated, they are made resident whole
+		Bool isMipGenerationNeeded = false;
+	};
+
+	struct TextureStreamingStats
+	{
+		Uint32 textureCount = 0;
+		Uint64 residentBytes = 0;
+		// with every texture at its wanted mip
+		Uint64 wantedBytes = 0;
+		Uint64 uploadedBytes = 0;
+		Uint32 mipsStreamedIn = 0;
+		Uint32 mipsEvicted = 0;
+		Uint32 replacedImages = 0;
+	};
+
+	// textures whose mips are uploaded over several frames, coarsest first and by priority, under a residency budget.
+	// update_texture_streaming makes every new texture's tail resident, then moves the highest priority textures one mip
+	// closer to their wanted mip, evicting the finest mips of textures that hold more than they want or have a lower
+	// priority when the budget is exceeded
+	struct TextureStreamer
+	{
+		TextureStreamingParams params;
+		// every image is placed into it, so replacing one on a residency change does not allocate device memory
+		ImageMemoryPool imageMemoryPool;
+		HandlePool<TextureTag, StreamedTexture> textures;
+		Uint64 residentBytes = 0;
+		// the textures whose image the last update_texture_streaming replaced, descriptor sets that reference their
+		// views have to be rewritten
+		std::vector<TextureHandle> changedTextures;
+
+		// scratch of update_texture_streaming, cleared and reused so that a steady update does not allocate
+		std::vector<Uint32> targetMips;
+		std::vector<Uint32> upgradeCandidates;
+		std::vector<vk::ImageCopy> imageCopies;
+	};
+
+	// destroys immediately together with the image memory pool, at runtime use the Context overload which defers until
+	// the gpu is done with the images
+	void destroy_texture_streamer( const vk::Device device, TextureStreamer& texture_streamer );
+
+	// nothing is uploaded before the next update_texture_streaming
+	TextureHandle add_streamed_texture( const DeviceCapabilities& device_capabilities, TextureStreamer& texture_streamer, TextureData texture_data );
+	// the image is destroyed once the frames that may still sample it have retired
+	void remove_streamed_texture( TextureStreamer& texture_streamer, TextureHandle texture_handle );
+	void set_texture_streaming_priority( TextureStreamer& texture_streamer, TextureHandle texture_handle, Float priority, Uint32 wanted_mip );
+
+	// records the uploads, copies and layout transitions into cmd_buffer, which has to run before anything samples the
+	// textures this frame
+	TextureStreamingStats update_texture_streaming( const DeviceCapabilities& device_capabilities, const vk::Device device, vk::CommandBuffer cmd_buffer,
+		TextureStreamer& texture_streamer );
+
+	AZHAL_INLINE Bool is_valid_streamed_texture( const TextureStreamer& texture_streamer, TextureHandle texture_handle )
+	{
+		return texture_streamer.textures.IsValid( texture_handle );
+	}
+
+	// the reference stays valid until the next add_streamed_texture or remove_streamed_texture
+	AZHAL_INLINE const StreamedTexture& get_streamed_texture( const TextureStreamer& texture_streamer, TextureHandle texture_handle )
+	{
+		return texture_streamer.textures.Get<0>( texture_handle );
+	}
+}
\ No newline at end of file
@@ -1,11 +1,14 @@
 #include "azpch.h"
 #include "vulkan_init_helper.h"
 
+#include "device_capabilities.h"
 #include "enums.h"
 #include "window.h"
 
 #include <GLFW/glfw3.h>
 
+#include <bit>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace
@@ -15,12 +18,21 @@ namespace
 
 namespace
 {
-	std::vector<const AnsiChar*> get_required_instance_extensions()
+	std::pmr::vector<const AnsiChar*> get_required_instance_extensions( Bool is_headless, std::pmr::memory_resource* p_memory )
 	{
-		Uint32 glfw_extension_count = 0;
-		const AnsiChar** pp_glfw_extensions = glfwGetRequiredInstanceExtensions( &glfw_extension_count );
-
-		std::vector<const AnsiChar*> required_instance_extensions( pp_glfw_extensions, pp_glfw_extensions + glfw_extension_count );
+		std::pmr::vector<const AnsiChar*> required_instance_extensions( p_memory );
+		if( is_headless )
+		{
+			// headless runs never initialize glfw, so the surface extensions are requested explicitly
+			required_instance_extensions.push_back( VK_KHR_SURFACE_EXTENSION_NAME );
+			required_instance_extensions.push_back( VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME );
+		}
+		else
+		{
+			Uint32 glfw_extension_count = 0;
+			const AnsiChar** pp_glfw_extensions = glfwGetRequiredInstanceExtensions( &glfw_extension_count );
+			required_instance_extensions.assign( pp_glfw_extensions, pp_glfw_extensions + glfw_extension_count );
+		}
 
 #ifdef AZHAL_ENABLE_LOGGING
 		required_instance_extensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
@@ -30,9 +42,9 @@ namespace
 	}
 
 
-	std::vector<const AnsiChar*> get_validation_layers( Bool enable_validation_layers )
+	std::pmr::vector<const AnsiChar*> get_validation_layers( Bool enable_validation_layers, std::pmr::memory_resource* p_memory )
 	{
-		std::vector<const AnsiChar*> validation_layers;
+		std::pmr::vector<const AnsiChar*> validation_layers( p_memory );
 		if( enable_validation_layers )
 		{
 			validation_layers.push_back( VK_LAYER_KHRONOS_VALIDATION_NAME );
@@ -41,15 +53,15 @@ namespace
 	}
 
 
-	std::vector<vk::ValidationFeatureEnableEXT> get_enabled_validation_features( Bool enable_gpu_assisted_validation )
+	std::pmr::vector<vk::ValidationFeatureEnableEXT> get_enabled_validation_features( Bool enable_gpu_assisted_validation, std::pmr::memory_resource* p_memory )
 	{
-		std::vector<vk::ValidationFeatureEnableEXT> validation_features
-		{
+		std::pmr::vector<vk::ValidationFeatureEnableEXT> validation_features
+		( {
 			 vk::ValidationFeatureEnableEXT::eBestPractices,
 			 // Enabling both eGpuAssited and eDebugPrintf would result in a validation error
 			 //vk::ValidationFeatureEnableEXT::eDebugPrintf,
 			 vk::ValidationFeatureEnableEXT::eSynchronizationValidation
-		};
+		}, p_memory );
 
 		if( enable_gpu_assisted_validation )
 		{
@@ -91,7 +103,7 @@ namespace
 	}
 
 
-	AZHAL_INLINE std::vector<const AnsiChar*> get_required_device_extensions()
+	AZHAL_INLINE const std::vector<const AnsiChar*>& get_required_device_extensions()
 	{
 		static const std::vector<const AnsiChar*> required_device_extensions
 		{
@@ -103,6 +115,90 @@ namespace
 
 		return required_device_extensions;
 	}
+
+
+	// enabled only when the physical device supports them
+	AZHAL_INLINE const std::vector<const AnsiChar*>& get_optional_device_extensions()
+	{
+		static const std::vector<const AnsiChar*> optional_device_extensions
+		{
+			VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME
+		};
+
+		return optional_device_extensions;
+	}
+
+
+	// 0 rejects the device. otherwise the device type dominates, followed by the optional features and the memory size
+	Uint64 score_physical_device( const vk::PhysicalDevice physical_device, const gdevice::DeviceCapabilities& device_capabilities, const vk::SurfaceKHR surface,
+		const vk::DispatchLoaderDynamic& dynamic_dispatch_loader, const gdevice::DeviceFeatureRequest& feature_request )
+	{
+		if( device_capabilities.apiVersion < VK_API_VERSION_1_3 )
+		{
+			AZHAL_LOG_WARN( "{0} is rejected: vulkan 1.3 is not supported", device_capabilities.deviceName );
+			return 0;
+		}
+
+		for( const AnsiChar* extension_name : get_required_device_extensions() )
+		{
+			if( !gdevice::is_device_extension_supported( physical_device, extension_name ) )
+			{
+				AZHAL_LOG_WARN( "{0} is rejected: extension {1} is not supported", device_capabilities.deviceName, extension_name );
+				return 0;
+			}
+		}
+
+		const Uint64 missing_features = feature_request.required & ~device_capabilities.supportedFeatures;
+		if( missing_features != 0 )
+		{
+			for( Uint32 bit = 0; bit < gdevice::eDeviceFeatureCount; ++bit )
+			{
+				if( missing_features & ( 1ull << bit ) )
+				{
+					AZHAL_LOG_WARN( "{0} is rejected: feature {1} is not supported", device_capabilities.deviceName,
+						gdevice::get_device_feature_name( static_cast< gdevice::DeviceFeatureBits >( 1ull << bit ) ) );
+				}
+			}
+			return 0;
+		}
+
+		Bool has_graphics_queue = false;
+		Bool has_present_queue = false;
+		const std::vector<vk::QueueFamilyProperties> queue_family_props = physical_device.getQueueFamilyProperties();
+		for( Uint32 i = 0; i < queue_family_props.size(); ++i )
+		{
+			has_graphics_queue |= static_cast< Bool >( queue_family_props[ i ].queueFlags & vk::QueueFlagBits::eGraphics );
+
+			const vk::ResultValue rv_surface_support = physical_device.getSurfaceSupportKHR( i, surface, dynamic_dispatch_loader );
+			has_present_queue |= ( rv_surface_support.result == vk::Result::eSuccess && rv_surface_support.value );
+		}
+		if( !has_graphics_queue || !has_present_queue )
+		{
+			AZHAL_LOG_WARN( "{0} is rejected: no graphics or present queue", device_capabilities.deviceName );
+			return 0;
+		}
+
+		Uint64 device_score = 1;
+		switch( device_capabilities.deviceType )
+		{
+		case vk::PhysicalDeviceType::eDiscreteGpu:
+			device_score += 100000;
+			break;
+		case vk::PhysicalDeviceType::eIntegratedGpu:
+			device_score += 10000;
+			break;
+		case vk::PhysicalDeviceType::eVirtualGpu:
+			device_score += 1000;
+			break;
+		default:
+			break;
+		}
+
+		device_score += 100 * std::popcount( feature_request.optional & device_capabilities.supportedFeatures );
+		device_score += device_capabilities.deviceLocalMemorySize / ( 1024ull * 1024ull * 1024ull );
+
+		return device_score;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -111,6 +207,8 @@ namespace gdevice
 {
 	vk::Instance create_instance( const VulkanInstanceCreationParams& instance_creation_params )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		const vk::ApplicationInfo app_info
 		{
 			.pNext = VK_NULL_HANDLE,
@@ -120,8 +218,9 @@ namespace gdevice
 			.apiVersion = VK_API_VERSION_1_3
 		};
 
-		const std::vector<const AnsiChar*> validation_layers = get_validation_layers( instance_creation_params.enableValidationLayers );
-		const std::vector<const AnsiChar*> required_extensions = get_required_instance_extensions();
+		ScratchScope scratch;
+		const std::pmr::vector<const AnsiChar*> validation_layers = get_validation_layers( instance_creation_params.enableValidationLayers, scratch.GetResource() );
+		const std::pmr::vector<const AnsiChar*> required_extensions = get_required_instance_extensions( instance_creation_params.isHeadless, scratch.GetResource() );
 
 		vk::InstanceCreateInfo instance_create_info
 		{
@@ -134,7 +233,7 @@ namespace gdevice
 		};
 
 #ifdef AZHAL_ENABLE_LOGGING
-		const std::vector<vk::ValidationFeatureEnableEXT> enabled_validation_features = get_enabled_validation_features( instance_creation_params.enableGpuAssistedValidation );
+		const std::pmr::vector<vk::ValidationFeatureEnableEXT> enabled_validation_features = get_enabled_validation_features( instance_creation_params.enableGpuAssistedValidation, scratch.GetResource() );
 		const vk::ValidationFeaturesEXT validation_features_info
 		{
 			.enabledValidationFeatureCount = VK_SIZE_CAST( enabled_validation_features.size() ),
@@ -166,6 +265,8 @@ namespace gdevice
 	vk::DebugUtilsMessengerEXT create_debug_messenger( const vk::Instance instance, vk::DebugUtilsMessageSeverityFlagBitsEXT debug_message_severity,
 		const PFN_vkDebugUtilsMessengerCallbackEXT& debug_callback_fn, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		const vk::DebugUtilsMessengerCreateInfoEXT debug_utils_create_info = build_debug_messenger_create_info( debug_message_severity, debug_callback_fn );
 
 		const vk::ResultValue rv_debug_msgnr = instance.createDebugUtilsMessengerEXT( debug_utils_create_info, VK_NULL_HANDLE, dynamic_dispatch_loader );
@@ -175,8 +276,18 @@ namespace gdevice
 	}
 
 
-	vk::SurfaceKHR create_vulkan_surface( const vk::Instance instance, void* p_window )
+	vk::SurfaceKHR create_vulkan_surface( const vk::Instance instance, void* p_window, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
+		if( p_window == nullptr )
+		{
+			const vk::HeadlessSurfaceCreateInfoEXT headless_surface_create_info {};
+
+			const vk::ResultValue rv_headless_surface = instance.createHeadlessSurfaceEXT( headless_surface_create_info, VK_NULL_HANDLE, dynamic_dispatch_loader );
+			return ( get_vk_result( rv_headless_surface, "failed to create headless surface" ) );
+		}
+
 		VkSurfaceKHR surface = VK_NULL_HANDLE;
 
 		VkResult result = glfwCreateWindowSurface( instance, static_cast< GLFWwindow* >( p_window ), VK_NULL_HANDLE, &surface );
@@ -204,6 +315,22 @@ namespace gdevice
 	}
 
 
+	Uint32 find_async_compute_queue_family_index( const vk::PhysicalDevice physical_device )
+	{
+		const std::vector<vk::QueueFamilyProperties> queue_family_props = physical_device.getQueueFamilyProperties();
+		for( Uint32 i = 0; i < queue_family_props.size(); ++i )
+		{
+			const vk::QueueFlags queue_flags = queue_family_props[ i ].queueFlags;
+			if( ( queue_flags & vk::QueueFlagBits::eCompute ) && !( queue_flags & vk::QueueFlagBits::eGraphics ) )
+			{
+				return i;
+			}
+		}
+
+		return find_queue_family_index( physical_device, vk::QueueFlagBits::eCompute );
+	}
+
+
 	Uint32 find_present_queue_family_index( const vk::PhysicalDevice physical_device, const vk::SurfaceKHR surface, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader )
 	{
 		const std::vector<vk::QueueFamilyProperties> queue_family_props = physical_device.getQueueFamilyProperties();
@@ -225,38 +352,62 @@ namespace gdevice
 	}
 
 
-	vk::PhysicalDevice get_suitable_physical_device( const vk::Instance instance )
+	vk::PhysicalDevice get_suitable_physical_device( const vk::Instance instance, const vk::SurfaceKHR surface, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader,
+		const DeviceFeatureRequest& feature_request )
 	{
+		AZHAL_PROFILE_FUNCTION();
+
 		const vk::ResultValue rv_physical_devices = instance.enumeratePhysicalDevices();
 		const std::vector<vk::PhysicalDevice> physical_devices = gdevice::get_vk_result( rv_physical_devices, "failed to enumerate physical devices" );
 
-		// TODO: check for appropriate physical device props
-		const vk::PhysicalDevice selected_physical_device = physical_devices[ 0 ];
-
-		const vk::ResultValue rv_extension_props = selected_physical_device.enumerateDeviceExtensionProperties();
-		const std::vector<vk::ExtensionProperties> extension_props = gdevice::get_vk_result( rv_extension_props, "failed to get extension properties for device" );
-
-		const std::vector<const AnsiChar*> required_extensions = get_required_device_extensions();
-		for( const AnsiChar* extension_name : required_extensions )
+		vk::PhysicalDevice selected_physical_device = VK_NULL_HANDLE;
+		Uint64 best_score = 0;
+		for( const vk::PhysicalDevice physical_device : physical_devices )
 		{
-			const auto iter = std::find_if
-			(
-				extension_props.begin(), extension_props.end(),
+			const DeviceCapabilities device_capabilities = query_device_capabilities( physical_device );
+			const Uint64 device_score = score_physical_device( physical_device, device_capabilities, surface, dynamic_dispatch_loader, feature_request );
 
-				[extension_name]( const vk::ExtensionProperties& prop ) -> Bool {
-					return ( strcmp( prop.extensionName, extension_name ) == 0 );
-				}
-			);
+			AZHAL_LOG_INFO( "physical device {0}: score {1}", device_capabilities.deviceName, device_score );
+			if( device_score > best_score )
+			{
+				best_score = device_score;
+				selected_physical_device = physical_device;
+			}
+		}
 
-			AZHAL_FATAL_ASSERT( iter != extension_props.cend(), "extension not found in physical device properties" );
+		if( !selected_physical_device )
+		{
+			AZHAL_LOG_ALWAYS_ENABLED( "none of the {0} physical devices supports the required extensions, features and queues", physical_devices.size() );
+			throw GDeviceException( "Failed to find a suitable physical device" );
 		}
 
 		return selected_physical_device;
 	}
 
 
-	vk::Device create_device( const vk::Instance instance, const vk::PhysicalDevice physical_device, const std::set<Uint32>& unique_queue_families )
+	Bool is_device_extension_supported( const vk::PhysicalDevice physical_device, const AnsiChar* extension_name )
 	{
+		const vk::ResultValue rv_extension_props = physical_device.enumerateDeviceExtensionProperties();
+		const std::vector<vk::ExtensionProperties> extension_props = gdevice::get_vk_result( rv_extension_props, "failed to get extension properties for device" );
+
+		const auto iter = std::find_if
+		(
+			extension_props.begin(), extension_props.end(),
+
+			[extension_name]( const vk::ExtensionProperties& prop ) -> Bool {
+				return ( strcmp( prop.extensionName, extension_name ) == 0 );
+			}
+		);
+
+		return ( iter != extension_props.cend() );
+	}
+
+
+
+	vk::Device create_device( const vk::Instance instance, const vk::PhysicalDevice physical_device, const std::set<Uint32>& unique_queue_families, Uint64 enabled_features )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
 		std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
 		for( Uint32 queue_family : unique_queue_families )
 		{
@@ -271,30 +422,40 @@ namespace gdevice
 			queue_create_infos.emplace_back( queue_create_info );
 		}
 
-		const std::vector<const AnsiChar*> required_extensions = get_required_device_extensions();
+		ScratchScope scratch;
+		std::pmr::vector<const AnsiChar*> enabled_extensions( get_required_device_extensions().begin(), get_required_device_extensions().end(), scratch.GetResource() );
+		for( const AnsiChar* extension_name : get_optional_device_extensions() )
+		{
+			if( is_device_extension_supported( physical_device, extension_name ) )
+			{
+				enabled_extensions.push_back( extension_name );
+			}
+			else
+			{
+				AZHAL_LOG_WARN( "optional device extension {0} is not supported", extension_name );
+			}
+		}
+
+		for( const AnsiChar* extension_name : get_device_feature_extensions( enabled_features ) )
+		{
+			enabled_extensions.push_back( extension_name );
+		}
+
+		DeviceFeatureChain feature_chain;
+		fill_device_feature_chain( feature_chain, enabled_features );
 
 		const vk::DeviceCreateInfo device_create_info
 		{
+			.pNext = &feature_chain.get<vk::PhysicalDeviceFeatures2>(),
 			.queueCreateInfoCount = VK_SIZE_CAST( queue_create_infos.size() ),
 			.pQueueCreateInfos = queue_create_infos.data(),
-			.enabledExtensionCount = VK_SIZE_CAST( required_extensions.size() ),
-			.ppEnabledExtensionNames = required_extensions.data(),
-			// TODO: add enabled features
+			.enabledExtensionCount = VK_SIZE_CAST( enabled_extensions.size() ),
+			.ppEnabledExtensionNames = enabled_extensions.data(),
+			// features are passed through vk::PhysicalDeviceFeatures2
 			.pEnabledFeatures = VK_NULL_HANDLE
 		};
 
-		constexpr vk::PhysicalDeviceDynamicRenderingFeatures dynamic_render_features
-		{
-			.dynamicRendering = VK_TRUE
-		};
-
-		const vk::StructureChain<vk::DeviceCreateInfo, vk::PhysicalDeviceDynamicRenderingFeatures> device_create_chain
-		{
-			device_create_info,
-			dynamic_render_features
-		};
-
-		const vk::ResultValue rv_device = physical_device.createDevice( device_create_chain.get<vk::DeviceCreateInfo>() );
+		const vk::ResultValue rv_device = physical_device.createDevice( device_create_info );
 		const vk::Device device = get_vk_result( rv_device, "Failed to create vulkan device" );
 
 		return device;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "device_capabilities.h"
+
 namespace gdevice
 {
 	struct VulkanInstanceCreationParams
@@ -9,6 +11,8 @@ namespace gdevice
 		PFN_vkDebugUtilsMessengerCallbackEXT debugCallbackFn;
 
 		Bool enableGpuAssistedValidation = false;
+
+		Bool isHeadless = false;
 	};
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -18,15 +22,26 @@ namespace gdevice
 	vk::DebugUtilsMessengerEXT create_debug_messenger( const vk::Instance instance, vk::DebugUtilsMessageSeverityFlagBitsEXT debug_message_severity,
 		const PFN_vkDebugUtilsMessengerCallbackEXT& debug_callback_fn, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader );
 
-	vk::SurfaceKHR create_vulkan_surface( const vk::Instance instance, void* p_window );
+	// creates a VK_EXT_headless_surface when p_window is null
+	vk::SurfaceKHR create_vulkan_surface( const vk::Instance instance, void* p_window, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader );
 
-	vk::PhysicalDevice get_suitable_physical_device( const vk::Instance instance );
+	// rejects devices without vulkan 1.3, the required extensions, required features or a graphics and present queue,
+	// then picks the best scoring one. throws GDeviceException when no device qualifies
+	vk::PhysicalDevice get_suitable_physical_device( const vk::Instance instance, const vk::SurfaceKHR surface, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader,
+		const DeviceFeatureRequest& feature_request );
+
+	Bool is_device_extension_supported( const vk::PhysicalDevice physical_device, const AnsiChar* extension_name );
 
 	Uint32 find_queue_family_index( const vk::PhysicalDevice physical_device, vk::QueueFlagBits queue_flag );
 
+	// prefers a family with compute but without graphics, whose queues run alongside the graphics queue.
+	// falls back to the first compute capable family, which then usually is the graphics family
+	Uint32 find_async_compute_queue_family_index( const vk::PhysicalDevice physical_device );
+
 	Uint32 find_present_queue_family_index( const vk::PhysicalDevice physical_device, const vk::SurfaceKHR surface, const vk::DispatchLoaderDynamic& dynamic_dispatch_loader );
 
-	vk::Device create_device( const vk::Instance instance, const vk::PhysicalDevice physical_device, const std::set<Uint32>& unique_queue_families );
+	// enabled_features is a DeviceFeatureBits mask, every feature in it must be supported
+	vk::Device create_device( const vk::Instance instance, const vk::PhysicalDevice physical_device, const std::set<Uint32>& unique_queue_families, Uint64 enabled_features );
 
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////
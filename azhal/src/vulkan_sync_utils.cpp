@@ -6,24 +6,83 @@
 
 namespace
 {
-	struct PipelineBarrierParams
+	struct LayoutUsage
 	{
-		vk::AccessFlags srcAccessMask = vk::AccessFlagBits::eNone;
-		vk::PipelineStageFlags srcStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
-		vk::AccessFlags destAccessMask = vk::AccessFlagBits::eNone;
-		vk::PipelineStageFlags dstStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
-		vk::ImageAspectFlags subResourceAspectMask;
+		vk::PipelineStageFlags stageMask;
+		vk::AccessFlags accessMask;
 	};
 
-	PipelineBarrierParams get_pipeline_barrier_params( vk::ImageLayout src_layout, gdevice::AccessTypeBits src_access_type_mask, vk::ImageLayout dst_layout, gdevice::AccessTypeBits dst_access_type_mask )
+	// the stages and accesses an image in layout is used with. is_source picks the stage a transition waits on for
+	// layouts that are not used by any stage
+	LayoutUsage get_layout_usage( vk::ImageLayout layout, gdevice::AccessTypeBits access_type_mask, Bool is_source )
+	{
+		const Bool is_read = ( access_type_mask & gdevice::AccessTypeBits::eAccessTypeRead );
+		const Bool is_write = ( access_type_mask & gdevice::AccessTypeBits::eAccessTypeWrite );
+
+		LayoutUsage layout_usage;
+		switch( layout )
+		{
+		case vk::ImageLayout::eUndefined:
+		case vk::ImageLayout::ePresentSrcKHR:
+			layout_usage.stageMask = is_source ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eBottomOfPipe;
+			break;
+		case vk::ImageLayout::eTransferSrcOptimal:
+		case vk::ImageLayout::eTransferDstOptimal:
+			layout_usage.stageMask = vk::PipelineStageFlagBits::eTransfer;
+			if( is_read ) layout_usage.accessMask |= vk::AccessFlagBits::eTransferRead;
+			if( is_write ) layout_usage.accessMask |= vk::AccessFlagBits::eTransferWrite;
+			break;
+		case vk::ImageLayout::eShaderReadOnlyOptimal:
+			// any shader stage may sample, vertex, task and mesh shaders included. all graphics is the closest the legacy
+			// stage flags have to all shaders, and only names the stages the device has
+			layout_usage.stageMask = vk::PipelineStageFlagBits::eAllGraphics | vk::PipelineStageFlagBits::eComputeShader;
+			layout_usage.accessMask = vk::AccessFlagBits::eShaderRead;
+			break;
+		case vk::ImageLayout::eGeneral:
+			layout_usage.stageMask = vk::PipelineStageFlagBits::eComputeShader;
+			if( is_read ) layout_usage.accessMask |= vk::AccessFlagBits::eShaderRead;
+			if( is_write ) layout_usage.accessMask |= vk::AccessFlagBits::eShaderWrite;
+			break;
+		case vk::ImageLayout::eColorAttachmentOptimal:
+			layout_usage.stageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+			if( is_read ) layout_usage.accessMask |= vk::AccessFlagBits::eColorAttachmentRead;
+			if( is_write ) layout_usage.accessMask |= vk::AccessFlagBits::eColorAttachmentWrite;
+			break;
+		case vk::ImageLayout::eDepthAttachmentOptimal:
+		case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+			layout_usage.stageMask = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+			if( is_read ) layout_usage.accessMask |= vk::AccessFlagBits::eDepthStencilAttachmentRead;
+			if( is_write ) layout_usage.accessMask |= vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+			break;
+		default:
+			AZHAL_LOG_CRITICAL( "no barrier parameters for image layout {0}", vk::to_string( layout ) );
+			AZHAL_DEBUG_BREAK();
+			layout_usage.stageMask = vk::PipelineStageFlagBits::eAllCommands;
+			layout_usage.accessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+			break;
+		}
+
+		return layout_usage;
+	}
+
+
+	Bool is_depth_layout( vk::ImageLayout layout )
+	{
+		return ( layout == vk::ImageLayout::eDepthAttachmentOptimal ) || ( layout == vk::ImageLayout::eDepthStencilAttachmentOptimal );
+	}
+}
+
+namespace gdevice
+{
+	PipelineBarrierParams get_pipeline_barrier_params( vk::ImageLayout src_layout, AccessTypeBits src_access_type_mask, vk::ImageLayout dst_layout, AccessTypeBits dst_access_type_mask )
 	{
-		using AccessTypeBits = gdevice::AccessTypeBits;
 		PipelineBarrierParams barrier_params;
 
 		if( src_layout == vk::ImageLayout::eUndefined && dst_layout == vk::ImageLayout::eColorAttachmentOptimal )
 		{
 			barrier_params.srcAccessMask = vk::AccessFlagBits::eNone;
-			barrier_params.srcStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
+			// waiting on eColorAttachmentOutput chains the transition after the swapchain acquire semaphore wait
+			barrier_params.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
 			barrier_params.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
 
 			if( dst_access_type_mask & AccessTypeBits::eAccessTypeRead ) barrier_params.destAccessMask |= vk::AccessFlagBits::eColorAttachmentRead;
@@ -42,18 +101,29 @@ namespace
 
 			barrier_params.subResourceAspectMask = vk::ImageAspectFlagBits::eColor;
 		}
+		else
+		{
+			// only writes of the source have to be made available, reads just have to finish
+			const LayoutUsage src_usage = get_layout_usage( src_layout, static_cast< AccessTypeBits >( src_access_type_mask & AccessTypeBits::eAccessTypeWrite ), true );
+			const LayoutUsage dst_usage = get_layout_usage( dst_layout, dst_access_type_mask, false );
+
+			barrier_params.srcStageMask = src_usage.stageMask;
+			barrier_params.srcAccessMask = src_usage.accessMask;
+			barrier_params.dstStageMask = dst_usage.stageMask;
+			barrier_params.destAccessMask = dst_usage.accessMask;
+			barrier_params.subResourceAspectMask = ( is_depth_layout( src_layout ) || is_depth_layout( dst_layout ) ) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+		}
 
 		return barrier_params;
 	}
-}
 
-namespace gdevice
-{
+
 	void insert_image_pipeline_barrier( vk::CommandBuffer cmd_buffer, vk::Image image,
 		vk::ImageLayout src_layout, AccessTypeBits src_access_type_mask,
 		vk::ImageLayout dst_layout, AccessTypeBits dst_access_type_mask,
 		Uint32 base_mip_level, Uint32 mip_count, Uint32 base_array_layer, Uint32 layer_count )
 	{
+		AZHAL_PROFILE_FUNCTION();
 
 		const PipelineBarrierParams barrier_params = get_pipeline_barrier_params( src_layout, src_access_type_mask, dst_layout, dst_access_type_mask );
 
@@ -76,4 +146,81 @@ namespace gdevice
 
 		cmd_buffer.pipelineBarrier( barrier_params.srcStageMask, barrier_params.dstStageMask, {}, {}, {}, image_mem_barrier );
 	}
+
+
+	void insert_memory_barrier( vk::CommandBuffer cmd_buffer,
+		vk::PipelineStageFlags2 src_stage_mask, vk::AccessFlags2 src_access_mask,
+		vk::PipelineStageFlags2 dst_stage_mask, vk::AccessFlags2 dst_access_mask )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::MemoryBarrier2 memory_barrier
+		{
+			.srcStageMask = src_stage_mask,
+			.srcAccessMask = src_access_mask,
+			.dstStageMask = dst_stage_mask,
+			.dstAccessMask = dst_access_mask
+		};
+		const vk::DependencyInfo dependency_info
+		{
+			.memoryBarrierCount = 1,
+			.pMemoryBarriers = &memory_barrier
+		};
+
+		cmd_buffer.pipelineBarrier2( dependency_info );
+	}
+
+
+	void insert_geometry_upload_barrier( vk::CommandBuffer cmd_buffer, Bool is_pulled )
+	{
+		if( is_pulled )
+		{
+			insert_memory_barrier( cmd_buffer,
+				vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+				vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead | vk::AccessFlagBits2::eShaderStorageRead );
+		}
+		else
+		{
+			insert_memory_barrier( cmd_buffer,
+				vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+				vk::PipelineStageFlagBits2::eVertexInput, vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead );
+		}
+	}
+
+
+	void insert_image_barrier( vk::CommandBuffer cmd_buffer, vk::Image image, vk::ImageAspectFlags aspect_mask,
+		vk::PipelineStageFlags2 src_stage_mask, vk::AccessFlags2 src_access_mask, vk::ImageLayout src_layout,
+		vk::PipelineStageFlags2 dst_stage_mask, vk::AccessFlags2 dst_access_mask, vk::ImageLayout dst_layout,
+		Uint32 base_mip_level, Uint32 mip_count )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::ImageMemoryBarrier2 image_memory_barrier
+		{
+			.srcStageMask = src_stage_mask,
+			.srcAccessMask = src_access_mask,
+			.dstStageMask = dst_stage_mask,
+			.dstAccessMask = dst_access_mask,
+			.oldLayout = src_layout,
+			.newLayout = dst_layout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image,
+			.subresourceRange =
+			{
+				.aspectMask = aspect_mask,
+				.baseMipLevel = base_mip_level,
+				.levelCount = mip_count,
+				.baseArrayLayer = 0,
+				.layerCount = 1
+			}
+		};
+		const vk::DependencyInfo dependency_info
+		{
+			.imageMemoryBarrierCount = 1,
+			.pImageMemoryBarriers = &image_memory_barrier
+		};
+
+		cmd_buffer.pipelineBarrier2( dependency_info );
+	}
 }
\ No newline at end of file
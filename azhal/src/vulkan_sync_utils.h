@@ -4,10 +4,41 @@ namespace gdevice
 {
 	enum AccessTypeBits : Uint32;
 
+	struct PipelineBarrierParams
+	{
+		vk::AccessFlags srcAccessMask = vk::AccessFlagBits::eNone;
+		vk::PipelineStageFlags srcStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
+		vk::AccessFlags destAccessMask = vk::AccessFlagBits::eNone;
+		vk::PipelineStageFlags dstStageMask = vk::PipelineStageFlagBits::eTopOfPipe;
+		vk::ImageAspectFlags subResourceAspectMask;
+	};
+
+	// derives the access and stage masks for a layout transition. undefined, transfer, shader read-only, general,
+	// color and depth attachment and present layouts are known, general is taken as a compute storage image
+	PipelineBarrierParams get_pipeline_barrier_params( vk::ImageLayout src_layout, AccessTypeBits src_access_type_mask, vk::ImageLayout dst_layout, AccessTypeBits dst_access_type_mask );
+
 	void insert_image_pipeline_barrier( vk::CommandBuffer cmd_buffer, vk::Image image,
 		vk::ImageLayout src_layout, AccessTypeBits src_access_type_mask,
 		vk::ImageLayout dst_layout, AccessTypeBits dst_access_type_mask,
 		Uint32 base_mip_level = 0, Uint32 mip_count = 1,
 		Uint32 base_array_layer = 0, Uint32 layer_count = 1
 	);
+
+	// a global execution and memory dependency, e.g. between a dispatch writing a buffer and the dispatch or draw reading it.
+	// within one queue only, work on other queues is ordered through their timeline semaphores
+	void insert_memory_barrier( vk::CommandBuffer cmd_buffer,
+		vk::PipelineStageFlags2 src_stage_mask, vk::AccessFlags2 src_access_mask,
+		vk::PipelineStageFlags2 dst_stage_mask, vk::AccessFlags2 dst_access_mask
+	);
+
+	// makes copies into vertex and index buffers visible to vertex input. pulled geometry is also read as storage
+	// buffers, by any stage, see get_pulled_geometry_usage
+	void insert_geometry_upload_barrier( vk::CommandBuffer cmd_buffer, Bool is_pulled );
+
+	// explicit stages and accesses for layouts get_pipeline_barrier_params does not know, e.g. depth and storage images
+	void insert_image_barrier( vk::CommandBuffer cmd_buffer, vk::Image image, vk::ImageAspectFlags aspect_mask,
+		vk::PipelineStageFlags2 src_stage_mask, vk::AccessFlags2 src_access_mask, vk::ImageLayout src_layout,
+		vk::PipelineStageFlags2 dst_stage_mask, vk::AccessFlags2 dst_access_mask, vk::ImageLayout dst_layout,
+		Uint32 base_mip_level = 0, Uint32 mip_count = VK_REMAINING_MIP_LEVELS
+	);
 }
\ No newline at end of file
@@ -14,11 +14,13 @@ Window::Window( const AnsiChar* name, Uint32 width, Uint32 height )
 	AZHAL_FATAL_ASSERT( result, "Failed to initialize GLFW" );
 
 	glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
-	// TODO: handle resizing
-	glfwWindowHint( GLFW_RESIZABLE, GLFW_FALSE );
+	glfwWindowHint( GLFW_RESIZABLE, GLFW_TRUE );
 
 	m_pWindow = glfwCreateWindow( m_width, m_height, m_name.data(), nullptr, nullptr );
 	AZHAL_FATAL_ASSERT( m_pWindow != nullptr, "Failed to create GLFWwindow" );
+
+	glfwSetWindowUserPointer( m_pWindow, this );
+	glfwSetFramebufferSizeCallback( m_pWindow, &Window::on_framebuffer_resized );
 }
 
 
@@ -47,4 +49,22 @@ Uvec2 Window::get_framebuffer_size() const
 	glfwGetFramebufferSize( m_pWindow, &width, &height );
 
 	return { width, height };
+}
+
+
+Bool Window::consume_framebuffer_resize()
+{
+	const Bool is_resized = m_isFramebufferResized;
+	m_isFramebufferResized = false;
+
+	return is_resized;
+}
+
+
+void Window::on_framebuffer_resized( GLFWwindow* p_glfw_window, Int32 width, Int32 height )
+{
+	Window* p_window = static_cast< Window* >( glfwGetWindowUserPointer( p_glfw_window ) );
+	p_window->m_width = static_cast< Uint32 >( width );
+	p_window->m_height = static_cast< Uint32 >( height );
+	p_window->m_isFramebufferResized = true;
 }
\ No newline at end of file
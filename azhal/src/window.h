@@ -20,10 +20,17 @@ public:
 
 	Uvec2 get_framebuffer_size() const;
 
+	// returns true once after the framebuffer was resized
+	Bool consume_framebuffer_resize();
+
 private:
+	static void on_framebuffer_resized( GLFWwindow* p_glfw_window, Int32 width, Int32 height );
+
 	GLFWwindow* m_pWindow;
 
 	String m_name;
 	Uint32 m_width;
 	Uint32 m_height;
+
+	Bool m_isFramebufferResized = false;
 };
\ No newline at end of file
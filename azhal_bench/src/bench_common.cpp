@@ -0,0 +1,129 @@
+#include "benchmarks.h"
+
+#include <spdlog/spdlog.h>
+#include <spdlog/async.h>
+#include <spdlog/sinks/null_sink.h>
+
+namespace
+{
+	// the benchmarks log through loggers of their own with a null sink, the sinks of the global logger belong to its
+	// worker thread while messages are queued and must not be swapped
+	std::shared_ptr<spdlog::logger> create_null_sink_logger( const AnsiChar* name, spdlog::level::level_enum level )
+	{
+		const std::shared_ptr<spdlog::logger> logger = std::make_shared<spdlog::logger>( name, std::make_shared<spdlog::sinks::null_sink_st>() );
+		logger->set_level( level );
+		return logger;
+	}
+
+
+	// shares the thread pool of the global logger, so that the enqueue cost is the one AZHAL_LOG_* pays
+	std::shared_ptr<spdlog::async_logger> create_null_sink_async_logger( const AnsiChar* name )
+	{
+		const std::shared_ptr<spdlog::async_logger> logger = std::make_shared<spdlog::async_logger>( name, std::make_shared<spdlog::sinks::null_sink_mt>(),
+			spdlog::thread_pool(), spdlog::async_overflow_policy::block );
+		logger->set_level( spdlog::level::trace );
+		return logger;
+	}
+}
+
+namespace bench
+{
+	void register_common_benchmarks( Harness& harness )
+	{
+		harness.add( "common/LoadBinaryBlob/simple.vspv", []()
+		{
+			const ByteBufferDynamic blob = LoadBinaryBlob( AZHAL_FILE_PATH( "azhal/shaders/simple.vspv" ) );
+			do_not_optimize( blob.data() );
+		} );
+
+		// the loggers are called directly, the AZHAL_LOG_* macros compile out in Profile and Final builds
+		harness.add( "common/log/filtered", []()
+		{
+			static const std::shared_ptr<spdlog::logger> s_logger = create_null_sink_logger( "bench_filtered", spdlog::level::info );
+			s_logger->trace( "filtered message {0} {1}", 42, 3.14f );
+		} );
+
+		harness.add( "common/log/format", []()
+		{
+			static const std::shared_ptr<spdlog::logger> s_logger = create_null_sink_logger( "bench_format", spdlog::level::trace );
+			s_logger->info( "formatted message {0} {1}", 42, 3.14f );
+		} );
+
+		harness.add( "common/log/async_enqueue", []()
+		{
+			static const std::shared_ptr<spdlog::async_logger> s_logger = create_null_sink_async_logger( "bench_async_enqueue" );
+			s_logger->info( "enqueued message {0} {1}", 42, 3.14f );
+		} );
+
+		// the baseline the scratch and pool variants are compared against
+		harness.add( "common/alloc/heap_vector_64", []()
+		{
+			std::vector<Uint64> values;
+			for( Uint64 i = 0; i < 64; ++i )
+			{
+				values.push_back( i );
+			}
+			do_not_optimize( values.data() );
+		} );
+
+		harness.add( "common/alloc/scratch_vector_64", []()
+		{
+			ScratchScope scratch;
+			std::pmr::vector<Uint64> values( scratch.GetResource() );
+			for( Uint64 i = 0; i < 64; ++i )
+			{
+				values.push_back( i );
+			}
+			do_not_optimize( values.data() );
+		} );
+
+		harness.add( "common/alloc/pool_64", []()
+		{
+			static PoolAllocator s_pool( 64, 64 );
+
+			void* blocks[ 64 ];
+			for( void*& p_block : blocks )
+			{
+				p_block = s_pool.Allocate();
+			}
+			do_not_optimize( blocks );
+			for( void* p_block : blocks )
+			{
+				s_pool.Free( p_block );
+			}
+		} );
+
+		harness.add( "common/jobs/run_wait_empty", []()
+		{
+			JobCounter counter;
+			JobSystem::Run( []() {}, &counter );
+			JobSystem::Wait( counter );
+		} );
+
+		// 64 independent jobs, dominated by scheduling and stealing overhead
+		harness.add( "common/jobs/fan_out_64", []()
+		{
+			JobCounter counter;
+			for( Uint32 i = 0; i < 64; ++i )
+			{
+				JobSystem::Run( []() {}, &counter );
+			}
+			JobSystem::Wait( counter );
+		} );
+
+		harness.add( "common/jobs/parallel_for_1m", []()
+		{
+			constexpr Uint32 K_ITEM_COUNT = 1 << 20;
+			static std::vector<Float> s_values( K_ITEM_COUNT, 1.0f );
+
+			JobSystem::ParallelFor( K_ITEM_COUNT, JobSystem::GetDefaultGrainSize( K_ITEM_COUNT ), []( Uint32 begin, Uint32 end )
+			{
+				for( Uint32 i = begin; i < end; ++i )
+				{
+					s_values[ i ] = s_values[ i ] * 0.5f + 1.0f;
+				}
+			} );
+			do_not_optimize( s_values.data() );
+		} );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "benchmarks.h"
+
+namespace
+{
+	const AnsiChar* K_VERTEX_SHADER_PATH = AZHAL_FILE_PATH( "azhal/shaders/simple.vspv" );
+	const AnsiChar* K_FRAGMENT_SHADER_PATH = AZHAL_FILE_PATH( "azhal/shaders/simple.pspv" );
+
+	vk::PipelineCache s_warmPipelineCache = VK_NULL_HANDLE;
+
+	// no frames run here, so the deferred destruction queue is drained explicitly. the cost is amortized into the samples
+	constexpr Uint32 K_DEFERRED_FLUSH_INTERVAL = 1024;
+	Uint32 s_iterationsSinceFlush = 0;
+
+	void flush_deferred_destructions_periodically( gdevice::Context& gctx )
+	{
+		if( ++s_iterationsSinceFlush >= K_DEFERRED_FLUSH_INTERVAL )
+		{
+			gdevice::flush_deferred_destructions( gctx );
+			s_iterationsSinceFlush = 0;
+		}
+	}
+}
+
+namespace bench
+{
+	void register_gdevice_benchmarks( Harness& harness, gdevice::Context& gctx )
+	{
+		harness.add( "gdevice/barrier_params/undefined_to_color_attachment", []()
+		{
+			const gdevice::PipelineBarrierParams barrier_params = gdevice::get_pipeline_barrier_params(
+				vk::ImageLayout::eUndefined, gdevice::eAccessTypeInvalid,
+				vk::ImageLayout::eColorAttachmentOptimal, gdevice::eAccessTypeReadWrite );
+			do_not_optimize( barrier_params );
+		} );
+
+		harness.add( "gdevice/barrier_params/color_attachment_to_present", []()
+		{
+			const gdevice::PipelineBarrierParams barrier_params = gdevice::get_pipeline_barrier_params(
+				vk::ImageLayout::eColorAttachmentOptimal, gdevice::eAccessTypeWrite,
+				vk::ImageLayout::ePresentSrcKHR, gdevice::eAccessTypeInvalid );
+			do_not_optimize( barrier_params );
+		} );
+
+		harness.add( "gdevice/command_buffer/allocate_free", [&gctx]()
+		{
+			const vk::CommandBuffer cmd_buffer = gdevice::allocate_command_buffer( gctx, gdevice::QueueType::eGraphics );
+			gdevice::free_command_buffer( gctx, gdevice::QueueType::eGraphics, cmd_buffer );
+			flush_deferred_destructions_periodically( gctx );
+		},
+		nullptr,
+		[&gctx]() { gdevice::flush_deferred_destructions( gctx ); } );
+
+		const vk::Format color_format = gdevice::get_swapchain( gctx ).imageFormat;
+
+		harness.add( "gdevice/pso/create_destroy_no_cache", [&gctx, color_format]()
+		{
+			const gdevice::PSOCreationParams pso_creation_params
+			{
+				.pVertexShader = K_VERTEX_SHADER_PATH,
+				.pFragmentShader = K_FRAGMENT_SHADER_PATH,
+				.isDynamicRendering = VK_TRUE,
+				.colorAttachmentFormats = { color_format }
+			};
+			gdevice::PSOHandle pso_handle = gdevice::create_pso( gctx, pso_creation_params );
+			gdevice::destroy_pso( gctx, pso_handle );
+			flush_deferred_destructions_periodically( gctx );
+		},
+		nullptr,
+		[&gctx]() { gdevice::flush_deferred_destructions( gctx ); } );
+
+		// the cache is primed by the warm-up iterations, samples then measure cache hits
+		harness.add( "gdevice/pso/create_destroy_warm_cache", [&gctx, color_format]()
+		{
+			const gdevice::PSOCreationParams pso_creation_params
+			{
+				.pVertexShader = K_VERTEX_SHADER_PATH,
+				.pFragmentShader = K_FRAGMENT_SHADER_PATH,
+				.isDynamicRendering = VK_TRUE,
+				.colorAttachmentFormats = { color_format },
+				.pipelineCache = s_warmPipelineCache
+			};
+			gdevice::PSOHandle pso_handle = gdevice::create_pso( gctx, pso_creation_params );
+			gdevice::destroy_pso( gctx, pso_handle );
+			flush_deferred_destructions_periodically( gctx );
+		},
+		[&gctx]() { s_warmPipelineCache = gdevice::create_pipeline_cache( gctx, {} ); },
+		[&gctx]()
+		{
+			gdevice::flush_deferred_destructions( gctx );
+			gdevice::destroy_pipeline_cache( gctx, s_warmPipelineCache );
+			s_warmPipelineCache = VK_NULL_HANDLE;
+		} );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "bench_harness.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	volatile const void* s_optimizationSink = nullptr;
+
+	Double run_iterations_ns( const bench::BenchmarkFn& fn, Uint64 iterations )
+	{
+		const Clock::time_point start_time = Clock::now();
+		for( Uint64 i = 0; i < iterations; ++i )
+		{
+			fn();
+		}
+		return std::chrono::duration<Double, std::nano>( Clock::now() - start_time ).count();
+	}
+}
+
+namespace bench
+{
+	void do_not_optimize_impl( const void* p_value )
+	{
+		s_optimizationSink = p_value;
+	}
+
+
+	Harness::Harness( const HarnessParams& harness_params )
+		: m_params( harness_params )
+	{
+	}
+
+
+	void Harness::add( const AnsiChar* name, BenchmarkFn fn, std::function<void()> setup_fn, std::function<void()> teardown_fn )
+	{
+		m_benchmarks.push_back( Benchmark { .name = name, .fn = std::move( fn ), .setupFn = std::move( setup_fn ), .teardownFn = std::move( teardown_fn ) } );
+	}
+
+
+	void Harness::run_all()
+	{
+		m_results.clear();
+		for( const Benchmark& benchmark : m_benchmarks )
+		{
+			if( !m_params.filter.empty() && benchmark.name.find( m_params.filter ) == String::npos )
+			{
+				continue;
+			}
+
+			if( benchmark.setupFn )
+			{
+				benchmark.setupFn();
+			}
+
+			const BenchmarkResult result = run( benchmark );
+
+			if( benchmark.teardownFn )
+			{
+				benchmark.teardownFn();
+			}
+
+			AZHAL_LOG_ALWAYS_ENABLED( "[bench] {0:<40} mean {1:>12.1f} ns  median {2:>12.1f} ns  stddev {3:>10.1f} ns  ({4} x {5})",
+				result.name, result.meanNs, result.medianNs, result.stddevNs, result.sampleCount, result.iterationsPerSample );
+			m_results.push_back( result );
+		}
+	}
+
+
+	BenchmarkResult Harness::run( const Benchmark& benchmark ) const
+	{
+		AZHAL_PROFILE_SCOPE( "bench::Harness::run" );
+		AZHAL_PROFILE_ZONE_TEXT( benchmark.name.c_str(), benchmark.name.size() );
+
+		// warm-up caches, allocators and lazily created driver state
+		Double warmup_elapsed_ns = 0.0;
+		while( warmup_elapsed_ns < m_params.warmupMs * 1e6 )
+		{
+			warmup_elapsed_ns += run_iterations_ns( benchmark.fn, 1 );
+		}
+
+		// scale the iteration count until one sample is long enough to hide the clock resolution
+		Uint64 iterations = 1;
+		while( run_iterations_ns( benchmark.fn, iterations ) < m_params.minSampleMs * 1e6 && iterations < ( 1ull << 40 ) )
+		{
+			iterations *= 2;
+		}
+
+		std::vector<Double> samples_ns( m_params.sampleCount );
+		for( Double& sample_ns : samples_ns )
+		{
+			sample_ns = run_iterations_ns( benchmark.fn, iterations ) / static_cast< Double >( iterations );
+		}
+
+		std::sort( samples_ns.begin(), samples_ns.end() );
+
+		Double sum = 0.0;
+		for( const Double sample_ns : samples_ns )
+		{
+			sum += sample_ns;
+		}
+		const Double mean = sum / static_cast< Double >( samples_ns.size() );
+
+		Double squared_deviation_sum = 0.0;
+		for( const Double sample_ns : samples_ns )
+		{
+			squared_deviation_sum += ( sample_ns - mean ) * ( sample_ns - mean );
+		}
+
+		const size_t middle = samples_ns.size() / 2;
+		const Double median = ( samples_ns.size() % 2 == 0 ) ? ( samples_ns[ middle - 1 ] + samples_ns[ middle ] ) * 0.5 : samples_ns[ middle ];
+
+		return BenchmarkResult
+		{
+			.name = benchmark.name,
+			.iterationsPerSample = iterations,
+			.sampleCount = m_params.sampleCount,
+			.meanNs = mean,
+			.medianNs = median,
+			.stddevNs = ( samples_ns.size() > 1 ) ? std::sqrt( squared_deviation_sum / static_cast< Double >( samples_ns.size() - 1 ) ) : 0.0,
+			.minNs = samples_ns.front(),
+			.maxNs = samples_ns.back()
+		};
+	}
+
+
+	Bool Harness::write_results_csv( const AnsiChar* file_path ) const
+	{
+		std::ofstream file_stream( file_path );
+		if( !file_stream.is_open() )
+		{
+			AZHAL_LOG_ALWAYS_ENABLED( "[bench] failed to open {0} for writing", file_path );
+			return false;
+		}
+
+		file_stream << "name,iterations,samples,mean_ns,median_ns,stddev_ns,min_ns,max_ns\n";
+		for( const BenchmarkResult& result : m_results )
+		{
+			file_stream << result.name << ',' << result.iterationsPerSample << ',' << result.sampleCount << ','
+				<< result.meanNs << ',' << result.medianNs << ',' << result.stddevNs << ',' << result.minNs << ',' << result.maxNs << '\n';
+		}
+
+		return true;
+	}
+
+
+	Bool Harness::compare_with_baseline( const AnsiChar* file_path ) const
+	{
+		std::ifstream file_stream( file_path );
+		if( !file_stream.is_open() )
+		{
+			AZHAL_LOG_ALWAYS_ENABLED( "[bench] failed to open baseline {0}", file_path );
+			return false;
+		}
+
+		std::unordered_map<String, Double> baseline_means;
+		// a baseline with rows that cannot be compared against fails the comparison, the rows that can are still reported
+		Bool is_baseline_valid = true;
+
+		String line;
+		// skip the header
+		std::getline( file_stream, line );
+		while( std::getline( file_stream, line ) )
+		{
+			std::stringstream line_stream( line );
+			String name, iterations, samples, mean;
+			if( !( std::getline( line_stream, name, ',' ) && std::getline( line_stream, iterations, ',' ) &&
+				std::getline( line_stream, samples, ',' ) && std::getline( line_stream, mean, ',' ) ) )
+			{
+				continue;
+			}
+
+			Double mean_ns = 0.0;
+			const std::from_chars_result parse_result = std::from_chars( mean.data(), mean.data() + mean.size(), mean_ns );
+			if( parse_result.ec != std::errc() || parse_result.ptr != mean.data() + mean.size() || !std::isfinite( mean_ns ) || mean_ns <= 0.0 )
+			{
+				AZHAL_LOG_ALWAYS_ENABLED( "[bench] {0:<40} invalid baseline mean '{1}'", name, mean );
+				is_baseline_valid = false;
+				continue;
+			}
+			baseline_means[ name ] = mean_ns;
+		}
+
+		Bool has_regression = false;
+		for( const BenchmarkResult& result : m_results )
+		{
+			const auto iter = baseline_means.find( result.name );
+			if( iter == baseline_means.end() )
+			{
+				AZHAL_LOG_ALWAYS_ENABLED( "[bench] {0:<40} no baseline", result.name );
+				continue;
+			}
+
+			const Double delta_percent = ( result.meanNs - iter->second ) / iter->second * 100.0;
+			const Bool is_regression = delta_percent > m_params.regressionThresholdPercent;
+			has_regression |= is_regression;
+
+			AZHAL_LOG_ALWAYS_ENABLED( "[bench] {0:<40} baseline {1:>12.1f} ns  current {2:>12.1f} ns  {3:>+7.2f}% {4}",
+				result.name, iter->second, result.meanNs, delta_percent, is_regression ? "REGRESSION" : "" );
+		}
+
+		return !has_regression && is_baseline_valid;
+	}
+}
\ No newline at end of file
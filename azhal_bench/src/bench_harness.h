@@ -0,0 +1,85 @@
+#pragma once
+
+#include "common.h"
+
+#include <functional>
+
+namespace bench
+{
+	struct HarnessParams
+	{
+		// warm-up runs the benchmark for at least this long before any sample is taken
+		Double warmupMs = 50.0;
+		// the iteration count of a sample is doubled until a sample takes at least this long
+		Double minSampleMs = 10.0;
+		Uint32 sampleCount = 20;
+
+		// only benchmarks whose name contains the filter are run
+		String filter;
+
+		// percentage a mean may grow over the baseline before it is reported as a regression
+		Double regressionThresholdPercent = 5.0;
+	};
+
+	struct BenchmarkResult
+	{
+		String name;
+		Uint64 iterationsPerSample = 0;
+		Uint32 sampleCount = 0;
+
+		// per-iteration times
+		Double meanNs = 0.0;
+		Double medianNs = 0.0;
+		Double stddevNs = 0.0;
+		Double minNs = 0.0;
+		Double maxNs = 0.0;
+	};
+
+	using BenchmarkFn = std::function<void()>;
+
+	struct Benchmark
+	{
+		String name;
+		BenchmarkFn fn;
+		// optional, run once before warm-up and once after the last sample
+		std::function<void()> setupFn;
+		std::function<void()> teardownFn;
+	};
+
+	class Harness : NonCopyable
+	{
+	public:
+		explicit Harness( const HarnessParams& harness_params );
+
+		void add( const AnsiChar* name, BenchmarkFn fn, std::function<void()> setup_fn = nullptr, std::function<void()> teardown_fn = nullptr );
+
+		void run_all();
+
+		AZHAL_INLINE const std::vector<BenchmarkResult>& get_results() const
+		{
+			return m_results;
+		}
+
+		Bool write_results_csv( const AnsiChar* file_path ) const;
+
+		// compares the results against a csv written by a previous run,
+		// returns false if any benchmark regressed beyond the threshold
+		Bool compare_with_baseline( const AnsiChar* file_path ) const;
+
+	private:
+		BenchmarkResult run( const Benchmark& benchmark ) const;
+
+		HarnessParams m_params;
+		std::vector<Benchmark> m_benchmarks;
+		std::vector<BenchmarkResult> m_results;
+	};
+
+	// keeps the compiler from discarding a computed value
+	void do_not_optimize_impl( const void* p_value );
+
+	template<typename T>
+	AZHAL_FORCE_INLINE void do_not_optimize( const T& value )
+	{
+		do_not_optimize_impl( &value );
+	}
+}
\ No newline at end of file
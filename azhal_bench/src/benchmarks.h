@@ -0,0 +1,10 @@
+#pragma once
+
+#include "bench_harness.h"
+#include "azhal_renderer.h"
+
+namespace bench
+{
+	void register_common_benchmarks( Harness& harness );
+	void register_gdevice_benchmarks( Harness& harness, gdevice::Context& gctx );
+}
\ No newline at end of file
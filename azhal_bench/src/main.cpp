@@ -0,0 +1,77 @@
+#include "common.h"
+#include "azhal_renderer.h"
+
+#include "benchmarks.h"
+
+Int32 main( int argc, char** argv )
+{
+	AZHAL_PROFILE_THREAD_NAME( "main" );
+
+	AzhalLogger::Init( "azhal_bench" );
+	JobSystem::Init();
+
+	cxxopts::Options cmd_line_options( "azhal_bench", "cpu microbenchmarks for azhal and common" );
+	cmd_line_options.add_options()
+		( "filter", "run only benchmarks whose name contains this string", cxxopts::value<String>()->default_value( "" ) )
+		( "samples", "samples taken per benchmark", cxxopts::value<Uint32>()->default_value( "20" ) )
+		( "minSampleMs", "minimum duration of a single sample", cxxopts::value<Double>()->default_value( "10" ) )
+		( "warmupMs", "warm-up duration per benchmark", cxxopts::value<Double>()->default_value( "50" ) )
+		( "output", "csv file the results are written to", cxxopts::value<String>()->default_value( "" ) )
+		( "baseline", "csv file of a previous run to compare against", cxxopts::value<String>()->default_value( "" ) )
+		( "threshold", "regression threshold in percent for --baseline", cxxopts::value<Double>()->default_value( "5" ) )
+		( "vkValidation", "enable vulkan api validation" );
+
+	const cxxopts::ParseResult& cmd_line_result = cmd_line_options.parse( argc, argv );
+
+	const bench::HarnessParams harness_params
+	{
+		.warmupMs = cmd_line_result[ "warmupMs" ].as<Double>(),
+		.minSampleMs = cmd_line_result[ "minSampleMs" ].as<Double>(),
+		.sampleCount = cmd_line_result[ "samples" ].as<Uint32>(),
+		.filter = cmd_line_result[ "filter" ].as<String>(),
+		.regressionThresholdPercent = cmd_line_result[ "threshold" ].as<Double>()
+	};
+
+	Int32 exit_code = 0;
+	try
+	{
+		// headless, so the benchmarks also run on build agents without a display
+		const gdevice::GDeviceInitParams gdevice_init_params
+		{
+			.pWindow = nullptr,
+			.swapchainExtent = vk::Extent2D { 64, 64 },
+			.areValidationLayersEnabled = cmd_line_result.count( "vkValidation" ) > 0,
+			.debugMessageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning
+		};
+		gdevice::Context gctx = gdevice::init( gdevice_init_params );
+
+		bench::Harness harness( harness_params );
+		bench::register_common_benchmarks( harness );
+		bench::register_gdevice_benchmarks( harness, gctx );
+
+		harness.run_all();
+
+		const String output_path = cmd_line_result[ "output" ].as<String>();
+		if( !output_path.empty() && !harness.write_results_csv( output_path.c_str() ) )
+		{
+			exit_code = 1;
+		}
+
+		const String baseline_path = cmd_line_result[ "baseline" ].as<String>();
+		if( !baseline_path.empty() && !harness.compare_with_baseline( baseline_path.c_str() ) )
+		{
+			exit_code = 1;
+		}
+
+		gdevice::shutdown( gctx );
+	}
+	catch( GDeviceException& e )
+	{
+		AZHAL_LOG_ALWAYS_ENABLED( "[GDeviceException] {0}", e.what() );
+		exit_code = 1;
+	}
+
+	JobSystem::Shutdown();
+
+	return exit_code;
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 SET "COMMON_DIR=%~dp0common\src"
 SET "AZHAL_DIR=%~dp0azhal\src"
 SET "SANDBOX_DIR=%~dp0sandbox\src"
+SET "BENCH_DIR=%~dp0azhal_bench\src"
 
 echo Project: Common
 tools\cloc\cloc.exe %COMMON_DIR%
@@ -15,4 +16,8 @@ echo Project: Sandbox
 tools\cloc\cloc.exe %SANDBOX_DIR%
 echo:
 
+echo Project: Bench
+tools\cloc\cloc.exe %BENCH_DIR%
+echo:
+
 PAUSE
\ No newline at end of file
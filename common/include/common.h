@@ -8,4 +8,15 @@
 #include "../src/exception.h"
 #include "../src/profiler.h"
 #include "../src/fileio.h"
-#include "../src/non_copyable.h"
\ No newline at end of file
+#include "../src/non_copyable.h"
+#include "../src/job_system.h"
+#include "../src/stage_timings.h"
+#include "../src/triple_buffer.h"
+#include "../src/mpsc_queue.h"
+#include "../src/allocators.h"
+#include "../src/handle_pool.h"
+#include "../src/mesh_processing.h"
+#include "../src/radix_sort.h"
+#include "../src/culling.h"
+#include "../src/transform_hierarchy.h"
+#include "../src/texture_data.h"
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include "allocators.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace
+{
+	constexpr Uint64 K_THREAD_SCRATCH_CAPACITY = 256 * K_KIBIBYTE;
+
+#ifdef AZHAL_MEMORY_TRACKING
+	// written over released memory so that reads through stale pointers stand out
+	constexpr Uint8 K_RELEASED_MEMORY_PATTERN = 0xCD;
+
+	thread_local ScratchScope* t_pInnermostScratchScope = nullptr;
+#endif
+
+	Uint64 align_up( Uint64 value, Uint64 alignment )
+	{
+		return ( value + alignment - 1 ) & ~( alignment - 1 );
+	}
+
+
+	LinearArena& get_thread_scratch_arena()
+	{
+		thread_local LinearArena t_scratchArena( K_THREAD_SCRATCH_CAPACITY );
+		return t_scratchArena;
+	}
+}
+
+LinearArena::LinearArena( Uint64 capacity )
+	: m_pBegin( static_cast< Uint8* >( ::operator new( capacity, std::align_val_t { alignof( std::max_align_t ) } ) ) )
+	, m_capacity( capacity )
+{
+}
+
+
+LinearArena::~LinearArena()
+{
+	if( m_overflowCount > 0 )
+	{
+		AZHAL_LOG_WARN( "linear arena of {0} bytes overflowed {1} times, high water mark {2} bytes", m_capacity, m_overflowCount, m_highWaterMark );
+	}
+
+	::operator delete( m_pBegin, std::align_val_t { alignof( std::max_align_t ) } );
+}
+
+
+void* LinearArena::Allocate( Uint64 size, Uint64 alignment )
+{
+	AZHAL_ASSERT( ( alignment & ( alignment - 1 ) ) == 0, "alignment must be a power of two" );
+
+	const Uint64 address = reinterpret_cast< Uint64 >( m_pBegin ) + m_offset;
+	const Uint64 aligned_offset = align_up( address, alignment ) - reinterpret_cast< Uint64 >( m_pBegin );
+	if( aligned_offset + size > m_capacity )
+	{
+		m_overflowCount++;
+		return nullptr;
+	}
+
+	m_offset = aligned_offset + size;
+	m_highWaterMark = std::max( m_highWaterMark, m_offset );
+
+	return m_pBegin + aligned_offset;
+}
+
+
+void LinearArena::Reset()
+{
+	Rewind( 0 );
+}
+
+
+void LinearArena::Rewind( Uint64 marker )
+{
+	AZHAL_ASSERT( marker <= m_offset, "linear arena markers must be rewound in reverse order" );
+
+#ifdef AZHAL_MEMORY_TRACKING
+	std::memset( m_pBegin + marker, K_RELEASED_MEMORY_PATTERN, m_offset - marker );
+#endif
+	m_offset = marker;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PoolAllocator::PoolAllocator( Uint64 block_size, Uint64 block_count, Uint64 block_alignment )
+	: m_blockSize( align_up( std::max<Uint64>( block_size, sizeof( void* ) ), block_alignment ) )
+	, m_blockCount( block_count )
+	, m_blockAlignment( block_alignment )
+{
+	AZHAL_ASSERT( ( block_alignment & ( block_alignment - 1 ) ) == 0, "alignment must be a power of two" );
+
+	m_pBegin = static_cast< Uint8* >( ::operator new( m_blockSize * m_blockCount, std::align_val_t { m_blockAlignment } ) );
+
+	// thread the free list front to back so that the first allocations are contiguous
+	for( Uint64 i = m_blockCount; i > 0; --i )
+	{
+		void* p_block = m_pBegin + ( i - 1 ) * m_blockSize;
+		*static_cast< void** >( p_block ) = m_pFreeList;
+		m_pFreeList = p_block;
+	}
+
+#ifdef AZHAL_MEMORY_TRACKING
+	m_isBlockLive.assign( m_blockCount, false );
+#endif
+}
+
+
+PoolAllocator::~PoolAllocator()
+{
+#ifdef AZHAL_MEMORY_TRACKING
+	if( m_liveBlockCount > 0 )
+	{
+		AZHAL_LOG_ERROR( "pool allocator destroyed with {0} of {1} blocks of {2} bytes still allocated", m_liveBlockCount, m_blockCount, m_blockSize );
+	}
+#endif
+
+	::operator delete( m_pBegin, std::align_val_t { m_blockAlignment } );
+}
+
+
+void* PoolAllocator::Allocate()
+{
+	if( !m_pFreeList )
+	{
+		return nullptr;
+	}
+
+	void* p_block = m_pFreeList;
+	m_pFreeList = *static_cast< void** >( p_block );
+	m_liveBlockCount++;
+
+#ifdef AZHAL_MEMORY_TRACKING
+	m_isBlockLive[ ( static_cast< Uint8* >( p_block ) - m_pBegin ) / m_blockSize ] = true;
+#endif
+
+	return p_block;
+}
+
+
+void PoolAllocator::Free( void* p_block )
+{
+	if( !p_block )
+	{
+		return;
+	}
+
+	AZHAL_ASSERT( Owns( p_block ), "freeing a block that does not belong to this pool" );
+
+#ifdef AZHAL_MEMORY_TRACKING
+	const Uint64 block_index = ( static_cast< Uint8* >( p_block ) - m_pBegin ) / m_blockSize;
+	AZHAL_ASSERT( m_pBegin + block_index * m_blockSize == p_block, "freeing a pointer into the middle of a pool block" );
+	AZHAL_ASSERT( m_isBlockLive[ block_index ], "pool block freed twice" );
+	m_isBlockLive[ block_index ] = false;
+
+	std::memset( p_block, K_RELEASED_MEMORY_PATTERN, m_blockSize );
+#endif
+
+	*static_cast< void** >( p_block ) = m_pFreeList;
+	m_pFreeList = p_block;
+	m_liveBlockCount--;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RangeAllocator::RangeAllocator( Uint64 capacity )
+	: m_capacity( capacity )
+{
+	if( capacity > 0 )
+	{
+		InsertFreeRange( 0, capacity );
+	}
+}
+
+
+Uint64 RangeAllocator::Allocate( Uint64 size )
+{
+	AZHAL_ASSERT( size > 0, "empty ranges cannot be allocated" );
+
+	// the smallest free range that fits leaves the large ones for large requests
+	const auto it_best_fit = m_freeBySize.lower_bound( size );
+	if( it_best_fit == m_freeBySize.end() )
+	{
+		return K_INVALID_OFFSET;
+	}
+
+	const Uint64 offset = it_best_fit->second;
+	const Uint64 free_size = it_best_fit->first;
+	EraseFreeRange( m_freeByOffset.find( offset ) );
+	if( free_size > size )
+	{
+		InsertFreeRange( offset + size, free_size - size );
+	}
+
+	m_allocations.emplace( offset, size );
+	m_usedSize += size;
+
+	return offset;
+}
+
+
+void RangeAllocator::Free( Uint64 offset )
+{
+	const auto it_allocation = m_allocations.find( offset );
+	AZHAL_ASSERT( it_allocation != m_allocations.end(), "freeing a range that was not allocated" );
+	if( it_allocation == m_allocations.end() )
+	{
+		return;
+	}
+
+	Uint64 free_offset = offset;
+	Uint64 free_size = it_allocation->second;
+	m_usedSize -= free_size;
+	m_allocations.erase( it_allocation );
+
+	const auto it_next = m_freeByOffset.find( free_offset + free_size );
+	if( it_next != m_freeByOffset.end() )
+	{
+		free_size += it_next->second;
+		EraseFreeRange( it_next );
+	}
+
+	const auto it_after = m_freeByOffset.lower_bound( free_offset );
+	if( it_after != m_freeByOffset.begin() )
+	{
+		const auto it_previous = std::prev( it_after );
+		if( it_previous->first + it_previous->second == free_offset )
+		{
+			free_offset = it_previous->first;
+			free_size += it_previous->second;
+			EraseFreeRange( it_previous );
+		}
+	}
+
+	InsertFreeRange( free_offset, free_size );
+}
+
+
+void RangeAllocator::Grow( Uint64 new_capacity )
+{
+	AZHAL_ASSERT( new_capacity >= m_capacity, "range allocators only grow" );
+	if( new_capacity <= m_capacity )
+	{
+		return;
+	}
+
+	Uint64 free_offset = m_capacity;
+	Uint64 free_size = new_capacity - m_capacity;
+	if( !m_freeByOffset.empty() )
+	{
+		const auto it_last = std::prev( m_freeByOffset.end() );
+		if( it_last->first + it_last->second == m_capacity )
+		{
+			free_offset = it_last->first;
+			free_size += it_last->second;
+			EraseFreeRange( it_last );
+		}
+	}
+
+	InsertFreeRange( free_offset, free_size );
+	m_capacity = new_capacity;
+}
+
+
+std::vector<RangeMove> RangeAllocator::Compact()
+{
+	std::vector<RangeMove> moves;
+	moves.reserve( m_allocations.size() );
+
+	std::map<Uint64, Uint64> packed_allocations;
+	Uint64 packed_offset = 0;
+	for( const auto& [offset, size] : m_allocations )
+	{
+		moves.push_back( RangeMove { .srcOffset = offset, .dstOffset = packed_offset, .size = size } );
+		packed_allocations.emplace_hint( packed_allocations.end(), packed_offset, size );
+		packed_offset += size;
+	}
+
+	m_allocations.swap( packed_allocations );
+	m_freeByOffset.clear();
+	m_freeBySize.clear();
+	if( packed_offset < m_capacity )
+	{
+		InsertFreeRange( packed_offset, m_capacity - packed_offset );
+	}
+
+	return moves;
+}
+
+
+Uint64 RangeAllocator::GetLargestFreeRange() const
+{
+	return m_freeBySize.empty() ? 0 : std::prev( m_freeBySize.end() )->first;
+}
+
+
+Float RangeAllocator::GetFragmentation() const
+{
+	const Uint64 free_size = m_capacity - m_usedSize;
+	return ( free_size == 0 ) ? 0.0f : 1.0f - static_cast< Float >( GetLargestFreeRange() ) / static_cast< Float >( free_size );
+}
+
+
+void RangeAllocator::InsertFreeRange( Uint64 offset, Uint64 size )
+{
+	m_freeByOffset.emplace( offset, size );
+	m_freeBySize.emplace( size, offset );
+}
+
+
+void RangeAllocator::EraseFreeRange( std::map<Uint64, Uint64>::iterator it )
+{
+	auto [it_size, it_size_end] = m_freeBySize.equal_range( it->second );
+	while( it_size != it_size_end && it_size->second != it->first )
+	{
+		++it_size;
+	}
+	AZHAL_ASSERT( it_size != it_size_end, "free range lists out of sync" );
+
+	m_freeBySize.erase( it_size );
+	m_freeByOffset.erase( it );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ArenaMemoryResource::ArenaMemoryResource( LinearArena& arena, std::pmr::memory_resource* p_upstream )
+	: m_arena( arena )
+	, m_pUpstream( p_upstream )
+{
+}
+
+
+void* ArenaMemoryResource::do_allocate( size_t bytes, size_t alignment )
+{
+	void* p_memory = m_arena.Allocate( bytes, alignment );
+	if( p_memory )
+	{
+		return p_memory;
+	}
+
+	// warn on the first overflow only, the arena reports the total when it is destroyed
+	if( m_arena.GetOverflowCount() == 1 )
+	{
+		AZHAL_LOG_WARN( "linear arena of {0} bytes is full, falling back to the upstream allocator", m_arena.GetCapacity() );
+	}
+	return m_pUpstream->allocate( bytes, alignment );
+}
+
+
+void ArenaMemoryResource::do_deallocate( void* p_memory, size_t bytes, size_t alignment )
+{
+	if( !m_arena.Owns( p_memory ) )
+	{
+		m_pUpstream->deallocate( p_memory, bytes, alignment );
+	}
+}
+
+
+bool ArenaMemoryResource::do_is_equal( const std::pmr::memory_resource& other ) const noexcept
+{
+	return ( this == &other );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PoolMemoryResource::PoolMemoryResource( PoolAllocator& pool, std::pmr::memory_resource* p_upstream )
+	: m_pool( pool )
+	, m_pUpstream( p_upstream )
+{
+}
+
+
+void* PoolMemoryResource::do_allocate( size_t bytes, size_t alignment )
+{
+	if( bytes <= m_pool.GetBlockSize() && alignment <= m_pool.GetBlockAlignment() )
+	{
+		void* p_block = m_pool.Allocate();
+		if( p_block )
+		{
+			return p_block;
+		}
+	}
+
+	return m_pUpstream->allocate( bytes, alignment );
+}
+
+
+void PoolMemoryResource::do_deallocate( void* p_memory, size_t bytes, size_t alignment )
+{
+	if( m_pool.Owns( p_memory ) )
+	{
+		m_pool.Free( p_memory );
+	}
+	else
+	{
+		m_pUpstream->deallocate( p_memory, bytes, alignment );
+	}
+}
+
+
+bool PoolMemoryResource::do_is_equal( const std::pmr::memory_resource& other ) const noexcept
+{
+	return ( this == &other );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScratchScope::ScratchScope()
+	: m_arena( get_thread_scratch_arena() )
+	, m_marker( m_arena.GetMarker() )
+	, m_resource( m_arena )
+{
+#ifdef AZHAL_MEMORY_TRACKING
+	m_ownerThread = std::this_thread::get_id();
+	m_pOuterScope = t_pInnermostScratchScope;
+	t_pInnermostScratchScope = this;
+#endif
+}
+
+
+ScratchScope::~ScratchScope()
+{
+#ifdef AZHAL_MEMORY_TRACKING
+	// a scope ended on another thread rewinds the owner's arena under its feet, one ended out of order frees its inner scopes
+	AZHAL_ASSERT( m_ownerThread == std::this_thread::get_id(), "scratch scopes must be destroyed on the thread that created them" );
+	AZHAL_ASSERT( t_pInnermostScratchScope == this, "scratch scopes must be destroyed in the reverse order they were created" );
+	t_pInnermostScratchScope = m_pOuterScope;
+#endif
+
+	m_arena.Rewind( m_marker );
+}
\ No newline at end of file
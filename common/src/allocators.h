@@ -0,0 +1,259 @@
+#pragma once
+
+#include "assert.h"
+#include "macros.h"
+#include "non_copyable.h"
+#include "typedefs.h"
+
+#include <map>
+#include <memory_resource>
+#include <thread>
+
+// overflow, leak and misuse tracking, compiled into the same configurations as AZHAL_ASSERT
+#if defined(AZHAL_DEBUG) || defined(AZHAL_RELEASE)
+#define AZHAL_MEMORY_TRACKING
+#endif
+
+constexpr Uint64 K_KIBIBYTE = 1024;
+constexpr Uint64 K_MEBIBYTE = 1024 * K_KIBIBYTE;
+
+// bump allocator over a single block that is allocated once. individual allocations are never freed, the arena
+// is reset as a whole or rewound to a marker, which also makes it a stack allocator
+class LinearArena : NonCopyable
+{
+public:
+	explicit LinearArena( Uint64 capacity );
+	~LinearArena();
+
+	// returns nullptr when the arena is full
+	void* Allocate( Uint64 size, Uint64 alignment = alignof( std::max_align_t ) );
+
+	template<typename T>
+	T* AllocateArray( Uint64 count )
+	{
+		return static_cast< T* >( Allocate( sizeof( T ) * count, alignof( T ) ) );
+	}
+
+	void Reset();
+
+	AZHAL_INLINE Uint64 GetMarker() const
+	{
+		return m_offset;
+	}
+	// frees everything allocated after marker was taken, markers must be rewound in reverse order
+	void Rewind( Uint64 marker );
+
+	AZHAL_INLINE Bool Owns( const void* p_memory ) const
+	{
+		return ( p_memory >= m_pBegin ) && ( p_memory < m_pBegin + m_capacity );
+	}
+
+	AZHAL_INLINE Uint64 GetUsedBytes() const
+	{
+		return m_offset;
+	}
+	AZHAL_INLINE Uint64 GetCapacity() const
+	{
+		return m_capacity;
+	}
+	AZHAL_INLINE Uint64 GetHighWaterMark() const
+	{
+		return m_highWaterMark;
+	}
+	AZHAL_INLINE Uint64 GetOverflowCount() const
+	{
+		return m_overflowCount;
+	}
+
+private:
+	Uint8* m_pBegin = nullptr;
+	Uint64 m_capacity = 0;
+	Uint64 m_offset = 0;
+
+	Uint64 m_highWaterMark = 0;
+	Uint64 m_overflowCount = 0;
+};
+
+
+// fixed-size blocks from a preallocated slab, threaded onto an intrusive free list
+class PoolAllocator : NonCopyable
+{
+public:
+	PoolAllocator( Uint64 block_size, Uint64 block_count, Uint64 block_alignment = alignof( std::max_align_t ) );
+	// reports blocks that were never freed when tracking is enabled
+	~PoolAllocator();
+
+	// returns nullptr when every block is in use
+	void* Allocate();
+	void Free( void* p_block );
+
+	AZHAL_INLINE Bool Owns( const void* p_memory ) const
+	{
+		return ( p_memory >= m_pBegin ) && ( p_memory < m_pBegin + m_blockSize * m_blockCount );
+	}
+
+	AZHAL_INLINE Uint64 GetBlockSize() const
+	{
+		return m_blockSize;
+	}
+	AZHAL_INLINE Uint64 GetBlockAlignment() const
+	{
+		return m_blockAlignment;
+	}
+	AZHAL_INLINE Uint64 GetLiveBlockCount() const
+	{
+		return m_liveBlockCount;
+	}
+
+private:
+	Uint8* m_pBegin = nullptr;
+	Uint64 m_blockSize = 0;
+	Uint64 m_blockCount = 0;
+	Uint64 m_blockAlignment = 0;
+
+	void* m_pFreeList = nullptr;
+	Uint64 m_liveBlockCount = 0;
+
+#ifdef AZHAL_MEMORY_TRACKING
+	// catches double frees and frees of foreign pointers
+	std::vector<Bool> m_isBlockLive;
+#endif
+};
+
+
+// one live range moved by RangeAllocator::Compact
+struct RangeMove
+{
+	Uint64 srcOffset = 0;
+	Uint64 dstOffset = 0;
+	Uint64 size = 0;
+};
+
+
+// hands out ranges of [0, capacity) of memory it does not own, e.g. elements of a gpu buffer. best fit, a freed range
+// merges with free neighbours. sizes and offsets are in whatever unit the caller picks, which is also the alignment
+class RangeAllocator
+{
+public:
+	static constexpr Uint64 K_INVALID_OFFSET = UINT64_MAX;
+
+	RangeAllocator() = default;
+	explicit RangeAllocator( Uint64 capacity );
+
+	// K_INVALID_OFFSET when no free range is large enough
+	Uint64 Allocate( Uint64 size );
+	// offset as returned by Allocate
+	void Free( Uint64 offset );
+
+	// the added space at the end is free
+	void Grow( Uint64 new_capacity );
+	// packs the live ranges to the front, keeping their order, and returns every live range with where it went.
+	// moves are sorted by srcOffset, ranges that stay have srcOffset == dstOffset
+	std::vector<RangeMove> Compact();
+
+	AZHAL_INLINE Uint64 GetCapacity() const
+	{
+		return m_capacity;
+	}
+	AZHAL_INLINE Uint64 GetUsedSize() const
+	{
+		return m_usedSize;
+	}
+	AZHAL_INLINE Uint64 GetAllocationCount() const
+	{
+		return m_allocations.size();
+	}
+	AZHAL_INLINE Uint64 GetFreeRangeCount() const
+	{
+		return m_freeByOffset.size();
+	}
+	Uint64 GetLargestFreeRange() const;
+	// 0 when the free space is one range, towards 1 the more it is split into small ones
+	Float GetFragmentation() const;
+
+private:
+	void InsertFreeRange( Uint64 offset, Uint64 size );
+	void EraseFreeRange( std::map<Uint64, Uint64>::iterator it );
+
+	Uint64 m_capacity = 0;
+	Uint64 m_usedSize = 0;
+
+	// offset to size
+	std::map<Uint64, Uint64> m_allocations;
+	std::map<Uint64, Uint64> m_freeByOffset;
+	// size to offset, for the best fit lookup
+	std::multimap<Uint64, Uint64> m_freeBySize;
+};
+
+
+// std::pmr adapter over a LinearArena. deallocation is a no-op, requests the arena cannot serve go to the upstream
+// resource and are counted, so an undersized arena shows up as overflows instead of a crash
+class ArenaMemoryResource final : public std::pmr::memory_resource
+{
+public:
+	explicit ArenaMemoryResource( LinearArena& arena, std::pmr::memory_resource* p_upstream = std::pmr::new_delete_resource() );
+
+private:
+	void* do_allocate( size_t bytes, size_t alignment ) override;
+	void do_deallocate( void* p_memory, size_t bytes, size_t alignment ) override;
+	bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override;
+
+	LinearArena& m_arena;
+	std::pmr::memory_resource* m_pUpstream;
+};
+
+
+// std::pmr adapter over a PoolAllocator, requests larger than a block or an exhausted pool go upstream
+class PoolMemoryResource final : public std::pmr::memory_resource
+{
+public:
+	explicit PoolMemoryResource( PoolAllocator& pool, std::pmr::memory_resource* p_upstream = std::pmr::new_delete_resource() );
+
+private:
+	void* do_allocate( size_t bytes, size_t alignment ) override;
+	void do_deallocate( void* p_memory, size_t bytes, size_t alignment ) override;
+	bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override;
+
+	PoolAllocator& m_pool;
+	std::pmr::memory_resource* m_pUpstream;
+};
+
+
+// per-thread scratch memory for containers that do not outlive a scope. scopes nest like a stack, everything
+// allocated through a scope is released when it ends:
+//
+//     ScratchScope scratch;
+//     std::pmr::vector<const AnsiChar*> names( scratch.GetResource() );
+class ScratchScope : NonCopyable
+{
+public:
+	ScratchScope();
+	~ScratchScope();
+
+	AZHAL_INLINE std::pmr::memory_resource* GetResource()
+	{
+#ifdef AZHAL_MEMORY_TRACKING
+		AZHAL_ASSERT( m_ownerThread == std::this_thread::get_id(), "scratch memory belongs to the thread that opened the scope" );
+#endif
+		return &m_resource;
+	}
+
+	AZHAL_INLINE LinearArena& GetArena()
+	{
+#ifdef AZHAL_MEMORY_TRACKING
+		AZHAL_ASSERT( m_ownerThread == std::this_thread::get_id(), "scratch memory belongs to the thread that opened the scope" );
+#endif
+		return m_arena;
+	}
+
+private:
+	LinearArena& m_arena;
+	Uint64 m_marker;
+	ArenaMemoryResource m_resource;
+
+#ifdef AZHAL_MEMORY_TRACKING
+	std::thread::id m_ownerThread;
+	// the scope that was innermost on the owning thread when this one opened
+	ScratchScope* m_pOuterScope = nullptr;
+#endif
+};
\ No newline at end of file
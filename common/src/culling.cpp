@@ -0,0 +1,290 @@
+#include "culling.h"
+
+#include "assert.h"
+#include "job_system.h"
+#include "profiler.h"
+
+#include <cstring>
+#include <immintrin.h>
+#include <intrin.h>
+
+// clang only emits intrinsics for instruction sets the function is marked with, msvc accepts them anywhere
+#if defined(__clang__)
+#define AZHAL_TARGET_ISA(isa) __attribute__(( target( isa ) ))
+#else
+#define AZHAL_TARGET_ISA(isa)
+#endif
+
+namespace
+{
+	constexpr Uint32 K_PLANE_COUNT = 6;
+
+	using CullFn = Uint32 ( * )( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32 begin, Uint32 end, Uint32* p_visible_indices );
+
+
+	// the reference every other kernel has to match bit for bit
+	AZHAL_FORCE_INLINE Bool is_sphere_visible( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32 index )
+	{
+		const Float x = bounds.centerX[ index ];
+		const Float y = bounds.centerY[ index ];
+		const Float z = bounds.centerZ[ index ];
+		const Float negative_radius = -bounds.radius[ index ];
+
+		Bool is_visible = true;
+		for( Uint32 plane = 0; plane < K_PLANE_COUNT; ++plane )
+		{
+			const Float distance = planes[ plane ].x * x + planes[ plane ].y * y + planes[ plane ].z * z + planes[ plane ].w;
+			is_visible &= !( distance < negative_radius );
+		}
+		return is_visible;
+	}
+
+
+	Uint32 cull_spheres_scalar( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32 begin, Uint32 end, Uint32* p_visible_indices )
+	{
+		Uint32 visible_count = 0;
+		for( Uint32 i = begin; i < end; ++i )
+		{
+			// written unconditionally, the count only advances for visible spheres
+			p_visible_indices[ visible_count ] = i;
+			visible_count += is_sphere_visible( bounds, planes, i ) ? 1 : 0;
+		}
+		return visible_count;
+	}
+
+
+	AZHAL_TARGET_ISA( "sse4.1" )
+	Uint32 cull_spheres_sse41( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32 begin, Uint32 end, Uint32* p_visible_indices )
+	{
+		constexpr Uint32 K_WIDTH = 4;
+
+		__m128 plane_x[ K_PLANE_COUNT ];
+		__m128 plane_y[ K_PLANE_COUNT ];
+		__m128 plane_z[ K_PLANE_COUNT ];
+		__m128 plane_w[ K_PLANE_COUNT ];
+		for( Uint32 plane = 0; plane < K_PLANE_COUNT; ++plane )
+		{
+			plane_x[ plane ] = _mm_set1_ps( planes[ plane ].x );
+			plane_y[ plane ] = _mm_set1_ps( planes[ plane ].y );
+			plane_z[ plane ] = _mm_set1_ps( planes[ plane ].z );
+			plane_w[ plane ] = _mm_set1_ps( planes[ plane ].w );
+		}
+		const __m128 sign_mask = _mm_set1_ps( -0.0f );
+
+		Uint32 visible_count = 0;
+		Uint32 i = begin;
+		for( ; i + K_WIDTH <= end; i += K_WIDTH )
+		{
+			const __m128 x = _mm_loadu_ps( bounds.centerX.data() + i );
+			const __m128 y = _mm_loadu_ps( bounds.centerY.data() + i );
+			const __m128 z = _mm_loadu_ps( bounds.centerZ.data() + i );
+			const __m128 negative_radius = _mm_xor_ps( _mm_loadu_ps( bounds.radius.data() + i ), sign_mask );
+
+			__m128 culled = _mm_setzero_ps();
+			for( Uint32 plane = 0; plane < K_PLANE_COUNT; ++plane )
+			{
+				// ( ( nx * x + ny * y ) + nz * z ) + w, the order of is_sphere_visible
+				__m128 distance = _mm_add_ps( _mm_mul_ps( plane_x[ plane ], x ), _mm_mul_ps( plane_y[ plane ], y ) );
+				distance = _mm_add_ps( _mm_add_ps( distance, _mm_mul_ps( plane_z[ plane ], z ) ), plane_w[ plane ] );
+				culled = _mm_or_ps( culled, _mm_cmplt_ps( distance, negative_radius ) );
+			}
+
+			const Uint32 visible_mask = ~static_cast< Uint32 >( _mm_movemask_ps( culled ) );
+			for( Uint32 lane = 0; lane < K_WIDTH; ++lane )
+			{
+				p_visible_indices[ visible_count ] = i + lane;
+				visible_count += ( visible_mask >> lane ) & 1;
+			}
+		}
+
+		return visible_count + cull_spheres_scalar( bounds, planes, i, end, p_visible_indices + visible_count );
+	}
+
+
+	AZHAL_TARGET_ISA( "avx2" )
+	Uint32 cull_spheres_avx2( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32 begin, Uint32 end, Uint32* p_visible_indices )
+	{
+		constexpr Uint32 K_WIDTH = 8;
+
+		__m256 plane_x[ K_PLANE_COUNT ];
+		__m256 plane_y[ K_PLANE_COUNT ];
+		__m256 plane_z[ K_PLANE_COUNT ];
+		__m256 plane_w[ K_PLANE_COUNT ];
+		for( Uint32 plane = 0; plane < K_PLANE_COUNT; ++plane )
+		{
+			plane_x[ plane ] = _mm256_set1_ps( planes[ plane ].x );
+			plane_y[ plane ] = _mm256_set1_ps( planes[ plane ].y );
+			plane_z[ plane ] = _mm256_set1_ps( planes[ plane ].z );
+			plane_w[ plane ] = _mm256_set1_ps( planes[ plane ].w );
+		}
+		const __m256 sign_mask = _mm256_set1_ps( -0.0f );
+
+		Uint32 visible_count = 0;
+		Uint32 i = begin;
+		for( ; i + K_WIDTH <= end; i += K_WIDTH )
+		{
+			const __m256 x = _mm256_loadu_ps( bounds.centerX.data() + i );
+			const __m256 y = _mm256_loadu_ps( bounds.centerY.data() + i );
+			const __m256 z = _mm256_loadu_ps( bounds.centerZ.data() + i );
+			const __m256 negative_radius = _mm256_xor_ps( _mm256_loadu_ps( bounds.radius.data() + i ), sign_mask );
+
+			__m256 culled = _mm256_setzero_ps();
+			for( Uint32 plane = 0; plane < K_PLANE_COUNT; ++plane )
+			{
+				// separate multiplies and adds instead of fma, which would round differently than is_sphere_visible
+				__m256 distance = _mm256_add_ps( _mm256_mul_ps( plane_x[ plane ], x ), _mm256_mul_ps( plane_y[ plane ], y ) );
+				distance = _mm256_add_ps( _mm256_add_ps( distance, _mm256_mul_ps( plane_z[ plane ], z ) ), plane_w[ plane ] );
+				culled = _mm256_or_ps( culled, _mm256_cmp_ps( distance, negative_radius, _CMP_LT_OQ ) );
+			}
+
+			const Uint32 visible_mask = ~static_cast< Uint32 >( _mm256_movemask_ps( culled ) );
+			for( Uint32 lane = 0; lane < K_WIDTH; ++lane )
+			{
+				p_visible_indices[ visible_count ] = i + lane;
+				visible_count += ( visible_mask >> lane ) & 1;
+			}
+		}
+
+		// the scalar tail runs legacy sse code, avoid the transition penalty
+		_mm256_zeroupper();
+
+		return visible_count + cull_spheres_scalar( bounds, planes, i, end, p_visible_indices + visible_count );
+	}
+
+
+	CullingIsa detect_culling_isa()
+	{
+		Int32 cpu_info[ 4 ] = {};
+		__cpuid( cpu_info, 0 );
+		const Int32 max_leaf = cpu_info[ 0 ];
+
+		__cpuid( cpu_info, 1 );
+		const Bool has_sse41 = ( cpu_info[ 2 ] & ( 1 << 19 ) ) != 0;
+		const Bool has_osxsave = ( cpu_info[ 2 ] & ( 1 << 27 ) ) != 0;
+		const Bool has_avx = ( cpu_info[ 2 ] & ( 1 << 28 ) ) != 0;
+
+		Bool has_avx2 = false;
+		if( max_leaf >= 7 )
+		{
+			__cpuidex( cpu_info, 7, 0 );
+			has_avx2 = ( cpu_info[ 1 ] & ( 1 << 5 ) ) != 0;
+		}
+
+		// the os has to save the ymm registers on context switches
+		const Bool is_ymm_state_enabled = has_osxsave && ( ( _xgetbv( 0 ) & 0x6 ) == 0x6 );
+
+		if( has_avx && has_avx2 && is_ymm_state_enabled )
+		{
+			return CullingIsa::eAvx2;
+		}
+		return has_sse41 ? CullingIsa::eSse41 : CullingIsa::eScalar;
+	}
+
+
+	CullFn get_cull_fn( CullingIsa isa )
+	{
+		switch( isa )
+		{
+		case CullingIsa::eAvx2:
+			return cull_spheres_avx2;
+		case CullingIsa::eSse41:
+			return cull_spheres_sse41;
+		case CullingIsa::eScalar:
+		default:
+			return cull_spheres_scalar;
+		}
+	}
+}
+
+void SphereBoundsSoA::Add( const Vec3& center, Float sphere_radius )
+{
+	centerX.push_back( center.x );
+	centerY.push_back( center.y );
+	centerZ.push_back( center.z );
+	radius.push_back( sphere_radius );
+}
+
+
+void SphereBoundsSoA::Reserve( Uint32 count )
+{
+	centerX.reserve( count );
+	centerY.reserve( count );
+	centerZ.reserve( count );
+	radius.reserve( count );
+}
+
+
+void SphereBoundsSoA::Clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radius.clear();
+}
+
+
+CullingIsa GetCullingIsa()
+{
+	static const CullingIsa s_isa = detect_culling_isa();
+	return s_isa;
+}
+
+
+const AnsiChar* GetCullingIsaName( CullingIsa isa )
+{
+	switch( isa )
+	{
+	case CullingIsa::eAvx2:
+		return "avx2";
+	case CullingIsa::eSse41:
+		return "sse4.1";
+	case CullingIsa::eScalar:
+	default:
+		return "scalar";
+	}
+}
+
+
+Uint32 CullSpheres( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32 begin, Uint32 end, Uint32* p_visible_indices, CullingIsa isa )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	AZHAL_ASSERT( begin <= end && end <= bounds.GetCount(), "cull range out of bounds" );
+	AZHAL_ASSERT( isa <= GetCullingIsa(), "the cpu does not support the requested culling isa" );
+
+	return get_cull_fn( isa )( bounds, planes, begin, end, p_visible_indices );
+}
+
+
+Uint32 CullSpheresParallel( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32* p_visible_indices, std::span<Uint32> chunk_visible_counts,
+	CullingIsa isa )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	AZHAL_ASSERT( isa <= GetCullingIsa(), "the cpu does not support the requested culling isa" );
+
+	const Uint32 count = bounds.GetCount();
+	const Uint32 chunk_count = GetCullingChunkCount( count );
+	const CullFn cull_fn = get_cull_fn( isa );
+	AZHAL_FATAL_ASSERT( chunk_visible_counts.size() >= chunk_count, "the chunk count scratch is smaller than GetCullingChunkCount" );
+
+	// every chunk writes into its own slice of the output, which is compacted once they all finished
+	JobSystem::ParallelFor( chunk_count, 1, [&]( Uint32 chunk_begin, Uint32 chunk_end )
+	{
+		for( Uint32 chunk = chunk_begin; chunk < chunk_end; ++chunk )
+		{
+			const Uint32 begin = chunk * K_CULLING_PARALLEL_GRAIN_SIZE;
+			const Uint32 end = std::min<Uint32>( begin + K_CULLING_PARALLEL_GRAIN_SIZE, count );
+			chunk_visible_counts[ chunk ] = cull_fn( bounds, planes, begin, end, p_visible_indices + begin );
+		}
+	} );
+
+	Uint32 visible_count = 0;
+	for( Uint32 chunk = 0; chunk < chunk_count; ++chunk )
+	{
+		// the destination never overtakes the source, slices only move towards the front
+		std::memmove( p_visible_indices + visible_count, p_visible_indices + chunk * K_CULLING_PARALLEL_GRAIN_SIZE, chunk_visible_counts[ chunk ] * sizeof( Uint32 ) );
+		visible_count += chunk_visible_counts[ chunk ];
+	}
+	return visible_count;
+}
\ No newline at end of file
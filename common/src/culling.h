@@ -0,0 +1,64 @@
+#pragma once
+
+#include "macros.h"
+#include "typedefs.h"
+
+#include <span>
+
+// bounding spheres as one array per component, so that a batch of spheres is one contiguous load per component
+struct SphereBoundsSoA
+{
+	std::vector<Float> centerX;
+	std::vector<Float> centerY;
+	std::vector<Float> centerZ;
+	std::vector<Float> radius;
+
+	AZHAL_INLINE Uint32 GetCount() const
+	{
+		return static_cast< Uint32 >( radius.size() );
+	}
+
+	void Add( const Vec3& center, Float sphere_radius );
+	void Reserve( Uint32 count );
+	void Clear();
+};
+
+// instruction sets the culling kernels are compiled for, picked at runtime
+enum class CullingIsa : Uint32
+{
+	eScalar = 0,
+	// 4 spheres per iteration
+	eSse41 = 1,
+	// 8 spheres per iteration
+	eAvx2 = 2
+};
+
+// the widest isa the cpu and the os support, queried once through cpuid
+CullingIsa GetCullingIsa();
+const AnsiChar* GetCullingIsaName( CullingIsa isa );
+
+// frustum planes with the xyz normal pointing inside and the distance in w, see extract_frustum_planes of the
+// sandbox. a sphere is visible unless it lies entirely behind one of the planes
+using CullingPlanes = Vec4[ 6 ];
+
+// writes the indices of the visible spheres in [begin, end) to p_visible_indices in ascending order and returns how
+// many there are. p_visible_indices needs room for end - begin indices. every isa evaluates the planes with the same
+// sequence of multiplies and adds, so the results are bit-identical to eScalar; the common project is built with
+// floating point contraction into fma turned off for that
+Uint32 CullSpheres( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32 begin, Uint32 end, Uint32* p_visible_indices,
+	CullingIsa isa = GetCullingIsa() );
+
+// spheres per job of CullSpheresParallel
+constexpr Uint32 K_CULLING_PARALLEL_GRAIN_SIZE = 16 * 1024;
+
+AZHAL_INLINE Uint32 GetCullingChunkCount( Uint32 sphere_count )
+{
+	return ( sphere_count + K_CULLING_PARALLEL_GRAIN_SIZE - 1 ) / K_CULLING_PARALLEL_GRAIN_SIZE;
+}
+
+// CullSpheres over every sphere, split across JobSystem workers. the indices come out compacted and in ascending
+// order like the single-threaded call. views such as shadow cascades are culled with one call each.
+// chunk_visible_counts is scratch of at least GetCullingChunkCount( bounds.GetCount() ) elements, kept by the caller
+// so that culling every frame does not allocate
+Uint32 CullSpheresParallel( const SphereBoundsSoA& bounds, const CullingPlanes& planes, Uint32* p_visible_indices, std::span<Uint32> chunk_visible_counts,
+	CullingIsa isa = GetCullingIsa() );
\ No newline at end of file
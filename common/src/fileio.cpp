@@ -16,3 +16,34 @@ ByteBufferDynamic LoadBinaryBlob( const AnsiChar* file_path )
 
 	return buffer;
 }
+
+
+ByteBufferDynamic TryLoadBinaryBlob( const AnsiChar* file_path )
+{
+	std::ifstream file_stream( file_path, std::ios::ate | std::ios::binary );
+	if( !file_stream.is_open() )
+	{
+		return {};
+	}
+
+	const Uint64 size_in_bytes = static_cast< Uint64 >( file_stream.tellg() );
+	ByteBufferDynamic buffer( size_in_bytes );
+
+	file_stream.seekg( 0 );
+	file_stream.read( buffer.data(), size_in_bytes );
+
+	return buffer;
+}
+
+
+Bool SaveBinaryBlob( const AnsiChar* file_path, const ByteBufferDynamic& buffer )
+{
+	std::ofstream file_stream( file_path, std::ios::binary | std::ios::trunc );
+	if( !file_stream.is_open() )
+	{
+		return false;
+	}
+
+	file_stream.write( buffer.data(), buffer.size() );
+	return file_stream.good();
+}
@@ -2,4 +2,10 @@
 #include "typedefs.h"
 
 [[nodiscard( "common::fileIO::LoadBinaryBlob" )]]
-ByteBufferDynamic LoadBinaryBlob( const AnsiChar* file_path );
\ No newline at end of file
+ByteBufferDynamic LoadBinaryBlob( const AnsiChar* file_path );
+
+// returns an empty buffer instead of asserting when the file does not exist, for optional files like caches
+[[nodiscard( "common::fileIO::TryLoadBinaryBlob" )]]
+ByteBufferDynamic TryLoadBinaryBlob( const AnsiChar* file_path );
+
+Bool SaveBinaryBlob( const AnsiChar* file_path, const ByteBufferDynamic& buffer );
\ No newline at end of file
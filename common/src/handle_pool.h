@@ -0,0 +1,183 @@
+#pragma once
+
+#include "assert.h"
+#include "macros.h"
+#include "non_copyable.h"
+#include "typedefs.h"
+
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// a slot index plus the generation the slot had when the handle was made. freeing a slot bumps its generation,
+// so a handle to a destroyed object is recognized as stale instead of aliasing whatever reuses the slot.
+// Tag keeps handles of different pools apart
+template<typename Tag>
+struct Handle
+{
+	Uint32 index = 0;
+	// 0 is never a live generation, a default constructed handle is null
+	Uint32 generation = 0;
+
+	AZHAL_INLINE Bool IsNull() const
+	{
+		return ( generation == 0 );
+	}
+
+	friend Bool operator==( const Handle& a, const Handle& b ) = default;
+};
+
+
+// objects addressed by Handle<Tag>, stored as one dense array per column. columns are the structure-of-arrays split:
+// loops over the hot columns never touch the cold ones. destroying swaps the last object into the hole, so the dense
+// arrays stay packed and iteration order changes
+template<typename Tag, typename... Columns>
+class HandlePool : NonCopyable
+{
+public:
+	using HandleType = Handle<Tag>;
+
+	template<Uint32 COLUMN>
+	using ColumnType = std::tuple_element_t<COLUMN, std::tuple<Columns...>>;
+
+	HandlePool() = default;
+
+	explicit HandlePool( Uint32 reserve_count )
+	{
+		m_slots.reserve( reserve_count );
+		m_denseToSlot.reserve( reserve_count );
+		std::apply( [reserve_count]( auto&... columns ) { ( columns.reserve( reserve_count ), ... ); }, m_columns );
+	}
+
+	// movable, so that the structs owning a pool can be returned and reset by value
+	HandlePool( HandlePool&& other ) noexcept
+		: m_slots( std::move( other.m_slots ) )
+		, m_denseToSlot( std::move( other.m_denseToSlot ) )
+		, m_columns( std::move( other.m_columns ) )
+		, m_firstFreeSlot( std::exchange( other.m_firstFreeSlot, K_NO_SLOT ) )
+	{
+	}
+
+	HandlePool& operator=( HandlePool&& other ) noexcept
+	{
+		m_slots = std::move( other.m_slots );
+		m_denseToSlot = std::move( other.m_denseToSlot );
+		m_columns = std::move( other.m_columns );
+		m_firstFreeSlot = std::exchange( other.m_firstFreeSlot, K_NO_SLOT );
+		return *this;
+	}
+
+	HandleType Create( Columns... values )
+	{
+		Uint32 slot_index = m_firstFreeSlot;
+		if( slot_index != K_NO_SLOT )
+		{
+			m_firstFreeSlot = m_slots[ slot_index ].nextFreeSlot;
+		}
+		else
+		{
+			slot_index = static_cast< Uint32 >( m_slots.size() );
+			m_slots.push_back( Slot { .generation = 1 } );
+		}
+
+		Slot& slot = m_slots[ slot_index ];
+		slot.denseIndex = static_cast< Uint32 >( m_denseToSlot.size() );
+		slot.nextFreeSlot = K_NO_SLOT;
+		m_denseToSlot.push_back( slot_index );
+
+		std::apply( [&values...]( auto&... columns ) { ( columns.push_back( std::move( values ) ), ... ); }, m_columns );
+
+		return HandleType { .index = slot_index, .generation = slot.generation };
+	}
+
+	void Destroy( HandleType handle )
+	{
+		AZHAL_ASSERT( IsValid( handle ), "destroying through a stale or null handle" );
+		if( !IsValid( handle ) )
+		{
+			return;
+		}
+
+		Slot& slot = m_slots[ handle.index ];
+		const Uint32 dense_index = slot.denseIndex;
+		const Uint32 last_dense_index = static_cast< Uint32 >( m_denseToSlot.size() ) - 1;
+
+		if( dense_index != last_dense_index )
+		{
+			std::apply( [dense_index, last_dense_index]( auto&... columns ) { ( ( columns[ dense_index ] = std::move( columns[ last_dense_index ] ) ), ... ); }, m_columns );
+
+			const Uint32 moved_slot_index = m_denseToSlot[ last_dense_index ];
+			m_denseToSlot[ dense_index ] = moved_slot_index;
+			m_slots[ moved_slot_index ].denseIndex = dense_index;
+		}
+
+		std::apply( []( auto&... columns ) { ( columns.pop_back(), ... ); }, m_columns );
+		m_denseToSlot.pop_back();
+
+		slot.generation = ( slot.generation == UINT32_MAX ) ? 1 : ( slot.generation + 1 );
+		slot.denseIndex = K_NO_SLOT;
+		slot.nextFreeSlot = m_firstFreeSlot;
+		m_firstFreeSlot = handle.index;
+	}
+
+	AZHAL_INLINE Bool IsValid( HandleType handle ) const
+	{
+		return ( handle.generation != 0 ) && ( handle.index < m_slots.size() ) && ( m_slots[ handle.index ].generation == handle.generation );
+	}
+
+	template<Uint32 COLUMN>
+	AZHAL_INLINE ColumnType<COLUMN>& Get( HandleType handle )
+	{
+		AZHAL_ASSERT( IsValid( handle ), "access through a stale or null handle" );
+		return std::get<COLUMN>( m_columns )[ m_slots[ handle.index ].denseIndex ];
+	}
+
+	template<Uint32 COLUMN>
+	AZHAL_INLINE const ColumnType<COLUMN>& Get( HandleType handle ) const
+	{
+		AZHAL_ASSERT( IsValid( handle ), "access through a stale or null handle" );
+		return std::get<COLUMN>( m_columns )[ m_slots[ handle.index ].denseIndex ];
+	}
+
+	// packed, in no particular order. invalidated by Create and Destroy
+	template<Uint32 COLUMN>
+	AZHAL_INLINE std::span<ColumnType<COLUMN>> GetDense()
+	{
+		return std::get<COLUMN>( m_columns );
+	}
+
+	template<Uint32 COLUMN>
+	AZHAL_INLINE std::span<const ColumnType<COLUMN>> GetDense() const
+	{
+		return std::get<COLUMN>( m_columns );
+	}
+
+	// the handle of the object at dense_index of the GetDense arrays
+	AZHAL_INLINE HandleType GetHandle( Uint32 dense_index ) const
+	{
+		const Uint32 slot_index = m_denseToSlot[ dense_index ];
+		return HandleType { .index = slot_index, .generation = m_slots[ slot_index ].generation };
+	}
+
+	AZHAL_INLINE Uint32 GetCount() const
+	{
+		return static_cast< Uint32 >( m_denseToSlot.size() );
+	}
+
+private:
+	static constexpr Uint32 K_NO_SLOT = UINT32_MAX;
+
+	struct Slot
+	{
+		Uint32 denseIndex = K_NO_SLOT;
+		Uint32 generation = 1;
+		Uint32 nextFreeSlot = K_NO_SLOT;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<Uint32> m_denseToSlot;
+	std::tuple<std::vector<Columns>...> m_columns;
+
+	Uint32 m_firstFreeSlot = K_NO_SLOT;
+};
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include "job_system.h"
+
+#include "assert.h"
+#include "log.h"
+#include "profiler.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <immintrin.h>
+
+namespace
+{
+	// lock-free single-owner deque after Chase and Lev, in the C11 formulation of Le et al.
+	// the owner pushes and pops at the bottom, thieves take from the top
+	class WorkStealingQueue : NonCopyable
+	{
+	public:
+		static constexpr Int64 K_CAPACITY = 4096;
+
+		Bool Push( Job* p_job )
+		{
+			const Int64 bottom = m_bottom.load( std::memory_order_relaxed );
+			const Int64 top = m_top.load( std::memory_order_acquire );
+			if( bottom - top >= K_CAPACITY )
+			{
+				return false;
+			}
+
+			m_jobs[ bottom & K_MASK ].store( p_job, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_release );
+			m_bottom.store( bottom + 1, std::memory_order_relaxed );
+
+			return true;
+		}
+
+		Job* Pop()
+		{
+			const Int64 bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+			m_bottom.store( bottom, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			Int64 top = m_top.load( std::memory_order_relaxed );
+
+			if( top > bottom )
+			{
+				m_bottom.store( bottom + 1, std::memory_order_relaxed );
+				return nullptr;
+			}
+
+			Job* p_job = m_jobs[ bottom & K_MASK ].load( std::memory_order_relaxed );
+			if( top == bottom )
+			{
+				// last job, race the thieves for it
+				if( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+				{
+					p_job = nullptr;
+				}
+				m_bottom.store( bottom + 1, std::memory_order_relaxed );
+			}
+
+			return p_job;
+		}
+
+		Job* Steal()
+		{
+			Int64 top = m_top.load( std::memory_order_acquire );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			const Int64 bottom = m_bottom.load( std::memory_order_acquire );
+
+			if( top >= bottom )
+			{
+				return nullptr;
+			}
+
+			Job* p_job = m_jobs[ top & K_MASK ].load( std::memory_order_relaxed );
+			if( !m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+			{
+				return nullptr;
+			}
+
+			return p_job;
+		}
+
+	private:
+		static constexpr Int64 K_MASK = K_CAPACITY - 1;
+
+		alignas( 64 ) std::atomic<Int64> m_top = 0;
+		alignas( 64 ) std::atomic<Int64> m_bottom = 0;
+		std::atomic<Job*> m_jobs[ K_CAPACITY ] = {};
+	};
+
+
+	// every thread allocates jobs from its own ring, a slot is reused once the job that held it has finished
+	constexpr Uint32 K_JOB_RING_SIZE = 4096;
+
+	struct JobRing
+	{
+		std::unique_ptr<Job[]> jobs;
+		Uint32 nextJob = 0;
+	};
+
+	// idle workers poll this many times before they go to sleep
+	constexpr Uint32 K_SPIN_COUNT_BEFORE_SLEEP = 256;
+
+	std::vector<std::unique_ptr<WorkStealingQueue>> s_queues;
+	std::vector<std::thread> s_workers;
+
+	// jobs submitted from threads that do not own a queue
+	std::mutex s_injectionMutex;
+	std::deque<Job*> s_injectionQueue;
+
+	// submitted and not yet picked up, keeps idle workers asleep while it is zero
+	std::atomic<Int32> s_queuedJobCount = 0;
+	std::atomic<Int32> s_sleepingWorkerCount = 0;
+	std::mutex s_sleepMutex;
+	std::condition_variable s_sleepCondition;
+	std::atomic<Bool> s_isShuttingDown = false;
+
+	thread_local Uint32 t_threadIndex = UINT32_MAX;
+	thread_local JobRing t_jobRing;
+	thread_local Uint32 t_randomState = 0x9E3779B9u;
+}
+
+namespace
+{
+	Uint32 next_random()
+	{
+		// xorshift32
+		t_randomState ^= t_randomState << 13;
+		t_randomState ^= t_randomState >> 17;
+		t_randomState ^= t_randomState << 5;
+		return t_randomState;
+	}
+
+
+	Job* pop_from_injection_queue()
+	{
+		std::scoped_lock lock( s_injectionMutex );
+		if( s_injectionQueue.empty() )
+		{
+			return nullptr;
+		}
+
+		Job* p_job = s_injectionQueue.front();
+		s_injectionQueue.pop_front();
+		return p_job;
+	}
+
+
+	Job* find_job()
+	{
+		Job* p_job = nullptr;
+
+		const Uint32 queue_count = static_cast< Uint32 >( s_queues.size() );
+		if( t_threadIndex < queue_count )
+		{
+			p_job = s_queues[ t_threadIndex ]->Pop();
+		}
+
+		if( !p_job )
+		{
+			p_job = pop_from_injection_queue();
+		}
+
+		// start at a random victim so that thieves spread out
+		const Uint32 first_victim = ( queue_count > 0 ) ? ( next_random() % queue_count ) : 0;
+		for( Uint32 i = 0; !p_job && i < queue_count; ++i )
+		{
+			const Uint32 victim = ( first_victim + i ) % queue_count;
+			if( victim != t_threadIndex )
+			{
+				p_job = s_queues[ victim ]->Steal();
+			}
+		}
+
+		if( p_job )
+		{
+			s_queuedJobCount.fetch_sub( 1, std::memory_order_relaxed );
+		}
+
+		return p_job;
+	}
+
+
+	void wake_workers( Int32 job_count )
+	{
+		if( s_sleepingWorkerCount.load( std::memory_order_seq_cst ) == 0 )
+		{
+			return;
+		}
+
+		std::scoped_lock lock( s_sleepMutex );
+		if( job_count == 1 )
+		{
+			s_sleepCondition.notify_one();
+		}
+		else
+		{
+			s_sleepCondition.notify_all();
+		}
+	}
+}
+
+void JobSystem::Init( Uint32 worker_count )
+{
+	AZHAL_PROFILE_FUNCTION();
+	AZHAL_FATAL_ASSERT( s_queues.empty(), "job system is already initialized" );
+
+	if( worker_count == 0 )
+	{
+		const Uint32 hardware_thread_count = std::thread::hardware_concurrency();
+		worker_count = ( hardware_thread_count > 1 ) ? ( hardware_thread_count - 1 ) : 1;
+	}
+
+	s_isShuttingDown.store( false );
+
+	// queue 0 belongs to the calling thread
+	s_queues.reserve( worker_count + 1 );
+	for( Uint32 i = 0; i <= worker_count; ++i )
+	{
+		s_queues.push_back( std::make_unique<WorkStealingQueue>() );
+	}
+	t_threadIndex = 0;
+
+	s_workers.reserve( worker_count );
+	for( Uint32 i = 1; i <= worker_count; ++i )
+	{
+		s_workers.emplace_back( &JobSystem::WorkerMain, i );
+	}
+
+	AZHAL_LOG_INFO( "job system started with {0} workers", worker_count );
+}
+
+
+void JobSystem::Shutdown()
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	// drain what is left so that no counter is left waiting
+	while( ExecuteNextJob() )
+	{
+	}
+
+	{
+		std::scoped_lock lock( s_sleepMutex );
+		s_isShuttingDown.store( true );
+	}
+	s_sleepCondition.notify_all();
+
+	for( std::thread& worker : s_workers )
+	{
+		worker.join();
+	}
+	s_workers.clear();
+	s_queues.clear();
+	t_threadIndex = UINT32_MAX;
+}
+
+
+Uint32 JobSystem::GetWorkerCount()
+{
+	return static_cast< Uint32 >( s_workers.size() );
+}
+
+
+Uint32 JobSystem::GetThreadIndex()
+{
+	return t_threadIndex;
+}
+
+
+Uint32 JobSystem::GetDefaultGrainSize( Uint32 count )
+{
+	constexpr Uint32 K_CHUNKS_PER_THREAD = 4;
+	const Uint32 chunk_count = ( GetWorkerCount() + 1 ) * K_CHUNKS_PER_THREAD;
+
+	return std::max<Uint32>( 1, ( count + chunk_count - 1 ) / chunk_count );
+}
+
+
+void JobSystem::Wait( const JobCounter& counter )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	while( !counter.IsDone() )
+	{
+		if( !ExecuteNextJob() )
+		{
+			// the remaining jobs are running on other threads
+			_mm_pause();
+		}
+	}
+}
+
+
+Job* JobSystem::AllocateJob()
+{
+	JobRing& job_ring = t_jobRing;
+	if( !job_ring.jobs )
+	{
+		job_ring.jobs = std::make_unique<Job[]>( K_JOB_RING_SIZE );
+	}
+
+	Job* p_job = &job_ring.jobs[ job_ring.nextJob & ( K_JOB_RING_SIZE - 1 ) ];
+	job_ring.nextJob++;
+
+	// the ring wrapped around onto a job that has not run yet, help until it has
+	while( p_job->isInUse.load( std::memory_order_acquire ) )
+	{
+		if( !ExecuteNextJob() )
+		{
+			_mm_pause();
+		}
+	}
+	p_job->isInUse.store( true, std::memory_order_relaxed );
+
+	return p_job;
+}
+
+
+void JobSystem::Submit( Job* p_job )
+{
+	s_queuedJobCount.fetch_add( 1, std::memory_order_seq_cst );
+
+	const Bool has_own_queue = ( t_threadIndex < s_queues.size() );
+	if( has_own_queue && !s_queues[ t_threadIndex ]->Push( p_job ) )
+	{
+		// the deque is full, running the job right away keeps the system making progress
+		s_queuedJobCount.fetch_sub( 1, std::memory_order_relaxed );
+		Execute( p_job );
+		return;
+	}
+
+	if( !has_own_queue )
+	{
+		std::scoped_lock lock( s_injectionMutex );
+		s_injectionQueue.push_back( p_job );
+	}
+
+	wake_workers( 1 );
+}
+
+
+void JobSystem::SubmitAfter( JobCounter& dependency, Job* p_job )
+{
+	while( dependency.m_continuationLock.test_and_set( std::memory_order_acquire ) )
+	{
+		_mm_pause();
+	}
+
+	// only the value, a releasing job that already brought it to zero takes the continuation list after this lock
+	if( dependency.m_value.load( std::memory_order_acquire ) == 0 )
+	{
+		dependency.m_continuationLock.clear( std::memory_order_release );
+		Submit( p_job );
+		return;
+	}
+
+	p_job->pNextContinuation = dependency.m_pContinuations;
+	dependency.m_pContinuations = p_job;
+	dependency.m_continuationLock.clear( std::memory_order_release );
+}
+
+
+Bool JobSystem::ExecuteNextJob()
+{
+	Job* p_job = find_job();
+	if( !p_job )
+	{
+		return false;
+	}
+
+	Execute( p_job );
+	return true;
+}
+
+
+void JobSystem::Execute( Job* p_job )
+{
+	{
+		AZHAL_PROFILE_SCOPE( "job" );
+		p_job->pInvokeFn( p_job->payload );
+	}
+
+	JobCounter* p_counter = p_job->pCounter;
+	p_job->pDestroyFn( p_job->payload );
+	p_job->isInUse.store( false, std::memory_order_release );
+
+	if( !p_counter )
+	{
+		return;
+	}
+
+	// while other jobs remain, the decrement is the last access to the counter
+	Int32 value = p_counter->m_value.load( std::memory_order_relaxed );
+	while( value > 1 )
+	{
+		if( p_counter->m_value.compare_exchange_weak( value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed ) )
+		{
+			return;
+		}
+	}
+
+	// possibly the last job. IsDone stays false until m_releasingJobCount drops back, so the waiter cannot destroy the
+	// counter while the continuations are taken
+	p_counter->m_releasingJobCount.fetch_add( 1, std::memory_order_relaxed );
+	Job* p_continuation = nullptr;
+	if( p_counter->m_value.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+	{
+		while( p_counter->m_continuationLock.test_and_set( std::memory_order_acquire ) )
+		{
+			_mm_pause();
+		}
+		p_continuation = p_counter->m_pContinuations;
+		p_counter->m_pContinuations = nullptr;
+		p_counter->m_continuationLock.clear( std::memory_order_release );
+	}
+	p_counter->m_releasingJobCount.fetch_sub( 1, std::memory_order_release );
+
+	// last job of the counter, release everything that depends on it
+	while( p_continuation )
+	{
+		Job* p_next_continuation = p_continuation->pNextContinuation;
+		Submit( p_continuation );
+		p_continuation = p_next_continuation;
+	}
+}
+
+
+void JobSystem::WorkerMain( Uint32 thread_index )
+{
+	t_threadIndex = thread_index;
+	t_randomState ^= ( thread_index * 0x85EBCA6Bu );
+
+	const std::string thread_name = "worker " + std::to_string( thread_index );
+	AZHAL_PROFILE_THREAD_NAME( thread_name.c_str() );
+
+	Uint32 idle_spin_count = 0;
+	while( !s_isShuttingDown.load( std::memory_order_relaxed ) )
+	{
+		if( ExecuteNextJob() )
+		{
+			idle_spin_count = 0;
+			continue;
+		}
+
+		if( ++idle_spin_count < K_SPIN_COUNT_BEFORE_SLEEP )
+		{
+			_mm_pause();
+			continue;
+		}
+
+		AZHAL_PROFILE_SCOPE( "worker_sleep" );
+		std::unique_lock lock( s_sleepMutex );
+		s_sleepingWorkerCount.fetch_add( 1, std::memory_order_seq_cst );
+		s_sleepCondition.wait( lock, []()
+		{
+			return ( s_queuedJobCount.load( std::memory_order_seq_cst ) > 0 ) || s_isShuttingDown.load( std::memory_order_relaxed );
+		} );
+		s_sleepingWorkerCount.fetch_sub( 1, std::memory_order_relaxed );
+		idle_spin_count = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "assert.h"
+#include "macros.h"
+#include "non_copyable.h"
+#include "typedefs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class JobCounter;
+
+// a job stores its callable inline, captures beyond K_JOB_PAYLOAD_SIZE bytes should capture a pointer instead
+constexpr Uint64 K_JOB_PAYLOAD_SIZE = 64;
+
+struct alignas( 64 ) Job
+{
+	void ( *pInvokeFn )( void* p_payload ) = nullptr;
+	void ( *pDestroyFn )( void* p_payload ) = nullptr;
+	// decremented once the job has run, may be null
+	JobCounter* pCounter = nullptr;
+	// intrusive list of jobs waiting on a counter
+	Job* pNextContinuation = nullptr;
+	std::atomic<Bool> isInUse = false;
+
+	alignas( 16 ) Uint8 payload[ K_JOB_PAYLOAD_SIZE ];
+};
+
+
+// counts unfinished jobs. jobs scheduled with JobSystem::RunAfter start once it drops to zero, which is how
+// dependencies between jobs are expressed. a counter must outlive its jobs and must not be reused while
+// continuations are queued on it
+class JobCounter : NonCopyable
+{
+public:
+	// false until the job that released the counter no longer touches it, a waiter may destroy it right after
+	AZHAL_INLINE Bool IsDone() const
+	{
+		return ( m_value.load( std::memory_order_acquire ) == 0 ) && ( m_releasingJobCount.load( std::memory_order_acquire ) == 0 );
+	}
+
+private:
+	friend class JobSystem;
+
+	std::atomic<Int32> m_value = 0;
+	// jobs that may bring m_value to zero and still have continuations to hand off, their last access is the decrement of this
+	std::atomic<Int32> m_releasingJobCount = 0;
+	std::atomic_flag m_continuationLock;
+	Job* m_pContinuations = nullptr;
+};
+
+
+// per-core worker threads with one work-stealing deque each. the thread that calls Init owns deque 0 and
+// participates whenever it waits. other threads may submit jobs too, they go through a shared injection queue
+class JobSystem
+{
+public:
+	JobSystem() = delete;
+
+	// worker_count 0 uses one worker per hardware thread besides the calling one
+	static void Init( Uint32 worker_count = 0 );
+	static void Shutdown();
+
+	static Uint32 GetWorkerCount();
+	// 0 for the thread that called Init, 1..GetWorkerCount() for workers, UINT32_MAX for any other thread
+	static Uint32 GetThreadIndex();
+
+	template<typename FnType>
+	static void Run( FnType&& fn, JobCounter* p_counter = nullptr )
+	{
+		Submit( CreateJob( std::forward<FnType>( fn ), p_counter ) );
+	}
+
+	// fn runs once dependency is done. p_counter is incremented right away, so waiting on it also waits for fn
+	template<typename FnType>
+	static void RunAfter( JobCounter& dependency, FnType&& fn, JobCounter* p_counter = nullptr )
+	{
+		SubmitAfter( dependency, CreateJob( std::forward<FnType>( fn ), p_counter ) );
+	}
+
+	// executes other jobs while waiting instead of blocking the thread
+	static void Wait( const JobCounter& counter );
+
+	// calls fn( begin, end ) for chunks of at most grain_size items and returns once all of them ran
+	template<typename FnType>
+	static void ParallelFor( Uint32 count, Uint32 grain_size, FnType&& fn )
+	{
+		if( count == 0 )
+		{
+			return;
+		}
+
+		grain_size = std::max<Uint32>( grain_size, 1 );
+		if( count <= grain_size || GetWorkerCount() == 0 )
+		{
+			fn( 0u, count );
+			return;
+		}
+
+		JobCounter counter;
+		// the calling thread takes the first chunk itself
+		for( Uint32 begin = grain_size; begin < count; begin += grain_size )
+		{
+			const Uint32 end = std::min<Uint32>( begin + grain_size, count );
+			Run( [&fn, begin, end]() { fn( begin, end ); }, &counter );
+		}
+		fn( 0u, grain_size );
+
+		Wait( counter );
+	}
+
+	// a grain that gives every thread a few chunks to balance uneven work
+	static Uint32 GetDefaultGrainSize( Uint32 count );
+
+private:
+	template<typename FnType>
+	static Job* CreateJob( FnType&& fn, JobCounter* p_counter )
+	{
+		using CallableType = std::decay_t<FnType>;
+		AZHAL_STATIC_ASSERT( sizeof( CallableType ) <= K_JOB_PAYLOAD_SIZE, "job callable is too large, capture a pointer to the data instead" );
+		AZHAL_STATIC_ASSERT( alignof( CallableType ) <= 16, "job callable is over-aligned" );
+
+		Job* p_job = AllocateJob();
+		new( p_job->payload ) CallableType( std::forward<FnType>( fn ) );
+		p_job->pInvokeFn = []( void* p_payload ) { ( *static_cast< CallableType* >( p_payload ) )(); };
+		p_job->pDestroyFn = []( void* p_payload ) { static_cast< CallableType* >( p_payload )->~CallableType(); };
+		p_job->pCounter = p_counter;
+		p_job->pNextContinuation = nullptr;
+
+		if( p_counter )
+		{
+			p_counter->m_value.fetch_add( 1, std::memory_order_relaxed );
+		}
+
+		return p_job;
+	}
+
+	static Job* AllocateJob();
+	static void Submit( Job* p_job );
+	static void SubmitAfter( JobCounter& dependency, Job* p_job );
+
+	// returns false when no job was found
+	static Bool ExecuteNextJob();
+	static void Execute( Job* p_job );
+	static void WorkerMain( Uint32 thread_index );
+};
\ No newline at end of file
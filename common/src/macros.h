@@ -1,6 +1,8 @@
 #pragma once
 
 #define TO_STRING(x) #x
+#define AZHAL_CONCAT_IMPL(a, b) a##b
+#define AZHAL_CONCAT(a, b) AZHAL_CONCAT_IMPL(a, b)
 
 #define AZHAL_INLINE __inline
 #define AZHAL_FORCE_INLINE __forceinline
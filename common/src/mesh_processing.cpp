@@ -0,0 +1,888 @@
+#include "mesh_processing.h"
+
+#include "log.h"
+#include "profiler.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+	constexpr Uint32 K_PACKED_MESH_MAGIC = 0x534d5a41; // "AZMS"
+	constexpr Uint32 K_PACKED_MESH_VERSION = 1;
+
+	struct PackedMeshHeader
+	{
+		Uint32 magic;
+		Uint32 version;
+		Uint32 vertexCount;
+		Uint32 indexCount;
+		// 2 or 4
+		Uint32 indexSize;
+		Float boundsCenter[ 3 ];
+		Float boundsExtent[ 3 ];
+	};
+
+	// forsyth's scoring, tuned for a 32 entry lru cache
+	constexpr Uint32 K_FORSYTH_CACHE_SIZE = 32;
+	constexpr Float K_FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	constexpr Float K_FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr Float K_FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	constexpr Float K_FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	Float get_forsyth_vertex_score( Int32 cache_position, Uint32 remaining_valence )
+	{
+		if( remaining_valence == 0 )
+		{
+			return -1.0f;
+		}
+
+		Float score = 0.0f;
+		if( cache_position >= 0 )
+		{
+			if( cache_position < 3 )
+			{
+				// the vertices of the last triangle are penalized so that strips do not double back
+				score = K_FORSYTH_LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				const Float scaler = 1.0f / static_cast< Float >( K_FORSYTH_CACHE_SIZE - 3 );
+				score = std::pow( 1.0f - static_cast< Float >( cache_position - 3 ) * scaler, K_FORSYTH_CACHE_DECAY_POWER );
+			}
+		}
+
+		// vertices with few triangles left are finished first so that they leave the cache for good
+		return score + K_FORSYTH_VALENCE_BOOST_SCALE * std::pow( static_cast< Float >( remaining_valence ), -K_FORSYTH_VALENCE_BOOST_POWER );
+	}
+
+
+	Vec3 get_triangle_normal( const Vec3& a, const Vec3& b, const Vec3& c )
+	{
+		// not normalized, the length is twice the area
+		return glm::cross( b - a, c - a );
+	}
+
+
+	Vec2 encode_octahedral( Vec3 normal )
+	{
+		normal /= ( std::abs( normal.x ) + std::abs( normal.y ) + std::abs( normal.z ) );
+		Vec2 encoded( normal.x, normal.y );
+		if( normal.z < 0.0f )
+		{
+			encoded = ( 1.0f - glm::abs( Vec2( encoded.y, encoded.x ) ) ) * Vec2( encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f );
+		}
+		return encoded;
+	}
+
+
+	Int16 quantize_snorm16( Float value )
+	{
+		return static_cast< Int16 >( std::lround( std::clamp( value, -1.0f, 1.0f ) * 32767.0f ) );
+	}
+
+
+	Vec3 decode_position( const PackedMesh& mesh, const PackedMeshVertex& vertex )
+	{
+		const Vec3 normalized_position = glm::max( Vec3( vertex.position[ 0 ], vertex.position[ 1 ], vertex.position[ 2 ] ) / 32767.0f, Vec3( -1.0f ) );
+		return normalized_position * mesh.boundsExtent + mesh.boundsCenter;
+	}
+
+
+	MeshletBounds compute_meshlet_bounds( const PackedMesh& mesh, const MeshletData& meshlet_data, const Meshlet& meshlet )
+	{
+		MeshletBounds bounds;
+
+		// the sphere around the center of the aabb is within a few percent of the minimal one for typical meshlets
+		Vec3 bounds_min( std::numeric_limits<Float>::max() );
+		Vec3 bounds_max( std::numeric_limits<Float>::lowest() );
+		for( Uint32 i = 0; i < meshlet.vertexCount; ++i )
+		{
+			const Vec3 position = decode_position( mesh, mesh.vertices[ meshlet_data.vertices[ meshlet.vertexOffset + i ] ] );
+			bounds_min = glm::min( bounds_min, position );
+			bounds_max = glm::max( bounds_max, position );
+		}
+		bounds.center = ( bounds_min + bounds_max ) * 0.5f;
+		for( Uint32 i = 0; i < meshlet.vertexCount; ++i )
+		{
+			const Vec3 position = decode_position( mesh, mesh.vertices[ meshlet_data.vertices[ meshlet.vertexOffset + i ] ] );
+			bounds.radius = std::max( bounds.radius, glm::length( position - bounds.center ) );
+		}
+
+		// the normals of the triangles as they are rasterized, not the shading normals
+		Vec3 normal_sum( 0.0f );
+		std::array<Vec3, K_MESHLET_MAX_TRIANGLES> triangle_normals;
+		Uint32 triangle_normal_count = 0;
+		for( Uint32 i = 0; i < meshlet.triangleCount; ++i )
+		{
+			const Uint32 packed_triangle = meshlet_data.triangles[ meshlet.triangleOffset + i ];
+			const Uint32* p_vertices = meshlet_data.vertices.data() + meshlet.vertexOffset;
+			const Vec3 a = decode_position( mesh, mesh.vertices[ p_vertices[ packed_triangle & 0xff ] ] );
+			const Vec3 b = decode_position( mesh, mesh.vertices[ p_vertices[ ( packed_triangle >> 8 ) & 0xff ] ] );
+			const Vec3 c = decode_position( mesh, mesh.vertices[ p_vertices[ ( packed_triangle >> 16 ) & 0xff ] ] );
+
+			const Vec3 normal = get_triangle_normal( a, b, c );
+			const Float length = glm::length( normal );
+			if( length > 0.0f && triangle_normal_count < triangle_normals.size() )
+			{
+				triangle_normals[ triangle_normal_count++ ] = normal / length;
+				normal_sum += normal / length;
+			}
+		}
+
+		const Float axis_length = glm::length( normal_sum );
+		if( triangle_normal_count == 0 || axis_length <= 0.0f )
+		{
+			return bounds;
+		}
+		bounds.coneAxis = normal_sum / axis_length;
+
+		Float min_dot = 1.0f;
+		for( Uint32 i = 0; i < triangle_normal_count; ++i )
+		{
+			min_dot = std::min( min_dot, glm::dot( triangle_normals[ i ], bounds.coneAxis ) );
+		}
+
+		// a cone of 90 degrees or more has a viewer on the front side of some triangle from every direction
+		if( min_dot > 0.0f )
+		{
+			bounds.coneCutoff = std::sqrt( 1.0f - min_dot * min_dot );
+		}
+		return bounds;
+	}
+
+
+	// obj indices are 1-based, negative ones count back from the last element
+	Int32 resolve_obj_index( Int32 index, size_t element_count )
+	{
+		return ( index < 0 ) ? static_cast< Int32 >( element_count ) + index : index - 1;
+	}
+
+
+	struct ObjCorner
+	{
+		Int32 position = -1;
+		Int32 uv = -1;
+		Int32 normal = -1;
+
+		Bool operator==( const ObjCorner& other ) const = default;
+	};
+
+	struct ObjCornerHash
+	{
+		size_t operator()( const ObjCorner& corner ) const
+		{
+			const Uint64 key = ( static_cast< Uint64 >( static_cast< Uint32 >( corner.position ) ) * 0x9e3779b97f4a7c15ull ) ^
+				( static_cast< Uint64 >( static_cast< Uint32 >( corner.uv ) ) * 0xc2b2ae3d27d4eb4full ) ^
+				static_cast< Uint64 >( static_cast< Uint32 >( corner.normal ) );
+			return static_cast< size_t >( key ^ ( key >> 29 ) );
+		}
+	};
+}
+
+Bool LoadObjMesh( const AnsiChar* file_path, MeshData& out_mesh )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	std::ifstream file_stream( file_path );
+	if( !file_stream.is_open() )
+	{
+		AZHAL_LOG_ERROR( "failed to open obj file {0}", file_path );
+		return false;
+	}
+
+	std::vector<Vec3> positions;
+	std::vector<Vec2> uvs;
+	std::vector<Vec3> normals;
+	std::unordered_map<ObjCorner, Uint32, ObjCornerHash> corner_to_vertex;
+	std::vector<Uint32> polygon;
+	Bool has_missing_normals = false;
+
+	out_mesh = {};
+
+	String line;
+	while( std::getline( file_stream, line ) )
+	{
+		std::istringstream line_stream( line );
+		String keyword;
+		line_stream >> keyword;
+
+		if( keyword == "v" )
+		{
+			Vec3& position = positions.emplace_back( 0.0f );
+			line_stream >> position.x >> position.y >> position.z;
+		}
+		else if( keyword == "vt" )
+		{
+			Vec2& uv = uvs.emplace_back( 0.0f );
+			line_stream >> uv.x >> uv.y;
+			// obj has v pointing up, vulkan samples top down
+			uv.y = 1.0f - uv.y;
+		}
+		else if( keyword == "vn" )
+		{
+			Vec3& normal = normals.emplace_back( 0.0f );
+			line_stream >> normal.x >> normal.y >> normal.z;
+		}
+		else if( keyword == "f" )
+		{
+			polygon.clear();
+
+			String corner_token;
+			while( line_stream >> corner_token )
+			{
+				// v, v/vt, v//vn or v/vt/vn
+				Int32 values[ 3 ] = { 0, 0, 0 };
+				size_t token_begin = 0;
+				for( Uint32 component = 0; component < 3 && token_begin <= corner_token.size(); ++component )
+				{
+					const size_t token_end = std::min( corner_token.find( '/', token_begin ), corner_token.size() );
+					if( token_end > token_begin )
+					{
+						// runs inside preload jobs, a malformed token fails the load instead of throwing
+						const AnsiChar* p_first = corner_token.data() + token_begin;
+						const AnsiChar* p_last = corner_token.data() + token_end;
+						const std::from_chars_result result = std::from_chars( p_first, p_last, values[ component ] );
+						if( result.ec != std::errc() || result.ptr != p_last )
+						{
+							AZHAL_LOG_ERROR( "obj file {0} has a malformed face corner {1}", file_path, corner_token );
+							return false;
+						}
+					}
+					token_begin = token_end + 1;
+				}
+
+				const ObjCorner corner
+				{
+					.position = resolve_obj_index( values[ 0 ], positions.size() ),
+					.uv = ( values[ 1 ] != 0 ) ? resolve_obj_index( values[ 1 ], uvs.size() ) : -1,
+					.normal = ( values[ 2 ] != 0 ) ? resolve_obj_index( values[ 2 ], normals.size() ) : -1
+				};
+				if( corner.position < 0 || corner.position >= static_cast< Int32 >( positions.size() ) ||
+					corner.uv >= static_cast< Int32 >( uvs.size() ) || corner.normal >= static_cast< Int32 >( normals.size() ) )
+				{
+					AZHAL_LOG_ERROR( "obj file {0} references a missing vertex attribute", file_path );
+					return false;
+				}
+
+				const auto [corner_it, is_new_corner] = corner_to_vertex.try_emplace( corner, static_cast< Uint32 >( out_mesh.vertices.size() ) );
+				if( is_new_corner )
+				{
+					out_mesh.vertices.push_back( MeshVertex
+					{
+						.position = positions[ corner.position ],
+						.normal = ( corner.normal >= 0 ) ? normals[ corner.normal ] : Vec3( 0.0f ),
+						.uv = ( corner.uv >= 0 ) ? uvs[ corner.uv ] : Vec2( 0.0f )
+					} );
+					has_missing_normals |= ( corner.normal < 0 );
+				}
+				polygon.push_back( corner_it->second );
+			}
+
+			for( size_t i = 2; i < polygon.size(); ++i )
+			{
+				out_mesh.indices.push_back( polygon[ 0 ] );
+				out_mesh.indices.push_back( polygon[ i - 1 ] );
+				out_mesh.indices.push_back( polygon[ i ] );
+			}
+		}
+	}
+
+	if( out_mesh.indices.empty() )
+	{
+		AZHAL_LOG_ERROR( "obj file {0} has no triangles", file_path );
+		return false;
+	}
+
+	if( has_missing_normals )
+	{
+		// area weighted face normals, accumulated per position so that uv seams do not show up in the shading
+		std::vector<Vec3> position_normals( positions.size(), Vec3( 0.0f ) );
+		std::vector<Uint32> vertex_positions( out_mesh.vertices.size() );
+		for( const auto& [corner, vertex_index] : corner_to_vertex )
+		{
+			vertex_positions[ vertex_index ] = static_cast< Uint32 >( corner.position );
+		}
+
+		for( size_t i = 0; i < out_mesh.indices.size(); i += 3 )
+		{
+			const Uint32 a = out_mesh.indices[ i ];
+			const Uint32 b = out_mesh.indices[ i + 1 ];
+			const Uint32 c = out_mesh.indices[ i + 2 ];
+			const Vec3 face_normal = get_triangle_normal( out_mesh.vertices[ a ].position, out_mesh.vertices[ b ].position, out_mesh.vertices[ c ].position );
+			for( const Uint32 vertex_index : { a, b, c } )
+			{
+				position_normals[ vertex_positions[ vertex_index ] ] += face_normal;
+			}
+		}
+
+		for( Uint32 i = 0; i < out_mesh.vertices.size(); ++i )
+		{
+			MeshVertex& vertex = out_mesh.vertices[ i ];
+			if( vertex.normal == Vec3( 0.0f ) )
+			{
+				vertex.normal = position_normals[ vertex_positions[ i ] ];
+			}
+		}
+	}
+
+	for( MeshVertex& vertex : out_mesh.vertices )
+	{
+		const Float length = glm::length( vertex.normal );
+		vertex.normal = ( length > 0.0f ) ? vertex.normal / length : Vec3( 0.0f, 0.0f, 1.0f );
+	}
+
+	return true;
+}
+
+
+void OptimizeVertexCache( std::span<Uint32> indices, Uint32 vertex_count )
+{
+	AZHAL_PROFILE_FUNCTION();
+	AZHAL_ASSERT( indices.size() % 3 == 0, "the indices have to form a triangle list" );
+
+	const Uint32 triangle_count = static_cast< Uint32 >( indices.size() / 3 );
+	if( triangle_count == 0 )
+	{
+		return;
+	}
+
+	// triangles adjacent to every vertex, as one flat array with per-vertex offsets
+	std::vector<Uint32> remaining_valence( vertex_count, 0 );
+	for( const Uint32 index : indices )
+	{
+		remaining_valence[ index ]++;
+	}
+	std::vector<Uint32> adjacency_offsets( vertex_count + 1, 0 );
+	std::inclusive_scan( remaining_valence.begin(), remaining_valence.end(), adjacency_offsets.begin() + 1 );
+	std::vector<Uint32> adjacency( indices.size() );
+	std::vector<Uint32> adjacency_fill( adjacency_offsets.begin(), adjacency_offsets.end() - 1 );
+	for( Uint32 triangle = 0; triangle < triangle_count; ++triangle )
+	{
+		for( Uint32 corner = 0; corner < 3; ++corner )
+		{
+			adjacency[ adjacency_fill[ indices[ triangle * 3 + corner ] ]++ ] = triangle;
+		}
+	}
+
+	std::vector<Int32> cache_positions( vertex_count, -1 );
+	std::vector<Float> vertex_scores( vertex_count );
+	for( Uint32 vertex = 0; vertex < vertex_count; ++vertex )
+	{
+		vertex_scores[ vertex ] = get_forsyth_vertex_score( -1, remaining_valence[ vertex ] );
+	}
+
+	std::vector<Float> triangle_scores( triangle_count );
+	std::vector<Bool> is_triangle_emitted( triangle_count, false );
+	for( Uint32 triangle = 0; triangle < triangle_count; ++triangle )
+	{
+		triangle_scores[ triangle ] = vertex_scores[ indices[ triangle * 3 ] ] + vertex_scores[ indices[ triangle * 3 + 1 ] ] + vertex_scores[ indices[ triangle * 3 + 2 ] ];
+	}
+
+	std::vector<Uint32> output_indices;
+	output_indices.reserve( indices.size() );
+
+	// one extra slot for the triangle being added, which pushes the oldest vertex out. the two swap every triangle
+	std::vector<Uint32> cache;
+	std::vector<Uint32> new_cache;
+	cache.reserve( K_FORSYTH_CACHE_SIZE + 3 );
+	new_cache.reserve( K_FORSYTH_CACHE_SIZE + 3 );
+
+	// vertices pushed out of the cache while they still had triangles, the most recent one is closest to where the
+	// strip continues
+	std::vector<Uint32> evicted_vertices;
+
+	Uint32 best_triangle = static_cast< Uint32 >( std::max_element( triangle_scores.begin(), triangle_scores.end() ) - triangle_scores.begin() );
+	Uint32 scan_cursor = 0;
+	for( Uint32 emitted = 0; emitted < triangle_count; ++emitted )
+	{
+		// nothing in the cache has triangles left: continue with the best triangle of a recently evicted vertex, and
+		// only once none has any left with the next one in input order. both only move forward, so this stays linear
+		while( best_triangle == UINT32_MAX && !evicted_vertices.empty() )
+		{
+			const Uint32 vertex = evicted_vertices.back();
+			evicted_vertices.pop_back();
+
+			Float best_score = -1.0f;
+			const Uint32 adjacency_begin = adjacency_offsets[ vertex ];
+			for( Uint32 i = 0; i < remaining_valence[ vertex ]; ++i )
+			{
+				const Uint32 triangle = adjacency[ adjacency_begin + i ];
+				const Float score = vertex_scores[ indices[ triangle * 3 ] ] + vertex_scores[ indices[ triangle * 3 + 1 ] ] + vertex_scores[ indices[ triangle * 3 + 2 ] ];
+				if( score > best_score )
+				{
+					best_score = score;
+					best_triangle = triangle;
+				}
+			}
+		}
+		if( best_triangle == UINT32_MAX )
+		{
+			while( is_triangle_emitted[ scan_cursor ] )
+			{
+				scan_cursor++;
+			}
+			best_triangle = scan_cursor;
+		}
+
+		is_triangle_emitted[ best_triangle ] = true;
+
+		new_cache.clear();
+		for( Uint32 corner = 0; corner < 3; ++corner )
+		{
+			const Uint32 vertex = indices[ best_triangle * 3 + corner ];
+			output_indices.push_back( vertex );
+			new_cache.push_back( vertex );
+
+			// drop the emitted triangle from the vertex's adjacency
+			Uint32* p_begin = adjacency.data() + adjacency_offsets[ vertex ];
+			Uint32* p_end = p_begin + remaining_valence[ vertex ];
+			std::iter_swap( std::find( p_begin, p_end, best_triangle ), p_end - 1 );
+			remaining_valence[ vertex ]--;
+		}
+		for( const Uint32 vertex : cache )
+		{
+			if( std::find( new_cache.begin(), new_cache.end(), vertex ) == new_cache.end() )
+			{
+				new_cache.push_back( vertex );
+			}
+		}
+
+		// vertices falling out of the cache lose their cache score
+		for( size_t i = K_FORSYTH_CACHE_SIZE; i < new_cache.size(); ++i )
+		{
+			cache_positions[ new_cache[ i ] ] = -1;
+			vertex_scores[ new_cache[ i ] ] = get_forsyth_vertex_score( -1, remaining_valence[ new_cache[ i ] ] );
+			if( remaining_valence[ new_cache[ i ] ] > 0 )
+			{
+				evicted_vertices.push_back( new_cache[ i ] );
+			}
+		}
+		new_cache.resize( std::min<size_t>( new_cache.size(), K_FORSYTH_CACHE_SIZE ) );
+		cache.swap( new_cache );
+
+		for( Uint32 i = 0; i < cache.size(); ++i )
+		{
+			cache_positions[ cache[ i ] ] = static_cast< Int32 >( i );
+			vertex_scores[ cache[ i ] ] = get_forsyth_vertex_score( static_cast< Int32 >( i ), remaining_valence[ cache[ i ] ] );
+		}
+
+		// only triangles touching the cache changed their score
+		best_triangle = UINT32_MAX;
+		Float best_score = -1.0f;
+		for( const Uint32 vertex : cache )
+		{
+			const Uint32 adjacency_begin = adjacency_offsets[ vertex ];
+			for( Uint32 i = 0; i < remaining_valence[ vertex ]; ++i )
+			{
+				const Uint32 triangle = adjacency[ adjacency_begin + i ];
+				const Float score = vertex_scores[ indices[ triangle * 3 ] ] + vertex_scores[ indices[ triangle * 3 + 1 ] ] + vertex_scores[ indices[ triangle * 3 + 2 ] ];
+				triangle_scores[ triangle ] = score;
+				if( score > best_score )
+				{
+					best_score = score;
+					best_triangle = triangle;
+				}
+			}
+		}
+	}
+
+	std::copy( output_indices.begin(), output_indices.end(), indices.begin() );
+}
+
+
+void OptimizeOverdraw( std::span<Uint32> indices, std::span<const MeshVertex> vertices, Float threshold )
+{
+	AZHAL_PROFILE_FUNCTION();
+	AZHAL_ASSERT( indices.size() % 3 == 0, "the indices have to form a triangle list" );
+
+	const Uint32 triangle_count = static_cast< Uint32 >( indices.size() / 3 );
+	if( triangle_count < 2 )
+	{
+		return;
+	}
+
+	// cache misses per triangle of the order the cache optimization produced
+	constexpr Uint32 K_CACHE_SIZE = 16;
+	std::vector<Uint32> triangle_misses( triangle_count, 0 );
+	{
+		std::vector<Uint64> cache_timestamps( vertices.size(), 0 );
+		Uint64 timestamp = K_CACHE_SIZE + 1;
+		for( Uint32 triangle = 0; triangle < triangle_count; ++triangle )
+		{
+			for( Uint32 corner = 0; corner < 3; ++corner )
+			{
+				const Uint32 vertex = indices[ triangle * 3 + corner ];
+				if( timestamp - cache_timestamps[ vertex ] > K_CACHE_SIZE )
+				{
+					cache_timestamps[ vertex ] = timestamp++;
+					triangle_misses[ triangle ]++;
+				}
+			}
+		}
+	}
+	const Float mesh_acmr = static_cast< Float >( std::accumulate( triangle_misses.begin(), triangle_misses.end(), 0u ) ) / static_cast< Float >( triangle_count );
+
+	// a cluster ends once its own acmr is good enough, which keeps the cost of reordering whole clusters bounded
+	std::vector<Uint32> cluster_offsets;
+	Uint32 cluster_misses = 0;
+	Uint32 cluster_begin = 0;
+	for( Uint32 triangle = 0; triangle < triangle_count; ++triangle )
+	{
+		if( triangle == cluster_begin )
+		{
+			cluster_offsets.push_back( triangle );
+			cluster_misses = 0;
+		}
+
+		cluster_misses += triangle_misses[ triangle ];
+		const Uint32 cluster_size = triangle - cluster_begin + 1;
+		const Float cluster_acmr = static_cast< Float >( cluster_misses ) / static_cast< Float >( cluster_size );
+		if( cluster_size >= 8 && cluster_acmr <= mesh_acmr * threshold )
+		{
+			cluster_begin = triangle + 1;
+		}
+	}
+	const Uint32 cluster_count = static_cast< Uint32 >( cluster_offsets.size() );
+	cluster_offsets.push_back( triangle_count );
+
+	Vec3 mesh_centroid( 0.0f );
+	Float mesh_area = 0.0f;
+	std::vector<Vec3> cluster_centroids( cluster_count, Vec3( 0.0f ) );
+	std::vector<Vec3> cluster_normals( cluster_count, Vec3( 0.0f ) );
+	for( Uint32 cluster = 0; cluster < cluster_count; ++cluster )
+	{
+		Float cluster_area = 0.0f;
+		for( Uint32 triangle = cluster_offsets[ cluster ]; triangle < cluster_offsets[ cluster + 1 ]; ++triangle )
+		{
+			const Vec3& a = vertices[ indices[ triangle * 3 ] ].position;
+			const Vec3& b = vertices[ indices[ triangle * 3 + 1 ] ].position;
+			const Vec3& c = vertices[ indices[ triangle * 3 + 2 ] ].position;
+			const Vec3 normal = get_triangle_normal( a, b, c );
+			const Float area = glm::length( normal );
+
+			cluster_centroids[ cluster ] += ( a + b + c ) * ( area / 3.0f );
+			cluster_normals[ cluster ] += normal;
+			cluster_area += area;
+		}
+
+		mesh_centroid += cluster_centroids[ cluster ];
+		mesh_area += cluster_area;
+		cluster_centroids[ cluster ] /= std::max( cluster_area, 1e-20f );
+	}
+	mesh_centroid /= std::max( mesh_area, 1e-20f );
+
+	// clusters far out along their own normal are likely to occlude the rest of the mesh
+	std::vector<Float> cluster_sort_keys( cluster_count );
+	for( Uint32 cluster = 0; cluster < cluster_count; ++cluster )
+	{
+		const Float normal_length = glm::length( cluster_normals[ cluster ] );
+		const Vec3 normal = ( normal_length > 0.0f ) ? cluster_normals[ cluster ] / normal_length : Vec3( 0.0f );
+		cluster_sort_keys[ cluster ] = glm::dot( cluster_centroids[ cluster ] - mesh_centroid, normal );
+	}
+
+	std::vector<Uint32> cluster_order( cluster_count );
+	std::iota( cluster_order.begin(), cluster_order.end(), 0u );
+	std::stable_sort( cluster_order.begin(), cluster_order.end(), [&cluster_sort_keys]( Uint32 a, Uint32 b )
+	{
+		return cluster_sort_keys[ a ] > cluster_sort_keys[ b ];
+	} );
+
+	std::vector<Uint32> output_indices;
+	output_indices.reserve( indices.size() );
+	for( const Uint32 cluster : cluster_order )
+	{
+		output_indices.insert( output_indices.end(), indices.begin() + cluster_offsets[ cluster ] * 3, indices.begin() + cluster_offsets[ cluster + 1 ] * 3 );
+	}
+	std::copy( output_indices.begin(), output_indices.end(), indices.begin() );
+}
+
+
+void OptimizeVertexFetch( MeshData& mesh )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	std::vector<Uint32> remap( mesh.vertices.size(), UINT32_MAX );
+	std::vector<MeshVertex> fetch_ordered_vertices;
+	fetch_ordered_vertices.reserve( mesh.vertices.size() );
+
+	for( Uint32& index : mesh.indices )
+	{
+		if( remap[ index ] == UINT32_MAX )
+		{
+			remap[ index ] = static_cast< Uint32 >( fetch_ordered_vertices.size() );
+			fetch_ordered_vertices.push_back( mesh.vertices[ index ] );
+		}
+		index = remap[ index ];
+	}
+
+	mesh.vertices = std::move( fetch_ordered_vertices );
+}
+
+
+Float ComputeAcmr( std::span<const Uint32> indices, Uint32 vertex_count, Uint32 cache_size )
+{
+	if( indices.size() < 3 )
+	{
+		return 0.0f;
+	}
+
+	std::vector<Uint64> cache_timestamps( vertex_count, 0 );
+	Uint64 timestamp = cache_size + 1;
+	Uint64 miss_count = 0;
+	for( const Uint32 index : indices )
+	{
+		if( timestamp - cache_timestamps[ index ] > cache_size )
+		{
+			cache_timestamps[ index ] = timestamp++;
+			miss_count++;
+		}
+	}
+
+	return static_cast< Float >( miss_count ) / static_cast< Float >( indices.size() / 3 );
+}
+
+
+PackedMesh QuantizeMesh( const MeshData& mesh )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	Vec3 bounds_min( std::numeric_limits<Float>::max() );
+	Vec3 bounds_max( std::numeric_limits<Float>::lowest() );
+	for( const MeshVertex& vertex : mesh.vertices )
+	{
+		bounds_min = glm::min( bounds_min, vertex.position );
+		bounds_max = glm::max( bounds_max, vertex.position );
+	}
+
+	PackedMesh packed_mesh;
+	packed_mesh.boundsCenter = ( bounds_min + bounds_max ) * 0.5f;
+	// flat meshes still get a non-zero extent along their flat axis
+	packed_mesh.boundsExtent = glm::max( ( bounds_max - bounds_min ) * 0.5f, Vec3( 1e-6f ) );
+	packed_mesh.indices = mesh.indices;
+
+	packed_mesh.vertices.resize( mesh.vertices.size() );
+	for( size_t i = 0; i < mesh.vertices.size(); ++i )
+	{
+		const MeshVertex& vertex = mesh.vertices[ i ];
+		PackedMeshVertex& packed_vertex = packed_mesh.vertices[ i ];
+
+		const Vec3 normalized_position = ( vertex.position - packed_mesh.boundsCenter ) / packed_mesh.boundsExtent;
+		packed_vertex.position[ 0 ] = quantize_snorm16( normalized_position.x );
+		packed_vertex.position[ 1 ] = quantize_snorm16( normalized_position.y );
+		packed_vertex.position[ 2 ] = quantize_snorm16( normalized_position.z );
+		packed_vertex.position[ 3 ] = 0;
+
+		const Vec2 octahedral_normal = encode_octahedral( vertex.normal );
+		packed_vertex.normal[ 0 ] = quantize_snorm16( octahedral_normal.x );
+		packed_vertex.normal[ 1 ] = quantize_snorm16( octahedral_normal.y );
+
+		packed_vertex.uv[ 0 ] = glm::packHalf1x16( vertex.uv.x );
+		packed_vertex.uv[ 1 ] = glm::packHalf1x16( vertex.uv.y );
+	}
+
+	return packed_mesh;
+}
+
+
+PackedMesh ProcessMesh( MeshData mesh, MeshProcessingStats* p_stats )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const Uint32 vertex_count = static_cast< Uint32 >( mesh.vertices.size() );
+	if( p_stats )
+	{
+		p_stats->acmrBefore = ComputeAcmr( mesh.indices, vertex_count );
+		p_stats->bytesBefore = mesh.vertices.size() * sizeof( MeshVertex ) + mesh.indices.size() * sizeof( Uint32 );
+	}
+
+	OptimizeVertexCache( mesh.indices, vertex_count );
+	OptimizeOverdraw( mesh.indices, mesh.vertices );
+	OptimizeVertexFetch( mesh );
+
+	PackedMesh packed_mesh = QuantizeMesh( mesh );
+
+	if( p_stats )
+	{
+		const size_t index_size = ( packed_mesh.vertices.size() <= 0x10000 ) ? sizeof( Uint16 ) : sizeof( Uint32 );
+		p_stats->vertexCount = static_cast< Uint32 >( packed_mesh.vertices.size() );
+		p_stats->triangleCount = static_cast< Uint32 >( packed_mesh.indices.size() / 3 );
+		p_stats->acmrAfter = ComputeAcmr( packed_mesh.indices, p_stats->vertexCount );
+		p_stats->bytesAfter = packed_mesh.vertices.size() * sizeof( PackedMeshVertex ) + packed_mesh.indices.size() * index_size;
+	}
+
+	return packed_mesh;
+}
+
+
+MeshletData BuildMeshlets( const PackedMesh& mesh, Uint32 max_vertices, Uint32 max_triangles )
+{
+	AZHAL_PROFILE_FUNCTION();
+	AZHAL_ASSERT( max_vertices <= 256 && max_vertices >= 3 && max_triangles <= K_MESHLET_MAX_TRIANGLES && max_triangles > 0,
+		"meshlet vertices are addressed with 8 bits" );
+
+	MeshletData meshlet_data;
+
+	// position of a vertex within the open meshlet, UINT32_MAX when it is not part of it yet
+	std::vector<Uint32> local_indices( mesh.vertices.size(), UINT32_MAX );
+	Meshlet meshlet;
+
+	const auto close_meshlet = [&]()
+	{
+		for( Uint32 i = 0; i < meshlet.vertexCount; ++i )
+		{
+			local_indices[ meshlet_data.vertices[ meshlet.vertexOffset + i ] ] = UINT32_MAX;
+		}
+		meshlet_data.meshlets.push_back( meshlet );
+		meshlet = Meshlet
+		{
+			.vertexOffset = static_cast< Uint32 >( meshlet_data.vertices.size() ),
+			.triangleOffset = static_cast< Uint32 >( meshlet_data.triangles.size() )
+		};
+	};
+
+	for( size_t i = 0; i + 2 < mesh.indices.size(); i += 3 )
+	{
+		const Uint32 triangle[ 3 ] = { mesh.indices[ i ], mesh.indices[ i + 1 ], mesh.indices[ i + 2 ] };
+
+		Uint32 new_vertex_count = 0;
+		for( Uint32 corner = 0; corner < 3; ++corner )
+		{
+			const Bool is_repeated_corner = ( corner > 0 && triangle[ corner ] == triangle[ 0 ] ) || ( corner > 1 && triangle[ corner ] == triangle[ 1 ] );
+			new_vertex_count += ( local_indices[ triangle[ corner ] ] == UINT32_MAX && !is_repeated_corner ) ? 1 : 0;
+		}
+
+		if( meshlet.vertexCount + new_vertex_count > max_vertices || meshlet.triangleCount == max_triangles )
+		{
+			close_meshlet();
+		}
+
+		Uint32 packed_triangle = 0;
+		for( Uint32 corner = 0; corner < 3; ++corner )
+		{
+			Uint32& local_index = local_indices[ triangle[ corner ] ];
+			if( local_index == UINT32_MAX )
+			{
+				local_index = meshlet.vertexCount++;
+				meshlet_data.vertices.push_back( triangle[ corner ] );
+			}
+			packed_triangle |= local_index << ( corner * 8 );
+		}
+		meshlet_data.triangles.push_back( packed_triangle );
+		meshlet.triangleCount++;
+	}
+
+	if( meshlet.triangleCount > 0 )
+	{
+		close_meshlet();
+	}
+
+	meshlet_data.bounds.reserve( meshlet_data.meshlets.size() );
+	for( const Meshlet& built_meshlet : meshlet_data.meshlets )
+	{
+		meshlet_data.bounds.push_back( compute_meshlet_bounds( mesh, meshlet_data, built_meshlet ) );
+	}
+
+	return meshlet_data;
+}
+
+
+ByteBufferDynamic SerializePackedMesh( const PackedMesh& mesh )
+{
+	const Bool has_16_bit_indices = ( mesh.vertices.size() <= 0x10000 );
+	const PackedMeshHeader header
+	{
+		.magic = K_PACKED_MESH_MAGIC,
+		.version = K_PACKED_MESH_VERSION,
+		.vertexCount = static_cast< Uint32 >( mesh.vertices.size() ),
+		.indexCount = static_cast< Uint32 >( mesh.indices.size() ),
+		.indexSize = has_16_bit_indices ? 2u : 4u,
+		.boundsCenter = { mesh.boundsCenter.x, mesh.boundsCenter.y, mesh.boundsCenter.z },
+		.boundsExtent = { mesh.boundsExtent.x, mesh.boundsExtent.y, mesh.boundsExtent.z }
+	};
+
+	const size_t vertex_bytes = mesh.vertices.size() * sizeof( PackedMeshVertex );
+	ByteBufferDynamic blob( sizeof( PackedMeshHeader ) + vertex_bytes + mesh.indices.size() * header.indexSize );
+	std::memcpy( blob.data(), &header, sizeof( header ) );
+	std::memcpy( blob.data() + sizeof( header ), mesh.vertices.data(), vertex_bytes );
+
+	AnsiChar* p_indices = blob.data() + sizeof( header ) + vertex_bytes;
+	if( has_16_bit_indices )
+	{
+		for( size_t i = 0; i < mesh.indices.size(); ++i )
+		{
+			const Uint16 index = static_cast< Uint16 >( mesh.indices[ i ] );
+			std::memcpy( p_indices + i * sizeof( Uint16 ), &index, sizeof( Uint16 ) );
+		}
+	}
+	else
+	{
+		std::memcpy( p_indices, mesh.indices.data(), mesh.indices.size() * sizeof( Uint32 ) );
+	}
+
+	return blob;
+}
+
+
+Bool DeserializePackedMesh( const ByteBufferDynamic& blob, PackedMesh& out_mesh )
+{
+	PackedMeshHeader header;
+	if( blob.size() < sizeof( header ) )
+	{
+		return false;
+	}
+	std::memcpy( &header, blob.data(), sizeof( header ) );
+
+	if( header.magic != K_PACKED_MESH_MAGIC || header.version != K_PACKED_MESH_VERSION || ( header.indexSize != 2 && header.indexSize != 4 ) )
+	{
+		return false;
+	}
+
+	const size_t vertex_bytes = static_cast< size_t >( header.vertexCount ) * sizeof( PackedMeshVertex );
+	const size_t index_bytes = static_cast< size_t >( header.indexCount ) * header.indexSize;
+	if( blob.size() != sizeof( header ) + vertex_bytes + index_bytes )
+	{
+		return false;
+	}
+
+	out_mesh.boundsCenter = Vec3( header.boundsCenter[ 0 ], header.boundsCenter[ 1 ], header.boundsCenter[ 2 ] );
+	out_mesh.boundsExtent = Vec3( header.boundsExtent[ 0 ], header.boundsExtent[ 1 ], header.boundsExtent[ 2 ] );
+	out_mesh.vertices.resize( header.vertexCount );
+	std::memcpy( out_mesh.vertices.data(), blob.data() + sizeof( header ), vertex_bytes );
+
+	const AnsiChar* p_indices = blob.data() + sizeof( header ) + vertex_bytes;
+	out_mesh.indices.resize( header.indexCount );
+	if( header.indexSize == 2 )
+	{
+		for( size_t i = 0; i < out_mesh.indices.size(); ++i )
+		{
+			Uint16 index;
+			std::memcpy( &index, p_indices + i * sizeof( Uint16 ), sizeof( Uint16 ) );
+			out_mesh.indices[ i ] = index;
+		}
+	}
+	else
+	{
+		std::memcpy( out_mesh.indices.data(), p_indices, index_bytes );
+	}
+
+	// the indices reach the gpu unchecked, one past the vertices would read out of bounds there
+	const Uint32 vertex_count = header.vertexCount;
+	if( std::any_of( out_mesh.indices.begin(), out_mesh.indices.end(), [vertex_count]( Uint32 index ) { return index >= vertex_count; } ) )
+	{
+		out_mesh = {};
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
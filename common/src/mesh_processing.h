@@ -0,0 +1,122 @@
+#pragma once
+
+#include "assert.h"
+#include "typedefs.h"
+
+#include <span>
+
+// offline mesh processing: import, index and vertex reordering for the post-transform cache and for overdraw,
+// and quantization into the packed vertex layout the renderer reads
+
+struct MeshVertex
+{
+	Vec3 position;
+	Vec3 normal;
+	Vec2 uv;
+};
+
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	// triangle list
+	std::vector<Uint32> indices;
+};
+
+// 16 bytes, half of a MeshVertex
+struct PackedMeshVertex
+{
+	// snorm, relative to the bounds of the mesh. w is unused
+	Int16 position[ 4 ];
+	// snorm, octahedral encoding
+	Int16 normal[ 2 ];
+	// half floats
+	Uint16 uv[ 2 ];
+};
+AZHAL_STATIC_ASSERT( sizeof( PackedMeshVertex ) == 16, "PackedMeshVertex has to stay tightly packed" );
+
+struct PackedMesh
+{
+	// position = packed position * boundsExtent + boundsCenter
+	Vec3 boundsCenter = Vec3( 0.0f );
+	Vec3 boundsExtent = Vec3( 1.0f );
+	std::vector<PackedMeshVertex> vertices;
+	std::vector<Uint32> indices;
+};
+
+// limits of one meshlet, sized so that a mesh shader group of 64 threads emits every vertex in one pass and the
+// primitive indices of a full meshlet stay within 128 bytes per 32 triangles
+constexpr Uint32 K_MESHLET_MAX_VERTICES = 64;
+constexpr Uint32 K_MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet
+{
+	// into MeshletData::vertices
+	Uint32 vertexOffset = 0;
+	// into MeshletData::triangles, and triangle offset into the index buffer of the mesh the meshlets were built from
+	Uint32 triangleOffset = 0;
+	Uint32 vertexCount = 0;
+	Uint32 triangleCount = 0;
+};
+
+// in the space of the decoded positions, see PackedMesh
+struct MeshletBounds
+{
+	Vec3 center = Vec3( 0.0f );
+	Float radius = 0.0f;
+	// average normal. the meshlet faces away from every viewer for which
+	// dot( normalize( center - viewer ), coneAxis ) >= coneCutoff + radius / distance
+	Vec3 coneAxis = Vec3( 0.0f, 0.0f, 1.0f );
+	// 1 when the normals spread too far for the cone to ever cull
+	Float coneCutoff = 1.0f;
+};
+
+struct MeshletData
+{
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletBounds> bounds;
+	// per meshlet, indices into the vertex buffer of the mesh
+	std::vector<Uint32> vertices;
+	// per meshlet, three 8-bit indices into the meshlet's vertices packed as a | b << 8 | c << 16
+	std::vector<Uint32> triangles;
+};
+
+struct MeshProcessingStats
+{
+	Uint32 vertexCount = 0;
+	Uint32 triangleCount = 0;
+	// average cache misses per triangle of a 16 entry fifo, 0.5 is the ideal for regular grids and 3 the worst case
+	Float acmrBefore = 0.0f;
+	Float acmrAfter = 0.0f;
+	Uint64 bytesBefore = 0;
+	Uint64 bytesAfter = 0;
+};
+
+// triangulates polygons as fans and merges identical position/uv/normal triplets. missing normals are generated
+// from the faces. returns false when the file cannot be read or has no triangles
+Bool LoadObjMesh( const AnsiChar* file_path, MeshData& out_mesh );
+
+// tom forsyth's linear-speed vertex cache optimization, reorders the triangles in place
+void OptimizeVertexCache( std::span<Uint32> indices, Uint32 vertex_count );
+
+// splits the cache-optimized triangles into clusters whose cache efficiency stays within threshold of the whole
+// mesh, then orders the clusters so that outward facing ones on the outside of the mesh are drawn first
+void OptimizeOverdraw( std::span<Uint32> indices, std::span<const MeshVertex> vertices, Float threshold = 1.05f );
+
+// reorders the vertices by first use in the index buffer and drops unreferenced ones
+void OptimizeVertexFetch( MeshData& mesh );
+
+Float ComputeAcmr( std::span<const Uint32> indices, Uint32 vertex_count, Uint32 cache_size = 16 );
+
+PackedMesh QuantizeMesh( const MeshData& mesh );
+
+// the whole pipeline: cache, overdraw and fetch optimization followed by quantization
+PackedMesh ProcessMesh( MeshData mesh, MeshProcessingStats* p_stats = nullptr );
+
+// splits the triangles into meshlets in index buffer order, so every meshlet is also one contiguous range of the
+// original index buffer. meant for meshes that went through ProcessMesh, whose order already keeps neighbours together
+MeshletData BuildMeshlets( const PackedMesh& mesh, Uint32 max_vertices = K_MESHLET_MAX_VERTICES, Uint32 max_triangles = K_MESHLET_MAX_TRIANGLES );
+
+// the binary mesh format, indices are stored with 16 bits when the vertex count allows it
+ByteBufferDynamic SerializePackedMesh( const PackedMesh& mesh );
+// returns false for blobs that are not packed meshes of the current version
+Bool DeserializePackedMesh( const ByteBufferDynamic& blob, PackedMesh& out_mesh );
\ No newline at end of file
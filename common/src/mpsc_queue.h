@@ -0,0 +1,88 @@
+#pragma once
+
+#include "assert.h"
+#include "macros.h"
+#include "non_copyable.h"
+#include "typedefs.h"
+
+#include <atomic>
+#include <thread>
+
+// bounded lock-free queue for many producers and one consumer, after Vyukov's bounded mpmc queue. every push gets
+// a ticket and items are popped in ticket order, which lets producers know where their item sits in the stream
+template<typename T, Uint32 CAPACITY>
+class MpscQueue : NonCopyable
+{
+public:
+	AZHAL_STATIC_ASSERT( ( CAPACITY & ( CAPACITY - 1 ) ) == 0, "MpscQueue capacity must be a power of two" );
+
+	MpscQueue()
+	{
+		for( Uint64 i = 0; i < CAPACITY; ++i )
+		{
+			m_cells[ i ].sequence.store( i, std::memory_order_relaxed );
+		}
+	}
+
+	// returns the ticket of the item. yields while the queue is full, which only happens when the consumer falls behind
+	Uint64 Push( const T& value )
+	{
+		Uint64 position = m_enqueuePosition.load( std::memory_order_relaxed );
+		while( true )
+		{
+			Cell& cell = m_cells[ position & K_MASK ];
+			const Uint64 sequence = cell.sequence.load( std::memory_order_acquire );
+			const Int64 difference = static_cast< Int64 >( sequence ) - static_cast< Int64 >( position );
+
+			if( difference == 0 )
+			{
+				if( m_enqueuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+				{
+					cell.value = value;
+					cell.sequence.store( position + 1, std::memory_order_release );
+					return position;
+				}
+			}
+			else if( difference < 0 )
+			{
+				// full
+				std::this_thread::yield();
+				position = m_enqueuePosition.load( std::memory_order_relaxed );
+			}
+			else
+			{
+				position = m_enqueuePosition.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	// consumer only. false when the next ticket has not been pushed yet, even if later tickets already have
+	Bool TryPop( T& out_value, Uint64& out_ticket )
+	{
+		Cell& cell = m_cells[ m_dequeuePosition & K_MASK ];
+		if( cell.sequence.load( std::memory_order_acquire ) != m_dequeuePosition + 1 )
+		{
+			return false;
+		}
+
+		out_value = std::move( cell.value );
+		out_ticket = m_dequeuePosition;
+		cell.sequence.store( m_dequeuePosition + CAPACITY, std::memory_order_release );
+		m_dequeuePosition++;
+
+		return true;
+	}
+
+private:
+	static constexpr Uint64 K_MASK = CAPACITY - 1;
+
+	struct Cell
+	{
+		std::atomic<Uint64> sequence;
+		T value;
+	};
+
+	alignas( 64 ) Cell m_cells[ CAPACITY ];
+	alignas( 64 ) std::atomic<Uint64> m_enqueuePosition = 0;
+	alignas( 64 ) Uint64 m_dequeuePosition = 0;
+};
\ No newline at end of file
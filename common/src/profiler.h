@@ -3,4 +3,27 @@
 // reference for integrating tracy
 // https://luxeengine.com/integrating-tracy-profiler-in-cpp/
 
-#include <Tracy.hpp>
\ No newline at end of file
+#include <Tracy.hpp>
+
+#ifdef TRACY_ENABLE
+
+#define AZHAL_PROFILE_FUNCTION()           ZoneScoped
+#define AZHAL_PROFILE_SCOPE(name)          ZoneScopedN(name)
+#define AZHAL_PROFILE_SCOPE_COLOR(name, color) ZoneScopedNC(name, color)
+#define AZHAL_PROFILE_ZONE_TEXT(text, size) ZoneText(text, size)
+#define AZHAL_PROFILE_FRAME_MARK()         FrameMark
+#define AZHAL_PROFILE_FRAME_MARK_NAMED(name) FrameMarkNamed(name)
+// names the calling thread's track in the profiler
+#define AZHAL_PROFILE_THREAD_NAME(name)    tracy::SetThreadName(name)
+
+#else
+
+#define AZHAL_PROFILE_FUNCTION()
+#define AZHAL_PROFILE_SCOPE(name)
+#define AZHAL_PROFILE_SCOPE_COLOR(name, color)
+#define AZHAL_PROFILE_ZONE_TEXT(text, size)
+#define AZHAL_PROFILE_FRAME_MARK()
+#define AZHAL_PROFILE_FRAME_MARK_NAMED(name)
+#define AZHAL_PROFILE_THREAD_NAME(name)
+
+#endif
\ No newline at end of file
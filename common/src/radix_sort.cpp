@@ -0,0 +1,150 @@
+#include "radix_sort.h"
+
+#include "job_system.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr Uint32 K_DIGIT_BITS = K_RADIX_SORT_DIGIT_BITS;
+	constexpr Uint32 K_DIGIT_COUNT = 1 << K_DIGIT_BITS;
+	constexpr Uint32 K_PASS_COUNT = K_RADIX_SORT_PASS_COUNT;
+
+	using DigitHistogram = RadixDigitHistogram;
+
+	AZHAL_INLINE Uint32 get_digit( Uint64 key, Uint32 pass )
+	{
+		return static_cast< Uint32 >( key >> ( pass * K_DIGIT_BITS ) ) & ( K_DIGIT_COUNT - 1 );
+	}
+}
+
+void RadixSortKeyValues( Uint64* p_keys, Uint32* p_values, Uint64* p_scratch_keys, Uint32* p_scratch_values, Uint32 count, RadixSortHistograms& histograms )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	if( count < 2 )
+	{
+		return;
+	}
+
+	// one chunk per thread keeps the per-chunk histograms small, the scatter of a pass is the expensive part
+	const Uint32 chunk_count = ( count < K_RADIX_SORT_PARALLEL_THRESHOLD ) ? 1 : std::min<Uint32>( JobSystem::GetWorkerCount() + 1, count / 1024 );
+	const Uint32 chunk_size = ( count + chunk_count - 1 ) / chunk_count;
+
+	// every histogram is cleared before it is counted into, so growing them is all the preparation they need
+	if( histograms.chunkTotals.size() < chunk_count )
+	{
+		histograms.chunkTotals.resize( chunk_count );
+		histograms.chunkHistograms.resize( chunk_count );
+	}
+
+	// digit counts do not change with the order of the keys, so every pass's totals come from one read up front
+	std::vector<std::array<DigitHistogram, K_PASS_COUNT>>& chunk_totals = histograms.chunkTotals;
+	JobSystem::ParallelFor( chunk_count, 1, [&]( Uint32 begin, Uint32 end )
+	{
+		for( Uint32 chunk = begin; chunk < end; ++chunk )
+		{
+			std::array<DigitHistogram, K_PASS_COUNT>& totals = chunk_totals[ chunk ];
+			for( DigitHistogram& histogram : totals )
+			{
+				histogram.fill( 0 );
+			}
+
+			const Uint32 key_end = std::min<Uint32>( ( chunk + 1 ) * chunk_size, count );
+			for( Uint32 i = chunk * chunk_size; i < key_end; ++i )
+			{
+				for( Uint32 pass = 0; pass < K_PASS_COUNT; ++pass )
+				{
+					++totals[ pass ][ get_digit( p_keys[ i ], pass ) ];
+				}
+			}
+		}
+	} );
+
+	std::vector<DigitHistogram>& chunk_histograms = histograms.chunkHistograms;
+	Uint64* p_src_keys = p_keys;
+	Uint32* p_src_values = p_values;
+	Uint64* p_dst_keys = p_scratch_keys;
+	Uint32* p_dst_values = p_scratch_values;
+
+	for( Uint32 pass = 0; pass < K_PASS_COUNT; ++pass )
+	{
+		Uint32 digit_totals[ K_DIGIT_COUNT ] = {};
+		for( Uint32 chunk = 0; chunk < chunk_count; ++chunk )
+		{
+			for( Uint32 digit = 0; digit < K_DIGIT_COUNT; ++digit )
+			{
+				digit_totals[ digit ] += chunk_totals[ chunk ][ pass ][ digit ];
+			}
+		}
+
+		// every key has the same digit, the pass would not move anything
+		if( std::ranges::any_of( digit_totals, [count]( Uint32 total ) { return total == count; } ) )
+		{
+			continue;
+		}
+
+		// per-chunk counts of this pass, the chunks hold different keys than when the totals were taken
+		if( chunk_count > 1 )
+		{
+			JobSystem::ParallelFor( chunk_count, 1, [&]( Uint32 begin, Uint32 end )
+			{
+				for( Uint32 chunk = begin; chunk < end; ++chunk )
+				{
+					DigitHistogram& histogram = chunk_histograms[ chunk ];
+					histogram.fill( 0 );
+
+					const Uint32 key_end = std::min<Uint32>( ( chunk + 1 ) * chunk_size, count );
+					for( Uint32 i = chunk * chunk_size; i < key_end; ++i )
+					{
+						++histogram[ get_digit( p_src_keys[ i ], pass ) ];
+					}
+				}
+			} );
+		}
+		else
+		{
+			std::memcpy( chunk_histograms[ 0 ].data(), digit_totals, sizeof( digit_totals ) );
+		}
+
+		// exclusive prefix in digit-major, chunk-minor order: chunk c writes its keys with digit d after every
+		// smaller digit and after the keys of earlier chunks with digit d
+		Uint32 offset = 0;
+		for( Uint32 digit = 0; digit < K_DIGIT_COUNT; ++digit )
+		{
+			for( Uint32 chunk = 0; chunk < chunk_count; ++chunk )
+			{
+				const Uint32 digit_count = chunk_histograms[ chunk ][ digit ];
+				chunk_histograms[ chunk ][ digit ] = offset;
+				offset += digit_count;
+			}
+		}
+
+		JobSystem::ParallelFor( chunk_count, 1, [&]( Uint32 begin, Uint32 end )
+		{
+			for( Uint32 chunk = begin; chunk < end; ++chunk )
+			{
+				DigitHistogram& offsets = chunk_histograms[ chunk ];
+				const Uint32 key_end = std::min<Uint32>( ( chunk + 1 ) * chunk_size, count );
+				for( Uint32 i = chunk * chunk_size; i < key_end; ++i )
+				{
+					const Uint32 dst_index = offsets[ get_digit( p_src_keys[ i ], pass ) ]++;
+					p_dst_keys[ dst_index ] = p_src_keys[ i ];
+					p_dst_values[ dst_index ] = p_src_values[ i ];
+				}
+			}
+		} );
+
+		std::swap( p_src_keys, p_dst_keys );
+		std::swap( p_src_values, p_dst_values );
+	}
+
+	// an odd number of passes leaves the result in the scratch arrays
+	if( p_src_keys != p_keys )
+	{
+		std::memcpy( p_keys, p_src_keys, count * sizeof( Uint64 ) );
+		std::memcpy( p_values, p_src_values, count * sizeof( Uint32 ) );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "macros.h"
+#include "typedefs.h"
+
+#include <array>
+#include <vector>
+
+// below this many keys RadixSortKeyValues runs on the calling thread only
+constexpr Uint32 K_RADIX_SORT_PARALLEL_THRESHOLD = 16 * 1024;
+constexpr Uint32 K_RADIX_SORT_DIGIT_BITS = 8;
+constexpr Uint32 K_RADIX_SORT_PASS_COUNT = 64 / K_RADIX_SORT_DIGIT_BITS;
+
+using RadixDigitHistogram = std::array<Uint32, 1 << K_RADIX_SORT_DIGIT_BITS>;
+
+// the per-chunk digit counts of a sort. they only grow, so a caller that keeps one alive across sorts of similar
+// sizes does not allocate per sort
+struct RadixSortHistograms
+{
+	std::vector<std::array<RadixDigitHistogram, K_RADIX_SORT_PASS_COUNT>> chunkTotals;
+	std::vector<RadixDigitHistogram> chunkHistograms;
+};
+
+// stable least-significant-digit radix sort over 8-bit digits, ascending by key. p_values is permuted along with the
+// keys, e.g. indices of the items the keys were made from. the scratch arrays need count elements each and hold
+// garbage afterwards. digits every key has in common are detected up front and their passes skipped, so keys that
+// only use their top bits cost as many passes as they have distinct bytes. the passes are split across JobSystem
+// workers, each chunk scatters its keys in order, which keeps the sort stable
+void RadixSortKeyValues( Uint64* p_keys, Uint32* p_values, Uint64* p_scratch_keys, Uint32* p_scratch_values, Uint32 count, RadixSortHistograms& histograms );
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "stage_timings.h"
+
+#include "job_system.h"
+#include "log.h"
+
+#include <algorithm>
+
+StageTimings::StageTimings()
+	: m_originTime( Clock::now() )
+{
+}
+
+
+void StageTimings::Record( const AnsiChar* name, Clock::time_point start_time, Clock::time_point end_time )
+{
+	const StageTiming stage
+	{
+		.pName = name,
+		.startMs = std::chrono::duration<Double, std::milli>( start_time - m_originTime ).count(),
+		.durationMs = std::chrono::duration<Double, std::milli>( end_time - start_time ).count(),
+		.threadIndex = JobSystem::GetThreadIndex()
+	};
+
+	std::scoped_lock lock( m_mutex );
+	m_stages.push_back( stage );
+}
+
+
+std::vector<StageTiming> StageTimings::GetStages() const
+{
+	std::vector<StageTiming> stages;
+	{
+		std::scoped_lock lock( m_mutex );
+		stages = m_stages;
+	}
+
+	std::sort( stages.begin(), stages.end(), []( const StageTiming& a, const StageTiming& b ) { return a.startMs < b.startMs; } );
+	return stages;
+}
+
+
+Double StageTimings::GetElapsedMs() const
+{
+	return std::chrono::duration<Double, std::milli>( Clock::now() - m_originTime ).count();
+}
+
+
+void StageTimings::Log( const AnsiChar* title ) const
+{
+	const std::vector<StageTiming> stages = GetStages();
+
+	AZHAL_LOG_INFO( "{0}: {1:.2f} ms since start", title, GetElapsedMs() );
+	for( const StageTiming& stage : stages )
+	{
+		AZHAL_LOG_INFO( "  {0:<32} start {1:>9.2f} ms  duration {2:>9.2f} ms  thread {3}", stage.pName, stage.startMs, stage.durationMs,
+			static_cast< Int64 >( stage.threadIndex == UINT32_MAX ? -1 : stage.threadIndex ) );
+	}
+}
\ No newline at end of file
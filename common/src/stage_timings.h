@@ -0,0 +1,71 @@
+#pragma once
+
+#include "macros.h"
+#include "non_copyable.h"
+#include "typedefs.h"
+
+#include <chrono>
+#include <mutex>
+
+struct StageTiming
+{
+	const AnsiChar* pName = nullptr;
+	// relative to the creation of the StageTimings
+	Double startMs = 0.0;
+	Double durationMs = 0.0;
+	// JobSystem::GetThreadIndex of the thread that ran the stage
+	Uint32 threadIndex = UINT32_MAX;
+};
+
+
+// collects named wall-clock intervals from any thread, used to see which startup stages overlap and which
+// one sits on the critical path. stage names must be string literals
+class StageTimings : NonCopyable
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	StageTimings();
+
+	void Record( const AnsiChar* name, Clock::time_point start_time, Clock::time_point end_time );
+
+	// ordered by start time
+	std::vector<StageTiming> GetStages() const;
+	Double GetElapsedMs() const;
+
+	void Log( const AnsiChar* title ) const;
+
+private:
+	Clock::time_point m_originTime;
+
+	mutable std::mutex m_mutex;
+	std::vector<StageTiming> m_stages;
+};
+
+
+// a null p_timings makes the scope a no-op
+class ScopedStageTiming : NonCopyable
+{
+public:
+	ScopedStageTiming( StageTimings* p_timings, const AnsiChar* name )
+		: m_pTimings( p_timings )
+		, m_pName( name )
+		, m_startTime( StageTimings::Clock::now() )
+	{
+	}
+
+	~ScopedStageTiming()
+	{
+		if( m_pTimings )
+		{
+			m_pTimings->Record( m_pName, m_startTime, StageTimings::Clock::now() );
+		}
+	}
+
+private:
+	StageTimings* m_pTimings;
+	const AnsiChar* m_pName;
+	StageTimings::Clock::time_point m_startTime;
+};
+
+#define AZHAL_STAGE_TIMING_SCOPE(p_timings, name) ScopedStageTiming AZHAL_CONCAT( stage_timing_, __LINE__ )( p_timings, name )
\ No newline at end of file
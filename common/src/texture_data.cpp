@@ -0,0 +1,333 @@
+#include "texture_data.h"
+
+#include "assert.h"
+#include "log.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+	constexpr Uint32 make_four_cc( AnsiChar a, AnsiChar b, AnsiChar c, AnsiChar d )
+	{
+		return static_cast< Uint32 >( a ) | ( static_cast< Uint32 >( b ) << 8 ) | ( static_cast< Uint32 >( c ) << 16 ) | ( static_cast< Uint32 >( d ) << 24 );
+	}
+
+	constexpr Uint32 K_DDS_MAGIC = make_four_cc( 'D', 'D', 'S', ' ' );
+
+	// DDS_PIXELFORMAT::flags
+	constexpr Uint32 K_DDPF_FOURCC = 0x4;
+	constexpr Uint32 K_DDPF_RGB = 0x40;
+	// DDS_HEADER::caps2
+	constexpr Uint32 K_DDSCAPS2_CUBEMAP = 0x200;
+	constexpr Uint32 K_DDSCAPS2_VOLUME = 0x200000;
+	// DDS_HEADER_DXT10::resourceDimension
+	constexpr Uint32 K_DDS_DIMENSION_TEXTURE2D = 3;
+	// DDS_HEADER_DXT10::miscFlag
+	constexpr Uint32 K_DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+	struct DdsPixelFormat
+	{
+		Uint32 size;
+		Uint32 flags;
+		Uint32 fourCC;
+		Uint32 rgbBitCount;
+		Uint32 rBitMask;
+		Uint32 gBitMask;
+		Uint32 bBitMask;
+		Uint32 aBitMask;
+	};
+
+	struct DdsHeader
+	{
+		Uint32 size;
+		Uint32 flags;
+		Uint32 height;
+		Uint32 width;
+		Uint32 pitchOrLinearSize;
+		Uint32 depth;
+		Uint32 mipMapCount;
+		Uint32 reserved1[ 11 ];
+		DdsPixelFormat pixelFormat;
+		Uint32 caps;
+		Uint32 caps2;
+		Uint32 caps3;
+		Uint32 caps4;
+		Uint32 reserved2;
+	};
+	AZHAL_STATIC_ASSERT( sizeof( DdsHeader ) == 124, "DdsHeader has to match the file layout" );
+
+	struct DdsHeaderDx10
+	{
+		Uint32 dxgiFormat;
+		Uint32 resourceDimension;
+		Uint32 miscFlag;
+		Uint32 arraySize;
+		Uint32 miscFlags2;
+	};
+
+	TextureFormat get_legacy_format( const DdsPixelFormat& pixel_format )
+	{
+		if( pixel_format.flags & K_DDPF_FOURCC )
+		{
+			switch( pixel_format.fourCC )
+			{
+			case make_four_cc( 'D', 'X', 'T', '1' ):
+				return TextureFormat::eBc1Unorm;
+			case make_four_cc( 'D', 'X', 'T', '2' ):
+			case make_four_cc( 'D', 'X', 'T', '3' ):
+				return TextureFormat::eBc2Unorm;
+			case make_four_cc( 'D', 'X', 'T', '4' ):
+			case make_four_cc( 'D', 'X', 'T', '5' ):
+				return TextureFormat::eBc3Unorm;
+			case make_four_cc( 'A', 'T', 'I', '1' ):
+			case make_four_cc( 'B', 'C', '4', 'U' ):
+				return TextureFormat::eBc4Unorm;
+			case make_four_cc( 'B', 'C', '4', 'S' ):
+				return TextureFormat::eBc4Snorm;
+			case make_four_cc( 'A', 'T', 'I', '2' ):
+			case make_four_cc( 'B', 'C', '5', 'U' ):
+				return TextureFormat::eBc5Unorm;
+			case make_four_cc( 'B', 'C', '5', 'S' ):
+				return TextureFormat::eBc5Snorm;
+			default:
+				return TextureFormat::eUnknown;
+			}
+		}
+
+		const Bool is_rgba8 = ( pixel_format.flags & K_DDPF_RGB ) && ( pixel_format.rgbBitCount == 32 ) &&
+			( pixel_format.rBitMask == 0x000000ff ) && ( pixel_format.gBitMask == 0x0000ff00 ) && ( pixel_format.bBitMask == 0x00ff0000 );
+		return is_rgba8 ? TextureFormat::eRgba8Unorm : TextureFormat::eUnknown;
+	}
+
+
+	TextureFormat get_dxgi_format( Uint32 dxgi_format )
+	{
+		switch( dxgi_format )
+		{
+		case 28:
+			return TextureFormat::eRgba8Unorm;
+		case 29:
+			return TextureFormat::eRgba8Srgb;
+		case 71:
+			return TextureFormat::eBc1Unorm;
+		case 72:
+			return TextureFormat::eBc1Srgb;
+		case 74:
+			return TextureFormat::eBc2Unorm;
+		case 75:
+			return TextureFormat::eBc2Srgb;
+		case 77:
+			return TextureFormat::eBc3Unorm;
+		case 78:
+			return TextureFormat::eBc3Srgb;
+		case 80:
+			return TextureFormat::eBc4Unorm;
+		case 81:
+			return TextureFormat::eBc4Snorm;
+		case 83:
+			return TextureFormat::eBc5Unorm;
+		case 84:
+			return TextureFormat::eBc5Snorm;
+		case 95:
+			return TextureFormat::eBc6hUfloat;
+		case 96:
+			return TextureFormat::eBc6hSfloat;
+		case 98:
+			return TextureFormat::eBc7Unorm;
+		case 99:
+			return TextureFormat::eBc7Srgb;
+		default:
+			return TextureFormat::eUnknown;
+		}
+	}
+}
+
+Bool IsBlockCompressed( TextureFormat format )
+{
+	return ( format != TextureFormat::eRgba8Unorm ) && ( format != TextureFormat::eRgba8Srgb ) && ( format != TextureFormat::eUnknown );
+}
+
+
+Uint32 GetTextureFormatBlockSize( TextureFormat format )
+{
+	switch( format )
+	{
+	case TextureFormat::eRgba8Unorm:
+	case TextureFormat::eRgba8Srgb:
+		return 4;
+	case TextureFormat::eBc1Unorm:
+	case TextureFormat::eBc1Srgb:
+	case TextureFormat::eBc4Unorm:
+	case TextureFormat::eBc4Snorm:
+		return 8;
+	case TextureFormat::eUnknown:
+		return 0;
+	default:
+		return 16;
+	}
+}
+
+
+const AnsiChar* GetTextureFormatName( TextureFormat format )
+{
+	switch( format )
+	{
+	case TextureFormat::eRgba8Unorm:
+		return "rgba8_unorm";
+	case TextureFormat::eRgba8Srgb:
+		return "rgba8_srgb";
+	case TextureFormat::eBc1Unorm:
+		return "bc1_unorm";
+	case TextureFormat::eBc1Srgb:
+		return "bc1_srgb";
+	case TextureFormat::eBc4Unorm:
+		return "bc4_unorm";
+	case TextureFormat::eBc4Snorm:
+		return "bc4_snorm";
+	case TextureFormat::eBc2Unorm:
+		return "bc2_unorm";
+	case TextureFormat::eBc2Srgb:
+		return "bc2_srgb";
+	case TextureFormat::eBc3Unorm:
+		return "bc3_unorm";
+	case TextureFormat::eBc3Srgb:
+		return "bc3_srgb";
+	case TextureFormat::eBc5Unorm:
+		return "bc5_unorm";
+	case TextureFormat::eBc5Snorm:
+		return "bc5_snorm";
+	case TextureFormat::eBc6hUfloat:
+		return "bc6h_ufloat";
+	case TextureFormat::eBc6hSfloat:
+		return "bc6h_sfloat";
+	case TextureFormat::eBc7Unorm:
+		return "bc7_unorm";
+	case TextureFormat::eBc7Srgb:
+		return "bc7_srgb";
+	default:
+		return "unknown";
+	}
+}
+
+
+Uint64 GetTextureMipSize( TextureFormat format, Uint32 width, Uint32 height )
+{
+	if( !IsBlockCompressed( format ) )
+	{
+		return static_cast< Uint64 >( width ) * height * GetTextureFormatBlockSize( format );
+	}
+
+	// partial blocks at the edges are stored whole
+	const Uint64 block_columns = std::max<Uint32>( ( width + 3 ) / 4, 1 );
+	const Uint64 block_rows = std::max<Uint32>( ( height + 3 ) / 4, 1 );
+	return block_columns * block_rows * GetTextureFormatBlockSize( format );
+}
+
+
+Uint64 GetTextureSize( const TextureData& texture, Uint32 first_mip )
+{
+	Uint64 size = 0;
+	for( Uint32 mip = first_mip; mip < texture.mips.size(); ++mip )
+	{
+		size += texture.mips[ mip ].size;
+	}
+	return size;
+}
+
+
+Bool ParseDdsTexture( const ByteBufferDynamic& blob, TextureData& out_texture )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	Uint64 offset = sizeof( Uint32 ) + sizeof( DdsHeader );
+	Uint32 magic = 0;
+	DdsHeader header;
+	if( blob.size() < offset )
+	{
+		return false;
+	}
+	std::memcpy( &magic, blob.data(), sizeof( magic ) );
+	std::memcpy( &header, blob.data() + sizeof( magic ), sizeof( header ) );
+	if( magic != K_DDS_MAGIC || header.size != sizeof( DdsHeader ) || header.width == 0 || header.height == 0 )
+	{
+		return false;
+	}
+	if( header.width > K_MAX_TEXTURE_EXTENT || header.height > K_MAX_TEXTURE_EXTENT )
+	{
+		AZHAL_LOG_WARN( "dds texture of {0}x{1} exceeds the largest supported extent {2}", header.width, header.height, K_MAX_TEXTURE_EXTENT );
+		return false;
+	}
+	if( header.caps2 & ( K_DDSCAPS2_CUBEMAP | K_DDSCAPS2_VOLUME ) )
+	{
+		AZHAL_LOG_WARN( "dds cube maps and volume textures are not supported" );
+		return false;
+	}
+
+	TextureFormat format = TextureFormat::eUnknown;
+	if( ( header.pixelFormat.flags & K_DDPF_FOURCC ) && header.pixelFormat.fourCC == make_four_cc( 'D', 'X', '1', '0' ) )
+	{
+		DdsHeaderDx10 header_dx10;
+		if( blob.size() < offset + sizeof( header_dx10 ) )
+		{
+			return false;
+		}
+		std::memcpy( &header_dx10, blob.data() + offset, sizeof( header_dx10 ) );
+		offset += sizeof( header_dx10 );
+
+		if( header_dx10.resourceDimension != K_DDS_DIMENSION_TEXTURE2D || header_dx10.arraySize != 1 )
+		{
+			AZHAL_LOG_WARN( "only single 2d dds textures are supported" );
+			return false;
+		}
+		if( header_dx10.miscFlag & K_DDS_RESOURCE_MISC_TEXTURECUBE )
+		{
+			AZHAL_LOG_WARN( "dds cube maps and volume textures are not supported" );
+			return false;
+		}
+		format = get_dxgi_format( header_dx10.dxgiFormat );
+	}
+	else
+	{
+		format = get_legacy_format( header.pixelFormat );
+	}
+
+	if( format == TextureFormat::eUnknown )
+	{
+		AZHAL_LOG_WARN( "unsupported dds pixel format" );
+		return false;
+	}
+
+	TextureData texture
+	{
+		.format = format,
+		.width = header.width,
+		.height = header.height
+	};
+
+	// files without the mip count flag still set the count to 0 or 1
+	const Uint32 max_mip_count = static_cast< Uint32 >( std::bit_width( std::max( header.width, header.height ) ) );
+	const Uint32 mip_count = std::clamp<Uint32>( header.mipMapCount, 1, max_mip_count );
+	const Uint64 data_offset = offset;
+	for( Uint32 mip = 0; mip < mip_count; ++mip )
+	{
+		const Uint32 mip_width = std::max<Uint32>( header.width >> mip, 1 );
+		const Uint32 mip_height = std::max<Uint32>( header.height >> mip, 1 );
+		const Uint64 mip_size = GetTextureMipSize( format, mip_width, mip_height );
+		if( offset + mip_size > blob.size() )
+		{
+			AZHAL_LOG_WARN( "dds file ends inside mip {0}", mip );
+			return false;
+		}
+
+		texture.mips.push_back( TextureMip { .width = mip_width, .height = mip_height, .offset = offset - data_offset, .size = mip_size } );
+		offset += mip_size;
+	}
+
+	texture.data.assign( blob.begin() + data_offset, blob.begin() + offset );
+	out_texture = std::move( texture );
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "typedefs.h"
+
+// texture data as the renderer uploads it: 2d, one layer, mips from largest to smallest in one blob
+
+enum class TextureFormat : Uint32
+{
+	eUnknown = 0,
+	eRgba8Unorm,
+	eRgba8Srgb,
+	// 4x4 blocks of 8 bytes
+	eBc1Unorm,
+	eBc1Srgb,
+	eBc4Unorm,
+	eBc4Snorm,
+	// 4x4 blocks of 16 bytes
+	eBc2Unorm,
+	eBc2Srgb,
+	eBc3Unorm,
+	eBc3Srgb,
+	eBc5Unorm,
+	eBc5Snorm,
+	eBc6hUfloat,
+	eBc6hSfloat,
+	eBc7Unorm,
+	eBc7Srgb
+};
+
+struct TextureMip
+{
+	Uint32 width = 0;
+	Uint32 height = 0;
+	// into TextureData::data
+	Uint64 offset = 0;
+	Uint64 size = 0;
+};
+
+struct TextureData
+{
+	TextureFormat format = TextureFormat::eUnknown;
+	Uint32 width = 0;
+	Uint32 height = 0;
+	// largest first, may stop before 1x1
+	std::vector<TextureMip> mips;
+	ByteBufferDynamic data;
+};
+
+Bool IsBlockCompressed( TextureFormat format );
+// of a 4x4 block for block compressed formats, of a texel otherwise
+Uint32 GetTextureFormatBlockSize( TextureFormat format );
+const AnsiChar* GetTextureFormatName( TextureFormat format );
+
+Uint64 GetTextureMipSize( TextureFormat format, Uint32 width, Uint32 height );
+// mips [first_mip, mips.size()) of the texture
+Uint64 GetTextureSize( const TextureData& texture, Uint32 first_mip = 0 );
+
+// the largest width and height ParseDdsTexture accepts, which also keeps the size computations of any mip far from overflowing
+constexpr Uint32 K_MAX_TEXTURE_EXTENT = 16384;
+
+// 2d DDS files with the legacy DXT1-5, ATI1-2 and BC4-5 four character codes, 32 bit rgba, or a DX10 header with one
+// of the formats above. returns false for anything else, e.g. cube maps, volumes, arrays and textures larger than
+// K_MAX_TEXTURE_EXTENT
+Bool ParseDdsTexture( const ByteBufferDynamic& blob, TextureData& out_texture );
\ No newline at end of file
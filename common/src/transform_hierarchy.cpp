@@ -0,0 +1,425 @@
+#include "transform_hierarchy.h"
+
+#include "assert.h"
+#include "job_system.h"
+#include "log.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+namespace
+{
+	// levels smaller than this are not worth a job
+	constexpr Uint32 K_MIN_PARALLEL_GRAIN_SIZE = 256;
+
+	template<typename T>
+	void permute( std::vector<T>& values, const std::vector<Uint32>& new_to_old, std::vector<T>& scratch )
+	{
+		scratch.resize( new_to_old.size() );
+		for( Uint32 i = 0; i < new_to_old.size(); ++i )
+		{
+			scratch[ i ] = values[ new_to_old[ i ] ];
+		}
+		values.swap( scratch );
+	}
+}
+
+TransformHierarchy::TransformHierarchy( Uint32 gpu_buffer_copy_count )
+	: m_gpuWriteHistory( std::max<Uint32>( gpu_buffer_copy_count, 1 ) - 1 )
+{
+}
+
+
+TransformHandle TransformHierarchy::Create( TransformHandle parent, const Mat4& local, Uint32 gpu_index )
+{
+	const Uint32 parent_index = parent.IsNull() ? K_NO_NODE : GetDenseIndex( parent );
+
+	Uint32 slot_index = m_firstFreeSlot;
+	if( slot_index != K_NO_NODE )
+	{
+		m_firstFreeSlot = m_slots[ slot_index ].denseIndex;
+	}
+	else
+	{
+		slot_index = static_cast< Uint32 >( m_slots.size() );
+		m_slots.emplace_back();
+	}
+
+	const Uint32 dense_index = static_cast< Uint32 >( m_locals.size() );
+	m_slots[ slot_index ].denseIndex = dense_index;
+
+	m_locals.push_back( local );
+	m_worlds.push_back( local );
+	m_parents.push_back( parent_index );
+	m_depths.push_back( ( parent_index == K_NO_NODE ) ? 0 : m_depths[ parent_index ] + 1 );
+	m_firstChildren.push_back( 0 );
+	m_childCounts.push_back( 0 );
+	m_gpuIndices.push_back( gpu_index );
+	m_denseToSlot.push_back( slot_index );
+	m_queuedUpdates.push_back( 0 );
+	m_isMarked.push_back( 0 );
+
+	// appending keeps parents before children, but not the children of a node contiguous
+	m_isOrderDirty = true;
+	MarkDirty( dense_index );
+
+	return TransformHandle { .index = slot_index, .generation = m_slots[ slot_index ].generation };
+}
+
+
+void TransformHierarchy::Destroy( TransformHandle handle )
+{
+	const Uint32 dense_index = GetDenseIndex( handle );
+
+	// the node stays in the dense arrays as a dead entry, the next reorder drops it together with its descendants
+	FreeSlot( handle.index );
+
+	m_denseToSlot[ dense_index ] = K_NO_NODE;
+	m_isOrderDirty = true;
+}
+
+
+Bool TransformHierarchy::SetParent( TransformHandle handle, TransformHandle parent )
+{
+	const Uint32 dense_index = GetDenseIndex( handle );
+	const Uint32 parent_index = parent.IsNull() ? K_NO_NODE : GetDenseIndex( parent );
+
+	for( Uint32 ancestor = parent_index; ancestor != K_NO_NODE; ancestor = m_parents[ ancestor ] )
+	{
+		if( ancestor == dense_index )
+		{
+			AZHAL_LOG_ERROR( "a transform cannot be parented to its own subtree" );
+			return false;
+		}
+	}
+
+	m_parents[ dense_index ] = parent_index;
+	m_isOrderDirty = true;
+	MarkDirty( dense_index );
+	return true;
+}
+
+
+void TransformHierarchy::SetLocal( TransformHandle handle, const Mat4& local )
+{
+	const Uint32 dense_index = GetDenseIndex( handle );
+	m_locals[ dense_index ] = local;
+	MarkDirty( dense_index );
+}
+
+
+void TransformHierarchy::SetGpuIndex( TransformHandle handle, Uint32 gpu_index )
+{
+	const Uint32 dense_index = GetDenseIndex( handle );
+	m_gpuIndices[ dense_index ] = gpu_index;
+	// the new index has never been written
+	MarkDirty( dense_index );
+}
+
+
+const Mat4& TransformHierarchy::GetLocal( TransformHandle handle ) const
+{
+	return m_locals[ GetDenseIndex( handle ) ];
+}
+
+
+const Mat4& TransformHierarchy::GetWorld( TransformHandle handle ) const
+{
+	return m_worlds[ GetDenseIndex( handle ) ];
+}
+
+
+Bool TransformHierarchy::IsValid( TransformHandle handle ) const
+{
+	return !handle.IsNull() && ( handle.index < m_slots.size() ) && ( m_slots[ handle.index ].generation == handle.generation );
+}
+
+
+Uint32 TransformHierarchy::GetDenseIndex( TransformHandle handle ) const
+{
+	AZHAL_ASSERT( IsValid( handle ), "stale or null transform handle" );
+	return m_slots[ handle.index ].denseIndex;
+}
+
+
+void TransformHierarchy::FreeSlot( Uint32 slot_index )
+{
+	Slot& slot = m_slots[ slot_index ];
+	slot.denseIndex = m_firstFreeSlot;
+	slot.generation = ( slot.generation == UINT32_MAX ) ? 1 : ( slot.generation + 1 );
+	m_firstFreeSlot = slot_index;
+}
+
+
+void TransformHierarchy::MarkDirty( Uint32 dense_index )
+{
+	if( !m_isMarked[ dense_index ] )
+	{
+		m_isMarked[ dense_index ] = 1;
+		m_markedNodes.push_back( dense_index );
+	}
+}
+
+
+void TransformHierarchy::ComputeWorld( Uint32 dense_index )
+{
+	const Uint32 parent_index = m_parents[ dense_index ];
+	m_worlds[ dense_index ] = ( parent_index == K_NO_NODE ) ? m_locals[ dense_index ] : m_worlds[ parent_index ] * m_locals[ dense_index ];
+}
+
+
+void TransformHierarchy::Reorder()
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const Uint32 old_count = static_cast< Uint32 >( m_locals.size() );
+
+	// children of every live node in dense order, as one array with offsets
+	std::vector<Uint32> child_offsets( old_count + 1, 0 );
+	for( Uint32 i = 0; i < old_count; ++i )
+	{
+		if( m_denseToSlot[ i ] != K_NO_NODE && m_parents[ i ] != K_NO_NODE )
+		{
+			++child_offsets[ m_parents[ i ] + 1 ];
+		}
+	}
+	for( Uint32 i = 0; i < old_count; ++i )
+	{
+		child_offsets[ i + 1 ] += child_offsets[ i ];
+	}
+	std::vector<Uint32> children( child_offsets[ old_count ] );
+	std::vector<Uint32> fill_offsets( child_offsets.begin(), child_offsets.end() - 1 );
+	for( Uint32 i = 0; i < old_count; ++i )
+	{
+		if( m_denseToSlot[ i ] != K_NO_NODE && m_parents[ i ] != K_NO_NODE )
+		{
+			children[ fill_offsets[ m_parents[ i ] ]++ ] = i;
+		}
+	}
+
+	// breadth first from the live roots: sorted by depth, and every node's children land next to each other.
+	// descendants of destroyed nodes are never reached
+	std::vector<Uint32> new_to_old;
+	new_to_old.reserve( old_count );
+	for( Uint32 i = 0; i < old_count; ++i )
+	{
+		if( m_denseToSlot[ i ] != K_NO_NODE && m_parents[ i ] == K_NO_NODE )
+		{
+			new_to_old.push_back( i );
+		}
+	}
+
+	std::vector<Uint32> first_children( old_count, 0 );
+	for( Uint32 i = 0; i < new_to_old.size(); ++i )
+	{
+		const Uint32 old_index = new_to_old[ i ];
+		first_children[ old_index ] = static_cast< Uint32 >( new_to_old.size() );
+		new_to_old.insert( new_to_old.end(), children.begin() + child_offsets[ old_index ], children.begin() + child_offsets[ old_index + 1 ] );
+	}
+
+	std::vector<Uint32> old_to_new( old_count, K_NO_NODE );
+	for( Uint32 i = 0; i < new_to_old.size(); ++i )
+	{
+		old_to_new[ new_to_old[ i ] ] = i;
+	}
+
+	// live nodes below a destroyed one go with it
+	for( Uint32 i = 0; i < old_count; ++i )
+	{
+		const Uint32 slot_index = m_denseToSlot[ i ];
+		if( slot_index != K_NO_NODE && old_to_new[ i ] == K_NO_NODE )
+		{
+			FreeSlot( slot_index );
+		}
+	}
+
+	std::vector<Mat4> matrix_scratch;
+	permute( m_locals, new_to_old, matrix_scratch );
+	permute( m_worlds, new_to_old, matrix_scratch );
+
+	std::vector<Uint32> index_scratch;
+	permute( m_parents, new_to_old, index_scratch );
+	permute( m_gpuIndices, new_to_old, index_scratch );
+	permute( m_denseToSlot, new_to_old, index_scratch );
+
+	std::vector<Uint8> flag_scratch;
+	permute( m_isMarked, new_to_old, flag_scratch );
+
+	const Uint32 new_count = static_cast< Uint32 >( new_to_old.size() );
+	m_firstChildren.resize( new_count );
+	m_childCounts.resize( new_count );
+	m_depths.resize( new_count );
+	m_queuedUpdates.assign( new_count, 0 );
+	m_levelCount = 0;
+	for( Uint32 i = 0; i < new_count; ++i )
+	{
+		const Uint32 old_index = new_to_old[ i ];
+		m_firstChildren[ i ] = first_children[ old_index ];
+		m_childCounts[ i ] = child_offsets[ old_index + 1 ] - child_offsets[ old_index ];
+
+		if( m_parents[ i ] != K_NO_NODE )
+		{
+			m_parents[ i ] = old_to_new[ m_parents[ i ] ];
+		}
+		// parents come first, their depth is final
+		m_depths[ i ] = ( m_parents[ i ] == K_NO_NODE ) ? 0 : m_depths[ m_parents[ i ] ] + 1;
+		m_levelCount = std::max( m_levelCount, m_depths[ i ] + 1 );
+
+		m_slots[ m_denseToSlot[ i ] ].denseIndex = i;
+	}
+
+	m_markedNodes.clear();
+	for( Uint32 i = 0; i < new_count; ++i )
+	{
+		if( m_isMarked[ i ] )
+		{
+			m_markedNodes.push_back( i );
+		}
+	}
+
+	// the history holds old dense indices, rewrite every drawn node into each buffer copy instead
+	for( std::vector<Uint32>& history : m_gpuWriteHistory )
+	{
+		history.clear();
+	}
+	m_fullGpuWritesRemaining = static_cast< Uint32 >( m_gpuWriteHistory.size() ) + 1;
+
+	m_isOrderDirty = false;
+}
+
+
+TransformUpdateStats TransformHierarchy::Update( Mat4* p_gpu_world_matrices )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	TransformUpdateStats stats;
+	++m_updateIndex;
+
+	if( m_isOrderDirty )
+	{
+		Reorder();
+		stats.wasReordered = true;
+	}
+	stats.nodeCount = GetCount();
+
+	m_markedByDepth.resize( m_levelCount );
+	for( std::vector<Uint32>& marked : m_markedByDepth )
+	{
+		marked.clear();
+	}
+	for( const Uint32 dense_index : m_markedNodes )
+	{
+		m_markedByDepth[ m_depths[ dense_index ] ].push_back( dense_index );
+		m_isMarked[ dense_index ] = 0;
+	}
+	m_markedNodes.clear();
+
+	// the buffer copy of this update was last written gpu_buffer_copy_count updates ago, every entry of the history
+	// changed since then
+	m_olderGpuWrites.clear();
+	for( const std::vector<Uint32>& history : m_gpuWriteHistory )
+	{
+		m_olderGpuWrites.insert( m_olderGpuWrites.end(), history.begin(), history.end() );
+	}
+
+	// the oldest entry of the history ring is replaced by the nodes recomputed below
+	std::vector<Uint32>& updated_nodes = m_gpuWriteHistory.empty() ? m_untrackedUpdates : m_gpuWriteHistory[ m_updateIndex % m_gpuWriteHistory.size() ];
+	updated_nodes.clear();
+
+	const Bool is_full_gpu_write = ( m_fullGpuWritesRemaining > 0 );
+	const auto write_gpu_matrix = [this, p_gpu_world_matrices]( Uint32 dense_index )
+	{
+		if( p_gpu_world_matrices && m_gpuIndices[ dense_index ] != K_TRANSFORM_NO_GPU_INDEX )
+		{
+			p_gpu_world_matrices[ m_gpuIndices[ dense_index ] ] = m_worlds[ dense_index ];
+		}
+	};
+
+	// a level holds the children of everything the previous level recomputed, plus the nodes marked on this level.
+	// the nodes of one level never depend on each other
+	m_level.clear();
+	for( Uint32 depth = 0; depth < m_levelCount; ++depth )
+	{
+		m_nextLevel.clear();
+		for( const Uint32 parent_index : m_level )
+		{
+			for( Uint32 child = m_firstChildren[ parent_index ]; child < m_firstChildren[ parent_index ] + m_childCounts[ parent_index ]; ++child )
+			{
+				m_queuedUpdates[ child ] = m_updateIndex;
+				m_nextLevel.push_back( child );
+			}
+		}
+		for( const Uint32 dense_index : m_markedByDepth[ depth ] )
+		{
+			if( m_queuedUpdates[ dense_index ] != m_updateIndex )
+			{
+				m_queuedUpdates[ dense_index ] = m_updateIndex;
+				m_nextLevel.push_back( dense_index );
+			}
+		}
+		m_level.swap( m_nextLevel );
+
+		if( m_level.empty() )
+		{
+			continue;
+		}
+
+		const Uint32 level_size = static_cast< Uint32 >( m_level.size() );
+		const Uint32 grain_size = std::max( JobSystem::GetDefaultGrainSize( level_size ), K_MIN_PARALLEL_GRAIN_SIZE );
+		JobSystem::ParallelFor( level_size, grain_size, [this, is_full_gpu_write, &write_gpu_matrix]( Uint32 begin, Uint32 end )
+		{
+			for( Uint32 i = begin; i < end; ++i )
+			{
+				ComputeWorld( m_level[ i ] );
+				if( !is_full_gpu_write )
+				{
+					write_gpu_matrix( m_level[ i ] );
+				}
+			}
+		} );
+
+		stats.updatedCount += level_size;
+		updated_nodes.insert( updated_nodes.end(), m_level.begin(), m_level.end() );
+	}
+
+	if( !p_gpu_world_matrices )
+	{
+		return stats;
+	}
+
+	if( is_full_gpu_write )
+	{
+		for( Uint32 i = 0; i < GetCount(); ++i )
+		{
+			write_gpu_matrix( i );
+		}
+		stats.gpuWriteCount = GetCount();
+		--m_fullGpuWritesRemaining;
+		return stats;
+	}
+
+	for( const Uint32 dense_index : m_olderGpuWrites )
+	{
+		write_gpu_matrix( dense_index );
+	}
+	stats.gpuWriteCount = stats.updatedCount + static_cast< Uint32 >( m_olderGpuWrites.size() );
+
+	return stats;
+}
+
+
+void TransformHierarchy::UpdateAll()
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	if( m_isOrderDirty )
+	{
+		Reorder();
+	}
+
+	// parents are stored before their children
+	for( Uint32 i = 0; i < GetCount(); ++i )
+	{
+		ComputeWorld( i );
+	}
+}
\ No newline at end of file
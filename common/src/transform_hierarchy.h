@@ -0,0 +1,114 @@
+#pragma once
+
+#include "handle_pool.h"
+#include "macros.h"
+#include "non_copyable.h"
+#include "typedefs.h"
+
+struct TransformTag;
+using TransformHandle = Handle<TransformTag>;
+
+constexpr Uint32 K_TRANSFORM_NO_GPU_INDEX = UINT32_MAX;
+
+struct TransformUpdateStats
+{
+	Uint32 nodeCount = 0;
+	// world matrices recomputed this update
+	Uint32 updatedCount = 0;
+	// world matrices copied into the gpu buffer, including the catch-up writes of older buffer copies
+	Uint32 gpuWriteCount = 0;
+	Bool wasReordered = false;
+};
+
+// scene transforms as structure-of-arrays sorted by depth: every node comes after its parent, and the children of
+// a node are contiguous on the next level. SetLocal only marks the node, Update then recomputes the world matrices
+// of the marked nodes and their descendants, level by level, with every level split across JobSystem workers.
+// untouched subtrees cost nothing beyond the marked list.
+// structural changes (create, destroy, reparent) are batched, the next Update re-sorts the arrays once
+class TransformHierarchy : NonCopyable
+{
+public:
+	// gpu_buffer_copy_count is how many copies of the gpu matrix buffer rotate, e.g. one per frame in flight. a changed
+	// world matrix is written into the copy Update gets and, over the next updates, into every other copy
+	explicit TransformHierarchy( Uint32 gpu_buffer_copy_count = 1 );
+
+	// a null parent makes a root
+	TransformHandle Create( TransformHandle parent, const Mat4& local = Mat4( 1.0f ), Uint32 gpu_index = K_TRANSFORM_NO_GPU_INDEX );
+	// destroys the whole subtree, the handles of the descendants turn stale with the next Update
+	void Destroy( TransformHandle handle );
+	// rejects a parent inside the node's own subtree, which would make a cycle, and leaves the hierarchy unchanged
+	Bool SetParent( TransformHandle handle, TransformHandle parent );
+
+	void SetLocal( TransformHandle handle, const Mat4& local );
+	// index of the node's world matrix in the gpu buffer, K_TRANSFORM_NO_GPU_INDEX for nodes that are not drawn
+	void SetGpuIndex( TransformHandle handle, Uint32 gpu_index );
+
+	const Mat4& GetLocal( TransformHandle handle ) const;
+	// as of the last Update
+	const Mat4& GetWorld( TransformHandle handle ) const;
+	Bool IsValid( TransformHandle handle ) const;
+
+	// p_gpu_world_matrices is the persistently mapped buffer copy of this frame, indexed by the nodes' gpu indices.
+	// may be null when nothing reads the matrices on the gpu
+	TransformUpdateStats Update( Mat4* p_gpu_world_matrices );
+
+	// recomputes every world matrix, the reference Update has to match
+	void UpdateAll();
+
+	AZHAL_INLINE Uint32 GetCount() const
+	{
+		return static_cast< Uint32 >( m_locals.size() );
+	}
+
+private:
+	static constexpr Uint32 K_NO_NODE = UINT32_MAX;
+
+	struct Slot
+	{
+		// into the dense arrays, or the next free slot while unused
+		Uint32 denseIndex = K_NO_NODE;
+		Uint32 generation = 1;
+	};
+
+	Uint32 GetDenseIndex( TransformHandle handle ) const;
+	// threads the slot onto the free list and bumps its generation, which skips 0 when it wraps like HandlePool's
+	void FreeSlot( Uint32 slot_index );
+	void MarkDirty( Uint32 dense_index );
+	void Reorder();
+	void ComputeWorld( Uint32 dense_index );
+
+	std::vector<Slot> m_slots;
+	Uint32 m_firstFreeSlot = K_NO_NODE;
+
+	// dense, sorted by depth once Reorder ran
+	std::vector<Mat4> m_locals;
+	std::vector<Mat4> m_worlds;
+	std::vector<Uint32> m_parents;
+	std::vector<Uint32> m_depths;
+	std::vector<Uint32> m_firstChildren;
+	std::vector<Uint32> m_childCounts;
+	std::vector<Uint32> m_gpuIndices;
+	std::vector<Uint32> m_denseToSlot;
+	// Update of the last time the node was queued, keeps a node from being queued twice per update
+	std::vector<Uint64> m_queuedUpdates;
+	std::vector<Uint8> m_isMarked;
+
+	// dense indices passed to SetLocal since the last Update
+	std::vector<Uint32> m_markedNodes;
+	Bool m_isOrderDirty = false;
+	Uint32 m_levelCount = 0;
+	Uint64 m_updateIndex = 0;
+
+	// nodes whose world matrix changed in each of the last gpu_buffer_copy_count updates, the older copies still hold
+	// the previous matrices. a reorder invalidates the indices, every drawn node is rewritten then
+	std::vector<std::vector<Uint32>> m_gpuWriteHistory;
+	Uint32 m_fullGpuWritesRemaining = 0;
+
+	// scratch of Update
+	std::vector<std::vector<Uint32>> m_markedByDepth;
+	std::vector<Uint32> m_olderGpuWrites;
+	// stands in for the history ring when there is a single buffer copy
+	std::vector<Uint32> m_untrackedUpdates;
+	std::vector<Uint32> m_level;
+	std::vector<Uint32> m_nextLevel;
+};
\ No newline at end of file
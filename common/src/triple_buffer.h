@@ -0,0 +1,72 @@
+#pragma once
+
+#include "macros.h"
+#include "non_copyable.h"
+#include "typedefs.h"
+
+#include <atomic>
+
+// single producer, single consumer. the producer fills the write buffer and publishes it, the consumer acquires the
+// most recently published one. neither side ever waits on the other: a slow consumer skips packets, a slow producer
+// makes the consumer see the same packet again. buffers are recycled, so the producer must overwrite all of a buffer
+template<typename T>
+class TripleBuffer : NonCopyable
+{
+public:
+	TripleBuffer() = default;
+
+	// producer side
+	AZHAL_INLINE T& GetWriteBuffer()
+	{
+		return m_buffers[ m_writeIndex ];
+	}
+
+	AZHAL_INLINE void Publish()
+	{
+		const Uint32 previous_middle = m_middle.exchange( m_writeIndex | K_NEW_DATA_BIT, std::memory_order_acq_rel );
+		m_writeIndex = previous_middle & K_INDEX_MASK;
+		m_middle.notify_one();
+	}
+
+	// consumer side, returns false and keeps the current read buffer when nothing was published since the last call
+	AZHAL_INLINE Bool Acquire()
+	{
+		if( ( m_middle.load( std::memory_order_relaxed ) & K_NEW_DATA_BIT ) == 0 )
+		{
+			return false;
+		}
+
+		const Uint32 previous_middle = m_middle.exchange( m_readIndex, std::memory_order_acq_rel );
+		m_readIndex = previous_middle & K_INDEX_MASK;
+		return true;
+	}
+
+	// blocks until something is published, for consumers that have nothing to do without a new packet
+	AZHAL_INLINE void WaitAndAcquire()
+	{
+		Uint32 middle = m_middle.load( std::memory_order_relaxed );
+		while( ( middle & K_NEW_DATA_BIT ) == 0 )
+		{
+			m_middle.wait( middle, std::memory_order_relaxed );
+			middle = m_middle.load( std::memory_order_relaxed );
+		}
+
+		Acquire();
+	}
+
+	AZHAL_INLINE const T& GetReadBuffer() const
+	{
+		return m_buffers[ m_readIndex ];
+	}
+
+private:
+	static constexpr Uint32 K_INDEX_MASK = 0x3;
+	static constexpr Uint32 K_NEW_DATA_BIT = 0x4;
+
+	T m_buffers[ 3 ] = {};
+
+	// index of the buffer between the two sides, with K_NEW_DATA_BIT set while the consumer has not taken it
+	alignas( 64 ) std::atomic<Uint32> m_middle = 1;
+	alignas( 64 ) Uint32 m_writeIndex = 0;
+	alignas( 64 ) Uint32 m_readIndex = 2;
+};
\ No newline at end of file
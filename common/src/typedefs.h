@@ -38,6 +38,10 @@ using Vec2 = glm::vec2;
 using Vec3 = glm::vec3;
 using Vec4 = glm::vec4;
 
+// floating point matrix types, column major
+using Mat3 = glm::mat3;
+using Mat4 = glm::mat4;
+
 // unsigned integer vector types
 using Uvec2 = glm::uvec2;
 using Uvec3 = glm::uvec3;
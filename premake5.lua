@@ -77,6 +77,16 @@ project "common"
 			buildoptions { "/Zc:__cplusplus" }
 			defines { "AZHAL_PLATFORM_WINDOWS" }
 
+	-- the culling kernels match their scalar reference bit for bit only while no multiply and add is fused into an fma
+	filter "system:windows"
+			buildoptions { "/fp:precise" }
+
+	filter { "system:windows", "toolset:clang" }
+			buildoptions { "/clang:-ffp-contract=off" }
+
+	filter "system:not windows"
+			buildoptions { "-ffp-contract=off" }
+
 	filter "configurations:Debug"
 		runtime "Debug"
 		symbols "on"
@@ -318,3 +328,91 @@ project "sandbox"
 		{ 
 			"AZHAL_FINAL"
 		}
+
+
+project "azhal_bench"
+	location "temp/build/azhal_bench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	staticruntime "on"
+
+	targetdir ("bin/%{prj.name}/" .. outputdir )
+	objdir ("temp/int/%{prj.name}/" .. outputdir )
+
+	files
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp"
+	}
+
+	includedirs
+	{
+		"%{IncludePaths.vulkan}",
+		"%{IncludePaths.cxxopts}",
+		"%{IncludePaths.glm}",
+		"%{IncludePaths.spdlog}",
+		"%{IncludePaths.tracy}",
+		"%{IncludePaths.imgui}",
+		"%{IncludePaths.common}",
+		"%{IncludePaths.azhal}"
+	}
+
+	links 
+	{ 
+		"azhal"
+	}
+	
+	defines
+	{
+		"GLM_FORCE_RADIANS"
+	}
+	
+	filter "system:windows"
+			systemversion "latest"
+			buildoptions { "/Zc:__cplusplus" }
+			defines 
+			{
+				"AZHAL_PLATFORM_WINDOWS"
+			}
+			
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+		optimize "off"
+		defines
+		{ 
+			"AZHAL_DEBUG",
+			"AZHAL_ENABLE_LOGGING",
+			"TRACY_ENABLE"
+		}			
+		
+	filter "configurations:Release"
+		runtime "Release"
+		symbols "on"
+		optimize "Debug"
+		defines
+		{ 
+			"AZHAL_RELEASE",
+			"AZHAL_ENABLE_LOGGING",
+			"TRACY_ENABLE"
+		}
+		
+	filter "configurations:Profile"
+		runtime "Release"
+		symbols "off"
+		optimize "Full"
+		defines
+		{ 
+			"AZHAL_FINAL",
+			"TRACY_ENABLE"
+		}
+	
+	filter "configurations:Final"
+		runtime "Release"
+		symbols "off"
+		optimize "Full"
+		defines
+		{ 
+			"AZHAL_FINAL"
+		}
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "asset_warmup.h"
+
+#include "gpu_driven_scene.h"
+#include "mesh_scene.h"
+
+namespace
+{
+	struct ShaderDesc
+	{
+		const AnsiChar* pPath;
+		// SandboxFeatureBits
+		Uint32 requiredFeatures = 0;
+	};
+
+	const ShaderDesc K_SHADERS[] =
+	{
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/simple.vspv" ) },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/simple.pspv" ) },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/gpu_driven.vspv" ), .requiredFeatures = eSandboxFeatureGpuDriven },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/cull_instances.cspv" ), .requiredFeatures = eSandboxFeatureGpuDriven },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/build_hiz.cspv" ), .requiredFeatures = eSandboxFeatureGpuDriven },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/mesh.vspv" ), .requiredFeatures = eSandboxFeatureMesh },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/meshlet.aspv" ), .requiredFeatures = eSandboxFeatureMeshlets },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/meshlet.mspv" ), .requiredFeatures = eSandboxFeatureMeshlets },
+		{ .pPath = AZHAL_FILE_PATH( "azhal/shaders/meshlet_cull.cspv" ), .requiredFeatures = eSandboxFeatureMeshlets }
+	};
+
+	constexpr Uint32 K_NO_SHADER = UINT32_MAX;
+
+	// a compute pso when computeShader is set, a mesh shading pso when meshShader is set, a graphics pso otherwise
+	struct PSODesc
+	{
+		Uint32 vertexShader = K_NO_SHADER;
+		Uint32 taskShader = K_NO_SHADER;
+		Uint32 meshShader = K_NO_SHADER;
+		Uint32 fragmentShader = K_NO_SHADER;
+		Uint32 computeShader = K_NO_SHADER;
+		vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+		vk::FrontFace frontFace = vk::FrontFace::eClockwise;
+		// reads PackedMeshVertex through the fixed function vertex fetch
+		Bool hasPackedMeshVertices = false;
+		vk::Format depthAttachmentFormat = vk::Format::eUndefined;
+		Uint32 pushConstantSize = 0;
+		Uint32 storageBufferCount = 0;
+		Uint32 sampledImageCount = 0;
+		Uint32 storageImageCount = 0;
+		// SandboxFeatureBits
+		Uint32 requiredFeatures = 0;
+		// gdevice::DeviceFeatureBits, the pso is skipped on devices without them
+		Uint64 requiredDeviceFeatures = 0;
+	};
+
+	// indexed by SandboxPSO, shaders are indices into K_SHADERS
+	const PSODesc K_PSO_DESCS[] =
+	{
+		{ .vertexShader = 0, .fragmentShader = 1 },
+		{
+			.vertexShader = 2, .fragmentShader = 1, .depthAttachmentFormat = K_GPU_DRIVEN_DEPTH_FORMAT,
+			.pushConstantSize = sizeof( GpuDrawConstants ), .requiredFeatures = eSandboxFeatureGpuDriven
+		},
+		{
+			.vertexShader = 2, .fragmentShader = 1, .cullMode = vk::CullModeFlagBits::eNone, .depthAttachmentFormat = K_GPU_DRIVEN_DEPTH_FORMAT,
+			.pushConstantSize = sizeof( GpuDrawConstants ), .requiredFeatures = eSandboxFeatureGpuDriven
+		},
+		{
+			.computeShader = 3, .pushConstantSize = sizeof( GpuCullConstants ),
+			.storageBufferCount = K_CULL_STORAGE_BUFFER_COUNT, .sampledImageCount = K_CULL_SAMPLED_IMAGE_COUNT, .requiredFeatures = eSandboxFeatureGpuDriven
+		},
+		{
+			.computeShader = 4, .pushConstantSize = sizeof( GpuHizConstants ),
+			.storageBufferCount = K_HIZ_STORAGE_BUFFER_COUNT, .sampledImageCount = K_HIZ_SAMPLED_IMAGE_COUNT, .storageImageCount = K_HIZ_MAX_MIPS, .requiredFeatures = eSandboxFeatureGpuDriven
+		},
+		{
+			.vertexShader = 5, .fragmentShader = 1, .frontFace = vk::FrontFace::eCounterClockwise, .hasPackedMeshVertices = true,
+			.depthAttachmentFormat = K_MESH_SCENE_DEPTH_FORMAT, .pushConstantSize = sizeof( MeshDrawConstants ), .requiredFeatures = eSandboxFeatureMesh
+		},
+		{
+			.taskShader = 6, .meshShader = 7, .fragmentShader = 1, .frontFace = vk::FrontFace::eCounterClockwise, .depthAttachmentFormat = K_MESH_SCENE_DEPTH_FORMAT,
+			.pushConstantSize = sizeof( MeshletDrawConstants ), .requiredFeatures = eSandboxFeatureMeshlets,
+			.requiredDeviceFeatures = gdevice::eDeviceFeatureMeshShader | gdevice::eDeviceFeatureBufferDeviceAddress | gdevice::eDeviceFeatureShaderInt64
+		},
+		{
+			.computeShader = 8, .pushConstantSize = sizeof( MeshletCullConstants ),
+			.storageBufferCount = K_MESHLET_CULL_STORAGE_BUFFER_COUNT, .requiredFeatures = eSandboxFeatureMeshlets
+		},
+		{ .vertexShader = 0, .fragmentShader = 1, .cullMode = vk::CullModeFlagBits::eNone, .requiredFeatures = eSandboxFeatureRenderQueue }
+	};
+	AZHAL_STATIC_ASSERT( std::size( K_PSO_DESCS ) == static_cast< size_t >( SandboxPSO::eCount ), "every SandboxPSO needs a description" );
+
+
+	gdevice::PSOHandle create_sandbox_pso( gdevice::Context& gctx, const AssetPreload& preload, const PSODesc& pso_desc, vk::PipelineCache pipeline_cache, vk::Format color_format )
+	{
+		if( pso_desc.computeShader != K_NO_SHADER )
+		{
+			const gdevice::ComputePSOCreationParams compute_pso_creation_params
+			{
+				.pComputeShader = K_SHADERS[ pso_desc.computeShader ].pPath,
+				.pipelineCache = pipeline_cache,
+				.pushConstantSize = pso_desc.pushConstantSize,
+				.storageBufferCount = pso_desc.storageBufferCount,
+				.sampledImageCount = pso_desc.sampledImageCount,
+				.storageImageCount = pso_desc.storageImageCount,
+				.pComputeShaderCode = &preload.shaderCode[ pso_desc.computeShader ]
+			};
+			return gdevice::create_compute_pso( gctx, compute_pso_creation_params );
+		}
+
+		// K_NO_SHADER maps to null, which create_pso skips
+		const auto get_shader_path = []( Uint32 shader ) { return ( shader != K_NO_SHADER ) ? K_SHADERS[ shader ].pPath : nullptr; };
+		const auto get_shader_code = [&preload]( Uint32 shader ) { return ( shader != K_NO_SHADER ) ? &preload.shaderCode[ shader ] : nullptr; };
+
+		const gdevice::PSOCreationParams pso_creation_params
+		{
+			.pVertexShader = get_shader_path( pso_desc.vertexShader ),
+			.pFragmentShader = get_shader_path( pso_desc.fragmentShader ),
+			.isDynamicRendering = VK_TRUE,
+			.colorAttachmentFormats = { color_format },
+			.pipelineCache = pipeline_cache,
+			.pVertexShaderCode = get_shader_code( pso_desc.vertexShader ),
+			.pFragmentShaderCode = get_shader_code( pso_desc.fragmentShader ),
+			.pTaskShader = get_shader_path( pso_desc.taskShader ),
+			.pMeshShader = get_shader_path( pso_desc.meshShader ),
+			.pTaskShaderCode = get_shader_code( pso_desc.taskShader ),
+			.pMeshShaderCode = get_shader_code( pso_desc.meshShader ),
+			.pushConstantSize = pso_desc.pushConstantSize,
+			.cullMode = pso_desc.cullMode,
+			.frontFace = pso_desc.frontFace,
+			.vertexLayout = pso_desc.hasPackedMeshVertices ? gdevice::get_packed_mesh_vertex_layout() : gdevice::VertexLayout {},
+			.depthAttachmentFormat = pso_desc.depthAttachmentFormat
+		};
+		return gdevice::create_pso( gctx, pso_creation_params );
+	}
+}
+
+void begin_asset_preload( AssetPreload& preload, const String& pipeline_cache_path, Uint32 features, const String& mesh_path, StageTimings* p_timings )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	preload.pipelineCachePath = pipeline_cache_path;
+	preload.features = features;
+	preload.meshPath = mesh_path;
+	preload.shaderCode.resize( std::size( K_SHADERS ) );
+
+	if( !preload.pipelineCachePath.empty() )
+	{
+		JobSystem::Run( [&preload, p_timings]()
+		{
+			AZHAL_PROFILE_SCOPE( "load_pipeline_cache" );
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "assets/pipeline_cache_load" );
+			preload.pipelineCacheData = TryLoadBinaryBlob( preload.pipelineCachePath.c_str() );
+		}, &preload.counter );
+	}
+
+	for( Uint32 i = 0; i < std::size( K_SHADERS ); ++i )
+	{
+		if( ( K_SHADERS[ i ].requiredFeatures & features ) != K_SHADERS[ i ].requiredFeatures )
+		{
+			continue;
+		}
+
+		JobSystem::Run( [&preload, p_timings, i]()
+		{
+			AZHAL_PROFILE_SCOPE( "load_shader" );
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "assets/shader_load" );
+			// a missing binary is reported by wait_for_asset_preload, not asserted on a job thread
+			preload.shaderCode[ i ] = TryLoadBinaryBlob( K_SHADERS[ i ].pPath );
+		}, &preload.counter );
+	}
+
+	if( features & eSandboxFeatureMesh )
+	{
+		JobSystem::Run( [&preload, p_timings]()
+		{
+			AZHAL_PROFILE_SCOPE( "load_mesh" );
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "assets/mesh_load" );
+			if( !load_sandbox_mesh( preload.meshPath, preload.mesh ) )
+			{
+				preload.mesh = {};
+			}
+		}, &preload.counter );
+	}
+}
+
+
+Bool load_sandbox_mesh( const String& mesh_path, PackedMesh& out_mesh, MeshProcessingStats* p_stats )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	if( mesh_path.ends_with( ".obj" ) )
+	{
+		MeshData mesh_data;
+		if( !LoadObjMesh( mesh_path.c_str(), mesh_data ) )
+		{
+			return false;
+		}
+
+		out_mesh = ProcessMesh( std::move( mesh_data ), p_stats );
+		return true;
+	}
+
+	const ByteBufferDynamic blob = TryLoadBinaryBlob( mesh_path.c_str() );
+	if( !DeserializePackedMesh( blob, out_mesh ) )
+	{
+		AZHAL_LOG_ERROR( "{0} is not a packed mesh", mesh_path );
+		return false;
+	}
+	return true;
+}
+
+
+Bool wait_for_asset_preload( AssetPreload& preload, StageTimings* p_timings )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	{
+		AZHAL_STAGE_TIMING_SCOPE( p_timings, "assets/wait_for_preload" );
+		JobSystem::Wait( preload.counter );
+	}
+
+	// only simple.vspv and simple.pspv are checked in, the others have to be compiled from azhal/shaders/src first
+	Bool are_shaders_loaded = true;
+	for( Uint32 i = 0; i < std::size( K_SHADERS ); ++i )
+	{
+		if( ( K_SHADERS[ i ].requiredFeatures & preload.features ) == K_SHADERS[ i ].requiredFeatures && preload.shaderCode[ i ].empty() )
+		{
+			AZHAL_LOG_ALWAYS_ENABLED( "shader binary {0} is missing or empty, compile the shaders with azhal/shaders/bat_compile_shaders.bat", K_SHADERS[ i ].pPath );
+			are_shaders_loaded = false;
+		}
+	}
+
+	return are_shaders_loaded;
+}
+
+
+WarmAssets finish_asset_warmup( gdevice::Context& gctx, AssetPreload& preload, StageTimings* p_timings )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	AZHAL_FATAL_ASSERT( preload.counter.IsDone(), "wait_for_asset_preload has to succeed before the warm-up" );
+
+	WarmAssets warm_assets;
+	{
+		AZHAL_STAGE_TIMING_SCOPE( p_timings, "assets/pipeline_cache_create" );
+		warm_assets.pipelineCache = gdevice::create_pipeline_cache( gctx, preload.pipelineCacheData );
+	}
+	AZHAL_LOG_INFO( "pipeline cache: {0} bytes loaded from disk", preload.pipelineCacheData.size() );
+
+	const vk::Format color_format = gdevice::get_swapchain( gctx ).imageFormat;
+	const gdevice::DeviceCapabilities& device_capabilities = gdevice::get_device_capabilities( gctx );
+
+	// create_pso only touches the device and the internally synchronized pipeline cache, so every pso gets its own job
+	AZHAL_STAGE_TIMING_SCOPE( p_timings, "assets/pso_compile" );
+	warm_assets.mesh = std::move( preload.mesh );
+	warm_assets.psos.resize( std::size( K_PSO_DESCS ) );
+	JobSystem::ParallelFor( static_cast< Uint32 >( std::size( K_PSO_DESCS ) ), 1, [&]( Uint32 begin, Uint32 end )
+	{
+		for( Uint32 i = begin; i < end; ++i )
+		{
+			AZHAL_STAGE_TIMING_SCOPE( p_timings, "assets/pso" );
+
+			const PSODesc& pso_desc = K_PSO_DESCS[ i ];
+			if( ( pso_desc.requiredFeatures & preload.features ) != pso_desc.requiredFeatures ||
+				!gdevice::is_device_feature_enabled( device_capabilities, pso_desc.requiredDeviceFeatures ) )
+			{
+				continue;
+			}
+
+			warm_assets.psos[ i ] = create_sandbox_pso( gctx, preload, pso_desc, warm_assets.pipelineCache, color_format );
+		}
+	} );
+
+	return warm_assets;
+}
+
+
+void destroy_warm_assets( gdevice::Context& gctx, const AssetPreload& preload, WarmAssets& warm_assets )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	for( gdevice::PSOHandle pso_handle : warm_assets.psos )
+	{
+		if( !pso_handle.IsNull() )
+		{
+			gdevice::destroy_pso( gctx, pso_handle );
+		}
+	}
+	warm_assets.psos.clear();
+
+	if( !preload.pipelineCachePath.empty() )
+	{
+		const ByteBufferDynamic cache_data = gdevice::get_pipeline_cache_data( gctx, warm_assets.pipelineCache );
+		if( !SaveBinaryBlob( preload.pipelineCachePath.c_str(), cache_data ) )
+		{
+			AZHAL_LOG_WARN( "failed to write the pipeline cache to {0}", preload.pipelineCachePath );
+		}
+	}
+
+	gdevice::destroy_pipeline_cache( gctx, warm_assets.pipelineCache );
+	warm_assets.pipelineCache = VK_NULL_HANDLE;
+}
\ No newline at end of file
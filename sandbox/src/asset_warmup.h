@@ -0,0 +1,77 @@
+#pragma once
+
+#include "common.h"
+#include "azhal_renderer.h"
+
+// optional parts of the sandbox, their files are only loaded and their psos only compiled when enabled
+enum SandboxFeatureBits : Uint32
+{
+	eSandboxFeatureGpuDriven = 1 << 0,
+	eSandboxFeatureMesh = 1 << 1,
+	// the meshlet render paths of the mesh scene, needs eSandboxFeatureMesh
+	eSandboxFeatureMeshlets = 1 << 2,
+	// the synthetic scene recorded through a sorted gdevice::RenderQueue
+	eSandboxFeatureRenderQueue = 1 << 3
+};
+
+// the psos the sandbox renders with, compiled during startup so that the first frame does not stall on them
+enum class SandboxPSO : Uint32
+{
+	eSimple = 0,
+	// only created when their SandboxFeatureBits are enabled and the device supports them, null otherwise
+	eGpuDrivenOpaque = 1,
+	eGpuDrivenTwoSided = 2,
+	eCullInstances = 3,
+	eBuildHiz = 4,
+	eMesh = 5,
+	eMeshlet = 6,
+	eCullMeshlets = 7,
+	eSimpleTwoSided = 8,
+
+	eCount
+};
+
+// file reads that do not need a device, started before the window and device exist
+struct AssetPreload : NonCopyable
+{
+	JobCounter counter;
+
+	String pipelineCachePath;
+	// SandboxFeatureBits
+	Uint32 features = 0;
+	ByteBufferDynamic pipelineCacheData;
+	std::vector<ByteBufferDynamic> shaderCode;
+
+	String meshPath;
+	// empty when the mesh failed to load
+	PackedMesh mesh;
+};
+
+struct WarmAssets
+{
+	vk::PipelineCache pipelineCache;
+	std::vector<gdevice::PSOHandle> psos;
+	// handed over from the preload, empty without eSandboxFeatureMesh
+	PackedMesh mesh;
+};
+
+// an empty pipeline_cache_path disables the on-disk pipeline cache. mesh_path is loaded with eSandboxFeatureMesh, see load_sandbox_mesh
+void begin_asset_preload( AssetPreload& preload, const String& pipeline_cache_path, Uint32 features, const String& mesh_path, StageTimings* p_timings );
+
+// waits for the preload, returns false when a shader binary an enabled feature needs could not be read. the missing
+// files are logged
+Bool wait_for_asset_preload( AssetPreload& preload, StageTimings* p_timings );
+
+// compiles every SandboxPSO in parallel through one shared pipeline cache, wait_for_asset_preload must have succeeded
+WarmAssets finish_asset_warmup( gdevice::Context& gctx, AssetPreload& preload, StageTimings* p_timings );
+
+// .obj files are imported and run through ProcessMesh, anything else is read as a serialized PackedMesh
+Bool load_sandbox_mesh( const String& mesh_path, PackedMesh& out_mesh, MeshProcessingStats* p_stats = nullptr );
+
+// writes the pipeline cache back to disk so that the next start compiles from it
+void destroy_warm_assets( gdevice::Context& gctx, const AssetPreload& preload, WarmAssets& warm_assets );
+
+AZHAL_INLINE gdevice::PSOHandle get_pso( const WarmAssets& warm_assets, SandboxPSO pso )
+{
+	return warm_assets.psos[ static_cast< Uint32 >( pso ) ];
+}
\ No newline at end of file
@@ -0,0 +1,1022 @@
+#include "benchmark.h"
+
+#include "gpu_driven_scene.h"
+#include "mesh_scene.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// begin_frame keeps failing while the swapchain cannot be recreated, e.g. while the window is minimized. the
+	// benchmarks wait between attempts and give up after a few seconds instead of spinning
+	constexpr Uint32 K_MAX_FAILED_BEGIN_FRAMES = 500;
+	constexpr std::chrono::milliseconds K_BEGIN_FRAME_RETRY_WAIT( 10 );
+
+	struct FrameTimeSummary
+	{
+		Uint64 sampleCount = 0;
+		Double averageMs = 0.0;
+		Double p50Ms = 0.0;
+		Double p95Ms = 0.0;
+		Double p99Ms = 0.0;
+		Double maxMs = 0.0;
+	};
+
+	// nearest-rank percentile, samples must be sorted
+	Double get_percentile( const std::vector<Double>& sorted_samples, Double percentile )
+	{
+		const size_t rank = static_cast< size_t >( std::ceil( percentile / 100.0 * static_cast< Double >( sorted_samples.size() ) ) );
+		return sorted_samples[ std::clamp<size_t>( rank, 1, sorted_samples.size() ) - 1 ];
+	}
+
+
+	FrameTimeSummary summarize_frame_times( std::vector<Double> samples )
+	{
+		FrameTimeSummary summary;
+		if( samples.empty() )
+		{
+			return summary;
+		}
+
+		std::sort( samples.begin(), samples.end() );
+
+		Double sum = 0.0;
+		for( const Double sample : samples )
+		{
+			sum += sample;
+		}
+
+		summary.sampleCount = samples.size();
+		summary.averageMs = sum / static_cast< Double >( samples.size() );
+		summary.p50Ms = get_percentile( samples, 50.0 );
+		summary.p95Ms = get_percentile( samples, 95.0 );
+		summary.p99Ms = get_percentile( samples, 99.0 );
+		summary.maxMs = samples.back();
+
+		return summary;
+	}
+
+
+	void write_summary_json( std::ostream& stream, const AnsiChar* name, const FrameTimeSummary& summary )
+	{
+		stream << "    \"" << name << "\": { \"samples\": " << summary.sampleCount
+			<< ", \"avg_ms\": " << summary.averageMs
+			<< ", \"p50_ms\": " << summary.p50Ms
+			<< ", \"p95_ms\": " << summary.p95Ms
+			<< ", \"p99_ms\": " << summary.p99Ms
+			<< ", \"max_ms\": " << summary.maxMs << " }";
+	}
+
+
+	// the fields only, the caller opens and closes the object
+	void write_render_queue_stats_json( std::ostream& stream, const gdevice::RenderQueueStats& stats )
+	{
+		stream << "\"draws\": " << stats.drawCount
+			<< ", \"pso_binds\": " << stats.psoBinds
+			<< ", \"pso_binds_skipped\": " << stats.psoBindsSkipped
+			<< ", \"descriptor_set_binds\": " << stats.descriptorSetBinds
+			<< ", \"descriptor_set_binds_skipped\": " << stats.descriptorSetBindsSkipped
+			<< ", \"mesh_binds\": " << stats.meshBinds
+			<< ", \"mesh_binds_skipped\": " << stats.meshBindsSkipped
+			<< ", \"viewport_sets\": " << stats.viewportSets
+			<< ", \"viewport_sets_skipped\": " << stats.viewportSetsSkipped;
+	}
+
+
+	// record_ms is the cpu time spent filling, sorting and recording the queue per measured frame
+	void write_render_queue_json( std::ostream& stream, const AnsiChar* name, const gdevice::RenderQueueStats& stats, Double record_ms, Double gpu_ms )
+	{
+		stream << "    \"" << name << "\": { ";
+		write_render_queue_stats_json( stream, stats );
+		stream << ", \"cpu_record_avg_ms\": " << record_ms
+			<< ", \"gpu_avg_ms\": " << gpu_ms << " }";
+	}
+
+
+	// lays the draws out on a grid of viewports so that every draw touches its own pixels
+	void record_synthetic_scene( const gdevice::Frame& frame, gdevice::PSOHandle pso_handle, Uint32 draw_count )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const vk::CommandBuffer cmd_buffer = frame.cmdBuffer;
+
+		const vk::RenderingAttachmentInfo color_attachment_info
+		{
+			.imageView = frame.swapchainImageView,
+			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = vk::ClearValue { .color = vk::ClearColorValue { std::array<Float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } } }
+		};
+
+		const vk::RenderingInfo rendering_info
+		{
+			.renderArea = { .offset = { 0, 0 }, .extent = frame.swapchainExtent },
+			.layerCount = 1,
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &color_attachment_info
+		};
+
+		cmd_buffer.beginRendering( rendering_info );
+		gdevice::bind_pso( cmd_buffer, pso_handle );
+
+		const Uint32 grid_columns = std::max<Uint32>( static_cast< Uint32 >( std::ceil( std::sqrt( static_cast< Double >( draw_count ) ) ) ), 1 );
+		const Uint32 grid_rows = std::max<Uint32>( ( draw_count + grid_columns - 1 ) / grid_columns, 1 );
+		const Float cell_width = static_cast< Float >( frame.swapchainExtent.width ) / static_cast< Float >( grid_columns );
+		const Float cell_height = static_cast< Float >( frame.swapchainExtent.height ) / static_cast< Float >( grid_rows );
+
+		for( Uint32 i = 0; i < draw_count; ++i )
+		{
+			const Float x = static_cast< Float >( i % grid_columns ) * cell_width;
+			const Float y = static_cast< Float >( i / grid_columns ) * cell_height;
+
+			const vk::Viewport viewport
+			{
+				.x = x,
+				.y = y,
+				.width = cell_width,
+				.height = cell_height,
+				.minDepth = 0.0f,
+				.maxDepth = 1.0f
+			};
+			const vk::Rect2D scissor
+			{
+				.offset = { static_cast< Int32 >( x ), static_cast< Int32 >( y ) },
+				.extent = { std::max<Uint32>( static_cast< Uint32 >( cell_width ), 1 ), std::max<Uint32>( static_cast< Uint32 >( cell_height ), 1 ) }
+			};
+
+			cmd_buffer.setViewport( 0, viewport );
+			cmd_buffer.setScissor( 0, scissor );
+			cmd_buffer.draw( 3, 1, 0, 0 );
+		}
+
+		cmd_buffer.endRendering();
+	}
+
+
+	// the synthetic scene submitted in the worst order for state changes: every draw switches pso. runs of
+	// K_DRAWS_PER_VIEWPORT draws share a viewport, so the queue also has viewport sets to skip in either order
+	void record_render_queue_synthetic_scene( const gdevice::Frame& frame, const std::array<gdevice::PSOHandle, 2>& pso_handles, Uint32 draw_count,
+		gdevice::RenderQueueOrder order, gdevice::RenderQueue& render_queue )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		constexpr Uint32 K_DRAWS_PER_VIEWPORT = 4;
+
+		const vk::CommandBuffer cmd_buffer = frame.cmdBuffer;
+
+		gdevice::reset_render_queue( render_queue );
+
+		const Uint32 viewport_count = ( draw_count + K_DRAWS_PER_VIEWPORT - 1 ) / K_DRAWS_PER_VIEWPORT;
+		const Uint32 grid_columns = std::max<Uint32>( static_cast< Uint32 >( std::ceil( std::sqrt( static_cast< Double >( viewport_count ) ) ) ), 1 );
+		const Uint32 grid_rows = std::max<Uint32>( ( viewport_count + grid_columns - 1 ) / grid_columns, 1 );
+		const Float cell_width = static_cast< Float >( frame.swapchainExtent.width ) / static_cast< Float >( grid_columns );
+		const Float cell_height = static_cast< Float >( frame.swapchainExtent.height ) / static_cast< Float >( grid_rows );
+
+		for( Uint32 i = 0; i < draw_count; ++i )
+		{
+			const gdevice::PSOHandle pso_handle = pso_handles[ i % pso_handles.size() ];
+			const Uint32 cell = i / K_DRAWS_PER_VIEWPORT;
+			const gdevice::RenderItem item
+			{
+				.pso = pso_handle,
+				.vertexCount = 3,
+				.viewport = vk::Viewport
+				{
+					.x = static_cast< Float >( cell % grid_columns ) * cell_width,
+					.y = static_cast< Float >( cell / grid_columns ) * cell_height,
+					.width = cell_width,
+					.height = cell_height,
+					.minDepth = 0.0f,
+					.maxDepth = 1.0f
+				}
+			};
+			// the draw index as depth keeps the grid order within a pso
+			gdevice::submit_render_item( render_queue, gdevice::make_render_key( 0, pso_handle, 0, static_cast< Float >( i ) ), item );
+		}
+
+		gdevice::sort_render_queue( render_queue, order );
+
+		const vk::RenderingAttachmentInfo color_attachment_info
+		{
+			.imageView = frame.swapchainImageView,
+			.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = vk::ClearValue { .color = vk::ClearColorValue { std::array<Float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } } }
+		};
+
+		const vk::RenderingInfo rendering_info
+		{
+			.renderArea = { .offset = { 0, 0 }, .extent = frame.swapchainExtent },
+			.layerCount = 1,
+			.colorAttachmentCount = 1,
+			.pColorAttachments = &color_attachment_info
+		};
+
+		cmd_buffer.beginRendering( rendering_info );
+		gdevice::record_render_queue( render_queue, cmd_buffer, 0 );
+		cmd_buffer.endRendering();
+	}
+
+
+	// a camera circling low over the instance grid, so that a good part of the instances is outside the frustum or hidden
+	void record_gpu_driven_scene( const gdevice::Frame& frame, GpuDrivenScene& scene )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const Float grid_extent = std::sqrt( static_cast< Float >( scene.GetInstanceCount() ) ) * 3.0f;
+		const Float angle = static_cast< Float >( frame.frameIndex ) * 0.005f;
+		const CameraPacket camera
+		{
+			.position = Vec3( std::cos( angle ), 0.0f, std::sin( angle ) ) * ( grid_extent * 0.35f ) + Vec3( 0.0f, 2.5f, 0.0f ),
+			.target = Vec3( 0.0f, 1.0f, 0.0f ),
+			.farPlane = grid_extent * 2.0f
+		};
+
+		scene.Record( frame, compute_view_projection( camera, frame.swapchainExtent ) );
+	}
+
+
+	// a camera circling above the mesh grid
+	void record_mesh_scene( const gdevice::Frame& frame, MeshScene& scene )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		const Float grid_extent = scene.GetGridExtent();
+		const Float angle = static_cast< Float >( frame.frameIndex ) * 0.005f;
+		const CameraPacket camera
+		{
+			.position = Vec3( std::cos( angle ), 0.6f, std::sin( angle ) ) * grid_extent,
+			.target = Vec3( 0.0f ),
+			.farPlane = grid_extent * 4.0f
+		};
+
+		scene.Record( frame, compute_view_projection( camera, frame.swapchainExtent ), camera.position );
+	}
+
+
+	// false once the attempts ran out, the caller ends its frame loop then
+	Bool wait_for_begin_frame_retry( Uint32& failed_begin_frames )
+	{
+		if( ++failed_begin_frames >= K_MAX_FAILED_BEGIN_FRAMES )
+		{
+			AZHAL_LOG_ERROR( "no frame could begin in {0} attempts, the window may be minimized or have no area", K_MAX_FAILED_BEGIN_FRAMES );
+			return false;
+		}
+
+		std::this_thread::sleep_for( K_BEGIN_FRAME_RETRY_WAIT );
+		return true;
+	}
+
+
+	const AnsiChar* get_mesh_render_path_name( MeshRenderPath render_path )
+	{
+		switch( render_path )
+		{
+		case MeshRenderPath::eMeshShader:
+			return "mesh_shader";
+		case MeshRenderPath::eComputeExpansion:
+			return "compute_expansion";
+		case MeshRenderPath::eVertex:
+		default:
+			return "vertex";
+		}
+	}
+
+
+	Mat4 make_random_local( std::mt19937& random_engine )
+	{
+		std::uniform_real_distribution<Float> offset_distribution( -4.0f, 4.0f );
+		std::uniform_real_distribution<Float> angle_distribution( 0.0f, glm::two_pi<Float>() );
+		const Vec3 offset( offset_distribution( random_engine ), offset_distribution( random_engine ), offset_distribution( random_engine ) );
+		return glm::rotate( glm::translate( Mat4( 1.0f ), offset ), angle_distribution( random_engine ), Vec3( 0.0f, 1.0f, 0.0f ) );
+	}
+
+
+	// what the transform check expects a node to be, kept next to the hierarchy
+	struct ReferenceTransform
+	{
+		TransformHandle handle;
+		// into the reference nodes, UINT32_MAX for roots
+		Uint32 parent = UINT32_MAX;
+		Mat4 local = Mat4( 1.0f );
+		Bool isLive = true;
+	};
+
+
+	// the definition the hierarchy has to reproduce, walked recursively without any ordering or caching
+	Mat4 get_reference_world( const std::vector<ReferenceTransform>& nodes, Uint32 node )
+	{
+		const ReferenceTransform& transform = nodes[ node ];
+		return ( transform.parent == UINT32_MAX ) ? transform.local : get_reference_world( nodes, transform.parent ) * transform.local;
+	}
+
+
+	Bool is_in_reference_subtree( const std::vector<ReferenceTransform>& nodes, Uint32 node, Uint32 subtree_root )
+	{
+		for( Uint32 ancestor = node; ancestor != UINT32_MAX; ancestor = nodes[ ancestor ].parent )
+		{
+			if( ancestor == subtree_root )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+	Uint32 get_random_live_node( const std::vector<ReferenceTransform>& nodes, std::mt19937& random_engine )
+	{
+		Uint32 node = 0;
+		do
+		{
+			node = random_engine() % static_cast< Uint32 >( nodes.size() );
+		} while( !nodes[ node ].isLive );
+		return node;
+	}
+
+
+	// every live node has to have its reference world matrix and every destroyed one a stale handle
+	Bool is_matching_reference( const TransformHierarchy& hierarchy, const std::vector<ReferenceTransform>& nodes )
+	{
+		Bool is_matching = true;
+		Uint32 live_count = 0;
+		for( Uint32 i = 0; i < nodes.size(); ++i )
+		{
+			const ReferenceTransform& transform = nodes[ i ];
+			if( !transform.isLive )
+			{
+				is_matching &= !hierarchy.IsValid( transform.handle );
+				continue;
+			}
+
+			++live_count;
+			is_matching &= hierarchy.IsValid( transform.handle ) && ( hierarchy.GetWorld( transform.handle ) == get_reference_world( nodes, i ) );
+		}
+		return is_matching && ( hierarchy.GetCount() == live_count );
+	}
+
+
+	// the structural edits the timed loop never makes: reparenting, a rejected cycle, destroying subtrees and reusing
+	// their slots. Update and UpdateAll are compared against the recursive reference after every step
+	Bool check_transform_hierarchy_structure()
+	{
+		constexpr Uint32 node_count = 256;
+
+		std::mt19937 random_engine( 0xc4ec );
+		TransformHierarchy hierarchy;
+		std::vector<ReferenceTransform> nodes;
+		const auto create_node = [&]( Uint32 parent )
+		{
+			ReferenceTransform transform { .parent = parent, .local = make_random_local( random_engine ) };
+			transform.handle = hierarchy.Create( ( parent == UINT32_MAX ) ? TransformHandle {} : nodes[ parent ].handle, transform.local );
+			nodes.push_back( transform );
+		};
+
+		for( Uint32 i = 0; i < node_count; ++i )
+		{
+			const Bool is_root = ( i % 16 ) == 0;
+			create_node( is_root ? UINT32_MAX : i - 1 - ( random_engine() % std::min<Uint32>( i % 16, 4 ) ) );
+		}
+		hierarchy.Update( nullptr );
+		Bool is_valid = is_matching_reference( hierarchy, nodes );
+
+		// node 1 hangs below root 0, parenting the root to it or a node to itself would close a cycle
+		is_valid &= !hierarchy.SetParent( nodes[ 0 ].handle, nodes[ 1 ].handle );
+		is_valid &= !hierarchy.SetParent( nodes[ 1 ].handle, nodes[ 1 ].handle );
+		for( Uint32 i = 0; i < 64; ++i )
+		{
+			const Uint32 node = get_random_live_node( nodes, random_engine );
+			const Uint32 parent = ( random_engine() % 8 == 0 ) ? UINT32_MAX : get_random_live_node( nodes, random_engine );
+			const Bool is_cycle = ( parent != UINT32_MAX ) && is_in_reference_subtree( nodes, parent, node );
+			const Bool is_reparented = hierarchy.SetParent( nodes[ node ].handle, ( parent == UINT32_MAX ) ? TransformHandle {} : nodes[ parent ].handle );
+			is_valid &= ( is_reparented != is_cycle );
+			if( is_reparented )
+			{
+				nodes[ node ].parent = parent;
+			}
+		}
+		for( Uint32 i = 0; i < 32; ++i )
+		{
+			ReferenceTransform& transform = nodes[ random_engine() % node_count ];
+			transform.local = make_random_local( random_engine );
+			hierarchy.SetLocal( transform.handle, transform.local );
+		}
+		hierarchy.Update( nullptr );
+		is_valid &= is_matching_reference( hierarchy, nodes );
+
+		// Destroy only drops the node itself, its descendants turn stale with the reorder of the next Update
+		for( Uint32 i = 0; i < 4; ++i )
+		{
+			const Uint32 subtree_root = get_random_live_node( nodes, random_engine );
+			hierarchy.Destroy( nodes[ subtree_root ].handle );
+			for( Uint32 node = 0; node < nodes.size(); ++node )
+			{
+				nodes[ node ].isLive &= !is_in_reference_subtree( nodes, node, subtree_root );
+			}
+		}
+		is_valid &= hierarchy.Update( nullptr ).wasReordered;
+		is_valid &= is_matching_reference( hierarchy, nodes );
+
+		// the new nodes reuse the freed slots, the handles of the destroyed ones have to stay stale
+		for( Uint32 i = 0; i < 32; ++i )
+		{
+			create_node( ( i % 4 == 0 ) ? UINT32_MAX : get_random_live_node( nodes, random_engine ) );
+		}
+		hierarchy.UpdateAll();
+		is_valid &= is_matching_reference( hierarchy, nodes );
+
+		return is_valid;
+	}
+}
+
+
+Int32 run_benchmark( gdevice::Context& gctx, Window* p_window, const WarmAssets& warm_assets, const BenchmarkParams& benchmark_params )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	std::unique_ptr<GpuDrivenScene> p_gpu_driven_scene;
+	if( benchmark_params.isGpuDriven )
+	{
+		if( !GpuDrivenScene::IsSupported( gctx ) )
+		{
+			AZHAL_LOG_ERROR( "the device lacks the features the gpu-driven benchmark needs" );
+			return 1;
+		}
+
+		const GpuDrivenSceneParams gpu_driven_scene_params
+		{
+			.instanceCount = benchmark_params.drawCount,
+			.cullPso = get_pso( warm_assets, SandboxPSO::eCullInstances ),
+			.buildHizPso = get_pso( warm_assets, SandboxPSO::eBuildHiz ),
+			.bucketPsos = { get_pso( warm_assets, SandboxPSO::eGpuDrivenOpaque ), get_pso( warm_assets, SandboxPSO::eGpuDrivenTwoSided ) },
+			.isOcclusionCullingEnabled = benchmark_params.isOcclusionCullingEnabled
+		};
+		p_gpu_driven_scene = std::make_unique<GpuDrivenScene>( gctx, gpu_driven_scene_params );
+	}
+
+	std::unique_ptr<MeshScene> p_mesh_scene;
+	if( !p_gpu_driven_scene && !benchmark_params.meshPath.empty() )
+	{
+		if( warm_assets.mesh.indices.empty() )
+		{
+			AZHAL_LOG_ERROR( "failed to load the benchmark mesh {0}", benchmark_params.meshPath );
+			return 1;
+		}
+
+		MeshRenderPath render_path = MeshRenderPath::eVertex;
+		if( benchmark_params.isMeshletCullingEnabled )
+		{
+			const Bool is_mesh_shader_usable = benchmark_params.isMeshShaderAllowed && MeshScene::IsSupported( gctx, MeshRenderPath::eMeshShader ) &&
+				!get_pso( warm_assets, SandboxPSO::eMeshlet ).IsNull();
+			render_path = is_mesh_shader_usable ? MeshRenderPath::eMeshShader : MeshRenderPath::eComputeExpansion;
+			if( !MeshScene::IsSupported( gctx, render_path ) )
+			{
+				AZHAL_LOG_ERROR( "the device lacks the features meshlet culling needs" );
+				return 1;
+			}
+		}
+
+		const MeshSceneParams mesh_scene_params
+		{
+			.instanceCount = benchmark_params.drawCount,
+			.renderPath = render_path,
+			.pso = get_pso( warm_assets, SandboxPSO::eMesh ),
+			.meshletPso = get_pso( warm_assets, SandboxPSO::eMeshlet ),
+			.cullMeshletsPso = get_pso( warm_assets, SandboxPSO::eCullMeshlets ),
+			.geometryPoolMeshCount = benchmark_params.isMeshletCullingEnabled ? 0 : benchmark_params.geometryPoolMeshCount
+		};
+		p_mesh_scene = std::make_unique<MeshScene>( gctx, warm_assets.mesh, mesh_scene_params );
+	}
+
+	const gdevice::GpuTimerCreationParams gpu_timer_creation_params
+	{
+		.framesInFlight = gdevice::MAX_FRAMES_IN_FLIGHT,
+		.maxScopesPerFrame = 4,
+		// the gpu frame times are read from the history once the run is over
+		.historyLength = std::max<Uint32>( benchmark_params.measuredFrames, 1 )
+	};
+	gdevice::GpuTimer gpu_timer = gdevice::create_gpu_timer( gctx, gpu_timer_creation_params );
+
+	const gdevice::GpuQueriesCreationParams gpu_queries_creation_params
+	{
+		.framesInFlight = gdevice::MAX_FRAMES_IN_FLIGHT,
+		.maxScopesPerFrame = 1
+	};
+	gdevice::GpuQueries gpu_queries = gdevice::create_gpu_queries( gctx, gpu_queries_creation_params );
+
+	// the same draws recorded in submission order and in key order every frame, so that one run compares both
+	gdevice::RenderQueue submission_render_queue;
+	gdevice::RenderQueue sorted_render_queue;
+	Double submission_record_ms = 0.0;
+	Double sorted_record_ms = 0.0;
+	const std::array<gdevice::PSOHandle, 2> sorted_scene_psos = { get_pso( warm_assets, SandboxPSO::eSimple ), get_pso( warm_assets, SandboxPSO::eSimpleTwoSided ) };
+
+	const Uint32 total_frames = benchmark_params.warmupFrames + benchmark_params.measuredFrames;
+
+	std::vector<Double> cpu_frame_times_ms;
+	std::vector<Double> gpu_frame_times_ms;
+	cpu_frame_times_ms.reserve( benchmark_params.measuredFrames );
+
+	AZHAL_LOG_INFO( "running benchmark: {0} warm-up frames, {1} measured frames, {2} draws per frame, {3}x{4}",
+		benchmark_params.warmupFrames, benchmark_params.measuredFrames, benchmark_params.drawCount, benchmark_params.width, benchmark_params.height );
+
+	Clock::time_point measure_start_time = Clock::now();
+	Clock::time_point previous_frame_time = measure_start_time;
+	Uint32 rendered_frames = 0;
+	Uint32 failed_begin_frames = 0;
+	Double time_to_first_frame_ms = 0.0;
+
+	while( rendered_frames < total_frames )
+	{
+		if( p_window && !p_window->poll() )
+		{
+			AZHAL_LOG_WARN( "window was closed before the benchmark finished" );
+			break;
+		}
+
+		if( p_window && p_window->consume_framebuffer_resize() )
+		{
+			const Uvec2 framebuffer_size = p_window->get_framebuffer_size();
+			gdevice::request_swapchain_resize( vk::Extent2D { framebuffer_size.x, framebuffer_size.y } );
+		}
+
+		gdevice::Frame frame;
+		if( !gdevice::begin_frame( gctx, frame ) )
+		{
+			if( !wait_for_begin_frame_retry( failed_begin_frames ) )
+			{
+				break;
+			}
+			continue;
+		}
+		failed_begin_frames = 0;
+
+		const Clock::time_point frame_time = Clock::now();
+		// a frame's cpu time runs from the begin of the frame before it, the first measured frame is timed from the
+		// last warm-up frame
+		if( rendered_frames == benchmark_params.warmupFrames )
+		{
+			measure_start_time = frame_time;
+		}
+		if( rendered_frames >= benchmark_params.warmupFrames )
+		{
+			cpu_frame_times_ms.push_back( std::chrono::duration<Double, std::milli>( frame_time - previous_frame_time ).count() );
+		}
+		previous_frame_time = frame_time;
+
+		gdevice::gpu_timer_begin_frame( gctx, gpu_timer, frame.cmdBuffer, frame.frameIndex );
+		gdevice::gpu_queries_begin_frame( gctx, gpu_queries, frame.cmdBuffer, frame.frameIndex );
+
+		{
+			AZHAL_GPU_TIMER_SCOPE( gpu_timer, frame.cmdBuffer, "frame" );
+			AZHAL_PROFILE_GPU_SCOPE( frame.cmdBuffer, "synthetic_scene" );
+			AZHAL_GPU_QUERY_SCOPE( gpu_queries, frame.cmdBuffer, "synthetic_scene", gdevice::eGpuQueryTypeAll );
+			if( p_gpu_driven_scene )
+			{
+				record_gpu_driven_scene( frame, *p_gpu_driven_scene );
+			}
+			else if( p_mesh_scene )
+			{
+				record_mesh_scene( frame, *p_mesh_scene );
+			}
+			else if( benchmark_params.isRenderQueueEnabled )
+			{
+				const Bool is_measured = ( rendered_frames >= benchmark_params.warmupFrames );
+				{
+					AZHAL_GPU_TIMER_SCOPE( gpu_timer, frame.cmdBuffer, "render_queue_submission_order" );
+					const Clock::time_point record_start_time = Clock::now();
+					record_render_queue_synthetic_scene( frame, sorted_scene_psos, benchmark_params.drawCount, gdevice::RenderQueueOrder::eSubmission, submission_render_queue );
+					submission_record_ms += is_measured ? std::chrono::duration<Double, std::milli>( Clock::now() - record_start_time ).count() : 0.0;
+				}
+				{
+					AZHAL_GPU_TIMER_SCOPE( gpu_timer, frame.cmdBuffer, "render_queue_key_order" );
+					const Clock::time_point record_start_time = Clock::now();
+					record_render_queue_synthetic_scene( frame, sorted_scene_psos, benchmark_params.drawCount, gdevice::RenderQueueOrder::eKey, sorted_render_queue );
+					sorted_record_ms += is_measured ? std::chrono::duration<Double, std::milli>( Clock::now() - record_start_time ).count() : 0.0;
+				}
+			}
+			else
+			{
+				record_synthetic_scene( frame, get_pso( warm_assets, SandboxPSO::eSimple ), benchmark_params.drawCount );
+			}
+		}
+		gdevice::gpu_timer_end_frame( gpu_timer );
+
+		gdevice::end_frame( gctx, frame );
+		if( rendered_frames == 0 && benchmark_params.pStartupTimings )
+		{
+			time_to_first_frame_ms = benchmark_params.pStartupTimings->GetElapsedMs();
+		}
+		rendered_frames++;
+	}
+
+	gdevice::wait_idle( gctx );
+	const Double measured_seconds = std::chrono::duration<Double>( Clock::now() - measure_start_time ).count();
+
+	const Uint32 measured_frames = ( rendered_frames > benchmark_params.warmupFrames ) ? ( rendered_frames - benchmark_params.warmupFrames ) : 0;
+
+	// every retired frame adds one sample in frame order, so the newest measured_frames samples of the history are
+	// the measured frames. the last frames in flight are only read back here
+	gdevice::gpu_timer_collect_pending( gctx, gpu_timer );
+	const std::vector<gdevice::GpuTimerScopeStats>& gpu_stats = gdevice::get_gpu_timer_stats( gpu_timer );
+	if( !gpu_stats.empty() )
+	{
+		const gdevice::GpuTimerScopeStats& frame_stats = gpu_stats[ 0 ];
+		const Uint64 history_length = frame_stats.history.size();
+		const Uint64 gpu_sample_count = std::min<Uint64>( { frame_stats.sampleCount, measured_frames, history_length } );
+		gpu_frame_times_ms.reserve( gpu_sample_count );
+		for( Uint64 i = 0; i < gpu_sample_count; ++i )
+		{
+			const Uint64 history_index = ( frame_stats.historyHead + history_length - gpu_sample_count + i ) % history_length;
+			gpu_frame_times_ms.push_back( frame_stats.history[ history_index ] );
+		}
+	}
+
+	const FrameTimeSummary cpu_summary = summarize_frame_times( cpu_frame_times_ms );
+	const FrameTimeSummary gpu_summary = summarize_frame_times( gpu_frame_times_ms );
+	const Double frames_per_second = ( measured_seconds > 0.0 ) ? static_cast< Double >( measured_frames ) / measured_seconds : 0.0;
+
+	std::stringstream report;
+	report << "{\n"
+		<< "  \"config\": { \"warmup_frames\": " << benchmark_params.warmupFrames
+		<< ", \"measured_frames\": " << benchmark_params.measuredFrames
+		<< ", \"draw_count\": " << benchmark_params.drawCount
+		<< ", \"gpu_driven\": " << ( benchmark_params.isGpuDriven ? "true" : "false" )
+		<< ", \"mesh\": \"" << ( p_mesh_scene ? benchmark_params.meshPath : String() ) << "\""
+		<< ", \"mesh_render_path\": \"" << ( p_mesh_scene ? get_mesh_render_path_name( p_mesh_scene->GetRenderPath() ) : "" ) << "\""
+		<< ", \"occlusion_culling\": " << ( benchmark_params.isGpuDriven && benchmark_params.isOcclusionCullingEnabled ? "true" : "false" )
+		<< ", \"width\": " << gdevice::get_swapchain( gctx ).imageExtent.width
+		<< ", \"height\": " << gdevice::get_swapchain( gctx ).imageExtent.height
+		<< ", \"headless\": " << ( p_window ? "false" : "true" )
+		<< ", \"present_mode\": \"" << vk::to_string( gdevice::get_swapchain( gctx ).presentMode ) << "\""
+		<< ", \"swapchain_images\": " << gdevice::get_swapchain( gctx ).images.size() << " },\n"
+		<< "  \"frame_times\": {\n";
+	write_summary_json( report, "cpu", cpu_summary );
+	report << ",\n";
+	write_summary_json( report, "gpu", gpu_summary );
+	report << "\n  },\n";
+
+	// counters of the last collected frame, every frame draws the same scene
+	const std::vector<gdevice::GpuQueryScopeResult>& query_results = gdevice::get_gpu_query_results( gpu_queries );
+	if( !query_results.empty() )
+	{
+		const gdevice::GpuQueryScopeResult& query_result = query_results[ 0 ];
+		const gdevice::PipelineStatistics& stats = query_result.pipelineStatistics;
+		report << "  \"pipeline_statistics\": { \"ia_vertices\": " << stats.inputAssemblyVertices
+			<< ", \"ia_primitives\": " << stats.inputAssemblyPrimitives
+			<< ", \"vs_invocations\": " << stats.vertexShaderInvocations
+			<< ", \"clipping_invocations\": " << stats.clippingInvocations
+			<< ", \"clipping_primitives\": " << stats.clippingPrimitives
+			<< ", \"fs_invocations\": " << stats.fragmentShaderInvocations
+			<< ", \"samples_passed\": " << query_result.samplesPassed << " },\n";
+		gdevice::log_gpu_query_results( gpu_queries );
+	}
+
+	// bind counters of the last frame, every frame submits the same draws. the gpu times average the whole run
+	if( benchmark_params.isRenderQueueEnabled && !p_gpu_driven_scene && !p_mesh_scene )
+	{
+		const auto get_gpu_scope_average_ms = [ &gpu_stats ]( std::string_view scope_name )
+		{
+			const auto it = std::ranges::find_if( gpu_stats, [ scope_name ]( const gdevice::GpuTimerScopeStats& scope_stats ) { return scope_stats.name == scope_name; } );
+			return ( it != gpu_stats.end() ) ? it->averageMs : 0.0;
+		};
+		const Double frame_count = static_cast< Double >( std::max<Uint32>( measured_frames, 1 ) );
+
+		report << "  \"render_queue\": {\n";
+		write_render_queue_json( report, "submission_order", submission_render_queue.stats, submission_record_ms / frame_count,
+			get_gpu_scope_average_ms( "render_queue_submission_order" ) );
+		report << ",\n";
+		write_render_queue_json( report, "key_order", sorted_render_queue.stats, sorted_record_ms / frame_count,
+			get_gpu_scope_average_ms( "render_queue_key_order" ) );
+		report << "\n  },\n";
+	}
+
+	if( p_mesh_scene && p_mesh_scene->IsGeometryPooled() )
+	{
+		const gdevice::GeometryPoolStats pool_stats = p_mesh_scene->GetGeometryPoolStats();
+		report << "  \"geometry_pool\": { \"meshes\": " << pool_stats.meshCount
+			<< ", \"used_vertices\": " << pool_stats.usedVertices
+			<< ", \"vertex_capacity\": " << pool_stats.vertexCapacity
+			<< ", \"used_indices\": " << pool_stats.usedIndices
+			<< ", \"index_capacity\": " << pool_stats.indexCapacity << ", ";
+		write_render_queue_stats_json( report, p_mesh_scene->GetRenderQueueStats() );
+		report << " },\n";
+	}
+
+	if( benchmark_params.pStartupTimings )
+	{
+		report << "  \"startup\": { \"time_to_first_frame_ms\": " << time_to_first_frame_ms << ", \"stages\": [";
+		const std::vector<StageTiming> stages = benchmark_params.pStartupTimings->GetStages();
+		for( size_t i = 0; i < stages.size(); ++i )
+		{
+			const StageTiming& stage = stages[ i ];
+			report << ( i == 0 ? "\n" : ",\n" )
+				<< "    { \"name\": \"" << stage.pName << "\""
+				<< ", \"start_ms\": " << stage.startMs
+				<< ", \"duration_ms\": " << stage.durationMs
+				<< ", \"thread\": " << static_cast< Int64 >( stage.threadIndex == UINT32_MAX ? -1 : stage.threadIndex ) << " }";
+		}
+		report << "\n  ] },\n";
+	}
+
+	report
+		<< "  \"throughput\": { \"frames\": " << measured_frames
+		<< ", \"seconds\": " << measured_seconds
+		<< ", \"frames_per_second\": " << frames_per_second
+		<< ", \"draws_per_second\": " << frames_per_second * static_cast< Double >( benchmark_params.drawCount ) << " }\n"
+		<< "}\n";
+
+	std::cout << report.str();
+	if( !benchmark_params.outputPath.empty() )
+	{
+		std::ofstream file_stream( benchmark_params.outputPath );
+		if( file_stream.is_open() )
+		{
+			file_stream << report.str();
+		}
+		else
+		{
+			AZHAL_LOG_ERROR( "failed to write benchmark report to {0}", benchmark_params.outputPath );
+		}
+	}
+
+	p_mesh_scene.reset();
+	p_gpu_driven_scene.reset();
+	gdevice::destroy_gpu_queries( gctx, gpu_queries );
+	gdevice::destroy_gpu_timer( gctx, gpu_timer );
+
+	// a run that ended early is reported, but flagged as failed for the build agents
+	return ( measured_frames == benchmark_params.measuredFrames ) ? 0 : 1;
+}
+
+
+Int32 run_culling_benchmark( Uint32 sphere_count, Uint32 iterations )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	iterations = std::max<Uint32>( iterations, 1 );
+
+	// instances scattered over a square kilometre, the sizes of props to buildings
+	const Float world_extent = 500.0f;
+	std::mt19937 random_engine( 0x5eed );
+	std::uniform_real_distribution<Float> position_distribution( -world_extent, world_extent );
+	std::uniform_real_distribution<Float> height_distribution( 0.0f, 20.0f );
+	std::uniform_real_distribution<Float> radius_distribution( 0.25f, 8.0f );
+
+	SphereBoundsSoA bounds;
+	bounds.Reserve( sphere_count );
+	for( Uint32 i = 0; i < sphere_count; ++i )
+	{
+		bounds.Add( Vec3( position_distribution( random_engine ), height_distribution( random_engine ), position_distribution( random_engine ) ),
+			radius_distribution( random_engine ) );
+	}
+
+	constexpr Uint32 K_CASCADE_COUNT = 3;
+	std::array<glm::mat4, 1 + K_CASCADE_COUNT> view_projections;
+	const CameraPacket camera
+	{
+		.position = Vec3( 0.0f, 10.0f, 0.0f ),
+		.target = Vec3( 1.0f, 8.0f, 1.0f ),
+		.farPlane = world_extent * 2.0f
+	};
+	view_projections[ 0 ] = compute_view_projection( camera, vk::Extent2D { 1920, 1080 } );
+
+	// orthographic cascades along a directional light, each covering four times the area of the previous one
+	const Vec3 light_direction = glm::normalize( Vec3( -0.4f, -1.0f, -0.3f ) );
+	for( Uint32 cascade = 0; cascade < K_CASCADE_COUNT; ++cascade )
+	{
+		const Float half_extent = 32.0f * static_cast< Float >( 1u << ( 2 * cascade ) );
+		const glm::mat4 light_view = glm::lookAtRH( camera.position - light_direction * world_extent, camera.position, Vec3( 0.0f, 0.0f, 1.0f ) );
+		view_projections[ 1 + cascade ] = glm::orthoRH_ZO( -half_extent, half_extent, -half_extent, half_extent, 0.0f, world_extent * 2.0f ) * light_view;
+	}
+
+	std::vector<Uint32> reference_indices( sphere_count );
+	std::vector<Uint32> visible_indices( sphere_count );
+	std::vector<Uint32> chunk_visible_counts( GetCullingChunkCount( sphere_count ) );
+	Bool is_matching = true;
+
+	const CullingIsa supported_isa = GetCullingIsa();
+	AZHAL_LOG_INFO( "culling benchmark: {0} spheres, {1} views, {2} iterations, widest isa {3}",
+		sphere_count, view_projections.size(), iterations, GetCullingIsaName( supported_isa ) );
+
+	for( Uint32 view = 0; view < view_projections.size(); ++view )
+	{
+		Vec4 planes[ 6 ];
+		extract_frustum_planes( view_projections[ view ], planes );
+
+		const Uint32 reference_count = CullSpheres( bounds, planes, 0, sphere_count, reference_indices.data(), CullingIsa::eScalar );
+
+		for( Uint32 isa = 0; isa <= static_cast< Uint32 >( supported_isa ); ++isa )
+		{
+			for( const Bool is_parallel : { false, true } )
+			{
+				Uint32 visible_count = 0;
+				const Clock::time_point start_time = Clock::now();
+				for( Uint32 iteration = 0; iteration < iterations; ++iteration )
+				{
+					visible_count = is_parallel ?
+						CullSpheresParallel( bounds, planes, visible_indices.data(), chunk_visible_counts, static_cast< CullingIsa >( isa ) ) :
+						CullSpheres( bounds, planes, 0, sphere_count, visible_indices.data(), static_cast< CullingIsa >( isa ) );
+				}
+				const Double average_ms = std::chrono::duration<Double, std::milli>( Clock::now() - start_time ).count() / static_cast< Double >( iterations );
+
+				const Bool is_view_matching = ( visible_count == reference_count ) &&
+					std::equal( visible_indices.begin(), visible_indices.begin() + visible_count, reference_indices.begin() );
+				is_matching &= is_view_matching;
+
+				AZHAL_LOG_INFO( "  view {0} {1} {2}: {3} visible, {4:.3f} ms{5}", view, GetCullingIsaName( static_cast< CullingIsa >( isa ) ),
+					is_parallel ? "parallel" : "single", visible_count, average_ms, is_view_matching ? "" : ", differs from the scalar reference" );
+			}
+		}
+	}
+
+	return is_matching ? 0 : 1;
+}
+
+
+Int32 run_transform_benchmark( Uint32 node_count, Uint32 iterations )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	iterations = std::max<Uint32>( iterations, 1 );
+
+	if( !check_transform_hierarchy_structure() )
+	{
+		AZHAL_LOG_ERROR( "transform hierarchy differs from the reference after reparenting or destroying nodes" );
+		return 1;
+	}
+
+	// scene-like forest: a root every 64 nodes, the rest hangs below a recent node, so that subtrees stay a few levels deep
+	std::mt19937 random_engine( 0x5eed );
+	TransformHierarchy hierarchy( gdevice::MAX_FRAMES_IN_FLIGHT );
+	std::vector<TransformHandle> nodes;
+	nodes.reserve( node_count );
+	for( Uint32 i = 0; i < node_count; ++i )
+	{
+		const Bool is_root = ( i % 64 ) == 0;
+		const TransformHandle parent = is_root ? TransformHandle {} : nodes[ i - 1 - ( random_engine() % std::min<Uint32>( i % 64, 8 ) ) ];
+		nodes.push_back( hierarchy.Create( parent, make_random_local( random_engine ), i ) );
+	}
+
+	// stands in for the persistently mapped instance buffer, one copy per frame in flight
+	std::vector<std::vector<Mat4>> gpu_world_matrices( gdevice::MAX_FRAMES_IN_FLIGHT, std::vector<Mat4>( node_count ) );
+	hierarchy.Update( gpu_world_matrices[ 0 ].data() );
+
+	// a few percent of the scene moves each frame
+	const Uint32 moved_count = std::max<Uint32>( node_count / 50, 1 );
+	Uint64 updated_count = 0;
+	Uint64 gpu_write_count = 0;
+	Double incremental_ms = 0.0;
+	Double full_ms = 0.0;
+	Bool is_matching = true;
+
+	AZHAL_LOG_INFO( "transform benchmark: {0} nodes, {1} moved per frame, {2} iterations", node_count, moved_count, iterations );
+
+	std::vector<Mat4> incremental_worlds( node_count );
+	for( Uint32 iteration = 0; iteration < iterations; ++iteration )
+	{
+		for( Uint32 i = 0; i < moved_count; ++i )
+		{
+			hierarchy.SetLocal( nodes[ random_engine() % node_count ], make_random_local( random_engine ) );
+		}
+
+		const Uint32 frame_slot = ( iteration + 1 ) % gdevice::MAX_FRAMES_IN_FLIGHT;
+		Clock::time_point start_time = Clock::now();
+		const TransformUpdateStats stats = hierarchy.Update( gpu_world_matrices[ frame_slot ].data() );
+		incremental_ms += std::chrono::duration<Double, std::milli>( Clock::now() - start_time ).count();
+		updated_count += stats.updatedCount;
+		gpu_write_count += stats.gpuWriteCount;
+
+		for( Uint32 i = 0; i < node_count; ++i )
+		{
+			incremental_worlds[ i ] = hierarchy.GetWorld( nodes[ i ] );
+			is_matching &= ( gpu_world_matrices[ frame_slot ][ i ] == incremental_worlds[ i ] );
+		}
+
+		start_time = Clock::now();
+		hierarchy.UpdateAll();
+		full_ms += std::chrono::duration<Double, std::milli>( Clock::now() - start_time ).count();
+
+		for( Uint32 i = 0; i < node_count; ++i )
+		{
+			is_matching &= ( hierarchy.GetWorld( nodes[ i ] ) == incremental_worlds[ i ] );
+		}
+	}
+
+	const Double iteration_count = static_cast< Double >( iterations );
+	AZHAL_LOG_INFO( "  incremental: {0:.3f} ms, {1:.2f}% of the nodes recomputed, {2:.0f} gpu writes per frame", incremental_ms / iteration_count,
+		100.0 * static_cast< Double >( updated_count ) / ( iteration_count * node_count ), static_cast< Double >( gpu_write_count ) / iteration_count );
+	AZHAL_LOG_INFO( "  full: {0:.3f} ms{1}", full_ms / iteration_count, is_matching ? "" : ", incremental update differs from the full one" );
+
+	return is_matching ? 0 : 1;
+}
+
+
+Int32 run_texture_streaming_check( gdevice::Context& gctx, const String& dds_path, Uint32 update_count )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	constexpr Uint32 K_TEXTURE_COUNT = 3;
+
+	TextureData texture_data;
+	const ByteBufferDynamic blob = TryLoadBinaryBlob( dds_path.c_str() );
+	if( blob.empty() || !ParseDdsTexture( blob, texture_data ) )
+	{
+		AZHAL_LOG_ERROR( "failed to parse the dds texture {0}", dds_path );
+		return 1;
+	}
+
+	// room for half of the copies at full resolution, and a quarter of one copy uploaded per update, so that the
+	// copies compete for the budget and every texture takes several updates to stream in
+	const Uint64 texture_size = GetTextureSize( texture_data );
+	gdevice::TextureStreamer texture_streamer
+	{
+		.params =
+		{
+			.residencyBudget = texture_size * K_TEXTURE_COUNT / 2,
+			.uploadBudget = std::max<Uint64>( texture_size / 4, 1 )
+		}
+	};
+
+	AZHAL_LOG_INFO( "texture streaming check: {0}x{1} {2} with {3} mips, {4} copies, {5} byte budget",
+		texture_data.width, texture_data.height, GetTextureFormatName( texture_data.format ), texture_data.mips.size(), K_TEXTURE_COUNT,
+		texture_streamer.params.residencyBudget );
+
+	std::array<gdevice::TextureHandle, K_TEXTURE_COUNT> textures;
+	for( Uint32 i = 0; i < K_TEXTURE_COUNT; ++i )
+	{
+		textures[ i ] = gdevice::add_streamed_texture( gctx, texture_streamer, texture_data );
+		if( textures[ i ].IsNull() )
+		{
+			gdevice::destroy_texture_streamer( gctx, texture_streamer );
+			return 1;
+		}
+	}
+
+	// the tails are resident regardless of the budget, only what streams in after them has to fit
+	Uint64 tail_bytes = 0;
+	Bool is_within_budget = true;
+	Uint32 rendered_updates = 0;
+	Uint32 failed_begin_frames = 0;
+	update_count = std::max<Uint32>( update_count, 2 );
+	while( rendered_updates < update_count )
+	{
+		gdevice::Frame frame;
+		if( !gdevice::begin_frame( gctx, frame ) )
+		{
+			if( !wait_for_begin_frame_retry( failed_begin_frames ) )
+			{
+				break;
+			}
+			continue;
+		}
+		failed_begin_frames = 0;
+
+		// every copy wants its finest mip, the priorities flip halfway so that the first ones are evicted again
+		const Bool is_flipped = ( rendered_updates >= update_count / 2 );
+		for( Uint32 i = 0; i < K_TEXTURE_COUNT; ++i )
+		{
+			const Float priority = static_cast< Float >( is_flipped ? ( K_TEXTURE_COUNT - i ) : i );
+			gdevice::set_texture_streaming_priority( texture_streamer, textures[ i ], priority, 0 );
+		}
+
+		const gdevice::TextureStreamingStats stats = gdevice::update_texture_streaming( gctx, frame.cmdBuffer, texture_streamer );
+		gdevice::end_frame( gctx, frame );
+
+		if( rendered_updates == 0 )
+		{
+			tail_bytes = stats.residentBytes;
+		}
+		else if( stats.residentBytes > std::max( texture_streamer.params.residencyBudget, tail_bytes ) )
+		{
+			is_within_budget = false;
+		}
+
+		AZHAL_LOG_INFO( "  update {0}: {1} of {2} bytes resident, {3} uploaded, {4} mips in, {5} mips evicted, {6} images replaced",
+			rendered_updates, stats.residentBytes, stats.wantedBytes, stats.uploadedBytes, stats.mipsStreamedIn, stats.mipsEvicted, stats.replacedImages );
+		rendered_updates++;
+	}
+
+	gdevice::wait_idle( gctx );
+
+	const gdevice::ImageMemoryPoolStats pool_stats = gdevice::get_image_memory_pool_stats( texture_streamer.imageMemoryPool );
+	AZHAL_LOG_INFO( "  image memory: {0} blocks of {1} bytes, {2} bytes in use{3}", pool_stats.blockCount, pool_stats.blockBytes, pool_stats.usedBytes,
+		is_within_budget ? "" : ", the resident mips exceeded the budget" );
+
+	gdevice::destroy_texture_streamer( gctx, texture_streamer );
+
+	return ( is_within_budget && rendered_updates == update_count ) ? 0 : 1;
+}
\ No newline at end of file
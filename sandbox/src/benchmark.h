@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common.h"
+#include "azhal_renderer.h"
+
+#include "asset_warmup.h"
+
+struct BenchmarkParams
+{
+	Uint32 warmupFrames = 100;
+	Uint32 measuredFrames = 1000;
+	Uint32 drawCount = 1000;
+	Uint32 width = 1280;
+	Uint32 height = 720;
+	// culls drawCount instances on the gpu and draws the survivors through indirect count draws, see GpuDrivenScene
+	Bool isGpuDriven = false;
+	// two-phase occlusion culling against a depth pyramid, only with isGpuDriven
+	Bool isOcclusionCullingEnabled = true;
+	// draws drawCount instances of this mesh with SandboxPSO::eMesh when set, see MeshScene
+	String meshPath;
+	// culls the mesh per meshlet, with mesh shaders where the device has them and a compute pass expanding indirect draws otherwise
+	Bool isMeshletCullingEnabled = false;
+	// forces the compute expansion fallback of the meshlet culling
+	Bool isMeshShaderAllowed = true;
+	// without meshlet culling: copies of the mesh added to a geometry pool that has to grow for them, half removed
+	// again and the rest compacted, see MeshSceneParams::geometryPoolMeshCount. the report counts the shared binds
+	Uint32 geometryPoolMeshCount = 0;
+
+	// submits the synthetic scene's draws alternating between two psos and records them through a gdevice::RenderQueue
+	// twice per frame, in submission order and sorted by key, which binds each pso once. the report compares the
+	// binds each order skipped and their cpu and gpu times
+	Bool isRenderQueueEnabled = false;
+
+	// empty path writes the report to stdout only
+	String outputPath;
+
+	// reported together with the time to the first benchmark frame when set
+	const StageTimings* pStartupTimings = nullptr;
+};
+
+// renders a synthetic scene for warmupFrames + measuredFrames frames and reports cpu and gpu
+// frame-time percentiles as json. window may be null for headless runs.
+Int32 run_benchmark( gdevice::Context& gctx, Window* p_window, const WarmAssets& warm_assets, const BenchmarkParams& benchmark_params );
+
+// culls sphere_count random spheres against a camera and three shadow cascades with every culling isa the cpu
+// supports, single-threaded and across the job system. logs the timings, fails when any isa disagrees with the
+// scalar reference. needs no device
+Int32 run_culling_benchmark( Uint32 sphere_count, Uint32 iterations );
+
+// moves a few percent of node_count transforms per frame and times the incremental TransformHierarchy::Update, which
+// writes into one host buffer per frame in flight, against recomputing every world matrix. fails when they differ.
+// needs no device
+Int32 run_transform_benchmark( Uint32 node_count, Uint32 iterations );
+
+// parses a dds file and streams three copies of it through a gdevice::TextureStreamer for update_count frames, under a
+// residency budget that holds half of them. logs every update, fails when the file cannot be used or the resident
+// mips beyond the tails exceed the budget
+Int32 run_texture_streaming_check( gdevice::Context& gctx, const String& dds_path, Uint32 update_count );
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "common.h"
+#include "azhal_renderer.h"
+
+struct CameraPacket
+{
+	Vec3 position = Vec3( 0.0f, 0.0f, -5.0f );
+	Vec3 target = Vec3( 0.0f );
+	Vec3 up = Vec3( 0.0f, 1.0f, 0.0f );
+	Float verticalFovRadians = 1.0f;
+	Float nearPlane = 0.1f;
+	Float farPlane = 1000.0f;
+};
+
+struct DrawPacket
+{
+	// x, y, width, height in pixels of the swapchain image
+	Vec4 viewportRect = Vec4( 0.0f );
+	Uint32 vertexCount = 3;
+};
+
+// everything the render thread needs for one frame. written by the simulation, read-only once published
+struct FramePacket
+{
+	Uint64 simulationFrame = 0;
+	Double simulationTimeSeconds = 0.0;
+
+	CameraPacket camera;
+	std::vector<DrawPacket> draws;
+
+	// the framebuffer size the simulation last saw, the render thread resizes the swapchain when it changes
+	vk::Extent2D framebufferExtent;
+
+	// the last packet, the render thread exits after it
+	Bool isShutdownRequested = false;
+};
+
+using FramePacketBuffer = TripleBuffer<FramePacket>;
\ No newline at end of file
@@ -0,0 +1,542 @@
+#include "gpu_driven_scene.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <bit>
+#include <cmath>
+
+namespace
+{
+	constexpr Uint32 K_CULL_GROUP_SIZE = 64;
+	// every group of build_hiz.cs writes a 32x32 tile of mip 0
+	constexpr Uint32 K_HIZ_GROUP_TILE_SIZE = 32;
+	constexpr Float K_INSTANCE_SPACING = 3.0f;
+
+	Uint32 pack_color( const Vec3& color )
+	{
+		const Uvec3 bytes = Uvec3( glm::clamp( color, Vec3( 0.0f ), Vec3( 1.0f ) ) * 255.0f + 0.5f );
+		return bytes.r | ( bytes.g << 8 ) | ( bytes.b << 16 ) | ( 0xffu << 24 );
+	}
+
+
+	// the psos cull counter-clockwise faces, the meshes are convex and centered on the origin so the winding is
+	// flipped whenever the triangle would face the origin from the outside
+	void append_clockwise_triangle( std::vector<GpuVertex>& vertices, std::vector<Uint16>& indices, Uint32 first_vertex, Vec3 a, Vec3 b, Vec3 c, Uint32 packed_color )
+	{
+		if( glm::dot( glm::cross( b - a, c - a ), a + b + c ) > 0.0f )
+		{
+			std::swap( b, c );
+		}
+
+		for( const Vec3& position : { a, b, c } )
+		{
+			indices.push_back( static_cast< Uint16 >( vertices.size() - first_vertex ) );
+			vertices.push_back( GpuVertex { .position = position, .packedColor = packed_color } );
+		}
+	}
+
+
+	GpuMesh append_cube( std::vector<GpuVertex>& vertices, std::vector<Uint16>& indices )
+	{
+		GpuMesh mesh
+		{
+			.firstIndex = static_cast< Uint32 >( indices.size() ),
+			.vertexOffset = static_cast< Int32 >( vertices.size() ),
+			.boundingRadius = std::sqrt( 3.0f ) * 0.5f
+		};
+
+		const Uint32 first_vertex = static_cast< Uint32 >( vertices.size() );
+		for( Uint32 axis = 0; axis < 3; ++axis )
+		{
+			for( const Float side : { -0.5f, 0.5f } )
+			{
+				Vec3 normal( 0.0f );
+				normal[ axis ] = side;
+				Vec3 tangent( 0.0f );
+				tangent[ ( axis + 1 ) % 3 ] = 0.5f;
+				Vec3 bitangent( 0.0f );
+				bitangent[ ( axis + 2 ) % 3 ] = 0.5f;
+
+				const Uint32 packed_color = pack_color( Vec3( 0.55f ) + glm::abs( normal ) * 0.9f );
+				append_clockwise_triangle( vertices, indices, first_vertex, normal - tangent - bitangent, normal + tangent - bitangent, normal + tangent + bitangent, packed_color );
+				append_clockwise_triangle( vertices, indices, first_vertex, normal - tangent - bitangent, normal + tangent + bitangent, normal - tangent + bitangent, packed_color );
+			}
+		}
+
+		mesh.indexCount = static_cast< Uint32 >( indices.size() ) - mesh.firstIndex;
+		return mesh;
+	}
+
+
+	GpuMesh append_octahedron( std::vector<GpuVertex>& vertices, std::vector<Uint16>& indices )
+	{
+		GpuMesh mesh
+		{
+			.firstIndex = static_cast< Uint32 >( indices.size() ),
+			.vertexOffset = static_cast< Int32 >( vertices.size() ),
+			.boundingRadius = 0.7f
+		};
+
+		const Uint32 first_vertex = static_cast< Uint32 >( vertices.size() );
+		for( Uint32 octant = 0; octant < 8; ++octant )
+		{
+			const Vec3 a( ( octant & 1 ) ? 0.7f : -0.7f, 0.0f, 0.0f );
+			const Vec3 b( 0.0f, ( octant & 2 ) ? 0.7f : -0.7f, 0.0f );
+			const Vec3 c( 0.0f, 0.0f, ( octant & 4 ) ? 0.7f : -0.7f );
+			append_clockwise_triangle( vertices, indices, first_vertex, a, b, c, pack_color( Vec3( 0.5f ) + ( a + b + c ) * 0.6f ) );
+		}
+
+		mesh.indexCount = static_cast< Uint32 >( indices.size() ) - mesh.firstIndex;
+		return mesh;
+	}
+
+
+	template<typename T>
+	vk::DeviceSize get_byte_size( const std::vector<T>& elements )
+	{
+		return static_cast< vk::DeviceSize >( elements.size() * sizeof( T ) );
+	}
+}
+
+GpuDrivenScene::GpuDrivenScene( gdevice::Context& gctx, const GpuDrivenSceneParams& params )
+	: m_gctx( gctx )
+	, m_params( params )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	AZHAL_FATAL_ASSERT( IsSupported( gctx ), "the gpu-driven scene needs device features that are not enabled" );
+	AZHAL_FATAL_ASSERT( m_params.instanceCount > 0, "the gpu-driven scene needs at least one instance" );
+
+	m_meshes.push_back( append_cube( m_vertices, m_indices ) );
+	m_meshes.push_back( append_octahedron( m_vertices, m_indices ) );
+
+	// a square grid on the ground plane, every instance gets a mesh, a bucket and a tint
+	const Uint32 grid_side = static_cast< Uint32 >( std::ceil( std::sqrt( static_cast< Double >( m_params.instanceCount ) ) ) );
+	const Float grid_origin = -0.5f * static_cast< Float >( grid_side - 1 ) * K_INSTANCE_SPACING;
+
+	m_instances.resize( m_params.instanceCount );
+	for( Uint32 i = 0; i < m_params.instanceCount; ++i )
+	{
+		const Uint32 column = i % grid_side;
+		const Uint32 row = i / grid_side;
+		const Float scale = 0.75f + 0.25f * std::sin( static_cast< Float >( i ) * 0.37f );
+		const Vec3 position( grid_origin + static_cast< Float >( column ) * K_INSTANCE_SPACING, std::sin( static_cast< Float >( column ) * 0.3f ) * std::cos( static_cast< Float >( row ) * 0.3f ), grid_origin + static_cast< Float >( row ) * K_INSTANCE_SPACING );
+
+		GpuInstance& instance = m_instances[ i ];
+		instance.meshIndex = i % static_cast< Uint32 >( m_meshes.size() );
+		instance.bucketIndex = ( i / 7 ) % K_GPU_DRIVEN_BUCKET_COUNT;
+		instance.positionScale = Vec4( position, scale );
+		instance.boundingSphere = Vec4( position, m_meshes[ instance.meshIndex ].boundingRadius * scale );
+		instance.packedColor = pack_color( Vec3( static_cast< Float >( column ) / static_cast< Float >( grid_side ), 0.6f, static_cast< Float >( row ) / static_cast< Float >( grid_side ) ) * 0.6f + 0.4f );
+		instance.padding = 0;
+
+		m_bucketCapacity[ instance.bucketIndex ]++;
+	}
+
+	for( Uint32 bucket = 0; bucket < K_GPU_DRIVEN_BUCKET_COUNT; ++bucket )
+	{
+		m_bucketFirstCommand[ bucket ] = m_phaseCommandCount;
+		m_phaseCommandCount += m_bucketCapacity[ bucket ];
+	}
+	const Uint32 phase_count = static_cast< Uint32 >( GpuCullPhase::eCount );
+
+	const vk::BufferUsageFlags pulled_usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferDst;
+	const vk::BufferUsageFlags storage_usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+	m_vertexBuffer = gdevice::create_buffer( gctx, { .size = get_byte_size( m_vertices ), .usage = pulled_usage } );
+	m_instanceBuffer = gdevice::create_buffer( gctx, { .size = get_byte_size( m_instances ), .usage = pulled_usage } );
+	m_indexBuffer = gdevice::create_buffer( gctx, { .size = get_byte_size( m_indices ), .usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst } );
+	m_meshBuffer = gdevice::create_buffer( gctx, { .size = get_byte_size( m_meshes ), .usage = storage_usage } );
+	m_drawCommandBuffer = gdevice::create_buffer( gctx,
+		{
+			.size = static_cast< vk::DeviceSize >( m_phaseCommandCount * phase_count ) * sizeof( vk::DrawIndexedIndirectCommand ),
+			.usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer
+		} );
+	m_drawCountBuffer = gdevice::create_buffer( gctx,
+		{
+			.size = K_GPU_DRIVEN_BUCKET_COUNT * phase_count * sizeof( Uint32 ),
+			.usage = storage_usage | vk::BufferUsageFlagBits::eIndirectBuffer
+		} );
+	m_earlyDrawnBuffer = gdevice::create_buffer( gctx, { .size = m_params.instanceCount * sizeof( Uint32 ), .usage = storage_usage } );
+	m_cullViewBuffer = gdevice::create_buffer( gctx,
+		{
+			.size = gdevice::MAX_FRAMES_IN_FLIGHT * sizeof( GpuCullView ),
+			.usage = vk::BufferUsageFlagBits::eStorageBuffer,
+			.memoryUsage = gdevice::BufferMemoryUsage::eCpuToGpu
+		} );
+	m_hizCounterBuffer = gdevice::create_buffer( gctx, { .size = sizeof( Uint32 ), .usage = storage_usage } );
+
+	AZHAL_LOG_INFO( "gpu-driven scene: {0} instances, {1} meshes, {2} indirect draw slots per phase, occlusion culling {3}",
+		m_params.instanceCount, m_meshes.size(), m_phaseCommandCount, m_params.isOcclusionCullingEnabled ? "on" : "off" );
+}
+
+
+GpuDrivenScene::~GpuDrivenScene()
+{
+	gdevice::destroy_descriptor_set( m_gctx, m_hizDescriptorSet );
+	gdevice::destroy_descriptor_set( m_gctx, m_cullDescriptorSet );
+	gdevice::destroy_image( m_gctx, m_hizPyramid );
+	gdevice::destroy_image( m_gctx, m_depthImage );
+	gdevice::destroy_buffer( m_gctx, m_hizCounterBuffer );
+	gdevice::destroy_buffer( m_gctx, m_cullViewBuffer );
+	gdevice::destroy_buffer( m_gctx, m_earlyDrawnBuffer );
+	gdevice::destroy_buffer( m_gctx, m_drawCountBuffer );
+	gdevice::destroy_buffer( m_gctx, m_drawCommandBuffer );
+	gdevice::destroy_buffer( m_gctx, m_meshBuffer );
+	gdevice::destroy_buffer( m_gctx, m_indexBuffer );
+	gdevice::destroy_buffer( m_gctx, m_instanceBuffer );
+	gdevice::destroy_buffer( m_gctx, m_vertexBuffer );
+}
+
+
+Bool GpuDrivenScene::IsSupported( const gdevice::Context& gctx )
+{
+	constexpr Uint64 K_REQUIRED_FEATURES = gdevice::eDeviceFeatureBufferDeviceAddress | gdevice::eDeviceFeatureDrawIndirectCount |
+		gdevice::eDeviceFeatureShaderInt64 | gdevice::eDeviceFeatureDrawIndirectFirstInstance;
+	return gdevice::is_device_feature_enabled( gdevice::get_device_capabilities( gctx ), K_REQUIRED_FEATURES );
+}
+
+
+void GpuDrivenScene::RecordUploads( vk::CommandBuffer cmd_buffer )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	gdevice::record_buffer_upload( m_gctx, cmd_buffer, m_vertexBuffer, 0, m_vertices.data(), get_byte_size( m_vertices ) );
+	gdevice::record_buffer_upload( m_gctx, cmd_buffer, m_indexBuffer, 0, m_indices.data(), get_byte_size( m_indices ) );
+	gdevice::record_buffer_upload( m_gctx, cmd_buffer, m_meshBuffer, 0, m_meshes.data(), get_byte_size( m_meshes ) );
+	gdevice::record_buffer_upload( m_gctx, cmd_buffer, m_instanceBuffer, 0, m_instances.data(), get_byte_size( m_instances ) );
+	cmd_buffer.fillBuffer( gdevice::get_buffer( m_earlyDrawnBuffer ).vkBuffer, 0, VK_WHOLE_SIZE, 0 );
+	cmd_buffer.fillBuffer( gdevice::get_buffer( m_hizCounterBuffer ).vkBuffer, 0, VK_WHOLE_SIZE, 0 );
+
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eCopy | vk::PipelineStageFlagBits2::eClear, vk::AccessFlagBits2::eTransferWrite,
+		vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eIndexInput,
+		vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eIndexRead );
+
+	// everything lives on the gpu from now on
+	m_vertices = {};
+	m_indices = {};
+	m_meshes = {};
+	m_instances = {};
+}
+
+
+void GpuDrivenScene::ResizeDepthTargets( vk::CommandBuffer cmd_buffer, const vk::Extent2D& extent )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	gdevice::destroy_descriptor_set( m_gctx, m_hizDescriptorSet );
+	gdevice::destroy_descriptor_set( m_gctx, m_cullDescriptorSet );
+	gdevice::destroy_image( m_gctx, m_hizPyramid );
+	gdevice::destroy_image( m_gctx, m_depthImage );
+	m_isPyramidValid = false;
+
+	m_depthImage = gdevice::create_image( m_gctx,
+		{
+			.format = K_GPU_DRIVEN_DEPTH_FORMAT,
+			.extent = extent,
+			.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled
+		} );
+
+	// power of two, so that every texel of a mip covers exactly 2x2 texels of the one above
+	m_hizMip0Extent = Uvec2( std::bit_ceil( extent.width ) / 2, std::bit_ceil( extent.height ) / 2 );
+	m_hizMip0Extent = glm::max( m_hizMip0Extent, Uvec2( 1 ) );
+	const vk::Extent2D mip0_extent { m_hizMip0Extent.x, m_hizMip0Extent.y };
+	m_hizPyramid = gdevice::create_image( m_gctx,
+		{
+			.format = vk::Format::eR32Sfloat,
+			.extent = mip0_extent,
+			.mipLevels = std::min( gdevice::get_full_mip_count( mip0_extent ), K_HIZ_MAX_MIPS ),
+			.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+			.hasMipViews = true
+		} );
+	const gdevice::Image depth_image = gdevice::get_image( m_depthImage );
+	const gdevice::Image hiz_pyramid = gdevice::get_image( m_hizPyramid );
+
+	// the pyramid stays in eGeneral, it is written as a storage image and read with Load
+	gdevice::insert_image_barrier( cmd_buffer, hiz_pyramid.vkImage, hiz_pyramid.aspectMask,
+		vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, vk::ImageLayout::eUndefined,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eGeneral );
+
+	const std::array<vk::DescriptorBufferInfo, K_CULL_STORAGE_BUFFER_COUNT> cull_buffer_infos
+	{
+		vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_instanceBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+		vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_meshBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+		vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_drawCommandBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+		vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_drawCountBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+		vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_earlyDrawnBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+		vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_cullViewBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE }
+	};
+	const vk::DescriptorImageInfo pyramid_image_info
+	{
+		.imageView = hiz_pyramid.view,
+		.imageLayout = vk::ImageLayout::eGeneral
+	};
+	m_cullDescriptorSet = gdevice::create_pso_descriptor_set( m_gctx, m_params.cullPso,
+		{
+			.storageBuffers = cull_buffer_infos,
+			.sampledImages = std::span<const vk::DescriptorImageInfo>( &pyramid_image_info, K_CULL_SAMPLED_IMAGE_COUNT )
+		} );
+
+	if( !m_params.isOcclusionCullingEnabled )
+	{
+		return;
+	}
+
+	const vk::DescriptorBufferInfo counter_buffer_info { .buffer = gdevice::get_buffer( m_hizCounterBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE };
+	const vk::DescriptorImageInfo depth_image_info
+	{
+		.imageView = depth_image.view,
+		.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+	};
+	// the shader declares K_HIZ_MAX_MIPS mips, the ones past the end of a short chain repeat the last mip and are never written
+	std::array<vk::DescriptorImageInfo, K_HIZ_MAX_MIPS> mip_image_infos;
+	for( Uint32 mip = 0; mip < K_HIZ_MAX_MIPS; ++mip )
+	{
+		mip_image_infos[ mip ] = vk::DescriptorImageInfo
+		{
+			.imageView = hiz_pyramid.mipViews[ std::min( mip, hiz_pyramid.mipLevels - 1 ) ],
+			.imageLayout = vk::ImageLayout::eGeneral
+		};
+	}
+	m_hizDescriptorSet = gdevice::create_pso_descriptor_set( m_gctx, m_params.buildHizPso,
+		{
+			.storageBuffers = std::span<const vk::DescriptorBufferInfo>( &counter_buffer_info, K_HIZ_STORAGE_BUFFER_COUNT ),
+			.sampledImages = std::span<const vk::DescriptorImageInfo>( &depth_image_info, K_HIZ_SAMPLED_IMAGE_COUNT ),
+			.storageImages = mip_image_infos
+		} );
+}
+
+
+void GpuDrivenScene::RecordCulling( vk::CommandBuffer cmd_buffer, GpuCullPhase phase, Uint32 view_index )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const Uint32 phase_index = static_cast< Uint32 >( phase );
+
+	GpuCullConstants cull_constants
+	{
+		.bucketFirstCommand = Uvec4( 0 ),
+		.instanceCount = m_params.instanceCount,
+		.viewIndex = view_index,
+		.phase = phase,
+		.drawCountOffset = phase_index * K_GPU_DRIVEN_BUCKET_COUNT
+	};
+	for( Uint32 bucket = 0; bucket < K_GPU_DRIVEN_BUCKET_COUNT; ++bucket )
+	{
+		cull_constants.bucketFirstCommand[ bucket ] = phase_index * m_phaseCommandCount + m_bucketFirstCommand[ bucket ];
+	}
+
+	const gdevice::PSO cull_pso = gdevice::get_pso( m_params.cullPso );
+	gdevice::bind_pso_descriptor_set( cmd_buffer, cull_pso, m_cullDescriptorSet.vkDescriptorSet );
+	gdevice::push_pso_constants( cmd_buffer, cull_pso, cull_constants );
+	gdevice::dispatch_threads( cmd_buffer, cull_pso, m_params.instanceCount, K_CULL_GROUP_SIZE );
+
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+		vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eComputeShader,
+		vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite );
+}
+
+
+void GpuDrivenScene::RecordPass( const gdevice::Frame& frame, GpuCullPhase phase, const glm::mat4& view_projection )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const vk::CommandBuffer cmd_buffer = frame.cmdBuffer;
+	const Bool is_early = ( phase == GpuCullPhase::eEarly );
+
+	const gdevice::Buffer index_buffer = gdevice::get_buffer( m_indexBuffer );
+	const gdevice::Buffer draw_command_buffer = gdevice::get_buffer( m_drawCommandBuffer );
+	const gdevice::Buffer draw_count_buffer = gdevice::get_buffer( m_drawCountBuffer );
+
+	const vk::RenderingAttachmentInfo color_attachment_info
+	{
+		.imageView = frame.swapchainImageView,
+		.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+		.loadOp = is_early ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad,
+		.storeOp = vk::AttachmentStoreOp::eStore,
+		.clearValue = vk::ClearValue { .color = vk::ClearColorValue { std::array<Float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } } }
+	};
+	const vk::RenderingAttachmentInfo depth_attachment_info
+	{
+		.imageView = gdevice::get_image( m_depthImage ).view,
+		.imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+		.loadOp = is_early ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad,
+		.storeOp = vk::AttachmentStoreOp::eStore,
+		.clearValue = vk::ClearValue { .depthStencil = vk::ClearDepthStencilValue { .depth = 1.0f, .stencil = 0 } }
+	};
+	const vk::RenderingInfo rendering_info
+	{
+		.renderArea = { .offset = { 0, 0 }, .extent = frame.swapchainExtent },
+		.layerCount = 1,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &color_attachment_info,
+		.pDepthAttachment = &depth_attachment_info
+	};
+	const vk::Viewport viewport
+	{
+		.x = 0.0f,
+		.y = 0.0f,
+		.width = static_cast< Float >( frame.swapchainExtent.width ),
+		.height = static_cast< Float >( frame.swapchainExtent.height ),
+		.minDepth = 0.0f,
+		.maxDepth = 1.0f
+	};
+	const GpuDrawConstants draw_constants
+	{
+		.viewProjection = view_projection,
+		.verticesAddress = gdevice::get_buffer( m_vertexBuffer ).deviceAddress,
+		.instancesAddress = gdevice::get_buffer( m_instanceBuffer ).deviceAddress
+	};
+
+	cmd_buffer.beginRendering( rendering_info );
+	cmd_buffer.setViewport( 0, viewport );
+	cmd_buffer.setScissor( 0, rendering_info.renderArea );
+	cmd_buffer.bindIndexBuffer( index_buffer.vkBuffer, 0, vk::IndexType::eUint16 );
+
+	const Uint32 phase_index = static_cast< Uint32 >( phase );
+	for( Uint32 bucket = 0; bucket < K_GPU_DRIVEN_BUCKET_COUNT; ++bucket )
+	{
+		const Uint32 first_command = phase_index * m_phaseCommandCount + m_bucketFirstCommand[ bucket ];
+		const Uint32 count_index = phase_index * K_GPU_DRIVEN_BUCKET_COUNT + bucket;
+
+		const gdevice::PSO bucket_pso = gdevice::get_pso( m_params.bucketPsos[ bucket ] );
+		gdevice::bind_pso( cmd_buffer, bucket_pso );
+		gdevice::push_pso_constants( cmd_buffer, bucket_pso, draw_constants );
+		gdevice::draw_indexed_indirect_count( cmd_buffer,
+			draw_command_buffer.vkBuffer, static_cast< vk::DeviceSize >( first_command ) * sizeof( vk::DrawIndexedIndirectCommand ),
+			draw_count_buffer.vkBuffer, static_cast< vk::DeviceSize >( count_index ) * sizeof( Uint32 ),
+			m_bucketCapacity[ bucket ] );
+	}
+
+	cmd_buffer.endRendering();
+}
+
+
+void GpuDrivenScene::RecordHizBuild( vk::CommandBuffer cmd_buffer )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const gdevice::Image depth_image = gdevice::get_image( m_depthImage );
+
+	// the early depth becomes the input, the previous pyramid may still be read by the last cull
+	// the early pass writes depth in both fragment test stages, the load op clear runs in the early one
+	gdevice::insert_image_barrier( cmd_buffer, depth_image.vkImage, depth_image.aspectMask,
+		vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentWrite, vk::ImageLayout::eDepthAttachmentOptimal,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eShaderReadOnlyOptimal );
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite );
+
+	const Uvec2 group_counts = ( m_hizMip0Extent + Uvec2( K_HIZ_GROUP_TILE_SIZE - 1 ) ) / K_HIZ_GROUP_TILE_SIZE;
+	const GpuHizConstants hiz_constants
+	{
+		.depthExtent = Uvec2( depth_image.extent.width, depth_image.extent.height ),
+		.mip0Extent = m_hizMip0Extent,
+		.mipCount = gdevice::get_image( m_hizPyramid ).mipLevels,
+		.groupCount = group_counts.x * group_counts.y
+	};
+
+	const gdevice::PSO hiz_pso = gdevice::get_pso( m_params.buildHizPso );
+	gdevice::bind_pso_descriptor_set( cmd_buffer, hiz_pso, m_hizDescriptorSet.vkDescriptorSet );
+	gdevice::push_pso_constants( cmd_buffer, hiz_pso, hiz_constants );
+	gdevice::dispatch( cmd_buffer, hiz_pso, group_counts.x, group_counts.y );
+
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead );
+	gdevice::insert_image_barrier( cmd_buffer, depth_image.vkImage, depth_image.aspectMask,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eNone, vk::ImageLayout::eShaderReadOnlyOptimal,
+		vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+		vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite, vk::ImageLayout::eDepthAttachmentOptimal );
+}
+
+
+void GpuDrivenScene::Record( const gdevice::Frame& frame, const glm::mat4& view_projection )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const vk::CommandBuffer cmd_buffer = frame.cmdBuffer;
+
+	if( !m_instances.empty() )
+	{
+		RecordUploads( cmd_buffer );
+	}
+	if( !gdevice::is_image_valid( m_depthImage ) || gdevice::get_image( m_depthImage ).extent != frame.swapchainExtent )
+	{
+		ResizeDepthTargets( cmd_buffer, frame.swapchainExtent );
+	}
+	const gdevice::Image depth_image = gdevice::get_image( m_depthImage );
+
+	GpuCullView& cull_view = static_cast< GpuCullView* >( gdevice::get_buffer( m_cullViewBuffer ).pMappedData )[ frame.frameSlot ];
+	extract_frustum_planes( view_projection, cull_view.frustumPlanes );
+	cull_view.viewProjection = view_projection;
+	cull_view.pyramidViewProjection = m_pyramidViewProjection;
+	cull_view.depthExtent = Vec2( static_cast< Float >( frame.swapchainExtent.width ), static_cast< Float >( frame.swapchainExtent.height ) );
+	cull_view.pyramidMip0Extent = m_hizMip0Extent;
+	cull_view.pyramidMipCount = gdevice::get_image( m_hizPyramid ).mipLevels;
+	cull_view.isPyramidValid = m_isPyramidValid ? 1 : 0;
+	cull_view.isOcclusionCullingEnabled = m_params.isOcclusionCullingEnabled ? 1 : 0;
+	cull_view.padding = 0;
+
+	// the draw lists and the depth buffer are rewritten while the previous frame may still read them
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eNone,
+		vk::PipelineStageFlagBits2::eClear | vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eNone );
+	gdevice::insert_image_barrier( cmd_buffer, depth_image.vkImage, depth_image.aspectMask,
+		vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eNone, vk::ImageLayout::eUndefined,
+		vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+		vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite, vk::ImageLayout::eDepthAttachmentOptimal );
+
+	cmd_buffer.fillBuffer( gdevice::get_buffer( m_drawCountBuffer ).vkBuffer, 0, VK_WHOLE_SIZE, 0 );
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eClear, vk::AccessFlagBits2::eTransferWrite,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite );
+
+	RecordCulling( cmd_buffer, GpuCullPhase::eEarly, frame.frameSlot );
+	RecordPass( frame, GpuCullPhase::eEarly, view_projection );
+
+	if( !m_params.isOcclusionCullingEnabled )
+	{
+		return;
+	}
+
+	RecordHizBuild( cmd_buffer );
+	m_isPyramidValid = true;
+	m_pyramidViewProjection = view_projection;
+
+	RecordCulling( cmd_buffer, GpuCullPhase::eLate, frame.frameSlot );
+
+	// the late pass loads the colour the early pass stored, the depth was handed back by RecordHizBuild
+	gdevice::insert_image_barrier( cmd_buffer, frame.swapchainImage, vk::ImageAspectFlagBits::eColor,
+		vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal,
+		vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal );
+	RecordPass( frame, GpuCullPhase::eLate, view_projection );
+}
+
+
+glm::mat4 compute_view_projection( const CameraPacket& camera, const vk::Extent2D& extent )
+{
+	const Float aspect_ratio = static_cast< Float >( extent.width ) / static_cast< Float >( std::max<Uint32>( extent.height, 1 ) );
+	glm::mat4 projection = glm::perspectiveRH_ZO( camera.verticalFovRadians, aspect_ratio, camera.nearPlane, camera.farPlane );
+	projection[ 1 ][ 1 ] *= -1.0f;
+
+	return projection * glm::lookAtRH( camera.position, camera.target, camera.up );
+}
+
+
+void extract_frustum_planes( const glm::mat4& view_projection, Vec4 ( &planes )[ 6 ] )
+{
+	const glm::mat4 rows = glm::transpose( view_projection );
+	planes[ 0 ] = rows[ 3 ] + rows[ 0 ];
+	planes[ 1 ] = rows[ 3 ] - rows[ 0 ];
+	planes[ 2 ] = rows[ 3 ] + rows[ 1 ];
+	planes[ 3 ] = rows[ 3 ] - rows[ 1 ];
+	planes[ 4 ] = rows[ 2 ];
+	planes[ 5 ] = rows[ 3 ] - rows[ 2 ];
+
+	for( Vec4& plane : planes )
+	{
+		plane /= glm::length( Vec3( plane ) );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "common.h"
+#include "azhal_renderer.h"
+
+#include "frame_packet.h"
+
+constexpr Uint32 K_GPU_DRIVEN_BUCKET_COUNT = 2;
+constexpr vk::Format K_GPU_DRIVEN_DEPTH_FORMAT = vk::Format::eD32Sfloat;
+// the pyramid of build_hiz.cs covers depth buffers up to 4096 texels wide
+constexpr Uint32 K_HIZ_MAX_MIPS = 12;
+constexpr Uint32 K_HIZ_STORAGE_BUFFER_COUNT = 1;
+constexpr Uint32 K_HIZ_SAMPLED_IMAGE_COUNT = 1;
+constexpr Uint32 K_CULL_STORAGE_BUFFER_COUNT = 6;
+constexpr Uint32 K_CULL_SAMPLED_IMAGE_COUNT = 1;
+
+// layouts below are shared with cull_instances.cs and gpu_driven.vs
+
+struct GpuVertex
+{
+	Vec3 position;
+	// rgba8
+	Uint32 packedColor;
+};
+AZHAL_STATIC_ASSERT( sizeof( GpuVertex ) == 16, "GpuVertex has to match the vertex stride of gpu_driven.vs" );
+
+struct GpuMesh
+{
+	Uint32 indexCount;
+	Uint32 firstIndex;
+	Int32 vertexOffset;
+	Float boundingRadius;
+};
+
+struct GpuInstance
+{
+	// world space center and radius
+	Vec4 boundingSphere;
+	// world space position and uniform scale
+	Vec4 positionScale;
+	Uint32 meshIndex;
+	// selects the pso, and with it the indirect draw list the instance is appended to
+	Uint32 bucketIndex;
+	Uint32 packedColor;
+	Uint32 padding;
+};
+AZHAL_STATIC_ASSERT( sizeof( GpuInstance ) == 48, "GpuInstance has to match the instance stride of gpu_driven.vs" );
+
+// one per frame slot
+struct GpuCullView
+{
+	// xyz normal pointing inside, w distance
+	Vec4 frustumPlanes[ 6 ];
+	glm::mat4 viewProjection;
+	// the view the depth pyramid was rendered from
+	glm::mat4 pyramidViewProjection;
+	Vec2 depthExtent;
+	Uvec2 pyramidMip0Extent;
+	Uint32 pyramidMipCount;
+	Uint32 isPyramidValid;
+	Uint32 isOcclusionCullingEnabled;
+	Uint32 padding;
+};
+AZHAL_STATIC_ASSERT( sizeof( GpuCullView ) == 256, "GpuCullView has to match CullView of cull_instances.cs" );
+
+enum class GpuCullPhase : Uint32
+{
+	eEarly = 0,
+	eLate = 1,
+
+	eCount
+};
+
+struct GpuCullConstants
+{
+	Uvec4 bucketFirstCommand;
+	Uint32 instanceCount;
+	Uint32 viewIndex;
+	GpuCullPhase phase;
+	Uint32 drawCountOffset;
+};
+
+struct GpuHizConstants
+{
+	Uvec2 depthExtent;
+	Uvec2 mip0Extent;
+	Uint32 mipCount;
+	Uint32 groupCount;
+};
+
+struct GpuDrawConstants
+{
+	glm::mat4 viewProjection;
+	vk::DeviceAddress verticesAddress;
+	vk::DeviceAddress instancesAddress;
+};
+
+struct GpuDrivenSceneParams
+{
+	Uint32 instanceCount = 10000;
+	gdevice::PSOHandle cullPso;
+	gdevice::PSOHandle buildHizPso;
+	// render with K_GPU_DRIVEN_DEPTH_FORMAT
+	std::array<gdevice::PSOHandle, K_GPU_DRIVEN_BUCKET_COUNT> bucketPsos;
+	// frustum culling only when disabled, the late phase and the pyramid are skipped
+	Bool isOcclusionCullingEnabled = true;
+};
+
+// meshes, instances and their bounds live on the gpu and are uploaded once. every frame a compute pass culls the
+// instances and compacts the visible ones into one indirect draw list per pso bucket, so the cpu records the same
+// handful of commands whatever the instance count.
+//
+// occlusion culling runs in two phases. the early phase draws what passes the depth pyramid of the previous frame,
+// then the pyramid is rebuilt from that depth in one dispatch and the late phase draws whatever the early phase
+// rejected but the new pyramid does not hide
+class GpuDrivenScene : NonCopyable
+{
+public:
+	GpuDrivenScene( gdevice::Context& gctx, const GpuDrivenSceneParams& params );
+	~GpuDrivenScene();
+
+	// buffer device addresses, count draws, 64-bit addresses in shaders and firstInstance in indirect draws
+	static Bool IsSupported( const gdevice::Context& gctx );
+
+	// culls and renders into the frame's swapchain image, clearing it first
+	void Record( const gdevice::Frame& frame, const glm::mat4& view_projection );
+
+	AZHAL_INLINE Uint32 GetInstanceCount() const
+	{
+		return m_params.instanceCount;
+	}
+
+private:
+	void RecordUploads( vk::CommandBuffer cmd_buffer );
+	// (re)creates the depth buffer, the pyramid and the descriptor sets that reference them
+	void ResizeDepthTargets( vk::CommandBuffer cmd_buffer, const vk::Extent2D& extent );
+	void RecordCulling( vk::CommandBuffer cmd_buffer, GpuCullPhase phase, Uint32 view_index );
+	void RecordPass( const gdevice::Frame& frame, GpuCullPhase phase, const glm::mat4& view_projection );
+	void RecordHizBuild( vk::CommandBuffer cmd_buffer );
+
+	gdevice::Context& m_gctx;
+	GpuDrivenSceneParams m_params;
+
+	gdevice::BufferHandle m_vertexBuffer;
+	gdevice::BufferHandle m_indexBuffer;
+	gdevice::BufferHandle m_meshBuffer;
+	gdevice::BufferHandle m_instanceBuffer;
+	gdevice::BufferHandle m_drawCommandBuffer;
+	gdevice::BufferHandle m_drawCountBuffer;
+	gdevice::BufferHandle m_earlyDrawnBuffer;
+	// MAX_FRAMES_IN_FLIGHT GpuCullViews, written by the cpu
+	gdevice::BufferHandle m_cullViewBuffer;
+	gdevice::BufferHandle m_hizCounterBuffer;
+
+	gdevice::ImageHandle m_depthImage;
+	gdevice::ImageHandle m_hizPyramid;
+	Uvec2 m_hizMip0Extent = Uvec2( 0 );
+	gdevice::DescriptorSet m_cullDescriptorSet;
+	gdevice::DescriptorSet m_hizDescriptorSet;
+	// valid once the pyramid was built for the current depth targets
+	Bool m_isPyramidValid = false;
+	glm::mat4 m_pyramidViewProjection = glm::mat4( 1.0f );
+
+	// the draw command list of every bucket is sized for all of its instances, and every phase has its own lists
+	std::array<Uint32, K_GPU_DRIVEN_BUCKET_COUNT> m_bucketFirstCommand = {};
+	std::array<Uint32, K_GPU_DRIVEN_BUCKET_COUNT> m_bucketCapacity = {};
+	Uint32 m_phaseCommandCount = 0;
+
+	// kept until the first RecordCulling uploads them
+	std::vector<GpuVertex> m_vertices;
+	std::vector<Uint16> m_indices;
+	std::vector<GpuMesh> m_meshes;
+	std::vector<GpuInstance> m_instances;
+};
+
+// right handed, depth 0..1 and y pointing down in clip space
+glm::mat4 compute_view_projection( const CameraPacket& camera, const vk::Extent2D& extent );
+
+// gribb-hartmann, the planes of a depth 0..1 projection with their normals pointing inside
+void extract_frustum_planes( const glm::mat4& view_projection, Vec4 ( &planes )[ 6 ] );
\ No newline at end of file
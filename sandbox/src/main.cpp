@@ -1,48 +1,309 @@
 #include "common.h"
 #include "azhal_renderer.h"
 
+#include "asset_warmup.h"
+#include "benchmark.h"
+#include "render_thread.h"
+#include "simulation.h"
+
+#include <chrono>
+
+namespace
+{
+	gdevice::PresentPolicy parse_present_policy( const String& present_policy_name )
+	{
+		if( present_policy_name == "immediate" )
+		{
+			return gdevice::PresentPolicy::eImmediate;
+		}
+		if( present_policy_name == "fifo" )
+		{
+			return gdevice::PresentPolicy::eFifo;
+		}
+		if( present_policy_name == "fifoRelaxed" )
+		{
+			return gdevice::PresentPolicy::eFifoRelaxed;
+		}
+		if( present_policy_name != "mailbox" )
+		{
+			AZHAL_LOG_WARN( "unknown present policy {0}, using mailbox", present_policy_name );
+		}
+		return gdevice::PresentPolicy::eMailbox;
+	}
+
+
+	// offline conversion into the packed mesh format the renderer loads without further processing
+	Int32 convert_mesh( const String& input_path, String output_path )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		if( output_path.empty() )
+		{
+			output_path = input_path.substr( 0, input_path.find_last_of( '.' ) ) + ".azmesh";
+		}
+
+		PackedMesh packed_mesh;
+		MeshProcessingStats stats;
+		if( !load_sandbox_mesh( input_path, packed_mesh, &stats ) )
+		{
+			return 1;
+		}
+
+		if( !SaveBinaryBlob( output_path.c_str(), SerializePackedMesh( packed_mesh ) ) )
+		{
+			AZHAL_LOG_ERROR( "failed to write the packed mesh to {0}", output_path );
+			return 1;
+		}
+
+		AZHAL_LOG_INFO( "converted {0} to {1}: {2} vertices, {3} triangles, acmr {4:.3f} -> {5:.3f}, {6} -> {7} bytes",
+			input_path, output_path, stats.vertexCount, stats.triangleCount, stats.acmrBefore, stats.acmrAfter, stats.bytesBefore, stats.bytesAfter );
+		return 0;
+	}
+
+
+	// this thread polls the window and simulates, the render thread records, submits and presents the packets
+	void run_interactive( gdevice::Context& gctx, Window& window, gdevice::PSOHandle pso_handle, Uint32 draw_count )
+	{
+		AZHAL_PROFILE_FUNCTION();
+
+		using Clock = std::chrono::steady_clock;
+
+		FramePacketBuffer packet_buffer;
+		SimulationState simulation_state
+		{
+			.drawCount = draw_count
+		};
+
+		RenderThread render_thread( gctx, pso_handle, packet_buffer );
+
+		// the simulation ticks at a fixed rate independent of the render rate, the render thread always draws the newest tick
+		constexpr Double K_SIMULATION_STEP_SECONDS = 1.0 / 120.0;
+		const Clock::duration simulation_step = std::chrono::duration_cast< Clock::duration >( std::chrono::duration<Double>( K_SIMULATION_STEP_SECONDS ) );
+
+		Clock::time_point next_tick_time = Clock::now();
+		while( window.poll() )
+		{
+			// nothing is published while minimized, the render thread sleeps until the window is restored
+			const Uvec2 framebuffer_size = window.get_framebuffer_size();
+			if( framebuffer_size.x > 0 && framebuffer_size.y > 0 )
+			{
+				simulate( simulation_state, K_SIMULATION_STEP_SECONDS, vk::Extent2D { framebuffer_size.x, framebuffer_size.y }, packet_buffer.GetWriteBuffer() );
+				packet_buffer.Publish();
+			}
+
+			next_tick_time += simulation_step;
+			const Clock::time_point now = Clock::now();
+			if( next_tick_time > now )
+			{
+				std::this_thread::sleep_until( next_tick_time );
+			}
+			else if( now - next_tick_time > simulation_step * 8 )
+			{
+				// fell far behind, e.g. while the window was being dragged, do not try to catch up
+				next_tick_time = now;
+			}
+		}
+
+		FramePacket& shutdown_packet = packet_buffer.GetWriteBuffer();
+		shutdown_packet.isShutdownRequested = true;
+		packet_buffer.Publish();
+	}
+}
+
 Int32 main( int argc, char** argv )
 {
+	AZHAL_PROFILE_THREAD_NAME( "main" );
+
+	// time-to-first-frame is measured from here
+	StageTimings startup_timings;
+
 	AzhalLogger::Init( "azhal" );
+	JobSystem::Init();
 	AZHAL_LOG_INFO( "initialized logger.." );
 
 	cxxopts::Options cmd_line_options( "Azhal", "A vulkan renderer" );
 	cmd_line_options.add_options()
 		( "vkValidation", "enable vulkan api validation" )
-		( "gpuValidation", "enable gpu-assisted validation" );
+		( "gpuValidation", "enable gpu-assisted validation" )
+		( "pipelineCache", "pipeline cache file loaded at startup and written at exit, empty disables it", cxxopts::value<String>()->default_value( "pipeline_cache.bin" ) );
+	cmd_line_options.add_options( "mesh" )
+		( "convertMesh", "optimize and quantize an .obj file into a packed mesh, then exit", cxxopts::value<String>()->default_value( "" ) )
+		( "meshOutput", "file written by --convertMesh, defaults to the input with the .azmesh extension", cxxopts::value<String>()->default_value( "" ) );
+	cmd_line_options.add_options( "culling" )
+		( "cullBenchmark", "time the cpu culling kernels on this many random spheres, then exit", cxxopts::value<Uint32>()->default_value( "0" ) )
+		( "cullIterations", "iterations per --cullBenchmark measurement", cxxopts::value<Uint32>()->default_value( "50" ) )
+		( "transformBenchmark", "time incremental transform hierarchy updates on this many nodes, then exit", cxxopts::value<Uint32>()->default_value( "0" ) )
+		( "transformIterations", "updates per --transformBenchmark measurement", cxxopts::value<Uint32>()->default_value( "50" ) );
+	cmd_line_options.add_options( "streaming" )
+		( "streamTexture", "parse a .dds file and stream copies of it under a tight residency budget, then exit", cxxopts::value<String>()->default_value( "" ) )
+		( "streamUpdates", "update_texture_streaming calls made by --streamTexture", cxxopts::value<Uint32>()->default_value( "8" ) );
+	cmd_line_options.add_options( "presentation" )
+		( "presentPolicy", "immediate, mailbox, fifo or fifoRelaxed", cxxopts::value<String>()->default_value( "mailbox" ) )
+		( "swapchainImages", "swapchain image count, 0 picks the surface minimum + 1", cxxopts::value<Uint32>()->default_value( "0" ) )
+		( "maxQueuedPresents", "pace frames with VK_KHR_present_wait, 0 disables it", cxxopts::value<Uint32>()->default_value( "0" ) )
+		( "fpsLimit", "cpu-side frame rate limit, 0 disables it", cxxopts::value<Double>()->default_value( "0" ) );
+	cmd_line_options.add_options( "benchmark" )
+		( "benchmark", "render a synthetic scene and report frame-time percentiles as json" )
+		( "headless", "render without a window through VK_EXT_headless_surface, requires --benchmark or --streamTexture" )
+		( "warmupFrames", "frames rendered before measuring", cxxopts::value<Uint32>()->default_value( "100" ) )
+		( "frames", "measured frames", cxxopts::value<Uint32>()->default_value( "1000" ) )
+		( "drawCount", "draws per frame in the synthetic and interactive scenes, instances with --gpuDriven", cxxopts::value<Uint32>()->default_value( "1000" ) )
+		( "gpuDriven", "cull instances in a compute pass and draw them through indirect count draws" )
+		( "noOcclusionCulling", "frustum culling only with --gpuDriven" )
+		( "renderQueue", "submit the synthetic scene across two psos in scattered order and record it through a render queue, in submission and in key order" )
+		( "mesh", "draw drawCount instances of a packed mesh or an .obj file instead of the synthetic scene", cxxopts::value<String>()->default_value( "" ) )
+		( "meshlets", "cull the --mesh instances per meshlet, through mesh shaders where supported" )
+		( "noMeshShader", "cull meshlets in a compute pass that expands indirect draws even when mesh shaders are supported" )
+		( "geometryPool", "draw the --mesh instances from this many copies of the mesh in a geometry pool, half of them removed and compacted first", cxxopts::value<Uint32>()->default_value( "0" ) )
+		( "width", "render width", cxxopts::value<Uint32>()->default_value( "1280" ) )
+		( "height", "render height", cxxopts::value<Uint32>()->default_value( "720" ) )
+		( "benchmarkOutput", "file the json report is written to", cxxopts::value<String>()->default_value( "" ) );
 
 	const cxxopts::ParseResult& cmd_line_result = cmd_line_options.parse( argc, argv );
 
+	const String& convert_mesh_path = cmd_line_result[ "convertMesh" ].as<String>();
+	if( !convert_mesh_path.empty() )
+	{
+		const Int32 convert_exit_code = convert_mesh( convert_mesh_path, cmd_line_result[ "meshOutput" ].as<String>() );
+		JobSystem::Shutdown();
+		return convert_exit_code;
+	}
+
+	const Uint32 cull_benchmark_sphere_count = cmd_line_result[ "cullBenchmark" ].as<Uint32>();
+	if( cull_benchmark_sphere_count > 0 )
+	{
+		const Int32 cull_exit_code = run_culling_benchmark( cull_benchmark_sphere_count, cmd_line_result[ "cullIterations" ].as<Uint32>() );
+		JobSystem::Shutdown();
+		return cull_exit_code;
+	}
+
+	const Uint32 transform_benchmark_node_count = cmd_line_result[ "transformBenchmark" ].as<Uint32>();
+	if( transform_benchmark_node_count > 0 )
+	{
+		const Int32 transform_exit_code = run_transform_benchmark( transform_benchmark_node_count, cmd_line_result[ "transformIterations" ].as<Uint32>() );
+		JobSystem::Shutdown();
+		return transform_exit_code;
+	}
+
 	const Bool are_validation_layers_enabled = cmd_line_result.count( "vkValidation" ) > 0;
 	const Bool is_gpu_assisted_validation_enabled = cmd_line_result.count( "gpuValidation" ) > 0;
 
+	const Bool is_benchmark_enabled = cmd_line_result.count( "benchmark" ) > 0;
+	const String& stream_texture_path = cmd_line_result[ "streamTexture" ].as<String>();
+	const Bool is_headless_allowed = is_benchmark_enabled || !stream_texture_path.empty();
+	const Bool is_headless = is_headless_allowed && ( cmd_line_result.count( "headless" ) > 0 );
+	if( !is_headless_allowed && cmd_line_result.count( "headless" ) > 0 )
+	{
+		AZHAL_LOG_WARN( "--headless is only supported together with --benchmark or --streamTexture, ignoring it" );
+	}
+
+	const BenchmarkParams benchmark_params
+	{
+		.warmupFrames = cmd_line_result[ "warmupFrames" ].as<Uint32>(),
+		.measuredFrames = cmd_line_result[ "frames" ].as<Uint32>(),
+		.drawCount = cmd_line_result[ "drawCount" ].as<Uint32>(),
+		.width = cmd_line_result[ "width" ].as<Uint32>(),
+		.height = cmd_line_result[ "height" ].as<Uint32>(),
+		.isGpuDriven = is_benchmark_enabled && ( cmd_line_result.count( "gpuDriven" ) > 0 ),
+		.isOcclusionCullingEnabled = ( cmd_line_result.count( "noOcclusionCulling" ) == 0 ),
+		.meshPath = is_benchmark_enabled ? cmd_line_result[ "mesh" ].as<String>() : String(),
+		.isMeshletCullingEnabled = ( cmd_line_result.count( "meshlets" ) > 0 ),
+		.isMeshShaderAllowed = ( cmd_line_result.count( "noMeshShader" ) == 0 ),
+		.geometryPoolMeshCount = cmd_line_result[ "geometryPool" ].as<Uint32>(),
+		.isRenderQueueEnabled = ( cmd_line_result.count( "renderQueue" ) > 0 ),
+		.outputPath = cmd_line_result[ "benchmarkOutput" ].as<String>(),
+		.pStartupTimings = &startup_timings
+	};
+
+	// file loads run on workers while the window and the device are created on this thread
+	Uint32 sandbox_features = 0;
+	if( benchmark_params.isGpuDriven )
+	{
+		sandbox_features |= eSandboxFeatureGpuDriven;
+	}
+	else if( !benchmark_params.meshPath.empty() )
+	{
+		sandbox_features |= eSandboxFeatureMesh;
+		if( benchmark_params.isMeshletCullingEnabled )
+		{
+			sandbox_features |= eSandboxFeatureMeshlets;
+		}
+	}
+	else if( benchmark_params.isRenderQueueEnabled )
+	{
+		sandbox_features |= eSandboxFeatureRenderQueue;
+	}
+
+	AssetPreload asset_preload;
+	begin_asset_preload( asset_preload, cmd_line_result[ "pipelineCache" ].as<String>(), sandbox_features, benchmark_params.meshPath, &startup_timings );
+
+	Int32 exit_code = 0;
 	try
 	{
-		std::unique_ptr<Window> p_window = std::make_unique<Window>( "Azhal Sandbox", 1280, 720 );
+		std::unique_ptr<Window> p_window;
+		if( !is_headless )
+		{
+			AZHAL_STAGE_TIMING_SCOPE( &startup_timings, "window" );
+			p_window = std::make_unique<Window>( "Azhal Sandbox", benchmark_params.width, benchmark_params.height );
+		}
 
-		const Uvec2 framebuffer_size = p_window->get_framebuffer_size();
+		const Uvec2 framebuffer_size = p_window ? p_window->get_framebuffer_size() : Uvec2( benchmark_params.width, benchmark_params.height );
 		const vk::Extent2D swapchain_extent { framebuffer_size.x, framebuffer_size.y };
 
 		const gdevice::GDeviceInitParams gdevice_init_params
 		{
-			.pWindow = p_window->get(),
+			.pWindow = p_window ? p_window->get() : nullptr,
 			.swapchainExtent = swapchain_extent,
 			.areValidationLayersEnabled = are_validation_layers_enabled,
 			.debugMessageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose,
-			.isGpuAssistedValidationEnabled = is_gpu_assisted_validation_enabled
+			.isGpuAssistedValidationEnabled = is_gpu_assisted_validation_enabled,
+			.presentPolicy = parse_present_policy( cmd_line_result[ "presentPolicy" ].as<String>() ),
+			.swapchainImageCount = cmd_line_result[ "swapchainImages" ].as<Uint32>(),
+			.framePacing =
+			{
+				.maxQueuedPresents = cmd_line_result[ "maxQueuedPresents" ].as<Uint32>(),
+				.maxFramesPerSecond = cmd_line_result[ "fpsLimit" ].as<Double>()
+			},
+			.pStartupTimings = &startup_timings
 		};
 		gdevice::Context gctx = gdevice::init( gdevice_init_params );
 
-		do
+		if( wait_for_asset_preload( asset_preload, &startup_timings ) )
 		{
-		} while( p_window->poll() );
+			WarmAssets warm_assets = finish_asset_warmup( gctx, asset_preload, &startup_timings );
+			startup_timings.Log( "startup" );
+
+			if( !stream_texture_path.empty() )
+			{
+				exit_code = run_texture_streaming_check( gctx, stream_texture_path, cmd_line_result[ "streamUpdates" ].as<Uint32>() );
+			}
+			else if( is_benchmark_enabled )
+			{
+				exit_code = run_benchmark( gctx, p_window.get(), warm_assets, benchmark_params );
+			}
+			else
+			{
+				run_interactive( gctx, *p_window, get_pso( warm_assets, SandboxPSO::eSimple ), benchmark_params.drawCount );
+			}
+
+			destroy_warm_assets( gctx, asset_preload, warm_assets );
+		}
+		else
+		{
+			exit_code = 1;
+		}
 
 		gdevice::shutdown( gctx );
 	}
 	catch( GDeviceException& e )
 	{
 		AZHAL_LOG_ALWAYS_ENABLED( "[GDeviceException] {0}", e.what() );
+		exit_code = 1;
 	}
 
-	return 0;
+	// the preload may still be running when init threw
+	JobSystem::Wait( asset_preload.counter );
+	JobSystem::Shutdown();
+
+	return exit_code;
 }
\ No newline at end of file
@@ -0,0 +1,461 @@
+#include "mesh_scene.h"
+
+#include "gpu_driven_scene.h"
+
+#include <cmath>
+
+namespace
+{
+	constexpr Uint32 K_MESHLET_CULL_GROUP_SIZE = 64;
+
+	template<typename T>
+	vk::DeviceSize get_byte_size( const std::vector<T>& elements )
+	{
+		return static_cast< vk::DeviceSize >( elements.size() * sizeof( T ) );
+	}
+
+
+	// meshlets are the x dimension of the task shader groups and instances the y dimension
+	Bool is_mesh_task_draw_supported( const gdevice::DeviceCapabilities& device_capabilities, Uint32 meshlet_count, Uint32 instance_count )
+	{
+		const Uint64 group_count_x = gdevice::get_dispatch_group_count( meshlet_count, K_MESHLET_TASK_GROUP_SIZE );
+		return ( group_count_x <= device_capabilities.maxTaskWorkGroupCount[ 0 ] ) && ( instance_count <= device_capabilities.maxTaskWorkGroupCount[ 1 ] ) &&
+			( group_count_x * instance_count <= device_capabilities.maxTaskWorkGroupTotalCount );
+	}
+
+
+	Bool is_meshlet_cull_dispatch_supported( Uint32 meshlet_count, Uint32 instance_count )
+	{
+		const Uint64 max_draw_count = static_cast< Uint64 >( meshlet_count ) * instance_count;
+		return ( max_draw_count <= static_cast< Uint64 >( UINT16_MAX ) * K_MESHLET_CULL_GROUP_SIZE );
+	}
+}
+
+MeshScene::MeshScene( gdevice::Context& gctx, PackedMesh packed_mesh, const MeshSceneParams& params )
+	: m_gctx( gctx )
+	, m_params( params )
+	, m_packedMesh( std::move( packed_mesh ) )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	AZHAL_FATAL_ASSERT( IsSupported( gctx, m_params.renderPath ), "the mesh render path needs device features that are not enabled" );
+
+	m_params.instanceCount = std::max<Uint32>( m_params.instanceCount, 1 );
+	m_gridColumns = static_cast< Uint32 >( std::ceil( std::sqrt( static_cast< Float >( m_params.instanceCount ) ) ) );
+	// instances are centered on their bounds, leave half a mesh of room between neighbours
+	m_instanceSpacing = glm::length( m_packedMesh.boundsExtent ) * 2.5f;
+
+	if( m_params.renderPath == MeshRenderPath::eVertex )
+	{
+		AZHAL_LOG_INFO( "mesh scene: {0} instances of {1} vertices and {2} triangles{3}",
+			m_params.instanceCount, m_packedMesh.vertices.size(), m_packedMesh.indices.size() / 3, IsGeometryPooled() ? ", from a geometry pool" : "" );
+		return;
+	}
+
+	m_meshletData = BuildMeshlets( m_packedMesh );
+	m_meshletCount = static_cast< Uint32 >( m_meshletData.meshlets.size() );
+
+	if( m_params.renderPath == MeshRenderPath::eMeshShader &&
+		!is_mesh_task_draw_supported( gdevice::get_device_capabilities( gctx ), m_meshletCount, m_params.instanceCount ) )
+	{
+		const Bool is_compute_expansion_usable = IsSupported( gctx, MeshRenderPath::eComputeExpansion ) && !m_params.cullMeshletsPso.IsNull() &&
+			is_meshlet_cull_dispatch_supported( m_meshletCount, m_params.instanceCount );
+		m_params.renderPath = is_compute_expansion_usable ? MeshRenderPath::eComputeExpansion : MeshRenderPath::eVertex;
+		AZHAL_LOG_WARN( "{0} meshlets x {1} instances exceed the device's task shader group limits, falling back to {2}",
+			m_meshletCount, m_params.instanceCount, is_compute_expansion_usable ? "compute expansion" : "vertex rendering" );
+	}
+	if( m_params.renderPath == MeshRenderPath::eComputeExpansion && !is_meshlet_cull_dispatch_supported( m_meshletCount, m_params.instanceCount ) )
+	{
+		m_params.renderPath = MeshRenderPath::eVertex;
+		AZHAL_LOG_WARN( "{0} meshlets x {1} instances exceed one meshlet cull dispatch, falling back to vertex rendering", m_meshletCount, m_params.instanceCount );
+	}
+	if( m_params.renderPath == MeshRenderPath::eVertex )
+	{
+		m_meshletData = {};
+		m_meshletCount = 0;
+		AZHAL_LOG_INFO( "mesh scene: {0} instances of {1} vertices and {2} triangles",
+			m_params.instanceCount, m_packedMesh.vertices.size(), m_packedMesh.indices.size() / 3 );
+		return;
+	}
+
+	const vk::BufferUsageFlags pulled_usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferDst;
+	const Bool is_mesh_shader_path = ( m_params.renderPath == MeshRenderPath::eMeshShader );
+	m_meshletBuffer = gdevice::create_buffer( gctx,
+		{
+			.size = m_meshletCount * sizeof( GpuMeshlet ),
+			.usage = is_mesh_shader_path ? pulled_usage : ( vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst )
+		} );
+	m_viewBuffer = gdevice::create_buffer( gctx,
+		{
+			.size = gdevice::MAX_FRAMES_IN_FLIGHT * sizeof( GpuMeshletView ),
+			.usage = vk::BufferUsageFlagBits::eStorageBuffer | ( is_mesh_shader_path ? vk::BufferUsageFlagBits::eShaderDeviceAddress : vk::BufferUsageFlags {} ),
+			.memoryUsage = gdevice::BufferMemoryUsage::eCpuToGpu
+		} );
+
+	if( is_mesh_shader_path )
+	{
+		m_meshletVertexBuffer = gdevice::create_buffer( gctx, { .size = get_byte_size( m_meshletData.vertices ), .usage = pulled_usage } );
+		m_meshletTriangleBuffer = gdevice::create_buffer( gctx, { .size = get_byte_size( m_meshletData.triangles ), .usage = pulled_usage } );
+	}
+	else
+	{
+		// the meshlets are contiguous ranges of the mesh's index buffer, so the expanded draws index it directly
+		const Uint64 max_draw_count = static_cast< Uint64 >( m_meshletCount ) * m_params.instanceCount;
+
+		m_drawCommandBuffer = gdevice::create_buffer( gctx,
+			{
+				.size = max_draw_count * sizeof( vk::DrawIndexedIndirectCommand ),
+				.usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer
+			} );
+		m_drawCountBuffer = gdevice::create_buffer( gctx,
+			{
+				.size = sizeof( Uint32 ),
+				.usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst
+			} );
+
+		const std::array<vk::DescriptorBufferInfo, K_MESHLET_CULL_STORAGE_BUFFER_COUNT> cull_buffer_infos
+		{
+			vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_meshletBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+			vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_viewBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+			vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_drawCommandBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE },
+			vk::DescriptorBufferInfo { .buffer = gdevice::get_buffer( m_drawCountBuffer ).vkBuffer, .offset = 0, .range = VK_WHOLE_SIZE }
+		};
+		m_cullDescriptorSet = gdevice::create_pso_descriptor_set( gctx, m_params.cullMeshletsPso, { .storageBuffers = cull_buffer_infos } );
+	}
+
+	AZHAL_LOG_INFO( "mesh scene: {0} instances of {1} vertices and {2} triangles in {3} meshlets, {4}",
+		m_params.instanceCount, m_packedMesh.vertices.size(), m_packedMesh.indices.size() / 3, m_meshletCount,
+		is_mesh_shader_path ? "mesh shaders" : "compute expansion" );
+}
+
+
+MeshScene::~MeshScene()
+{
+	gdevice::destroy_descriptor_set( m_gctx, m_cullDescriptorSet );
+	gdevice::destroy_buffer( m_gctx, m_drawCountBuffer );
+	gdevice::destroy_buffer( m_gctx, m_drawCommandBuffer );
+	gdevice::destroy_buffer( m_gctx, m_viewBuffer );
+	gdevice::destroy_buffer( m_gctx, m_meshletTriangleBuffer );
+	gdevice::destroy_buffer( m_gctx, m_meshletVertexBuffer );
+	gdevice::destroy_buffer( m_gctx, m_meshletBuffer );
+	gdevice::destroy_geometry_pool( m_gctx, m_geometryPool );
+	gdevice::destroy_image( m_gctx, m_depthImage );
+	gdevice::destroy_mesh( m_gctx, m_mesh );
+}
+
+
+Bool MeshScene::IsSupported( const gdevice::Context& gctx, MeshRenderPath render_path )
+{
+	const gdevice::DeviceCapabilities& device_capabilities = gdevice::get_device_capabilities( gctx );
+	switch( render_path )
+	{
+	case MeshRenderPath::eMeshShader:
+		return gdevice::is_device_feature_enabled( device_capabilities,
+			gdevice::eDeviceFeatureMeshShader | gdevice::eDeviceFeatureBufferDeviceAddress | gdevice::eDeviceFeatureShaderInt64 );
+	case MeshRenderPath::eComputeExpansion:
+		return gdevice::is_device_feature_enabled( device_capabilities, gdevice::eDeviceFeatureDrawIndirectCount | gdevice::eDeviceFeatureDrawIndirectFirstInstance );
+	case MeshRenderPath::eVertex:
+	default:
+		return true;
+	}
+}
+
+
+Float MeshScene::GetGridExtent() const
+{
+	return static_cast< Float >( m_gridColumns ) * m_instanceSpacing;
+}
+
+
+void MeshScene::RecordUploads( vk::CommandBuffer cmd_buffer )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	m_areUploadsRecorded = true;
+	if( IsGeometryPooled() )
+	{
+		RecordGeometryPoolUploads( cmd_buffer );
+		m_packedMesh = {};
+		return;
+	}
+
+	const Bool is_mesh_shader_path = ( m_params.renderPath == MeshRenderPath::eMeshShader );
+	m_mesh = gdevice::create_mesh( m_gctx, cmd_buffer, m_packedMesh, is_mesh_shader_path );
+	m_packedMesh = {};
+
+	if( m_params.renderPath == MeshRenderPath::eVertex )
+	{
+		return;
+	}
+
+	std::vector<GpuMeshlet> gpu_meshlets( m_meshletCount );
+	for( Uint32 i = 0; i < m_meshletCount; ++i )
+	{
+		const Meshlet& meshlet = m_meshletData.meshlets[ i ];
+		const MeshletBounds& bounds = m_meshletData.bounds[ i ];
+		gpu_meshlets[ i ] = GpuMeshlet
+		{
+			.boundingSphere = Vec4( bounds.center, bounds.radius ),
+			.cone = Vec4( bounds.coneAxis, bounds.coneCutoff ),
+			.vertexOffset = meshlet.vertexOffset,
+			.triangleOffset = meshlet.triangleOffset,
+			.vertexCount = meshlet.vertexCount,
+			.triangleCount = meshlet.triangleCount
+		};
+	}
+	gdevice::record_buffer_upload( m_gctx, cmd_buffer, m_meshletBuffer, 0, gpu_meshlets.data(), get_byte_size( gpu_meshlets ) );
+
+	vk::PipelineStageFlags2 dst_stage_mask = vk::PipelineStageFlagBits2::eComputeShader;
+	if( is_mesh_shader_path )
+	{
+		gdevice::record_buffer_upload( m_gctx, cmd_buffer, m_meshletVertexBuffer, 0, m_meshletData.vertices.data(), get_byte_size( m_meshletData.vertices ) );
+		gdevice::record_buffer_upload( m_gctx, cmd_buffer, m_meshletTriangleBuffer, 0, m_meshletData.triangles.data(), get_byte_size( m_meshletData.triangles ) );
+		dst_stage_mask = vk::PipelineStageFlagBits2::eTaskShaderEXT | vk::PipelineStageFlagBits2::eMeshShaderEXT;
+	}
+
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+		dst_stage_mask, vk::AccessFlagBits2::eShaderStorageRead );
+
+	// everything lives on the gpu from now on
+	m_meshletData = {};
+}
+
+
+void MeshScene::RecordGeometryPoolUploads( vk::CommandBuffer cmd_buffer )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	// room for a quarter of the copies, so that adding them grows the pool twice
+	const Uint32 mesh_count = m_params.geometryPoolMeshCount;
+	const Uint32 initial_mesh_count = std::max<Uint32>( mesh_count / 4, 1 );
+	const gdevice::GeometryPoolCreationParams geometry_pool_creation_params
+	{
+		.vertexCapacity = static_cast< Uint32 >( m_packedMesh.vertices.size() ) * initial_mesh_count,
+		.indexCapacity = static_cast< Uint32 >( m_packedMesh.indices.size() ) * initial_mesh_count
+	};
+	m_geometryPool = gdevice::create_geometry_pool( m_gctx, geometry_pool_creation_params );
+
+	std::vector<gdevice::GeometryHandle> added_meshes;
+	added_meshes.reserve( mesh_count );
+	for( Uint32 i = 0; i < mesh_count; ++i )
+	{
+		added_meshes.push_back( gdevice::add_pool_mesh( m_gctx, cmd_buffer, m_geometryPool, m_packedMesh ) );
+	}
+
+	// every other copy leaves a gap behind, the compaction closes them
+	m_poolMeshes.clear();
+	for( Uint32 i = 0; i < mesh_count; ++i )
+	{
+		if( i % 2 == 0 )
+		{
+			m_poolMeshes.push_back( added_meshes[ i ] );
+		}
+		else
+		{
+			gdevice::remove_pool_mesh( m_geometryPool, added_meshes[ i ] );
+		}
+	}
+	const gdevice::GeometryPoolStats fragmented_stats = gdevice::get_geometry_pool_stats( m_geometryPool );
+
+	gdevice::compact_geometry_pool( m_gctx, cmd_buffer, m_geometryPool );
+	const gdevice::GeometryPoolStats compacted_stats = gdevice::get_geometry_pool_stats( m_geometryPool );
+
+	AZHAL_LOG_INFO( "geometry pool: {0} meshes added, {1} kept, {2} of {3} vertices in use before compaction and {4} after",
+		mesh_count, compacted_stats.meshCount, fragmented_stats.usedVertices, fragmented_stats.vertexCapacity, compacted_stats.usedVertices );
+}
+
+
+// one item per instance, spread over the pooled copies. they share the pool's buffers, so the queue binds them once
+void MeshScene::RecordGeometryPoolDraws( vk::CommandBuffer cmd_buffer, const MeshDrawConstants& draw_constants )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	gdevice::reset_render_queue( m_renderQueue );
+
+	const Uint32 pool_mesh_count = static_cast< Uint32 >( m_poolMeshes.size() );
+	for( Uint32 i = 0; i < m_params.instanceCount; ++i )
+	{
+		const gdevice::RenderItem item
+		{
+			.pso = m_params.pso,
+			.pMesh = &gdevice::get_pool_mesh( m_geometryPool, m_poolMeshes[ i % pool_mesh_count ] ),
+			.firstInstance = i,
+			.pPushConstants = &draw_constants,
+			.pushConstantSize = sizeof( MeshDrawConstants )
+		};
+		gdevice::submit_render_item( m_renderQueue, gdevice::make_render_key( 0, m_params.pso, 0, static_cast< Float >( i ) ), item );
+	}
+
+	gdevice::sort_render_queue( m_renderQueue );
+	gdevice::record_render_queue( m_renderQueue, cmd_buffer, 0 );
+}
+
+
+void MeshScene::RecordMeshletCulling( vk::CommandBuffer cmd_buffer, Uint32 view_index )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	// the draw list is rewritten while the previous frame may still read it
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eDrawIndirect, vk::AccessFlagBits2::eNone,
+		vk::PipelineStageFlagBits2::eClear | vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eNone );
+
+	cmd_buffer.fillBuffer( gdevice::get_buffer( m_drawCountBuffer ).vkBuffer, 0, VK_WHOLE_SIZE, 0 );
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eClear, vk::AccessFlagBits2::eTransferWrite,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite );
+
+	const MeshletCullConstants cull_constants
+	{
+		.viewIndex = view_index
+	};
+	const gdevice::PSO cull_pso = gdevice::get_pso( m_params.cullMeshletsPso );
+	gdevice::bind_pso_descriptor_set( cmd_buffer, cull_pso, m_cullDescriptorSet.vkDescriptorSet );
+	gdevice::push_pso_constants( cmd_buffer, cull_pso, cull_constants );
+	gdevice::dispatch_threads( cmd_buffer, cull_pso, m_meshletCount * m_params.instanceCount, K_MESHLET_CULL_GROUP_SIZE );
+
+	gdevice::insert_memory_barrier( cmd_buffer,
+		vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+		vk::PipelineStageFlagBits2::eDrawIndirect, vk::AccessFlagBits2::eIndirectCommandRead );
+}
+
+
+void MeshScene::Record( const gdevice::Frame& frame, const glm::mat4& view_projection, const Vec3& camera_position )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const vk::CommandBuffer cmd_buffer = frame.cmdBuffer;
+
+	if( !m_areUploadsRecorded )
+	{
+		RecordUploads( cmd_buffer );
+	}
+	const gdevice::Mesh mesh = IsGeometryPooled() ? gdevice::get_pool_mesh( m_geometryPool, m_poolMeshes[ 0 ] ) : gdevice::get_mesh( m_mesh );
+
+	if( m_params.renderPath != MeshRenderPath::eVertex )
+	{
+		GpuMeshletView& view = static_cast< GpuMeshletView* >( gdevice::get_buffer( m_viewBuffer ).pMappedData )[ frame.frameSlot ];
+		view = GpuMeshletView
+		{
+			.viewProjection = view_projection,
+			.cameraPosition = Vec4( camera_position, 1.0f ),
+			.boundsCenterSpacing = Vec4( mesh.boundsCenter, m_instanceSpacing ),
+			.boundsExtent = Vec4( mesh.boundsExtent, 0.0f ),
+			.gridColumns = m_gridColumns,
+			.instanceCount = m_params.instanceCount,
+			.meshletCount = m_meshletCount
+		};
+		extract_frustum_planes( view_projection, view.frustumPlanes );
+	}
+
+	if( m_params.renderPath == MeshRenderPath::eComputeExpansion )
+	{
+		RecordMeshletCulling( cmd_buffer, frame.frameSlot );
+	}
+
+	if( !gdevice::is_image_valid( m_depthImage ) || gdevice::get_image( m_depthImage ).extent != frame.swapchainExtent )
+	{
+		gdevice::destroy_image( m_gctx, m_depthImage );
+		m_depthImage = gdevice::create_image( m_gctx,
+			{
+				.format = K_MESH_SCENE_DEPTH_FORMAT,
+				.extent = frame.swapchainExtent,
+				.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment
+			} );
+	}
+	const gdevice::Image depth_image = gdevice::get_image( m_depthImage );
+
+	// the previous contents are cleared, so the old layout does not matter
+	gdevice::insert_image_barrier( cmd_buffer, depth_image.vkImage, depth_image.aspectMask,
+		vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests, vk::AccessFlagBits2::eDepthStencilAttachmentWrite, vk::ImageLayout::eUndefined,
+		vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+		vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite, vk::ImageLayout::eDepthAttachmentOptimal );
+
+	const vk::RenderingAttachmentInfo color_attachment_info
+	{
+		.imageView = frame.swapchainImageView,
+		.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+		.loadOp = vk::AttachmentLoadOp::eClear,
+		.storeOp = vk::AttachmentStoreOp::eStore,
+		.clearValue = vk::ClearValue { .color = vk::ClearColorValue { std::array<Float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } } }
+	};
+	const vk::RenderingAttachmentInfo depth_attachment_info
+	{
+		.imageView = depth_image.view,
+		.imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+		.loadOp = vk::AttachmentLoadOp::eClear,
+		.storeOp = vk::AttachmentStoreOp::eDontCare,
+		.clearValue = vk::ClearValue { .depthStencil = vk::ClearDepthStencilValue { .depth = 1.0f, .stencil = 0 } }
+	};
+	const vk::RenderingInfo rendering_info
+	{
+		.renderArea = { .offset = { 0, 0 }, .extent = frame.swapchainExtent },
+		.layerCount = 1,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &color_attachment_info,
+		.pDepthAttachment = &depth_attachment_info
+	};
+	const vk::Viewport viewport
+	{
+		.x = 0.0f,
+		.y = 0.0f,
+		.width = static_cast< Float >( frame.swapchainExtent.width ),
+		.height = static_cast< Float >( frame.swapchainExtent.height ),
+		.minDepth = 0.0f,
+		.maxDepth = 1.0f
+	};
+
+	cmd_buffer.beginRendering( rendering_info );
+	cmd_buffer.setViewport( 0, viewport );
+	cmd_buffer.setScissor( 0, rendering_info.renderArea );
+
+	if( m_params.renderPath == MeshRenderPath::eMeshShader )
+	{
+		const MeshletDrawConstants draw_constants
+		{
+			.viewAddress = gdevice::get_buffer( m_viewBuffer ).deviceAddress + frame.frameSlot * sizeof( GpuMeshletView ),
+			.meshletsAddress = gdevice::get_buffer( m_meshletBuffer ).deviceAddress,
+			.verticesAddress = mesh.vertexBuffer.deviceAddress,
+			.meshletVerticesAddress = gdevice::get_buffer( m_meshletVertexBuffer ).deviceAddress,
+			.meshletTrianglesAddress = gdevice::get_buffer( m_meshletTriangleBuffer ).deviceAddress
+		};
+
+		const gdevice::PSO meshlet_pso = gdevice::get_pso( m_params.meshletPso );
+		gdevice::bind_pso( cmd_buffer, meshlet_pso );
+		gdevice::push_pso_constants( cmd_buffer, meshlet_pso, draw_constants );
+		gdevice::draw_mesh_tasks( cmd_buffer, gdevice::get_dispatch_group_count( m_meshletCount, K_MESHLET_TASK_GROUP_SIZE ), m_params.instanceCount );
+	}
+	else
+	{
+		const MeshDrawConstants draw_constants
+		{
+			.viewProjection = view_projection,
+			.boundsExtentSpacing = Vec4( mesh.boundsExtent, m_instanceSpacing ),
+			.gridColumns = m_gridColumns
+		};
+
+		if( IsGeometryPooled() )
+		{
+			RecordGeometryPoolDraws( cmd_buffer, draw_constants );
+			cmd_buffer.endRendering();
+			return;
+		}
+
+		const gdevice::PSO pso = gdevice::get_pso( m_params.pso );
+		gdevice::bind_pso( cmd_buffer, pso );
+		gdevice::push_pso_constants( cmd_buffer, pso, draw_constants );
+		gdevice::bind_mesh( cmd_buffer, mesh );
+		if( m_params.renderPath == MeshRenderPath::eComputeExpansion )
+		{
+			gdevice::draw_indexed_indirect_count( cmd_buffer, gdevice::get_buffer( m_drawCommandBuffer ).vkBuffer, 0, gdevice::get_buffer( m_drawCountBuffer ).vkBuffer, 0,
+				m_meshletCount * m_params.instanceCount );
+		}
+		else
+		{
+			gdevice::draw_mesh( cmd_buffer, mesh, m_params.instanceCount );
+		}
+	}
+
+	cmd_buffer.endRendering();
+}
\ No newline at end of file
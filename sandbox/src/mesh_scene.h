@@ -0,0 +1,169 @@
+#pragma once
+
+#include "common.h"
+#include "azhal_renderer.h"
+
+constexpr vk::Format K_MESH_SCENE_DEPTH_FORMAT = vk::Format::eD32Sfloat;
+// meshlets per task shader group of meshlet.as
+constexpr Uint32 K_MESHLET_TASK_GROUP_SIZE = 32;
+constexpr Uint32 K_MESHLET_CULL_STORAGE_BUFFER_COUNT = 4;
+
+enum class MeshRenderPath : Uint32
+{
+	// every triangle of every instance through the fixed function vertex fetch
+	eVertex = 0,
+	// task shaders cull the meshlets of every instance, mesh shaders emit the survivors
+	eMeshShader = 1,
+	// a compute pass culls the meshlets of every instance and appends one indexed indirect draw per survivor
+	eComputeExpansion = 2
+};
+
+// layouts below are shared with mesh.vs, meshlet.as, meshlet.ms and meshlet_cull.cs
+
+struct MeshDrawConstants
+{
+	glm::mat4 viewProjection;
+	// xyz half extent of the mesh bounds, w distance between instances
+	Vec4 boundsExtentSpacing;
+	Uint32 gridColumns;
+	Uint32 padding[ 3 ];
+};
+
+struct GpuMeshlet
+{
+	// xyz center, w radius
+	Vec4 boundingSphere;
+	// xyz axis, w cutoff, see MeshletBounds
+	Vec4 cone;
+	Uint32 vertexOffset;
+	Uint32 triangleOffset;
+	Uint32 vertexCount;
+	Uint32 triangleCount;
+};
+AZHAL_STATIC_ASSERT( sizeof( GpuMeshlet ) == 48, "GpuMeshlet has to match the meshlet stride of the meshlet shaders" );
+
+// one per frame slot
+struct GpuMeshletView
+{
+	glm::mat4 viewProjection;
+	// xyz normal pointing inside, w distance
+	Vec4 frustumPlanes[ 6 ];
+	Vec4 cameraPosition;
+	// xyz center of the mesh bounds, w distance between instances
+	Vec4 boundsCenterSpacing;
+	// xyz half extent of the mesh bounds
+	Vec4 boundsExtent;
+	Uint32 gridColumns;
+	Uint32 instanceCount;
+	Uint32 meshletCount;
+	Uint32 padding[ 9 ];
+};
+AZHAL_STATIC_ASSERT( sizeof( GpuMeshletView ) == 256, "GpuMeshletView has to match MeshletView of the meshlet shaders" );
+
+struct MeshletDrawConstants
+{
+	vk::DeviceAddress viewAddress;
+	vk::DeviceAddress meshletsAddress;
+	vk::DeviceAddress verticesAddress;
+	vk::DeviceAddress meshletVerticesAddress;
+	vk::DeviceAddress meshletTrianglesAddress;
+};
+
+struct MeshletCullConstants
+{
+	Uint32 viewIndex;
+};
+
+struct MeshSceneParams
+{
+	Uint32 instanceCount = 1000;
+	MeshRenderPath renderPath = MeshRenderPath::eVertex;
+	// renders with K_MESH_SCENE_DEPTH_FORMAT, see SandboxPSO::eMesh. also draws the expanded meshlets
+	gdevice::PSOHandle pso;
+	// SandboxPSO::eMeshlet, only read by eMeshShader
+	gdevice::PSOHandle meshletPso;
+	// SandboxPSO::eCullMeshlets, only read by eComputeExpansion
+	gdevice::PSOHandle cullMeshletsPso;
+	// eVertex only. this many copies of the mesh are added to a gdevice::GeometryPool created too small for them, every
+	// other copy is removed again and the pool compacted. the instances are spread over the remaining copies and drawn
+	// through a gdevice::RenderQueue, which binds the pool once
+	Uint32 geometryPoolMeshCount = 0;
+};
+
+// draws one imported mesh instanced on a grid, so the frame time is dominated by vertex work and the order the
+// triangles are submitted in. the meshlet paths skip clusters outside the frustum and clusters whose normal cone
+// faces away from the camera. everything is uploaded by the first Record
+class MeshScene : NonCopyable
+{
+public:
+	MeshScene( gdevice::Context& gctx, PackedMesh packed_mesh, const MeshSceneParams& params );
+	~MeshScene();
+
+	static Bool IsSupported( const gdevice::Context& gctx, MeshRenderPath render_path );
+
+	// renders into the frame's swapchain image, clearing it first
+	void Record( const gdevice::Frame& frame, const glm::mat4& view_projection, const Vec3& camera_position );
+
+	// of the whole instance grid
+	Float GetGridExtent() const;
+
+	AZHAL_INLINE Uint32 GetInstanceCount() const
+	{
+		return m_params.instanceCount;
+	}
+
+	AZHAL_INLINE MeshRenderPath GetRenderPath() const
+	{
+		return m_params.renderPath;
+	}
+
+	AZHAL_INLINE Bool IsGeometryPooled() const
+	{
+		return ( m_params.renderPath == MeshRenderPath::eVertex ) && ( m_params.geometryPoolMeshCount > 0 );
+	}
+
+	// of the last Record, only filled when IsGeometryPooled
+	AZHAL_INLINE const gdevice::RenderQueueStats& GetRenderQueueStats() const
+	{
+		return m_renderQueue.stats;
+	}
+
+	AZHAL_INLINE gdevice::GeometryPoolStats GetGeometryPoolStats() const
+	{
+		return gdevice::get_geometry_pool_stats( m_geometryPool );
+	}
+
+private:
+	void RecordUploads( vk::CommandBuffer cmd_buffer );
+	void RecordGeometryPoolUploads( vk::CommandBuffer cmd_buffer );
+	void RecordGeometryPoolDraws( vk::CommandBuffer cmd_buffer, const MeshDrawConstants& draw_constants );
+	void RecordMeshletCulling( vk::CommandBuffer cmd_buffer, Uint32 view_index );
+
+	gdevice::Context& m_gctx;
+	MeshSceneParams m_params;
+
+	gdevice::MeshHandle m_mesh;
+	Bool m_areUploadsRecorded = false;
+	gdevice::ImageHandle m_depthImage;
+	Uint32 m_gridColumns = 1;
+	Float m_instanceSpacing = 1.0f;
+	Uint32 m_meshletCount = 0;
+
+	gdevice::BufferHandle m_meshletBuffer;
+	gdevice::BufferHandle m_meshletVertexBuffer;
+	gdevice::BufferHandle m_meshletTriangleBuffer;
+	// MAX_FRAMES_IN_FLIGHT GpuMeshletViews, written by the cpu
+	gdevice::BufferHandle m_viewBuffer;
+	gdevice::BufferHandle m_drawCommandBuffer;
+	gdevice::BufferHandle m_drawCountBuffer;
+	gdevice::DescriptorSet m_cullDescriptorSet;
+
+	// IsGeometryPooled only, m_mesh stays null then
+	gdevice::GeometryPool m_geometryPool;
+	std::vector<gdevice::GeometryHandle> m_poolMeshes;
+	gdevice::RenderQueue m_renderQueue;
+
+	// kept until the first Record uploads them
+	PackedMesh m_packedMesh;
+	MeshletData m_meshletData;
+};
\ No newline at end of file
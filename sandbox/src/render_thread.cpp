@@ -0,0 +1,112 @@
+#include "render_thread.h"
+
+RenderThread::RenderThread( gdevice::Context& gctx, gdevice::PSOHandle pso_handle, FramePacketBuffer& packet_buffer )
+	: m_gctx( gctx )
+	, m_psoHandle( pso_handle )
+	, m_packetBuffer( packet_buffer )
+	, m_framebufferExtent( gdevice::get_swapchain( gctx ).imageExtent )
+{
+	m_thread = std::thread( &RenderThread::Run, this );
+}
+
+
+RenderThread::~RenderThread()
+{
+	m_thread.join();
+}
+
+
+void RenderThread::Run()
+{
+	AZHAL_PROFILE_THREAD_NAME( "render" );
+
+	// nothing to draw before the first packet
+	m_packetBuffer.WaitAndAcquire();
+
+	while( true )
+	{
+		// the newest packet wins, packets the render thread was too slow for are skipped
+		m_packetBuffer.Acquire();
+		const FramePacket& packet = m_packetBuffer.GetReadBuffer();
+		if( packet.isShutdownRequested )
+		{
+			break;
+		}
+
+		if( packet.framebufferExtent != m_framebufferExtent )
+		{
+			m_framebufferExtent = packet.framebufferExtent;
+			gdevice::request_swapchain_resize( m_framebufferExtent );
+		}
+
+		gdevice::Frame frame;
+		if( !gdevice::begin_frame( m_gctx, frame ) )
+		{
+			// e.g. minimized or a resize that has to wait for frames in flight. blocks until the next packet, which the
+			// simulation only publishes once the window has an area again
+			m_packetBuffer.WaitAndAcquire();
+			continue;
+		}
+
+		{
+			AZHAL_PROFILE_GPU_SCOPE( frame.cmdBuffer, "frame_packet" );
+			RecordPacket( frame, packet );
+		}
+
+		gdevice::end_frame( m_gctx, frame );
+	}
+
+	gdevice::wait_idle( m_gctx );
+}
+
+
+void RenderThread::RecordPacket( const gdevice::Frame& frame, const FramePacket& packet )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	const vk::CommandBuffer cmd_buffer = frame.cmdBuffer;
+
+	const vk::RenderingAttachmentInfo color_attachment_info
+	{
+		.imageView = frame.swapchainImageView,
+		.imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+		.loadOp = vk::AttachmentLoadOp::eClear,
+		.storeOp = vk::AttachmentStoreOp::eStore,
+		.clearValue = vk::ClearValue { .color = vk::ClearColorValue { std::array<Float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } } }
+	};
+
+	const vk::RenderingInfo rendering_info
+	{
+		.renderArea = { .offset = { 0, 0 }, .extent = frame.swapchainExtent },
+		.layerCount = 1,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &color_attachment_info
+	};
+
+	cmd_buffer.beginRendering( rendering_info );
+	gdevice::bind_pso( cmd_buffer, m_psoHandle );
+
+	for( const DrawPacket& draw : packet.draws )
+	{
+		const vk::Viewport viewport
+		{
+			.x = draw.viewportRect.x,
+			.y = draw.viewportRect.y,
+			.width = std::max( draw.viewportRect.z, 1.0f ),
+			.height = std::max( draw.viewportRect.w, 1.0f ),
+			.minDepth = 0.0f,
+			.maxDepth = 1.0f
+		};
+		const vk::Rect2D scissor
+		{
+			.offset = { static_cast< Int32 >( draw.viewportRect.x ), static_cast< Int32 >( draw.viewportRect.y ) },
+			.extent = { static_cast< Uint32 >( viewport.width ), static_cast< Uint32 >( viewport.height ) }
+		};
+
+		cmd_buffer.setViewport( 0, viewport );
+		cmd_buffer.setScissor( 0, scissor );
+		cmd_buffer.draw( draw.vertexCount, 1, 0, 0 );
+	}
+
+	cmd_buffer.endRendering();
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "frame_packet.h"
+
+#include <thread>
+
+// owns every gdevice frame call while it runs. the thread that starts it must not begin or end frames itself
+class RenderThread : NonCopyable
+{
+public:
+	RenderThread( gdevice::Context& gctx, gdevice::PSOHandle pso_handle, FramePacketBuffer& packet_buffer );
+	// expects a packet with isShutdownRequested to have been published, then joins
+	~RenderThread();
+
+private:
+	void Run();
+	void RecordPacket( const gdevice::Frame& frame, const FramePacket& packet );
+
+	gdevice::Context& m_gctx;
+	gdevice::PSOHandle m_psoHandle;
+	FramePacketBuffer& m_packetBuffer;
+
+	vk::Extent2D m_framebufferExtent;
+
+	std::thread m_thread;
+};
\ No newline at end of file
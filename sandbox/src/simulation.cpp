@@ -0,0 +1,47 @@
+#include "simulation.h"
+
+#include <cmath>
+
+void simulate( SimulationState& state, Double delta_seconds, const vk::Extent2D& framebuffer_extent, FramePacket& packet )
+{
+	AZHAL_PROFILE_FUNCTION();
+
+	state.frame++;
+	state.timeSeconds += delta_seconds;
+
+	packet.simulationFrame = state.frame;
+	packet.simulationTimeSeconds = state.timeSeconds;
+	packet.framebufferExtent = framebuffer_extent;
+	packet.isShutdownRequested = false;
+
+	// slow orbit around the origin
+	const Float orbit_angle = static_cast< Float >( state.timeSeconds * 0.25 );
+	packet.camera = CameraPacket
+	{
+		.position = Vec3( std::sin( orbit_angle ) * 5.0f, 1.0f, std::cos( orbit_angle ) * -5.0f )
+	};
+
+	// a grid of cells that breathe out of phase, the packet keeps its capacity between frames
+	const Uint32 grid_columns = std::max<Uint32>( static_cast< Uint32 >( std::ceil( std::sqrt( static_cast< Double >( state.drawCount ) ) ) ), 1 );
+	const Uint32 grid_rows = std::max<Uint32>( ( state.drawCount + grid_columns - 1 ) / grid_columns, 1 );
+	const Float cell_width = static_cast< Float >( framebuffer_extent.width ) / static_cast< Float >( grid_columns );
+	const Float cell_height = static_cast< Float >( framebuffer_extent.height ) / static_cast< Float >( grid_rows );
+
+	packet.draws.resize( state.drawCount );
+	for( Uint32 i = 0; i < state.drawCount; ++i )
+	{
+		const Float phase = static_cast< Float >( state.timeSeconds * 2.0 ) + static_cast< Float >( i ) * 0.37f;
+		const Float scale = 0.6f + 0.4f * std::sin( phase );
+
+		const Float width = cell_width * scale;
+		const Float height = cell_height * scale;
+		const Float x = static_cast< Float >( i % grid_columns ) * cell_width + ( cell_width - width ) * 0.5f;
+		const Float y = static_cast< Float >( i / grid_columns ) * cell_height + ( cell_height - height ) * 0.5f;
+
+		packet.draws[ i ] = DrawPacket
+		{
+			.viewportRect = Vec4( x, y, width, height ),
+			.vertexCount = 3
+		};
+	}
+}
\ No newline at end of file
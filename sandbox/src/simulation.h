@@ -0,0 +1,13 @@
+#pragma once
+
+#include "frame_packet.h"
+
+struct SimulationState
+{
+	Uint64 frame = 0;
+	Double timeSeconds = 0.0;
+	Uint32 drawCount = 256;
+};
+
+// advances the scene by delta_seconds and writes the result into packet, overwriting all of it
+void simulate( SimulationState& state, Double delta_seconds, const vk::Extent2D& framebuffer_extent, FramePacket& packet );
\ No newline at end of file